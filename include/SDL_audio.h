@@ -105,6 +105,12 @@ typedef struct SDL_AudioSpec {
 #define AUDIO_S16MSB	0x9010	/**< As above, but big-endian byte order */
 #define AUDIO_U16	AUDIO_U16LSB
 #define AUDIO_S16	AUDIO_S16LSB
+#define AUDIO_S32LSB	0x8020	/**< Signed 32-bit samples */
+#define AUDIO_S32MSB	0x9020	/**< As above, but big-endian byte order */
+#define AUDIO_F32LSB	0x8120	/**< 32-bit floating point samples, -1.0 to 1.0 */
+#define AUDIO_F32MSB	0x9120	/**< As above, but big-endian byte order */
+#define AUDIO_S32	AUDIO_S32LSB
+#define AUDIO_F32	AUDIO_F32LSB
 
 /**
  *  @name Native audio byte ordering
@@ -113,9 +119,13 @@ typedef struct SDL_AudioSpec {
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
 #define AUDIO_U16SYS	AUDIO_U16LSB
 #define AUDIO_S16SYS	AUDIO_S16LSB
+#define AUDIO_S32SYS	AUDIO_S32LSB
+#define AUDIO_F32SYS	AUDIO_F32LSB
 #else
 #define AUDIO_U16SYS	AUDIO_U16MSB
 #define AUDIO_S16SYS	AUDIO_S16MSB
+#define AUDIO_S32SYS	AUDIO_S32MSB
+#define AUDIO_F32SYS	AUDIO_F32MSB
 #endif
 /*@}*/
 
@@ -173,6 +183,8 @@ extern DECLSPEC char * SDLCALL SDL_AudioDriverName(char *namebuf, int maxlen);
  * may modify the requested size of the audio buffer, you should allocate
  * any local mixing buffers after you open the audio device.
  *
+ * If the callback is NULL, the audio is queued with SDL_QueueAudio().
+ *
  * @sa SDL_AudioSpec
  */
 extern DECLSPEC int SDLCALL SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained);
@@ -195,6 +207,45 @@ extern DECLSPEC SDL_audiostatus SDLCALL SDL_GetAudioStatus(void);
  */
 extern DECLSPEC void SDLCALL SDL_PauseAudio(int pause_on);
 
+/**
+ * Get how long, in milliseconds, audio passed to the device now will take
+ * to be heard, as last measured by the audio driver.
+ *
+ * @return the latency, or -1 if the audio driver can't measure it.
+ */
+extern DECLSPEC int SDLCALL SDL_GetAudioLatency(void);
+
+/**
+ * @name Audio Queue
+ * When SDL_OpenAudio() is given a NULL callback, the audio is pushed with
+ * SDL_QueueAudio() instead, and played as the device needs it.  The audio
+ * is in the format a callback would have been given: 'obtained' if one
+ * was passed to SDL_OpenAudio(), otherwise 'desired'.  Silence is played
+ * when the queue runs dry.  The queue holds at least a second of audio.
+ * Only one thread at a time may queue or clear audio, and it never waits
+ * for the audio thread, so SDL_LockAudio() isn't needed.
+ */
+/*@{*/
+
+/**
+ * Add 'len' bytes of audio to the end of the queue.  The audio doesn't
+ * have to be whole sample frames; a partial frame waits for the rest.
+ *
+ * @return 0, or -1 if the device wasn't opened for queueing or there
+ *         isn't room for all of the audio, in which case none is queued.
+ */
+extern DECLSPEC int SDLCALL SDL_QueueAudio(const void *data, Uint32 len);
+
+/** Get the number of bytes queued that haven't been played yet */
+extern DECLSPEC Uint32 SDLCALL SDL_GetQueuedAudioSize(void);
+
+/**
+ * Throw away the audio queued that hasn't been played yet.  The space
+ * is available again once the audio thread has caught up.
+ */
+extern DECLSPEC void SDLCALL SDL_ClearQueuedAudio(void);
+/*@}*/
+
 /**
  * This function loads a WAVE from the data source, automatically freeing
  * that source if 'freesrc' is non-zero.  For example, to load a WAVE file,
@@ -243,9 +294,73 @@ extern DECLSPEC int SDLCALL SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
  * The data conversion may expand the size of the audio data, so the buffer
  * cvt->buf should be allocated after the cvt structure is initialized by
  * SDL_BuildAudioCVT(), and should be cvt->len*cvt->len_mult bytes long.
+ * Rate changes use a band-limited filter which treats the buffer as one
+ * complete piece of audio, with silence before and after it.  The result,
+ * cvt->len_cvt bytes, is cvt->len*cvt->len_ratio rounded up to whole
+ * sample frames.
  */
 extern DECLSPEC int SDLCALL SDL_ConvertAudio(SDL_AudioCVT *cvt);
 
+/**
+ * @name Audio Streams
+ * An audio stream converts audio that arrives in pieces of any size.
+ * Source audio put into the stream with SDL_AudioStreamPut() is converted
+ * as whole sample frames are available, and can be read back in the
+ * destination format with SDL_AudioStreamGet().  The rate conversion keeps
+ * its filter state between calls, so the output is continuous.
+ */
+/*@{*/
+typedef struct SDL_AudioStream SDL_AudioStream;
+
+/**
+ * Create a stream converting audio from one format, number of channels and
+ * rate to another.
+ *
+ * @return The new stream, or NULL with the SDL error set if the conversion
+ *         isn't supported or there wasn't enough memory.
+ */
+extern DECLSPEC SDL_AudioStream * SDLCALL SDL_NewAudioStream(
+		Uint16 src_format, Uint8 src_channels, int src_rate,
+		Uint16 dst_format, Uint8 dst_channels, int dst_rate);
+
+/**
+ * Add 'len' bytes of source audio to the stream.  The length doesn't have
+ * to be a whole number of sample frames; the rest of a frame may follow
+ * in the next call.
+ *
+ * @return 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamPut(SDL_AudioStream *stream,
+		const void *buf, int len);
+
+/**
+ * Read up to 'len' bytes of converted audio from the stream.  The length
+ * must be a whole number of destination sample frames.
+ *
+ * @return The number of bytes read, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamGet(SDL_AudioStream *stream,
+		void *buf, int len);
+
+/** Get the number of converted bytes that can be read from the stream */
+extern DECLSPEC int SDLCALL SDL_AudioStreamAvailable(SDL_AudioStream *stream);
+
+/**
+ * Make all the audio put so far available, as if it were followed by
+ * silence.  Audio put after a flush continues from where the source
+ * audio ended.
+ *
+ * @return 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamFlush(SDL_AudioStream *stream);
+
+/** Throw away all audio in the stream, read or not */
+extern DECLSPEC void SDLCALL SDL_AudioStreamClear(SDL_AudioStream *stream);
+
+/** Free a stream created by SDL_NewAudioStream() */
+extern DECLSPEC void SDLCALL SDL_FreeAudioStream(SDL_AudioStream *stream);
+/*@}*/
+
 
 #define SDL_MIX_MAXVOLUME 128
 /**
@@ -257,6 +372,27 @@ extern DECLSPEC int SDLCALL SDL_ConvertAudio(SDL_AudioCVT *cvt);
  */
 extern DECLSPEC void SDLCALL SDL_MixAudio(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
 
+/** One source of audio for SDL_MixAudioMulti() */
+typedef struct SDL_MixVoice {
+	const Uint8 *src;	/**< The audio data, or NULL to skip this voice */
+	int volume;		/**< 0 - SDL_MIX_MAXVOLUME */
+	int pan;		/**< 0 centered, -SDL_MIX_MAXVOLUME left only,
+				     SDL_MIX_MAXVOLUME right only */
+} SDL_MixVoice;
+
+/**
+ * This mixes several buffers of audio in 'format' into 'dst', like
+ * calling SDL_MixAudio() once for each of them, but the sum is only
+ * clipped once at the end, and 'dst' is only read and written once.
+ * Each voice's source must hold at least 'len' bytes.  The pan setting
+ * lowers the volume of the left or right channels of stereo and 4 channel
+ * audio, and is ignored otherwise.  With one voice, centered, the result
+ * is the same as SDL_MixAudio().
+ *
+ * @return 0, or -1 if the format isn't supported.
+ */
+extern DECLSPEC int SDLCALL SDL_MixAudioMulti(Uint8 *dst, Uint16 format, Uint8 channels, Uint32 len, const SDL_MixVoice *voices, int num_voices);
+
 /**
  * @name Audio Locks
  * The lock manipulated by these functions protects the callback function.
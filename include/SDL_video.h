@@ -52,6 +52,12 @@ typedef struct SDL_Rect {
 	Uint16 w, h;
 } SDL_Rect;
 
+/** A rectangle with 32-bit coordinates, for SDL_LARGESURFACE surfaces */
+typedef struct SDL_LargeRect {
+	Sint32 x, y;
+	Sint32 w, h;
+} SDL_LargeRect;
+
 typedef struct SDL_Color {
 	Uint8 r;
 	Uint8 g;
@@ -97,7 +103,7 @@ typedef struct SDL_Surface {
 	Uint32 flags;				/**< Read-only */
 	SDL_PixelFormat *format;		/**< Read-only */
 	int w, h;				/**< Read-only */
-	Uint16 pitch;				/**< Read-only */
+	Uint16 pitch;				/**< Read-only, see SDL_GetSurfacePitch() */
 	void *pixels;				/**< Read-write */
 	int offset;				/**< Private */
 
@@ -133,6 +139,11 @@ typedef struct SDL_Surface {
 #define SDL_ASYNCBLIT	0x00000004	/**< Use asynchronous blits if possible */
 /*@}*/
 
+/** Available for SDL_CreateRGBSurface() */
+/*@{*/
+#define SDL_LARGESURFACE 0x00000040	/**< Allow a pitch over 65535 bytes */
+/*@}*/
+
 /** Available for SDL_SetVideoMode() */
 /*@{*/
 #define SDL_ANYFORMAT	0x10000000	/**< Allow any video depth/pixel-format */
@@ -203,6 +214,8 @@ typedef struct SDL_VideoInfo {
 #define SDL_YUY2_OVERLAY  0x32595559	/**< Packed mode: Y0+U0+Y1+V0 (1 plane) */
 #define SDL_UYVY_OVERLAY  0x59565955	/**< Packed mode: U0+Y0+V0+Y1 (1 plane) */
 #define SDL_YVYU_OVERLAY  0x55595659	/**< Packed mode: Y0+V0+Y1+U0 (1 plane) */
+#define SDL_NV12_OVERLAY  0x3231564E	/**< Planar mode: Y + U0+V0  (2 planes) */
+#define SDL_NV21_OVERLAY  0x3132564E	/**< Planar mode: Y + V0+U0  (2 planes) */
 /*@}*/
 
 /** The YUV hardware video overlay */
@@ -248,6 +261,23 @@ typedef enum {
     SDL_GL_SWAP_CONTROL
 } SDL_GLattr;
 
+/** @name Blend modes for SDL_SetBlendMode()
+ *  Each mode changes only the RGB components of the destination,
+ *  its alpha channel is left untouched.  'srcA' is the per-pixel or
+ *  per-surface alpha if SDL_SRCALPHA is set, and opaque otherwise.
+ */
+/*@{*/
+#define SDL_BLENDMODE_NONE	0	/**< Normal copy, colorkey and alpha blits */
+#define SDL_BLENDMODE_ADD	1	/**< dstRGB = dstRGB + srcRGB*srcA, saturated */
+#define SDL_BLENDMODE_MOD	2	/**< dstRGB = dstRGB * srcRGB */
+#define SDL_BLENDMODE_MUL	3	/**< dstRGB = dstRGB * srcRGB + dstRGB * (1-srcA), saturated */
+/*@}*/
+
+/** @name Flags for SDL_TransformBlit() */
+/*@{*/
+#define SDL_TRANSFORM_SMOOTH	0x01	/**< Bilinear filtering, nearest neighbour otherwise */
+/*@}*/
+
 /** @name flags for SDL_SetPalette() */
 /*@{*/
 #define SDL_LOGPAL 0x01
@@ -435,6 +465,11 @@ extern DECLSPEC int SDLCALL SDL_SetGamma(float red, float green, float blue);
  * If the call succeeds, it will return 0.  If the display driver or
  * hardware does not support gamma translation, or otherwise fails,
  * this function will return -1.
+ *
+ * When the hardware can't do it and the screen has a shadow surface,
+ * the gamma is applied in software while copying the shadow surface to
+ * the display.  Set SDL_VIDEO_SOFTWARE_GAMMA in the environment before
+ * SDL_SetVideoMode() to always get a shadow surface and software gamma.
  */
 extern DECLSPEC int SDLCALL SDL_SetGammaRamp(const Uint16 *red, const Uint16 *green, const Uint16 *blue);
 
@@ -515,6 +550,31 @@ extern DECLSPEC void SDLCALL SDL_GetRGBA(Uint32 pixel,
 				const SDL_PixelFormat * const fmt,
 				Uint8 *r, Uint8 *g, Uint8 *b, Uint8 *a);
 
+/**
+ * Maps 'count' RGBA quadruples, stored as consecutive R, G, B and A bytes,
+ * to pixel values for a given pixel format.  The results are the same as
+ * those of SDL_MapRGBA().
+ */
+extern DECLSPEC void SDLCALL SDL_MapRGBAArray
+(const SDL_PixelFormat * const format,
+ const Uint8 *rgba, Uint32 *pixels, int count);
+
+/**
+ * Maps 'count' pixel values into RGBA quadruples, stored as consecutive
+ * R, G, B and A bytes, with the same results as SDL_GetRGBA().
+ */
+extern DECLSPEC void SDLCALL SDL_GetRGBAArray
+(const SDL_PixelFormat * const fmt,
+ const Uint32 *pixels, Uint8 *rgba, int count);
+
+/**
+ * Maps 'count' pixel values into separate arrays of R, G, B and A
+ * components, with the same results as SDL_GetRGBA().  'a' may be NULL.
+ */
+extern DECLSPEC void SDLCALL SDL_GetRGBAPlanar
+(const SDL_PixelFormat * const fmt, const Uint32 *pixels,
+ Uint8 *r, Uint8 *g, Uint8 *b, Uint8 *a, int count);
+
 /** @sa SDL_CreateRGBSurface */
 #define SDL_AllocSurface    SDL_CreateRGBSurface
 /**
@@ -550,6 +610,8 @@ extern DECLSPEC void SDLCALL SDL_GetRGBA(Uint32 pixel,
  * will be set in the flags member of the returned surface.  If for some
  * reason the surface could not be placed in video memory, it will not have
  * the SDL_HWSURFACE flag set, and will be created in system memory instead.
+ * SDL_LARGESURFACE lifts the 65535 byte limit on the length of a row of
+ * a surface in system memory, see SDL_GetSurfacePitch().
  */
 extern DECLSPEC SDL_Surface * SDLCALL SDL_CreateRGBSurface
 			(Uint32 flags, int width, int height, int depth, 
@@ -560,6 +622,18 @@ extern DECLSPEC SDL_Surface * SDLCALL SDL_CreateRGBSurfaceFrom(void *pixels,
 			Uint32 Rmask, Uint32 Gmask, Uint32 Bmask, Uint32 Amask);
 extern DECLSPEC void SDLCALL SDL_FreeSurface(SDL_Surface *surface);
 
+/**
+ * Returns the length of a row of the surface in bytes.
+ *
+ * A surface with SDL_LARGESURFACE set may have rows longer than the
+ * 'pitch' member can hold, it is 0 then and this function must be used.
+ * SDL_CreateRGBSurfaceFrom() sets SDL_LARGESURFACE by itself for a pitch
+ * over 65535.  Large surfaces work with the SDL_LargeRect functions like
+ * SDL_BlitSurfaceLarge() and with SDL_LockSurface(), the SDL_Rect
+ * functions only reach the part of them an SDL_Rect can describe.
+ */
+extern DECLSPEC Uint32 SDLCALL SDL_GetSurfacePitch(SDL_Surface *surface);
+
 /**
  * SDL_LockSurface() sets up a surface for directly accessing the pixels.
  * Between calls to SDL_LockSurface()/SDL_UnlockSurface(), you can write
@@ -592,6 +666,15 @@ extern DECLSPEC SDL_Surface * SDLCALL SDL_LoadBMP_RW(SDL_RWops *src, int freesrc
 /** Convenience macro -- load a surface from a file */
 #define SDL_LoadBMP(file)	SDL_LoadBMP_RW(SDL_RWFromFile(file, "rb"), 1)
 
+/**
+ * Load a surface from a BMP file in memory.
+ * Uncompressed top-down images whose rows are laid out like a surface
+ * are used in place: the returned surface then has SDL_PREALLOC set and
+ * points into 'mem', which must stay valid until it is freed.
+ * Other images are copied as by SDL_LoadBMP_RW().
+ */
+extern DECLSPEC SDL_Surface * SDLCALL SDL_LoadBMPFromMem(void *mem, int size);
+
 /**
  * Save a surface to a seekable SDL data source (memory or file.)
  * If 'freedst' is non-zero, the source will be closed after being written.
@@ -633,6 +716,24 @@ extern DECLSPEC int SDLCALL SDL_SetColorKey
  */
 extern DECLSPEC int SDLCALL SDL_SetAlpha(SDL_Surface *surface, Uint32 flag, Uint8 alpha);
 
+/**
+ * This function sets the blend mode used when the surface is the source
+ * of a blit, one of the SDL_BLENDMODE_* values.  The colorkey and the
+ * SDL_SRCALPHA setting of the surface still apply, the colorkey skipping
+ * pixels and the alpha value weighting the source for SDL_BLENDMODE_ADD
+ * and SDL_BLENDMODE_MUL.
+ *
+ * Blend modes other than SDL_BLENDMODE_NONE are only supported between
+ * surfaces of 16 bits per pixel or more, and are never hardware
+ * accelerated.  This function returns 0, or -1 if the mode is invalid.
+ */
+extern DECLSPEC int SDLCALL SDL_SetBlendMode(SDL_Surface *surface, int mode);
+
+/**
+ * Returns the blend mode of the surface, one of the SDL_BLENDMODE_* values.
+ */
+extern DECLSPEC int SDLCALL SDL_GetBlendMode(SDL_Surface *surface);
+
 /**
  * Sets the clipping rectangle for the destination surface in a blit.
  *
@@ -669,6 +770,32 @@ extern DECLSPEC void SDLCALL SDL_GetClipRect(SDL_Surface *surface, SDL_Rect *rec
 extern DECLSPEC SDL_Surface * SDLCALL SDL_ConvertSurface
 			(SDL_Surface *src, SDL_PixelFormat *fmt, Uint32 flags);
 
+/**
+ * Converts 'count' surfaces at once, as if by calling SDL_ConvertSurface()
+ * on each of them, storing the new surfaces in the 'dst' array.  Software
+ * conversions are spread over several threads.  A surface may appear only
+ * once in the 'src' array, and none of them may be used by other threads
+ * during the call.  NULL entries in 'src' give NULL entries in 'dst'.
+ *
+ * Returns the number of surfaces converted.  The entries of the surfaces
+ * that couldn't be converted are set to NULL.
+ */
+extern DECLSPEC int SDLCALL SDL_ConvertSurfaces(SDL_Surface **src,
+			SDL_Surface **dst, int count,
+			SDL_PixelFormat *fmt, Uint32 flags);
+
+/**
+ * Converts a software surface to the given format without allocating new
+ * pixels, which is possible when both formats have the same number of
+ * bytes per pixel.  The surface keeps its colorkey and alpha settings,
+ * with the same 'flags' semantics as SDL_ConvertSurface().
+ *
+ * Returns 0 on success, or -1 if the surface can't be converted in place,
+ * in which case it is left unchanged.
+ */
+extern DECLSPEC int SDLCALL SDL_ConvertSurfaceInPlace
+			(SDL_Surface *surface, SDL_PixelFormat *fmt, Uint32 flags);
+
 /**
  * This performs a fast blit from the source surface to the destination
  * surface.  It assumes that the source and destination rectangles are
@@ -756,6 +883,28 @@ extern DECLSPEC int SDLCALL SDL_LowerBlit
 			(SDL_Surface *src, SDL_Rect *srcrect,
 			 SDL_Surface *dst, SDL_Rect *dstrect);
 
+/**
+ * This function blits the source rectangle rotated by 'angle' degrees
+ * counter-clockwise and scaled by 'zoomx' and 'zoomy', with the centre of
+ * the source rectangle placed at dstrect->x, dstrect->y (the centre of
+ * the destination surface if 'dstrect' is NULL).  Negative zoom factors
+ * mirror the image.  If 'srcrect' is NULL, the whole surface is used.
+ *
+ * The blit is clipped to the destination clip rectangle and honours the
+ * colorkey, alpha and blend mode of the source like SDL_BlitSurface().
+ * With SDL_TRANSFORM_SMOOTH in 'flags', 32-bit sources with 8 bits per
+ * channel and no colorkey are filtered bilinearly, everything else is
+ * sampled nearest neighbour.  Sources need 8 bits per pixel or more.
+ *
+ * On return 'dstrect' holds the area of the destination that was drawn
+ * to, suitable for SDL_UpdateRects().
+ * This function returns 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_TransformBlit
+			(SDL_Surface *src, SDL_Rect *srcrect,
+			 SDL_Surface *dst, SDL_Rect *dstrect,
+			 double angle, double zoomx, double zoomy, Uint32 flags);
+
 /**
  * This function performs a fast fill of the given rectangle with 'color'
  * The given rectangle is clipped to the destination surface clip area
@@ -768,6 +917,27 @@ extern DECLSPEC int SDLCALL SDL_LowerBlit
 extern DECLSPEC int SDLCALL SDL_FillRect
 		(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color);
 
+/**
+ * @name Blits and fills with 32-bit rectangles
+ * These work like SDL_BlitSurface(), SDL_LowerBlit() and SDL_FillRect(),
+ * but take SDL_LargeRect arguments so they can reach every pixel of a
+ * surface created with SDL_LARGESURFACE, or of one taller than 32767 rows.
+ * Their destination clip area is the clip rectangle of the surface, or
+ * the whole surface if it has SDL_LARGESURFACE set.
+ */
+/*@{*/
+#define SDL_BlitSurfaceLarge SDL_UpperBlitLarge
+
+extern DECLSPEC int SDLCALL SDL_UpperBlitLarge
+			(SDL_Surface *src, SDL_LargeRect *srcrect,
+			 SDL_Surface *dst, SDL_LargeRect *dstrect);
+extern DECLSPEC int SDLCALL SDL_LowerBlitLarge
+			(SDL_Surface *src, SDL_LargeRect *srcrect,
+			 SDL_Surface *dst, SDL_LargeRect *dstrect);
+extern DECLSPEC int SDLCALL SDL_FillRectLarge
+		(SDL_Surface *dst, SDL_LargeRect *dstrect, Uint32 color);
+/*@}*/
+
 /**
  * This function takes a surface and copies it to a new surface of the
  * pixel format and colors of the video framebuffer, suitable for fast
@@ -796,6 +966,73 @@ extern DECLSPEC SDL_Surface * SDLCALL SDL_DisplayFormat(SDL_Surface *surface);
 extern DECLSPEC SDL_Surface * SDLCALL SDL_DisplayFormatAlpha(SDL_Surface *surface);
 
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/** @name Deferred surface operations                                       */ /*@{*/
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/**
+ * A command list records blits, fills, stretches and screen updates
+ * so they can be carried out later by the SDL render thread, while the
+ * application goes on with other work.
+ *
+ * Commands are run in the order they were recorded for any surface they
+ * read or write.  Commands that share no surfaces may run concurrently on
+ * several threads; all commands touching video memory or the display
+ * surface run in order on one thread.
+ *
+ * The surfaces used by a submitted list must not be freed, changed or
+ * used by the application until SDL_WaitCommandList() returns.  Screen
+ * updates are done on the render thread, so the display surface must not
+ * be touched from another thread while they are pending.
+ */
+typedef struct SDL_CommandList SDL_CommandList;
+
+/** Create an empty command list, or return NULL if out of memory */
+extern DECLSPEC SDL_CommandList * SDLCALL SDL_CreateCommandList(void);
+
+/** Free a command list, waiting for it first if it has been submitted */
+extern DECLSPEC void SDLCALL SDL_FreeCommandList(SDL_CommandList *list);
+
+/**
+ * Record a SDL_BlitSurface(), SDL_FillRect(), SDL_SoftStretch() or
+ * SDL_UpdateRects() call.  The rectangles are copied, and unlike
+ * SDL_BlitSurface() the final blit rectangle is not passed back.
+ *
+ * These return 0, or -1 if the command couldn't be recorded.
+ */
+/*@{*/
+extern DECLSPEC int SDLCALL SDL_RecordBlit(SDL_CommandList *list,
+			SDL_Surface *src, SDL_Rect *srcrect,
+			SDL_Surface *dst, SDL_Rect *dstrect);
+extern DECLSPEC int SDLCALL SDL_RecordFillRect(SDL_CommandList *list,
+			SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color);
+extern DECLSPEC int SDLCALL SDL_RecordStretch(SDL_CommandList *list,
+			SDL_Surface *src, SDL_Rect *srcrect,
+			SDL_Surface *dst, SDL_Rect *dstrect);
+extern DECLSPEC int SDLCALL SDL_RecordUpdateRects(SDL_CommandList *list,
+			SDL_Surface *screen, int numrects, SDL_Rect *rects);
+/*@}*/
+
+/**
+ * Hand a command list over to the render thread and return right away.
+ * Lists run one after another, in the order they were submitted.  No more
+ * commands can be recorded into the list until it has been waited for.
+ *
+ * If the render thread isn't available, the commands are run before this
+ * function returns.
+ */
+extern DECLSPEC int SDLCALL SDL_SubmitCommandList(SDL_CommandList *list);
+
+/**
+ * Wait for a submitted command list to finish, and empty it so it can be
+ * recorded into again.  Returns 0 if all commands succeeded, or -1 if any
+ * of them failed, with the first error available from SDL_GetError().
+ */
+extern DECLSPEC int SDLCALL SDL_WaitCommandList(SDL_CommandList *list);
+
+/*@}*/
+
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 /** @name YUV video surface overlay functions                                */ /*@{*/
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
@@ -808,7 +1045,44 @@ extern DECLSPEC SDL_Surface * SDLCALL SDL_DisplayFormatAlpha(SDL_Surface *surfac
 extern DECLSPEC SDL_Overlay * SDLCALL SDL_CreateYUVOverlay(int width, int height,
 				Uint32 format, SDL_Surface *display);
 
-/** Lock an overlay for direct access, and unlock it when you are done */
+/**
+ *  Create an overlay that displays planes owned by the caller, in the
+ *  same way as SDL_CreateRGBSurfaceFrom().  This is SDL_CreateYUVOverlay()
+ *  followed by SDL_SetYUVOverlayPlanes(), except that a hardware overlay
+ *  which can't take the planes is replaced by a software one.
+ */
+extern DECLSPEC SDL_Overlay * SDLCALL SDL_CreateYUVOverlayFrom(Uint8 **pixels,
+				Uint16 *pitches, int width, int height,
+				Uint32 format, SDL_Surface *display);
+
+/**
+ *  Point an overlay at planes owned by the caller, so decoded frames can
+ *  be displayed without copying them into the overlay first.
+ *
+ *  @param[in] pixels One pointer per plane of the overlay, in the same
+ *		order as SDL_Overlay::pixels, or NULL to go back to the
+ *		overlay's own planes.
+ *  @param[in] pitches The bytes per row of each plane.
+ *
+ *  The planes are neither copied nor freed, and must stay valid until
+ *  they are replaced or the overlay is freed.  Locking the overlay no
+ *  longer moves the pixel pointers.  Software overlays convert straight
+ *  from the planes, hardware overlays copy them into video memory in
+ *  SDL_DisplayYUVOverlay().
+ *
+ *  @return 0 on success, or -1 if the overlay can't use the planes.
+ */
+extern DECLSPEC int SDLCALL SDL_SetYUVOverlayPlanes(SDL_Overlay *overlay,
+				Uint8 **pixels, Uint16 *pitches);
+
+/**
+ *  Lock an overlay for direct access, and unlock it when you are done.
+ *
+ *  Hardware overlays may be double buffered, so the pixel pointers can
+ *  change with every lock and the contents of the planes after a call
+ *  to SDL_DisplayYUVOverlay() are undefined until the next frame is
+ *  written.
+ */
 extern DECLSPEC int SDLCALL SDL_LockYUVOverlay(SDL_Overlay *overlay);
 extern DECLSPEC void SDLCALL SDL_UnlockYUVOverlay(SDL_Overlay *overlay);
 
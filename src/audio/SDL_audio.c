@@ -27,6 +27,8 @@
 #include "SDL_audio_c.h"
 #include "SDL_audiomem.h"
 #include "SDL_sysaudio.h"
+#include "SDL_resample_c.h"
+#include "SDL_audioqueue_c.h"
 
 /* Available audio drivers */
 static AudioBootStrap *bootstrap[] = {
@@ -127,6 +129,11 @@ int SDLCALL SDL_RunAudio(void *audiop)
 	void  *udata;
 	void (SDLCALL *fill)(void *userdata,Uint8 *stream, int len);
 	int    silence;
+	int    len;
+	int    direct;
+	int    clear;
+	int    paused;
+	const char *env;
 
 	/* Perform any thread setup */
 	if ( audio->ThreadInit ) {
@@ -150,40 +157,107 @@ int SDLCALL SDL_RunAudio(void *audiop)
 		stream_len = audio->spec.size;
 	}
 
+	/* When the conversion never needs more room than the device buffer,
+	   the callback writes into that buffer and the audio is converted
+	   in place there, instead of being copied in afterwards.
+	 */
+	direct = 0;
+	if ( audio->convert.needed && !audio->resampler &&
+	     (audio->convert.len * audio->convert.len_mult <=
+	      (int)audio->spec.size) ) {
+		direct = 1;
+	}
+
+	/* The stream only needs clearing if the callback may leave some of it
+	   alone, which applications can promise it doesn't.
+	 */
+	clear = 1;
+	env = SDL_getenv("SDL_AUDIO_CALLBACK_FILLS");
+	if ( (env && SDL_atoi(env)) || audio->queue ) {
+		clear = 0;
+	}
+
 	/* Loop, filling the audio buffers */
 	while ( audio->enabled ) {
 
-		/* Fill the current buffer with sound */
-		if ( audio->convert.needed ) {
-			if ( audio->convert.buf ) {
-				stream = audio->convert.buf;
-			} else {
-				continue;
+		/* Run the callback at its own rate until there is enough
+		   resampled audio to fill the device buffer */
+		if ( audio->resampler ) {
+			stream = audio->convert.buf;
+			while ( SDL_ResamplerAvailable(audio->resampler) <
+			        (int)audio->spec.size ) {
+				paused = audio->paused;
+				if ( clear || paused ) {
+					SDL_memset(stream, silence, stream_len);
+				}
+
+				if ( ! paused ) {
+					SDL_mutexP(audio->mixer_lock);
+					(*fill)(udata, stream, stream_len);
+					SDL_mutexV(audio->mixer_lock);
+				}
+
+				len = stream_len;
+				if ( audio->convert.needed ) {
+					SDL_ConvertAudio(&audio->convert);
+					len = audio->convert.len_cvt;
+				}
+				if ( SDL_ResamplerPut(audio->resampler,
+				                      stream, len) < 0 ) {
+					break;
+				}
 			}
-		} else {
+
 			stream = audio->GetAudioBuf(audio);
 			if ( stream == NULL ) {
 				stream = audio->fake_stream;
 			}
-		}
+			len = SDL_ResamplerGet(audio->resampler,
+			                       stream, audio->spec.size);
+			SDL_memset(stream + len, audio->spec.silence,
+			           audio->spec.size - len);
+		} else {
+			/* Fill the current buffer with sound */
+			if ( audio->convert.needed && !direct ) {
+				if ( audio->convert.buf ) {
+					stream = audio->convert.buf;
+				} else {
+					continue;
+				}
+			} else {
+				stream = audio->GetAudioBuf(audio);
+				if ( stream == NULL ) {
+					stream = audio->fake_stream;
+				}
+			}
 
-		SDL_memset(stream, silence, stream_len);
+			paused = audio->paused;
+			if ( clear || paused ) {
+				SDL_memset(stream, silence, stream_len);
+			}
 
-		if ( ! audio->paused ) {
-			SDL_mutexP(audio->mixer_lock);
-			(*fill)(udata, stream, stream_len);
-			SDL_mutexV(audio->mixer_lock);
-		}
+			if ( ! paused ) {
+				SDL_mutexP(audio->mixer_lock);
+				(*fill)(udata, stream, stream_len);
+				SDL_mutexV(audio->mixer_lock);
+			}
 
-		/* Convert the audio if necessary */
-		if ( audio->convert.needed ) {
-			SDL_ConvertAudio(&audio->convert);
-			stream = audio->GetAudioBuf(audio);
-			if ( stream == NULL ) {
-				stream = audio->fake_stream;
+			/* Convert the audio if necessary */
+			if ( direct ) {
+				Uint8 *buf = audio->convert.buf;
+
+				audio->convert.buf = stream;
+				SDL_ConvertAudio(&audio->convert);
+				audio->convert.buf = buf;
+			} else if ( audio->convert.needed ) {
+				SDL_ConvertAudio(&audio->convert);
+				stream = audio->GetAudioBuf(audio);
+				if ( stream == NULL ) {
+					stream = audio->fake_stream;
+				}
+				SDL_memcpy(stream, audio->convert.buf,
+				               audio->convert.len_cvt);
 			}
-			SDL_memcpy(stream, audio->convert.buf,
-			               audio->convert.len_cvt);
 		}
 
 		/* Ready current buffer for play and change current buffer */
@@ -236,6 +310,10 @@ static Uint16 SDL_ParseAudioFormat(const char *string)
 		++string;
 		format |= 0x8000;
 		break;
+	    case 'F':
+		++string;
+		format |= 0x8100;
+		break;
 	    default:
 		return 0;
 	}
@@ -245,8 +323,9 @@ static Uint16 SDL_ParseAudioFormat(const char *string)
 		format |= 8;
 		break;
 	    case 16:
+	    case 32:
+		format |= SDL_atoi(string);
 		string += 2;
-		format |= 16;
 		if ( SDL_strcmp(string, "LSB") == 0
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
 		     || SDL_strcmp(string, "SYS") == 0
@@ -265,6 +344,13 @@ static Uint16 SDL_ParseAudioFormat(const char *string)
 	    default:
 		return 0;
 	}
+	/* There are only signed 32-bit integers, and only 32-bit floats */
+	if ( (format & 0x0100) && ((format & 0xFF) != 32) ) {
+		return 0;
+	}
+	if ( ((format & 0xFF) == 32) && !(format & 0x8000) ) {
+		return 0;
+	}
 	return format;
 }
 
@@ -356,6 +442,7 @@ int SDL_AudioInit(const char *driver_name)
 	current_audio = audio;
 	if ( current_audio ) {
 		current_audio->name = bootstrap[i]->name;
+		SDL_ResamplerInit();
 		if ( !current_audio->LockAudio && !current_audio->UnlockAudio ) {
 			current_audio->LockAudio = SDL_LockAudio_Default;
 			current_audio->UnlockAudio = SDL_UnlockAudio_Default;
@@ -377,6 +464,7 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 {
 	SDL_AudioDevice *audio;
 	const char *env;
+	int queued;
 
 	/* Start up the audio driver, if necessary */
 	if ( ! current_audio ) {
@@ -448,10 +536,8 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 		}
 		desired->samples = power2;
 	}
-	if ( desired->callback == NULL ) {
-		SDL_SetError("SDL_OpenAudio() passed a NULL callback");
-		return(-1);
-	}
+	/* The audio thread plays what's queued with SDL_QueueAudio() */
+	queued = (desired->callback == NULL);
 
 #if SDL_THREADS_DISABLED
 	/* Uses interrupt driven audio, without thread */
@@ -470,12 +556,29 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 
 	/* Open the audio subsystem */
 	SDL_memcpy(&audio->spec, desired, sizeof(audio->spec));
+	if ( queued ) {
+		audio->spec.callback = SDL_DrainAudioQueue;
+		audio->spec.userdata = NULL;
+	}
 	audio->convert.needed = 0;
 	audio->enabled = 1;
 	audio->paused  = 1;
 
 	audio->opened = audio->OpenAudio(audio, &audio->spec)+1;
 
+	/* Drivers which don't know the 32-bit formats get 16-bit audio,
+	   converted from the callback's format */
+	if ( ! audio->opened && ((desired->format & 0xFF) == 32) ) {
+		SDL_memcpy(&audio->spec, desired, sizeof(audio->spec));
+		if ( queued ) {
+			audio->spec.callback = SDL_DrainAudioQueue;
+			audio->spec.userdata = NULL;
+		}
+		audio->spec.format = AUDIO_S16SYS;
+		SDL_CalculateAudioSpec(&audio->spec);
+		audio->opened = audio->OpenAudio(audio, &audio->spec)+1;
+	}
+
 	if ( ! audio->opened ) {
 		SDL_CloseAudio();
 		return(-1);
@@ -497,22 +600,54 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 
 	/* See if we need to do any conversion */
 	if ( obtained != NULL ) {
+		void *userdata = desired->userdata;
+
 		SDL_memcpy(obtained, &audio->spec, sizeof(audio->spec));
+		/* The queue's callback is internal, hand back the caller's */
+		if ( queued ) {
+			obtained->callback = NULL;
+			obtained->userdata = userdata;
+		}
 	} else if ( desired->freq != audio->spec.freq ||
 		    desired->format != audio->spec.format ||
 		    desired->channels != audio->spec.channels ) {
+		int rate = audio->spec.freq;
+
+		/* The audio thread keeps its own resampler, so the rate
+		   conversion is continuous and fills every device buffer */
+		if ( (audio->opened == 1) && (desired->freq != rate) ) {
+			int up, down;
+
+			SDL_FindRateRatio((double)rate / desired->freq,
+			                  &up, &down);
+			if ( up != down ) {
+				audio->resampler = SDL_CreateResampler(
+					audio->spec.format, audio->spec.channels,
+					up, down, SDL_GetResampleQuality());
+				if ( audio->resampler == NULL ) {
+					SDL_CloseAudio();
+					return(-1);
+				}
+			}
+			rate = desired->freq;
+		}
+
 		/* Build an audio conversion block */
 		if ( SDL_BuildAudioCVT(&audio->convert,
 			desired->format, desired->channels,
 					desired->freq,
 			audio->spec.format, audio->spec.channels,
-					audio->spec.freq) < 0 ) {
+					rate) < 0 ) {
 			SDL_CloseAudio();
 			return(-1);
 		}
-		if ( audio->convert.needed ) {
+		if ( audio->convert.needed || audio->resampler ) {
+			int framesize = ((desired->format & 0xFF) / 8) *
+			                desired->channels;
+
 			audio->convert.len = (int) ( ((double) audio->spec.size) /
                                           audio->convert.len_ratio );
+			audio->convert.len -= audio->convert.len % framesize;
 			audio->convert.buf =(Uint8 *)SDL_AllocAudioMem(
 			   audio->convert.len*audio->convert.len_mult);
 			if ( audio->convert.buf == NULL ) {
@@ -523,6 +658,24 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 		}
 	}
 
+	/* Make room for a second of queued audio, and a few callbacks' worth,
+	   in the format the callback would have been given */
+	if ( queued ) {
+		const SDL_AudioSpec *spec = obtained ? &audio->spec : desired;
+		int framesize = ((spec->format & 0xFF) / 8) * spec->channels;
+		Uint32 size = spec->freq * framesize;
+
+		if ( size < spec->size * 4 ) {
+			size = spec->size * 4;
+		}
+		audio->queue = SDL_CreateAudioQueue(size, framesize,
+		                                    spec->silence);
+		if ( audio->queue == NULL ) {
+			SDL_CloseAudio();
+			return(-1);
+		}
+	}
+
 	/* Start the audio thread if necessary */
 	switch (audio->opened) {
 		case  1:
@@ -573,6 +726,16 @@ void SDL_PauseAudio (int pause_on)
 	}
 }
 
+int SDL_GetAudioLatency(void)
+{
+	SDL_AudioDevice *audio = current_audio;
+
+	if ( audio && audio->enabled && audio->GetLatency ) {
+		return audio->GetLatency(audio);
+	}
+	return(-1);
+}
+
 void SDL_LockAudio (void)
 {
 	SDL_AudioDevice *audio = current_audio;
@@ -613,9 +776,14 @@ void SDL_AudioQuit(void)
 		if ( audio->fake_stream != NULL ) {
 			SDL_FreeAudioMem(audio->fake_stream);
 		}
-		if ( audio->convert.needed ) {
+		if ( audio->convert.buf != NULL ) {
 			SDL_FreeAudioMem(audio->convert.buf);
-
+		}
+		if ( audio->resampler != NULL ) {
+			SDL_FreeResampler(audio->resampler);
+		}
+		if ( audio->queue != NULL ) {
+			SDL_FreeAudioQueue(audio->queue);
 		}
 		if ( audio->opened ) {
 			audio->CloseAudio(audio);
@@ -624,19 +792,34 @@ void SDL_AudioQuit(void)
 		/* Free the driver data */
 		audio->free(audio);
 		current_audio = NULL;
+		SDL_ResamplerQuit();
 	}
 }
 
-#define NUM_FORMATS	6
+#define NUM_FORMATS	10
 static int format_idx;
 static int format_idx_sub;
 static Uint16 format_list[NUM_FORMATS][NUM_FORMATS] = {
- { AUDIO_U8, AUDIO_S8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB },
- { AUDIO_S8, AUDIO_U8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB },
- { AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_U8, AUDIO_S8 },
- { AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_U8, AUDIO_S8 },
- { AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U8, AUDIO_S8 },
- { AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_U8, AUDIO_S8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB,
+   AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB },
+ { AUDIO_S8, AUDIO_U8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB,
+   AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB },
+ { AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_U8, AUDIO_S8,
+   AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB },
+ { AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_U8, AUDIO_S8,
+   AUDIO_S32MSB, AUDIO_S32LSB, AUDIO_F32MSB, AUDIO_F32LSB },
+ { AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U8, AUDIO_S8,
+   AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB },
+ { AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_U8, AUDIO_S8,
+   AUDIO_S32MSB, AUDIO_S32LSB, AUDIO_F32MSB, AUDIO_F32LSB },
+ { AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB, AUDIO_S16LSB,
+   AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_S32MSB, AUDIO_S32LSB, AUDIO_F32MSB, AUDIO_F32LSB, AUDIO_S16MSB,
+   AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_F32LSB, AUDIO_F32MSB, AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_S16LSB,
+   AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_F32MSB, AUDIO_F32LSB, AUDIO_S32MSB, AUDIO_S32LSB, AUDIO_S16MSB,
+   AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_U8, AUDIO_S8 },
 };
 
 Uint16 SDL_FirstAudioFormat(Uint16 format)
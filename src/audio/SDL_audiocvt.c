@@ -24,6 +24,8 @@
 /* Functions for audio drivers to perform runtime conversion of audio format */
 
 #include "SDL_audio.h"
+#include "SDL_resample_c.h"
+#include "SDL_audiotypecvt_c.h"
 
 
 /* Effectively mix right and left channels into a single channel */
@@ -35,7 +37,7 @@ void SDLCALL SDL_ConvertMono(SDL_AudioCVT *cvt, Uint16 format)
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting to mono\n");
 #endif
-	switch (format&0x8018) {
+	switch (format&0x8138) {
 
 		case AUDIO_U8: {
 			Uint8 *src, *dst;
@@ -126,6 +128,20 @@ void SDLCALL SDL_ConvertMono(SDL_AudioCVT *cvt, Uint16 format)
 			}
 		}
 		break;
+
+		/* Floats are always in native byte order by this point */
+		case AUDIO_F32: {
+			float *src, *dst;
+
+			src = (float *)cvt->buf;
+			dst = (float *)cvt->buf;
+			for ( i=cvt->len_cvt/8; i; --i ) {
+				*dst = (src[0] + src[1]) * 0.5f;
+				src += 2;
+				dst += 1;
+			}
+		}
+		break;
 	}
 	cvt->len_cvt /= 2;
 	if ( cvt->filters[++cvt->filter_index] ) {
@@ -142,7 +158,7 @@ void SDLCALL SDL_ConvertStrip(SDL_AudioCVT *cvt, Uint16 format)
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting down to stereo\n");
 #endif
-	switch (format&0x8018) {
+	switch (format&0x8138) {
 
 		case AUDIO_U8: {
 			Uint8 *src, *dst;
@@ -241,6 +257,20 @@ void SDLCALL SDL_ConvertStrip(SDL_AudioCVT *cvt, Uint16 format)
 			}
 		}
 		break;
+
+		case AUDIO_F32: {
+			float *src, *dst;
+
+			src = (float *)cvt->buf;
+			dst = (float *)cvt->buf;
+			for ( i=cvt->len_cvt/24; i; --i ) {
+				dst[0] = src[0];
+				dst[1] = src[1];
+				src += 6;
+				dst += 2;
+			}
+		}
+		break;
 	}
 	cvt->len_cvt /= 3;
 	if ( cvt->filters[++cvt->filter_index] ) {
@@ -258,7 +288,7 @@ void SDLCALL SDL_ConvertStrip_2(SDL_AudioCVT *cvt, Uint16 format)
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting 6 down to quad\n");
 #endif
-	switch (format&0x8018) {
+	switch (format&0x8138) {
 
 		case AUDIO_U8: {
 			Uint8 *src, *dst;
@@ -357,6 +387,20 @@ void SDLCALL SDL_ConvertStrip_2(SDL_AudioCVT *cvt, Uint16 format)
 			}
 		}
 		break;
+
+		case AUDIO_F32: {
+			float *src, *dst;
+
+			src = (float *)cvt->buf;
+			dst = (float *)cvt->buf;
+			for ( i=cvt->len_cvt/16; i; --i ) {
+				dst[0] = src[0];
+				dst[1] = src[1];
+				src += 4;
+				dst += 2;
+			}
+		}
+		break;
 	}
 	cvt->len_cvt /= 2;
 	if ( cvt->filters[++cvt->filter_index] ) {
@@ -372,7 +416,18 @@ void SDLCALL SDL_ConvertStereo(SDL_AudioCVT *cvt, Uint16 format)
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting to stereo\n");
 #endif
-	if ( (format & 0xFF) == 16 ) {
+	if ( (format & 0xFF) == 32 ) {
+		Uint32 *src, *dst;
+
+		src = (Uint32 *)(cvt->buf+cvt->len_cvt);
+		dst = (Uint32 *)(cvt->buf+cvt->len_cvt*2);
+		for ( i=cvt->len_cvt/4; i; --i ) {
+			dst -= 2;
+			src -= 1;
+			dst[0] = src[0];
+			dst[1] = src[0];
+		}
+	} else if ( (format & 0xFF) == 16 ) {
 		Uint16 *src, *dst;
 
 		src = (Uint16 *)(cvt->buf+cvt->len_cvt);
@@ -410,7 +465,7 @@ void SDLCALL SDL_ConvertSurround(SDL_AudioCVT *cvt, Uint16 format)
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting stereo to surround\n");
 #endif
-	switch (format&0x8018) {
+	switch (format&0x8138) {
 
 		case AUDIO_U8: {
 			Uint8 *src, *dst, lf, rf, ce;
@@ -571,6 +626,27 @@ void SDLCALL SDL_ConvertSurround(SDL_AudioCVT *cvt, Uint16 format)
 			}
 		}
 		break;
+
+		case AUDIO_F32: {
+			float *src, *dst, lf, rf, ce;
+
+			src = (float *)(cvt->buf+cvt->len_cvt);
+			dst = (float *)(cvt->buf+cvt->len_cvt*3);
+			for ( i=cvt->len_cvt/8; i; --i ) {
+				dst -= 6;
+				src -= 2;
+				lf = src[0];
+				rf = src[1];
+				ce = (lf + rf) * 0.5f;
+				dst[0] = lf;
+				dst[1] = rf;
+				dst[2] = rf - ce;
+				dst[3] = lf - ce;
+				dst[4] = ce;
+				dst[5] = ce;
+			}
+		}
+		break;
 	}
 	cvt->len_cvt *= 3;
 	if ( cvt->filters[++cvt->filter_index] ) {
@@ -587,7 +663,7 @@ void SDLCALL SDL_ConvertSurround_4(SDL_AudioCVT *cvt, Uint16 format)
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting stereo to quad\n");
 #endif
-	switch (format&0x8018) {
+	switch (format&0x8138) {
 
 		case AUDIO_U8: {
 			Uint8 *src, *dst, lf, rf, ce;
@@ -724,6 +800,25 @@ void SDLCALL SDL_ConvertSurround_4(SDL_AudioCVT *cvt, Uint16 format)
 			}
 		}
 		break;
+
+		case AUDIO_F32: {
+			float *src, *dst, lf, rf, ce;
+
+			src = (float *)(cvt->buf+cvt->len_cvt);
+			dst = (float *)(cvt->buf+cvt->len_cvt*2);
+			for ( i=cvt->len_cvt/8; i; --i ) {
+				dst -= 4;
+				src -= 2;
+				lf = src[0];
+				rf = src[1];
+				ce = (lf + rf) * 0.5f;
+				dst[0] = lf;
+				dst[1] = rf;
+				dst[2] = rf - ce;
+				dst[3] = lf - ce;
+			}
+		}
+		break;
 	}
 	cvt->len_cvt *= 2;
 	if ( cvt->filters[++cvt->filter_index] ) {
@@ -856,450 +951,331 @@ void SDLCALL SDL_ConvertEndian(SDL_AudioCVT *cvt, Uint16 format)
 	}
 }
 
-/* Convert rate up by multiple of 2 */
-void SDLCALL SDL_RateMUL2(SDL_AudioCVT *cvt, Uint16 format)
+/* Convert any format to native floats, which the filters after this one
+   work on when either end of the conversion is a 32-bit format.
+ */
+void SDLCALL SDL_ConvertToFloat(SDL_AudioCVT *cvt, Uint16 format)
 {
-	int i;
-	Uint8 *src, *dst;
+	int count;
 
 #ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * 2\n");
+	fprintf(stderr, "Converting to float\n");
 #endif
-	src = cvt->buf+cvt->len_cvt;
-	dst = cvt->buf+cvt->len_cvt*2;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt; i; --i ) {
-				src -= 1;
-				dst -= 2;
-				dst[0] = src[0];
-				dst[1] = src[0];
-			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/2; i; --i ) {
-				src -= 2;
-				dst -= 4;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[0];
-				dst[3] = src[1];
-			}
-			break;
-	}
-	cvt->len_cvt *= 2;
+	count = cvt->len_cvt / ((format & 0xFF) / 8);
+	SDL_ConvertSamplesToFloat(format, cvt->buf, (float *)cvt->buf, count);
+	format = AUDIO_F32SYS;
+	cvt->len_cvt = count * 4;
 	if ( cvt->filters[++cvt->filter_index] ) {
 		cvt->filters[cvt->filter_index](cvt, format);
 	}
 }
 
-
-/* Convert rate up by multiple of 2, for stereo */
-void SDLCALL SDL_RateMUL2_c2(SDL_AudioCVT *cvt, Uint16 format)
+/* Convert native floats to the destination format */
+void SDLCALL SDL_ConvertFromFloat(SDL_AudioCVT *cvt, Uint16 format)
 {
-	int i;
-	Uint8 *src, *dst;
+	int count;
 
 #ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * 2\n");
+	fprintf(stderr, "Converting from float\n");
 #endif
-	src = cvt->buf+cvt->len_cvt;
-	dst = cvt->buf+cvt->len_cvt*2;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/2; i; --i ) {
-				src -= 2;
-				dst -= 4;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[0];
-				dst[3] = src[1];
-			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/4; i; --i ) {
-				src -= 4;
-				dst -= 8;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[0];
-				dst[5] = src[1];
-				dst[6] = src[2];
-				dst[7] = src[3];
-			}
-			break;
-	}
-	cvt->len_cvt *= 2;
+	count = cvt->len_cvt / 4;
+	format = cvt->dst_format;
+	SDL_ConvertSamplesFromFloat(format, (float *)cvt->buf, cvt->buf, count);
+	cvt->len_cvt = count * ((format & 0xFF) / 8);
 	if ( cvt->filters[++cvt->filter_index] ) {
 		cvt->filters[cvt->filter_index](cvt, format);
 	}
 }
 
-/* Convert rate up by multiple of 2, for quad */
-void SDLCALL SDL_RateMUL2_c4(SDL_AudioCVT *cvt, Uint16 format)
+/* The fused conversion below works on this many frames at a time, which
+   keeps each piece of the buffer in the cache while all the steps run.
+ */
+#define CVT_BLOCK	1024
+
+/* Swap the bytes with shifts, which compilers can vectorize */
+#define SWAP16(x)	((Uint16)(((x) << 8) | ((x) >> 8)))
+
+/* Read 8-bit or 16-bit samples as 16-bit values, toggling the sign bit
+   with 'flip' when the signedness changes.
+ */
+static void SDL_ReadSamples16(Uint16 format, const Uint8 *src, Uint16 *dst,
+                              int count, Uint16 flip)
 {
+	const Uint16 *src16 = (const Uint16 *)src;
 	int i;
-	Uint8 *src, *dst;
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * 2\n");
-#endif
-	src = cvt->buf+cvt->len_cvt;
-	dst = cvt->buf+cvt->len_cvt*2;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/4; i; --i ) {
-				src -= 4;
-				dst -= 8;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[0];
-				dst[5] = src[1];
-				dst[6] = src[2];
-				dst[7] = src[3];
-			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/8; i; --i ) {
-				src -= 8;
-				dst -= 16;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				dst[6] = src[6];
-				dst[7] = src[7];
-				dst[8] = src[0];
-				dst[9] = src[1];
-				dst[10] = src[2];
-				dst[11] = src[3];
-				dst[12] = src[4];
-				dst[13] = src[5];
-				dst[14] = src[6];
-				dst[15] = src[7];
-			}
-			break;
-	}
-	cvt->len_cvt *= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+	if ( (format & 0xFF) == 8 ) {
+		for ( i = 0; i < count; ++i ) {
+			dst[i] = (Uint16)((src[i] << 8) ^ flip);
+		}
+	} else if ( (format & 0x1000) == (AUDIO_U16SYS & 0x1000) ) {
+		for ( i = 0; i < count; ++i ) {
+			dst[i] = src16[i] ^ flip;
+		}
+	} else {
+		for ( i = 0; i < count; ++i ) {
+			dst[i] = SWAP16(src16[i]) ^ flip;
+		}
 	}
 }
 
-
-/* Convert rate up by multiple of 2, for 5.1 */
-void SDLCALL SDL_RateMUL2_c6(SDL_AudioCVT *cvt, Uint16 format)
+/* Write 16-bit values as 8-bit or 16-bit samples, twice each if 'twice' */
+static void SDL_WriteSamples16(Uint16 format, const Uint16 *src, Uint8 *dst,
+                               int count, int twice)
 {
+	Uint16 *dst16 = (Uint16 *)dst;
+	Uint16 sample;
 	int i;
-	Uint8 *src, *dst;
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * 2\n");
-#endif
-	src = cvt->buf+cvt->len_cvt;
-	dst = cvt->buf+cvt->len_cvt*2;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/6; i; --i ) {
-				src -= 6;
-				dst -= 12;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				dst[6] = src[0];
-				dst[7] = src[1];
-				dst[8] = src[2];
-				dst[9] = src[3];
-				dst[10] = src[4];
-				dst[11] = src[5];
+	if ( (format & 0xFF) == 8 ) {
+		if ( twice ) {
+			for ( i = 0; i < count; ++i ) {
+				dst[i*2] = dst[i*2+1] = (Uint8)(src[i] >> 8);
 			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/12; i; --i ) {
-				src -= 12;
-				dst -= 24;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				dst[6] = src[6];
-				dst[7] = src[7];
-				dst[8] = src[8];
-				dst[9] = src[9];
-				dst[10] = src[10];
-				dst[11] = src[11];
-				dst[12] = src[0];
-				dst[13] = src[1];
-				dst[14] = src[2];
-				dst[15] = src[3];
-				dst[16] = src[4];
-				dst[17] = src[5];
-				dst[18] = src[6];
-				dst[19] = src[7];
-				dst[20] = src[8];
-				dst[21] = src[9];
-				dst[22] = src[10];
-				dst[23] = src[11];
+		} else {
+			for ( i = 0; i < count; ++i ) {
+				dst[i] = (Uint8)(src[i] >> 8);
 			}
-			break;
-	}
-	cvt->len_cvt *= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+		}
+	} else if ( (format & 0x1000) == (AUDIO_U16SYS & 0x1000) ) {
+		if ( twice ) {
+			for ( i = 0; i < count; ++i ) {
+				dst16[i*2] = dst16[i*2+1] = src[i];
+			}
+		} else {
+			for ( i = 0; i < count; ++i ) {
+				dst16[i] = src[i];
+			}
+		}
+	} else {
+		if ( twice ) {
+			for ( i = 0; i < count; ++i ) {
+				sample = SWAP16(src[i]);
+				dst16[i*2] = dst16[i*2+1] = sample;
+			}
+		} else {
+			for ( i = 0; i < count; ++i ) {
+				dst16[i] = SWAP16(src[i]);
+			}
+		}
 	}
 }
 
-/* Convert rate down by multiple of 2 */
-void SDLCALL SDL_RateDIV2(SDL_AudioCVT *cvt, Uint16 format)
+/* Average pairs of 16-bit values the way SDL_ConvertMono() would in
+   'format', which for 8-bit formats only sees the high bytes.
+ */
+static void SDL_MixPairs16(Uint16 format, Uint16 *data, int count)
 {
 	int i;
-	Uint8 *src, *dst;
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate / 2\n");
-#endif
-	src = cvt->buf;
-	dst = cvt->buf;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/2; i; --i ) {
-				dst[0] = src[0];
-				src += 2;
-				dst += 1;
+	switch (format&0x8018) {
+		case AUDIO_U8:
+			for ( i = 0; i < count; ++i ) {
+				data[i] = (Uint16)((((data[i*2] >> 8) +
+				                     (data[i*2+1] >> 8)) / 2) << 8);
 			}
 			break;
-		case 16:
-			for ( i=cvt->len_cvt/4; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				src += 4;
-				dst += 2;
+		case AUDIO_S8:
+			for ( i = 0; i < count; ++i ) {
+				data[i] = (Uint16)((Uint8)(((Sint8)(data[i*2] >> 8) +
+				          (Sint8)(data[i*2+1] >> 8)) / 2) << 8);
 			}
 			break;
-	}
-	cvt->len_cvt /= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
-	}
-}
-
-
-/* Convert rate down by multiple of 2, for stereo */
-void SDLCALL SDL_RateDIV2_c2(SDL_AudioCVT *cvt, Uint16 format)
-{
-	int i;
-	Uint8 *src, *dst;
-
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate / 2\n");
-#endif
-	src = cvt->buf;
-	dst = cvt->buf;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/4; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				src += 4;
-				dst += 2;
+		case AUDIO_U16:
+			for ( i = 0; i < count; ++i ) {
+				data[i] = (Uint16)((data[i*2] + data[i*2+1]) / 2);
 			}
 			break;
-		case 16:
-			for ( i=cvt->len_cvt/8; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				src += 8;
-				dst += 4;
+		case AUDIO_S16:
+			for ( i = 0; i < count; ++i ) {
+				data[i] = (Uint16)(((Sint16)data[i*2] +
+				                    (Sint16)data[i*2+1]) / 2);
 			}
 			break;
 	}
-	cvt->len_cvt /= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
-	}
 }
 
-
-/* Convert rate down by multiple of 2, for quad */
-void SDLCALL SDL_RateDIV2_c4(SDL_AudioCVT *cvt, Uint16 format)
+/* Convert between 8-bit and 16-bit formats and from mono to stereo or
+   back in one pass, doing what the endian, sign, 8/16-bit and channel
+   filters would do one after another.  The buffer is worked through a
+   block at a time, from the end when the data grows so that no block
+   overwrites data that hasn't been read yet.
+ */
+static void SDL_ConvertFormat(SDL_AudioCVT *cvt, Uint16 format,
+                              int src_channels, int dst_channels)
 {
-	int i;
-	Uint8 *src, *dst;
+	Uint16 block[CVT_BLOCK*2];	/* Room for stereo frames */
+	Uint16 dst_format;
+	Uint16 flip;
+	int src_size, dst_size, frames, start, count, i;
 
 #ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate / 2\n");
+	fprintf(stderr, "Converting format and channels %d -> %d\n",
+	        src_channels, dst_channels);
 #endif
-	src = cvt->buf;
-	dst = cvt->buf;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/8; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				src += 8;
-				dst += 4;
-			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/16; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				dst[6] = src[6];
-				dst[7] = src[7];
-				src += 16;
-				dst += 8;
-			}
-			break;
+	dst_format = cvt->dst_format;
+	flip = (Uint16)((format ^ dst_format) & 0x8000);
+	src_size = ((format & 0xFF) / 8) * src_channels;
+	dst_size = ((dst_format & 0xFF) / 8) * dst_channels;
+	frames = cvt->len_cvt / src_size;
+
+	for ( i = 0; i < frames; i += CVT_BLOCK ) {
+		if ( dst_size > src_size ) {
+			start = ((frames - 1) / CVT_BLOCK - i / CVT_BLOCK) * CVT_BLOCK;
+		} else {
+			start = i;
+		}
+		count = frames - start;
+		if ( count > CVT_BLOCK ) {
+			count = CVT_BLOCK;
+		}
+		SDL_ReadSamples16(format, cvt->buf + start * src_size, block,
+		                  count * src_channels, flip);
+		if ( src_channels > dst_channels ) {
+			SDL_MixPairs16(dst_format, block, count);
+		}
+		SDL_WriteSamples16(dst_format, block, cvt->buf + start * dst_size,
+		                   count, (src_channels < dst_channels));
 	}
-	cvt->len_cvt /= 2;
+	format = dst_format;
+	cvt->len_cvt = frames * dst_size;
 	if ( cvt->filters[++cvt->filter_index] ) {
 		cvt->filters[cvt->filter_index](cvt, format);
 	}
 }
 
-/* Convert rate down by multiple of 2, for 5.1 */
-void SDLCALL SDL_RateDIV2_c6(SDL_AudioCVT *cvt, Uint16 format)
+void SDLCALL SDL_ConvertFormat_c1(SDL_AudioCVT *cvt, Uint16 format)
 {
-	int i;
-	Uint8 *src, *dst;
+	SDL_ConvertFormat(cvt, format, 1, 1);
+}
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate / 2\n");
-#endif
-	src = cvt->buf;
-	dst = cvt->buf;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/12; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				src += 12;
-				dst += 6;
+void SDLCALL SDL_ConvertFormatStereo(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_ConvertFormat(cvt, format, 1, 2);
+}
+
+void SDLCALL SDL_ConvertFormatMono(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_ConvertFormat(cvt, format, 2, 1);
+}
+
+/* Convert the rate by picking the nearest input frame for each output
+   frame, like the old SDL_RateSLOW(), when there's no memory for a
+   resampler.  The output has the length SDL_BuildAudioCVT() expects.
+ */
+static void SDL_RateNearest(SDL_AudioCVT *cvt, int framesize,
+                            int frames, int total, int up, int down)
+{
+	Uint8 *buf = cvt->buf;
+	int i, pos;
+
+	/* Walk backwards when growing so no input is overwritten unread */
+	if ( up > down ) {
+		for ( i = total - 1; i >= 0; --i ) {
+			pos = (int)(((double)i * down) / up);
+			if ( pos != i ) {
+				SDL_memcpy(buf + i * framesize,
+				           buf + pos * framesize, framesize);
 			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/24; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-				dst[4] = src[4];
-				dst[5] = src[5];
-				dst[6] = src[6];
-				dst[7] = src[7];
-				dst[8] = src[8];
-				dst[9] = src[9];
-				dst[10] = src[10];
-				dst[11] = src[11];
-				src += 24;
-				dst += 12;
+		}
+	} else {
+		for ( i = 0; i < total; ++i ) {
+			pos = (int)(((double)i * down) / up);
+			if ( pos >= frames ) {
+				pos = frames - 1;
 			}
-			break;
-	}
-	cvt->len_cvt /= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+			if ( pos != i ) {
+				SDL_memcpy(buf + i * framesize,
+				           buf + pos * framesize, framesize);
+			}
+		}
 	}
+	cvt->len_cvt = total * framesize;
 }
 
-/* Very slow rate conversion routine */
-void SDLCALL SDL_RateSLOW(SDL_AudioCVT *cvt, Uint16 format)
+/* Convert the rate with a windowed-sinc filter, treating the buffer as one
+   complete piece of audio with silence before and after it.
+ */
+static void SDL_RateResample(SDL_AudioCVT *cvt, Uint16 format, int channels)
 {
-	double ipos;
-	int i, clen;
+	SDL_Resampler *resampler;
+	int up, down, framesize, frames, chunk, done, count, total, len;
 
 #ifdef DEBUG_CONVERT
 	fprintf(stderr, "Converting audio rate * %4.4f\n", 1.0/cvt->rate_incr);
 #endif
-	clen = (int)((double)cvt->len_cvt / cvt->rate_incr);
-	if ( cvt->rate_incr > 1.0 ) {
-		switch (format & 0xFF) {
-			case 8: {
-				Uint8 *output;
-
-				output = cvt->buf;
-				ipos = 0.0;
-				for ( i=clen; i; --i ) {
-					*output = cvt->buf[(int)ipos];
-					ipos += cvt->rate_incr;
-					output += 1;
-				}
-			}
-			break;
-
-			case 16: {
-				Uint16 *output;
-
-				clen &= ~1;
-				output = (Uint16 *)cvt->buf;
-				ipos = 0.0;
-				for ( i=clen/2; i; --i ) {
-					*output=((Uint16 *)cvt->buf)[(int)ipos];
-					ipos += cvt->rate_incr;
-					output += 1;
-				}
+	SDL_FindRateRatio(1.0 / cvt->rate_incr, &up, &down);
+	framesize = ((format & 0xFF) / 8) * channels;
+	frames = cvt->len_cvt / framesize;
+	total = 0;
+	if ( frames > 0 ) {
+		total = (int)(((double)frames * up - 1) / down) + 1;
+	}
+	resampler = SDL_CreateResampler(format, channels, up, down,
+	                                SDL_GetResampleQuality());
+	if ( resampler ) {
+		/* The output never overtakes the input when the rate goes
+		   down, so the buffer can be converted in place a piece at
+		   a time.  Otherwise all of it is read in first.
+		 */
+		chunk = (up > down) ? frames : 4096;
+		len = 0;
+		for ( done = 0; done < frames; done += count ) {
+			count = frames - done;
+			if ( count > chunk ) {
+				count = chunk;
 			}
-			break;
-		}
-	} else {
-		switch (format & 0xFF) {
-			case 8: {
-				Uint8 *output;
-
-				output = cvt->buf+clen;
-				ipos = (double)cvt->len_cvt;
-				for ( i=clen; i; --i ) {
-					ipos -= cvt->rate_incr;
-					output -= 1;
-					*output = cvt->buf[(int)ipos];
-				}
+			if ( SDL_ResamplerPut(resampler,
+			         cvt->buf + done * framesize,
+			         count * framesize) < 0 ) {
+				break;
 			}
-			break;
-
-			case 16: {
-				Uint16 *output;
-
-				clen &= ~1;
-				output = (Uint16 *)(cvt->buf+clen);
-				ipos = (double)cvt->len_cvt/2;
-				for ( i=clen/2; i; --i ) {
-					ipos -= cvt->rate_incr;
-					output -= 1;
-					*output=((Uint16 *)cvt->buf)[(int)ipos];
-				}
+			if ( (done + count == frames) &&
+			     (SDL_ResamplerFlush(resampler) < 0) ) {
+				break;
 			}
-			break;
+			len += SDL_ResamplerGet(resampler, cvt->buf + len,
+			                        total * framesize - len);
 		}
+		SDL_FreeResampler(resampler);
+		cvt->len_cvt = len;
+		if ( (done < frames) && (len > 0) ) {
+			/* Out of memory part way, and the start of the
+			   buffer is already converted */
+			SDL_SetError("Out of memory resampling audio");
+		} else if ( done < frames ) {
+			resampler = NULL;
+		}
+	}
+	if ( resampler == NULL ) {
+		SDL_SetError("Couldn't resample audio, using nearest frames");
+		SDL_RateNearest(cvt, framesize, frames, total, up, down);
 	}
-	cvt->len_cvt = clen;
 	if ( cvt->filters[++cvt->filter_index] ) {
 		cvt->filters[cvt->filter_index](cvt, format);
 	}
 }
 
+void SDLCALL SDL_RateResample_c1(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_RateResample(cvt, format, 1);
+}
+
+void SDLCALL SDL_RateResample_c2(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_RateResample(cvt, format, 2);
+}
+
+void SDLCALL SDL_RateResample_c4(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_RateResample(cvt, format, 4);
+}
+
+void SDLCALL SDL_RateResample_c6(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_RateResample(cvt, format, 6);
+}
+
 int SDL_ConvertAudio(SDL_AudioCVT *cvt)
 {
 	/* Make sure there's data to convert */
@@ -1319,6 +1295,74 @@ int SDL_ConvertAudio(SDL_AudioCVT *cvt)
 	return(0);
 }
 
+/* The formats SDL_ConvertSamplesToFloat() and back understand */
+static int SDL_FloatConvertible(Uint16 format)
+{
+	switch (format) {
+	    case AUDIO_U8:
+	    case AUDIO_S8:
+	    case AUDIO_U16LSB:
+	    case AUDIO_S16LSB:
+	    case AUDIO_U16MSB:
+	    case AUDIO_S16MSB:
+	    case AUDIO_S32LSB:
+	    case AUDIO_S32MSB:
+	    case AUDIO_F32LSB:
+	    case AUDIO_F32MSB:
+		return(1);
+	}
+	return(0);
+}
+
+/* The 8-bit and 16-bit formats the integer filters understand */
+static int SDL_IntegerFormat(Uint16 format)
+{
+	switch (format) {
+	    case AUDIO_U8:
+	    case AUDIO_S8:
+	    case AUDIO_U16LSB:
+	    case AUDIO_S16LSB:
+	    case AUDIO_U16MSB:
+	    case AUDIO_S16MSB:
+		return(1);
+	}
+	return(0);
+}
+
+/* Whether SDL_ConvertFormat() can replace two or more of the filters for
+   8-bit and 16-bit formats, changing the channels from mono to stereo or
+   back at most.
+ */
+static int SDL_FormatFusable(Uint16 src_format, int src_channels,
+                             Uint16 dst_format, int dst_channels)
+{
+	int steps;
+
+	if ( !SDL_IntegerFormat(src_format) || !SDL_IntegerFormat(dst_format) ) {
+		return(0);
+	}
+	if ( (src_channels != dst_channels) &&
+	     !((src_channels == 1) && (dst_channels == 2)) &&
+	     !((src_channels == 2) && (dst_channels == 1)) ) {
+		return(0);
+	}
+	steps = 0;
+	if ( ((src_format & 0x1000) != (dst_format & 0x1000)) &&
+	     ((src_format & 0xFF) == 16) && ((dst_format & 0xFF) == 16) ) {
+		++steps;
+	}
+	if ( (src_format & 0x8000) != (dst_format & 0x8000) ) {
+		++steps;
+	}
+	if ( (src_format & 0xFF) != (dst_format & 0xFF) ) {
+		++steps;
+	}
+	if ( src_channels != dst_channels ) {
+		++steps;
+	}
+	return(steps >= 2);
+}
+
 /* Creates a set of audio filters to convert from one format to another. 
    Returns -1 if the format conversion is not supported, or 1 if the
    audio filter is set up.
@@ -1328,6 +1372,8 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 	Uint16 src_format, Uint8 src_channels, int src_rate,
 	Uint16 dst_format, Uint8 dst_channels, int dst_rate)
 {
+	int use_float;
+
 /*printf("Build format %04x->%04x, channels %u->%u, rate %d->%d\n",
 		src_format, dst_format, src_channels, dst_channels, src_rate, dst_rate);*/
 	/* Start off with no conversion necessary */
@@ -1337,41 +1383,85 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 	cvt->len_mult = 1;
 	cvt->len_ratio = 1.0;
 
-	/* First filter:  Endian conversion from src to dst */
-	if ( (src_format & 0x1000) != (dst_format & 0x1000)
-	     && ((src_format & 0xff) == 16) && ((dst_format & 0xff) == 16)) {
-		cvt->filters[cvt->filter_index++] = SDL_ConvertEndian;
-	}
-	
-	/* Second filter: Sign conversion -- signed/unsigned */
-	if ( (src_format & 0x8000) != (dst_format & 0x8000) ) {
-		cvt->filters[cvt->filter_index++] = SDL_ConvertSign;
+	/* 32-bit formats are converted through native floats, so a float
+	   stream takes a single pass unless the channels or rate change too.
+	 */
+	use_float = 0;
+	if ( ((src_format & 0xFF) == 32) || ((dst_format & 0xFF) == 32) ) {
+		if ( (src_format != dst_format) ||
+		     (src_channels != dst_channels) ||
+		     (src_rate != dst_rate) ) {
+			use_float = 1;
+		}
 	}
+	if ( use_float ) {
+		if ( !SDL_FloatConvertible(src_format) ||
+		     !SDL_FloatConvertible(dst_format) ) {
+			SDL_SetError("Unsupported audio format");
+			return(-1);
+		}
+		if ( src_format != AUDIO_F32SYS ) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertToFloat;
+			cvt->len_mult *= 4 / ((src_format & 0xFF) / 8);
+			cvt->len_ratio *= 4.0 / ((src_format & 0xFF) / 8);
+		}
+	} else if ( SDL_FormatFusable(src_format, src_channels,
+	                              dst_format, dst_channels) ) {
+		/* One pass does the format and channel conversion */
+		if ( src_channels == dst_channels ) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertFormat_c1;
+		} else if ( src_channels < dst_channels ) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertFormatStereo;
+			cvt->len_mult *= 2;
+			cvt->len_ratio *= 2;
+		} else {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertFormatMono;
+			cvt->len_ratio /= 2;
+		}
+		if ( (src_format & 0xFF) < (dst_format & 0xFF) ) {
+			cvt->len_mult *= 2;
+			cvt->len_ratio *= 2;
+		} else if ( (src_format & 0xFF) > (dst_format & 0xFF) ) {
+			cvt->len_ratio /= 2;
+		}
+		src_channels = dst_channels;
+	} else {
+		/* First filter:  Endian conversion from src to dst */
+		if ( (src_format & 0x1000) != (dst_format & 0x1000)
+		     && ((src_format & 0xff) == 16) && ((dst_format & 0xff) == 16)) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertEndian;
+		}
 
-	/* Next filter:  Convert 16 bit <--> 8 bit PCM */
-	if ( (src_format & 0xFF) != (dst_format & 0xFF) ) {
-		switch (dst_format&0x10FF) {
-			case AUDIO_U8:
-				cvt->filters[cvt->filter_index++] =
-							 SDL_Convert8;
-				cvt->len_ratio /= 2;
-				break;
-			case AUDIO_U16LSB:
-				cvt->filters[cvt->filter_index++] =
-							SDL_Convert16LSB;
-				cvt->len_mult *= 2;
-				cvt->len_ratio *= 2;
-				break;
-			case AUDIO_U16MSB:
-				cvt->filters[cvt->filter_index++] =
-							SDL_Convert16MSB;
-				cvt->len_mult *= 2;
-				cvt->len_ratio *= 2;
-				break;
+		/* Second filter: Sign conversion -- signed/unsigned */
+		if ( (src_format & 0x8000) != (dst_format & 0x8000) ) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertSign;
+		}
+
+		/* Next filter:  Convert 16 bit <--> 8 bit PCM */
+		if ( (src_format & 0xFF) != (dst_format & 0xFF) ) {
+			switch (dst_format&0x10FF) {
+				case AUDIO_U8:
+					cvt->filters[cvt->filter_index++] =
+								 SDL_Convert8;
+					cvt->len_ratio /= 2;
+					break;
+				case AUDIO_U16LSB:
+					cvt->filters[cvt->filter_index++] =
+								SDL_Convert16LSB;
+					cvt->len_mult *= 2;
+					cvt->len_ratio *= 2;
+					break;
+				case AUDIO_U16MSB:
+					cvt->filters[cvt->filter_index++] =
+								SDL_Convert16MSB;
+					cvt->len_mult *= 2;
+					cvt->len_ratio *= 2;
+					break;
+			}
 		}
 	}
 
-	/* Last filter:  Mono/Stereo conversion */
+	/* Next filter:  Mono/Stereo conversion */
 	if ( src_channels != dst_channels ) {
 		if ( (src_channels == 1) && (dst_channels > 1) ) {
 			cvt->filters[cvt->filter_index++] = 
@@ -1435,68 +1525,36 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 
 	/* Do rate conversion */
 	cvt->rate_incr = 0.0;
-	if ( (src_rate/100) != (dst_rate/100) ) {
-		Uint32 hi_rate, lo_rate;
-		int len_mult;
-		double len_ratio;
+	if ( (src_rate != dst_rate) && (src_rate > 0) && (dst_rate > 0) ) {
+		int up, down;
 		void (SDLCALL *rate_cvt)(SDL_AudioCVT *cvt, Uint16 format);
 
-		if ( src_rate > dst_rate ) {
-			hi_rate = src_rate;
-			lo_rate = dst_rate;
-			switch (src_channels) {
-				case 1: rate_cvt = SDL_RateDIV2; break;
-				case 2: rate_cvt = SDL_RateDIV2_c2; break;
-				case 4: rate_cvt = SDL_RateDIV2_c4; break;
-				case 6: rate_cvt = SDL_RateDIV2_c6; break;
-				default: return -1;
-			}
-			len_mult = 1;
-			len_ratio = 0.5;
-		} else {
-			hi_rate = dst_rate;
-			lo_rate = src_rate;
-			switch (src_channels) {
-				case 1: rate_cvt = SDL_RateMUL2; break;
-				case 2: rate_cvt = SDL_RateMUL2_c2; break;
-				case 4: rate_cvt = SDL_RateMUL2_c4; break;
-				case 6: rate_cvt = SDL_RateMUL2_c6; break;
-				default: return -1;
-			}
-			len_mult = 2;
-			len_ratio = 2.0;
+		switch (src_channels) {
+			case 1: rate_cvt = SDL_RateResample_c1; break;
+			case 2: rate_cvt = SDL_RateResample_c2; break;
+			case 4: rate_cvt = SDL_RateResample_c4; break;
+			case 6: rate_cvt = SDL_RateResample_c6; break;
+			default: return -1;
 		}
-		/* If hi_rate = lo_rate*2^x then conversion is easy */
-		while ( ((lo_rate*2)/100) <= (hi_rate/100) ) {
+		/* The output isn't a power of two multiple of the input size
+		   any more, so buffers handed to the audio driver this way
+		   may not be full.  SDL_RunAudio() resamples separately.
+		 */
+		SDL_FindRateRatio((double)dst_rate / src_rate, &up, &down);
+		if ( up != down ) {
+			cvt->rate_incr = (double)down / up;
 			cvt->filters[cvt->filter_index++] = rate_cvt;
-			cvt->len_mult *= len_mult;
-			lo_rate *= 2;
-			cvt->len_ratio *= len_ratio;
-		}
-		/* We may need a slow conversion here to finish up */
-		if ( (lo_rate/100) != (hi_rate/100) ) {
-#if 1
-			/* The problem with this is that if the input buffer is
-			   say 1K, and the conversion rate is say 1.1, then the
-			   output buffer is 1.1K, which may not be an acceptable
-			   buffer size for the audio driver (not a power of 2)
-			*/
-			/* For now, punt and hope the rate distortion isn't great.
-			*/
-#else
-			if ( src_rate < dst_rate ) {
-				cvt->rate_incr = (double)lo_rate/hi_rate;
-				cvt->len_mult *= 2;
-				cvt->len_ratio /= cvt->rate_incr;
-			} else {
-				cvt->rate_incr = (double)hi_rate/lo_rate;
-				cvt->len_ratio *= cvt->rate_incr;
-			}
-			cvt->filters[cvt->filter_index++] = SDL_RateSLOW;
-#endif
+			cvt->len_mult *= (up + down - 1) / down;
+			cvt->len_ratio *= (double)up / down;
 		}
 	}
 
+	/* Last filter:  Float to the destination format */
+	if ( use_float && (dst_format != AUDIO_F32SYS) ) {
+		cvt->filters[cvt->filter_index++] = SDL_ConvertFromFloat;
+		cvt->len_ratio *= ((dst_format & 0xFF) / 8) / 4.0;
+	}
+
 	/* Set up the filter information */
 	if ( cvt->filter_index != 0 ) {
 		cvt->needed = 1;
@@ -0,0 +1,249 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Audio pushed with SDL_QueueAudio() instead of pulled by a callback
+
+   The queue is a ring buffer with one writer, the thread queueing audio,
+   and one reader, the audio thread, so neither ever waits for the other.
+   Each side only moves its own position, which it publishes after a
+   memory barrier so the other side sees the bytes it copied before the
+   new position.  The positions count bytes from the start and wrap
+   around at 2^32, so a power of two sized buffer can be indexed with a
+   mask.  Clearing the queue moves a third position, which the reader
+   skips up to the next time it runs.
+
+   Compilers without a known memory barrier get a mutex instead, which
+   is still separate from the lock around the audio callback.
+*/
+
+#include "SDL_audio.h"
+#include "SDL_mutex.h"
+#include "SDL_sysaudio.h"
+#include "SDL_audioqueue_c.h"
+
+#if defined(__GNUC__) && \
+    ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 1)))
+#define SDL_QueueBarrier()	__sync_synchronize()
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+/* x86 keeps stores and loads in order, so the compiler is all that moves */
+#define SDL_QueueBarrier()	_ReadWriteBarrier()
+#else
+#define SDL_QUEUE_LOCKED	1
+#define SDL_QueueBarrier()
+#endif
+
+struct SDL_AudioQueue {
+	Uint8 *buf;
+	Uint32 size;		/* A power of two */
+	int framesize;
+	Uint8 silence;
+
+	volatile Uint32 write;	/* Moved by the thread queueing audio */
+	volatile Uint32 read;	/* Moved by the audio thread */
+	volatile Uint32 flush;	/* Where the last clear left the writer */
+
+#if SDL_QUEUE_LOCKED
+	SDL_mutex *lock;
+#endif
+};
+
+#if SDL_QUEUE_LOCKED
+#define LockQueue(queue)	SDL_mutexP(queue->lock)
+#define UnlockQueue(queue)	SDL_mutexV(queue->lock)
+#else
+#define LockQueue(queue)
+#define UnlockQueue(queue)
+#endif
+
+SDL_AudioQueue *SDL_CreateAudioQueue(Uint32 size, int framesize,
+                                     Uint8 silence)
+{
+	SDL_AudioQueue *queue;
+
+	queue = (SDL_AudioQueue *)SDL_malloc(sizeof(*queue));
+	if ( queue == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_memset(queue, 0, sizeof(*queue));
+	queue->size = 1;
+	while ( queue->size < size ) {
+		queue->size *= 2;
+	}
+	queue->framesize = framesize;
+	queue->silence = silence;
+	queue->buf = (Uint8 *)SDL_malloc(queue->size);
+	if ( queue->buf == NULL ) {
+		SDL_FreeAudioQueue(queue);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+#if SDL_QUEUE_LOCKED
+	queue->lock = SDL_CreateMutex();
+	if ( queue->lock == NULL ) {
+		SDL_FreeAudioQueue(queue);
+		return(NULL);
+	}
+#endif
+	return(queue);
+}
+
+void SDL_FreeAudioQueue(SDL_AudioQueue *queue)
+{
+	if ( queue ) {
+#if SDL_QUEUE_LOCKED
+		if ( queue->lock ) {
+			SDL_DestroyMutex(queue->lock);
+		}
+#endif
+		SDL_free(queue->buf);
+		SDL_free(queue);
+	}
+}
+
+/* The position of the first byte still to be played */
+static Uint32 SDL_QueueStart(SDL_AudioQueue *queue)
+{
+	Uint32 read = queue->read;
+	Uint32 flush = queue->flush;
+
+	if ( (Sint32)(flush - read) > 0 ) {
+		read = flush;
+	}
+	return(read);
+}
+
+void SDLCALL SDL_DrainAudioQueue(void *userdata, Uint8 *stream, int len)
+{
+	SDL_AudioDevice *audio = current_audio;
+	SDL_AudioQueue *queue = audio->queue;
+	Uint32 read, pos, count, part;
+
+	count = 0;
+	if ( queue ) {
+		LockQueue(queue);
+		read = SDL_QueueStart(queue);
+		SDL_QueueBarrier();
+		count = queue->write - read;
+		SDL_QueueBarrier();
+		if ( (Sint32)count < 0 ) {
+			/* A clear was seen before the write it skips to */
+			count = 0;
+			read = queue->read;
+		}
+		if ( count > (Uint32)len ) {
+			count = len;
+		}
+		count -= count % queue->framesize;
+
+		pos = read & (queue->size - 1);
+		part = queue->size - pos;
+		if ( part > count ) {
+			part = count;
+		}
+		SDL_memcpy(stream, queue->buf + pos, part);
+		SDL_memcpy(stream + part, queue->buf, count - part);
+
+		/* Finish reading before the writer may reuse the space */
+		SDL_QueueBarrier();
+		queue->read = read + count;
+		UnlockQueue(queue);
+	}
+	if ( count < (Uint32)len ) {
+		SDL_memset(stream + count,
+		           queue ? queue->silence : audio->spec.silence,
+		           len - count);
+	}
+}
+
+int SDL_QueueAudio(const void *data, Uint32 len)
+{
+	SDL_AudioDevice *audio = current_audio;
+	SDL_AudioQueue *queue;
+	Uint32 write, pos, part;
+
+	if ( !audio || !audio->queue ) {
+		SDL_SetError("Audio device wasn't opened for queueing");
+		return(-1);
+	}
+	queue = audio->queue;
+
+	LockQueue(queue);
+	write = queue->write;
+	/* Don't write over what the reader may not have copied yet */
+	SDL_QueueBarrier();
+	if ( len > queue->size - (write - queue->read) ) {
+		UnlockQueue(queue);
+		SDL_SetError("Audio queue is full");
+		return(-1);
+	}
+
+	pos = write & (queue->size - 1);
+	part = queue->size - pos;
+	if ( part > len ) {
+		part = len;
+	}
+	SDL_memcpy(queue->buf + pos, data, part);
+	SDL_memcpy(queue->buf, (const Uint8 *)data + part, len - part);
+
+	/* Publish the audio before the new position */
+	SDL_QueueBarrier();
+	queue->write = write + len;
+	UnlockQueue(queue);
+	return(0);
+}
+
+Uint32 SDL_GetQueuedAudioSize(void)
+{
+	SDL_AudioDevice *audio = current_audio;
+	SDL_AudioQueue *queue;
+	Uint32 size;
+
+	if ( !audio || !audio->queue ) {
+		return(0);
+	}
+	queue = audio->queue;
+
+	LockQueue(queue);
+	size = queue->write - SDL_QueueStart(queue);
+	UnlockQueue(queue);
+	return(size);
+}
+
+void SDL_ClearQueuedAudio(void)
+{
+	SDL_AudioDevice *audio = current_audio;
+	SDL_AudioQueue *queue;
+
+	if ( !audio || !audio->queue ) {
+		return;
+	}
+	queue = audio->queue;
+
+	LockQueue(queue);
+	/* The reader must never see a flush past the write it came from */
+	SDL_QueueBarrier();
+	queue->flush = queue->write;
+	UnlockQueue(queue);
+}
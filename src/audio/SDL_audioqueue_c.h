@@ -0,0 +1,45 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* The ring buffer behind SDL_QueueAudio() */
+
+#ifndef _SDL_audioqueue_c_h
+#define _SDL_audioqueue_c_h
+
+#include "SDL_audio.h"
+
+typedef struct SDL_AudioQueue SDL_AudioQueue;
+
+/* Create a queue holding at least 'size' bytes of audio in sample frames
+   of 'framesize' bytes, played as 'silence' when it runs dry.
+ */
+extern SDL_AudioQueue *SDL_CreateAudioQueue(Uint32 size, int framesize,
+                                            Uint8 silence);
+extern void SDL_FreeAudioQueue(SDL_AudioQueue *queue);
+
+/* The callback SDL_OpenAudio() uses when it isn't given one, which plays
+   the queue of the current audio device.
+ */
+extern void SDLCALL SDL_DrainAudioQueue(void *userdata, Uint8 *stream, int len);
+
+#endif /* _SDL_audioqueue_c_h */
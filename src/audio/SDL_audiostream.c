@@ -0,0 +1,324 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Audio streams: conversion of audio arriving in pieces of any size
+
+   Source audio is converted a whole number of frames at a time with an
+   SDL_AudioCVT at the source rate, then goes through a resampler if the
+   rate changes.  The resampler keeps the frames its filter still needs,
+   and also holds the output until it is read.  Without a rate change the
+   converted audio waits in a ring buffer.  A partial source frame at the
+   end of a put is kept until the rest of it arrives.
+*/
+
+#include "SDL_audio.h"
+#include "SDL_resample_c.h"
+
+/* Source frames converted at a time */
+#define SDL_STREAM_CHUNK	1024
+
+struct SDL_AudioStream {
+	SDL_AudioCVT cvt;		/* Format and channels */
+	SDL_Resampler *resampler;	/* Rate, or NULL if unchanged */
+	int src_framesize;
+	int dst_framesize;
+
+	/* Room for converting one chunk in place */
+	Uint8 *work;
+
+	/* The start of a source frame cut off by the last put */
+	Uint8 *partial;
+	int partial_len;
+
+	/* Converted audio waiting to be read, without a resampler */
+	Uint8 *fifo;
+	int fifo_size;
+	int fifo_head;
+	int fifo_count;
+};
+
+SDL_AudioStream *SDL_NewAudioStream(Uint16 src_format, Uint8 src_channels,
+                                    int src_rate, Uint16 dst_format,
+                                    Uint8 dst_channels, int dst_rate)
+{
+	SDL_AudioStream *stream;
+	int up, down;
+
+	if ( (src_channels == 0) || (dst_channels == 0) ||
+	     (src_rate <= 0) || (dst_rate <= 0) ) {
+		SDL_SetError("Invalid audio stream parameters");
+		return(NULL);
+	}
+
+	stream = (SDL_AudioStream *)SDL_malloc(sizeof(*stream));
+	if ( stream == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_memset(stream, 0, sizeof(*stream));
+	stream->src_framesize = ((src_format & 0xFF) / 8) * src_channels;
+	stream->dst_framesize = ((dst_format & 0xFF) / 8) * dst_channels;
+
+	if ( SDL_BuildAudioCVT(&stream->cvt,
+	                       src_format, src_channels, src_rate,
+	                       dst_format, dst_channels, src_rate) < 0 ) {
+		SDL_SetError("Unsupported audio stream conversion");
+		SDL_FreeAudioStream(stream);
+		return(NULL);
+	}
+	/* SDL_BuildAudioCVT() quietly skips channel layouts it can't do */
+	if ( (int)(stream->cvt.len_ratio * stream->src_framesize + 0.5) !=
+	     stream->dst_framesize ) {
+		SDL_SetError("Unsupported audio stream conversion");
+		SDL_FreeAudioStream(stream);
+		return(NULL);
+	}
+
+	SDL_FindRateRatio((double)dst_rate / src_rate, &up, &down);
+	if ( up != down ) {
+		stream->resampler = SDL_CreateResampler(dst_format,
+		                    dst_channels, up, down,
+		                    SDL_GetResampleQuality());
+		if ( stream->resampler == NULL ) {
+			SDL_FreeAudioStream(stream);
+			return(NULL);
+		}
+	}
+
+	stream->work = (Uint8 *)SDL_malloc(SDL_STREAM_CHUNK *
+	               stream->src_framesize * stream->cvt.len_mult);
+	stream->partial = (Uint8 *)SDL_malloc(stream->src_framesize);
+	if ( (stream->work == NULL) || (stream->partial == NULL) ) {
+		SDL_FreeAudioStream(stream);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	return(stream);
+}
+
+/* Copy 'len' bytes out of the ring buffer, without removing them */
+static void SDL_AudioStreamPeek(SDL_AudioStream *stream, Uint8 *dst, int len)
+{
+	int n = stream->fifo_size - stream->fifo_head;
+
+	if ( n > len ) {
+		n = len;
+	}
+	SDL_memcpy(dst, stream->fifo + stream->fifo_head, n);
+	SDL_memcpy(dst + n, stream->fifo, len - n);
+}
+
+static int SDL_AudioStreamWrite(SDL_AudioStream *stream,
+                                const Uint8 *src, int len)
+{
+	Uint8 *fifo;
+	int size, tail, n;
+
+	if ( stream->fifo_count + len > stream->fifo_size ) {
+		size = stream->fifo_size ? stream->fifo_size : 4096;
+		while ( size < stream->fifo_count + len ) {
+			size *= 2;
+		}
+		fifo = (Uint8 *)SDL_malloc(size);
+		if ( fifo == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		if ( stream->fifo ) {
+			SDL_AudioStreamPeek(stream, fifo, stream->fifo_count);
+			SDL_free(stream->fifo);
+		}
+		stream->fifo = fifo;
+		stream->fifo_size = size;
+		stream->fifo_head = 0;
+	}
+
+	tail = stream->fifo_head + stream->fifo_count;
+	if ( tail >= stream->fifo_size ) {
+		tail -= stream->fifo_size;
+	}
+	n = stream->fifo_size - tail;
+	if ( n > len ) {
+		n = len;
+	}
+	SDL_memcpy(stream->fifo + tail, src, n);
+	SDL_memcpy(stream->fifo, src + n, len - n);
+	stream->fifo_count += len;
+	return(0);
+}
+
+/* Convert whole source frames and queue the result */
+static int SDL_AudioStreamConvert(SDL_AudioStream *stream,
+                                  const Uint8 *src, int len)
+{
+	if ( stream->cvt.needed ) {
+		SDL_memcpy(stream->work, src, len);
+		stream->cvt.buf = stream->work;
+		stream->cvt.len = len;
+		SDL_ConvertAudio(&stream->cvt);
+		src = stream->work;
+		len = stream->cvt.len_cvt;
+	}
+	if ( stream->resampler ) {
+		return SDL_ResamplerPut(stream->resampler, src, len);
+	}
+	return SDL_AudioStreamWrite(stream, src, len);
+}
+
+int SDL_AudioStreamPut(SDL_AudioStream *stream, const void *buf, int len)
+{
+	const Uint8 *src = (const Uint8 *)buf;
+	int framesize, n;
+
+	if ( stream == NULL ) {
+		SDL_SetError("Passed a NULL audio stream");
+		return(-1);
+	}
+	if ( (len < 0) || ((src == NULL) && (len > 0)) ) {
+		SDL_SetError("Invalid audio data");
+		return(-1);
+	}
+	framesize = stream->src_framesize;
+
+	/* Finish the frame left over from last time */
+	if ( stream->partial_len ) {
+		n = framesize - stream->partial_len;
+		if ( n > len ) {
+			n = len;
+		}
+		SDL_memcpy(stream->partial + stream->partial_len, src, n);
+		stream->partial_len += n;
+		src += n;
+		len -= n;
+		if ( stream->partial_len < framesize ) {
+			return(0);
+		}
+		stream->partial_len = 0;
+		if ( SDL_AudioStreamConvert(stream, stream->partial,
+		                            framesize) < 0 ) {
+			return(-1);
+		}
+	}
+
+	while ( len >= framesize ) {
+		n = len / framesize;
+		if ( n > SDL_STREAM_CHUNK ) {
+			n = SDL_STREAM_CHUNK;
+		}
+		n *= framesize;
+		if ( SDL_AudioStreamConvert(stream, src, n) < 0 ) {
+			return(-1);
+		}
+		src += n;
+		len -= n;
+	}
+
+	if ( len > 0 ) {
+		SDL_memcpy(stream->partial, src, len);
+		stream->partial_len = len;
+	}
+	return(0);
+}
+
+int SDL_AudioStreamGet(SDL_AudioStream *stream, void *buf, int len)
+{
+	if ( stream == NULL ) {
+		SDL_SetError("Passed a NULL audio stream");
+		return(-1);
+	}
+	if ( (len < 0) || ((len % stream->dst_framesize) != 0) ||
+	     ((buf == NULL) && (len > 0)) ) {
+		SDL_SetError("Can't read a partial sample frame");
+		return(-1);
+	}
+
+	if ( stream->resampler ) {
+		return SDL_ResamplerGet(stream->resampler, (Uint8 *)buf, len);
+	}
+	if ( len > stream->fifo_count ) {
+		len = stream->fifo_count;
+	}
+	if ( len > 0 ) {
+		SDL_AudioStreamPeek(stream, (Uint8 *)buf, len);
+		stream->fifo_head += len;
+		if ( stream->fifo_head >= stream->fifo_size ) {
+			stream->fifo_head -= stream->fifo_size;
+		}
+		stream->fifo_count -= len;
+	}
+	return(len);
+}
+
+int SDL_AudioStreamAvailable(SDL_AudioStream *stream)
+{
+	if ( stream == NULL ) {
+		return(0);
+	}
+	if ( stream->resampler ) {
+		return SDL_ResamplerAvailable(stream->resampler);
+	}
+	return(stream->fifo_count);
+}
+
+int SDL_AudioStreamFlush(SDL_AudioStream *stream)
+{
+	if ( stream == NULL ) {
+		SDL_SetError("Passed a NULL audio stream");
+		return(-1);
+	}
+	if ( stream->resampler ) {
+		return SDL_ResamplerFlush(stream->resampler);
+	}
+	return(0);
+}
+
+void SDL_AudioStreamClear(SDL_AudioStream *stream)
+{
+	if ( stream ) {
+		if ( stream->resampler ) {
+			SDL_ResamplerClear(stream->resampler);
+		}
+		stream->partial_len = 0;
+		stream->fifo_head = 0;
+		stream->fifo_count = 0;
+	}
+}
+
+void SDL_FreeAudioStream(SDL_AudioStream *stream)
+{
+	if ( stream ) {
+		if ( stream->resampler ) {
+			SDL_FreeResampler(stream->resampler);
+		}
+		if ( stream->work ) {
+			SDL_free(stream->work);
+		}
+		if ( stream->partial ) {
+			SDL_free(stream->partial);
+		}
+		if ( stream->fifo ) {
+			SDL_free(stream->fifo);
+		}
+		SDL_free(stream);
+	}
+}
@@ -0,0 +1,414 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Conversion between the integer sample formats and native floats.  The
+   common 16-bit and 32-bit native formats have SSE2 and NEON versions,
+   which give exactly the same results as the C loops.
+*/
+
+#include "SDL_audio.h"
+#include "SDL_audiotypecvt_c.h"
+
+#if SDL_ASSEMBLY_ROUTINES
+#  if (defined(__GNUC__) && defined(__SSE2__)) || \
+      (defined(_MSC_VER) && (defined(_M_X64) || (_M_IX86_FP >= 2)))
+#    define SSE2_TYPECVT 1
+#  endif
+#  if defined(__GNUC__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#    define NEON_TYPECVT 1
+#  endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
+
+/* Function to check the CPU flags */
+#include "SDL_cpuinfo.h"
+#if SSE2_TYPECVT
+#include <emmintrin.h>
+#endif
+#if NEON_TYPECVT
+#include <arm_neon.h>
+extern SDL_bool SDL_HasNEON(void);
+#endif
+
+#define S16_SCALE	32768.0f
+#define S32_SCALE	2147483648.0f
+
+/* The vector versions convert the input from the end, eight samples at a
+   time, and return the number of samples left over at the start.  The
+   other direction goes from the start and returns the number converted.
+ */
+#if SSE2_TYPECVT
+static int S16ToFloatSSE2(const Uint8 *src, float *dst, int count)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / S16_SCALE);
+	__m128i x;
+
+	while ( count >= 8 ) {
+		count -= 8;
+		x = _mm_loadu_si128((const __m128i *)(src + count * 2));
+		_mm_storeu_ps(dst + count + 4, _mm_mul_ps(scale, _mm_cvtepi32_ps(
+		        _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16))));
+		_mm_storeu_ps(dst + count, _mm_mul_ps(scale, _mm_cvtepi32_ps(
+		        _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16))));
+	}
+	return count;
+}
+
+static int S32ToFloatSSE2(const Uint8 *src, float *dst, int count)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / S32_SCALE);
+	__m128i x, y;
+
+	while ( count >= 8 ) {
+		count -= 8;
+		x = _mm_loadu_si128((const __m128i *)(src + count * 4));
+		y = _mm_loadu_si128((const __m128i *)(src + count * 4 + 16));
+		_mm_storeu_ps(dst + count, _mm_mul_ps(scale, _mm_cvtepi32_ps(x)));
+		_mm_storeu_ps(dst + count + 4,
+		              _mm_mul_ps(scale, _mm_cvtepi32_ps(y)));
+	}
+	return count;
+}
+
+/* Round half away from zero, like the C code, by adding 0.5 with the sign
+   of the sample and truncating.
+ */
+static __inline__ __m128i RoundSSE2(__m128 x)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	x = _mm_add_ps(x, _mm_or_ps(_mm_and_ps(x, sign), half));
+	return _mm_cvttps_epi32(x);
+}
+
+static int FloatToS16SSE2(const float *src, Uint8 *dst, int count)
+{
+	const __m128 scale = _mm_set1_ps(S16_SCALE);
+	const __m128 lo = _mm_set1_ps(-32768.0f);
+	const __m128 hi = _mm_set1_ps(32767.0f);
+	__m128 x, y;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		x = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+		y = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+		x = _mm_min_ps(_mm_max_ps(x, lo), hi);
+		y = _mm_min_ps(_mm_max_ps(y, lo), hi);
+		_mm_storeu_si128((__m128i *)(dst + i * 2),
+		                 _mm_packs_epi32(RoundSSE2(x), RoundSSE2(y)));
+	}
+	return i;
+}
+
+static int FloatToS32SSE2(const float *src, Uint8 *dst, int count)
+{
+	const __m128 scale = _mm_set1_ps(S32_SCALE);
+	const __m128 lo = _mm_set1_ps(-S32_SCALE);
+	__m128 x, y;
+	__m128i over;
+	int i;
+
+	/* Too large values convert to 0x80000000, which the comparison mask
+	   flips to 0x7FFFFFFF */
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		x = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+		y = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+		over = _mm_castps_si128(_mm_cmpge_ps(x, scale));
+		_mm_storeu_si128((__m128i *)(dst + i * 4), _mm_xor_si128(
+		                 RoundSSE2(_mm_max_ps(x, lo)), over));
+		over = _mm_castps_si128(_mm_cmpge_ps(y, scale));
+		_mm_storeu_si128((__m128i *)(dst + i * 4 + 16), _mm_xor_si128(
+		                 RoundSSE2(_mm_max_ps(y, lo)), over));
+	}
+	return i;
+}
+#endif /* SSE2_TYPECVT */
+
+#if NEON_TYPECVT
+static int S16ToFloatNEON(const Uint8 *src, float *dst, int count)
+{
+	int16x8_t x;
+
+	while ( count >= 8 ) {
+		count -= 8;
+		x = vld1q_s16((const int16_t *)(src + count * 2));
+		vst1q_f32(dst + count + 4, vmulq_n_f32(vcvtq_f32_s32(
+		          vmovl_s16(vget_high_s16(x))), 1.0f / S16_SCALE));
+		vst1q_f32(dst + count, vmulq_n_f32(vcvtq_f32_s32(
+		          vmovl_s16(vget_low_s16(x))), 1.0f / S16_SCALE));
+	}
+	return count;
+}
+
+static int S32ToFloatNEON(const Uint8 *src, float *dst, int count)
+{
+	int32x4_t x, y;
+
+	while ( count >= 8 ) {
+		count -= 8;
+		x = vld1q_s32((const int32_t *)(src + count * 4));
+		y = vld1q_s32((const int32_t *)(src + count * 4 + 16));
+		vst1q_f32(dst + count,
+		          vmulq_n_f32(vcvtq_f32_s32(x), 1.0f / S32_SCALE));
+		vst1q_f32(dst + count + 4,
+		          vmulq_n_f32(vcvtq_f32_s32(y), 1.0f / S32_SCALE));
+	}
+	return count;
+}
+
+/* Round half away from zero and truncate, saturating out of range values */
+static __inline__ int32x4_t RoundNEON(float32x4_t x)
+{
+	const uint32x4_t sign = vdupq_n_u32(0x80000000);
+	const uint32x4_t half = vreinterpretq_u32_f32(vdupq_n_f32(0.5f));
+
+	x = vaddq_f32(x, vreinterpretq_f32_u32(
+	        vorrq_u32(vandq_u32(vreinterpretq_u32_f32(x), sign), half)));
+	return vcvtq_s32_f32(x);
+}
+
+static int FloatToS16NEON(const float *src, Uint8 *dst, int count)
+{
+	const float32x4_t lo = vdupq_n_f32(-32768.0f);
+	const float32x4_t hi = vdupq_n_f32(32767.0f);
+	float32x4_t x, y;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		x = vmulq_n_f32(vld1q_f32(src + i), S16_SCALE);
+		y = vmulq_n_f32(vld1q_f32(src + i + 4), S16_SCALE);
+		x = vminq_f32(vmaxq_f32(x, lo), hi);
+		y = vminq_f32(vmaxq_f32(y, lo), hi);
+		vst1q_s16((int16_t *)(dst + i * 2),
+		          vcombine_s16(vqmovn_s32(RoundNEON(x)),
+		                       vqmovn_s32(RoundNEON(y))));
+	}
+	return i;
+}
+
+static int FloatToS32NEON(const float *src, Uint8 *dst, int count)
+{
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		vst1q_s32((int32_t *)(dst + i * 4), RoundNEON(
+		          vmulq_n_f32(vld1q_f32(src + i), S32_SCALE)));
+		vst1q_s32((int32_t *)(dst + i * 4 + 16), RoundNEON(
+		          vmulq_n_f32(vld1q_f32(src + i + 4), S32_SCALE)));
+	}
+	return i;
+}
+#endif /* NEON_TYPECVT */
+
+/* The C loops go backwards, so the wider output can overwrite the input */
+#define TO_FLOAT(value) \
+	while ( count-- ) { \
+		dst[count] = (value); \
+	}
+
+void SDL_ConvertSamplesToFloat(Uint16 format, const Uint8 *src,
+                               float *dst, int count)
+{
+	switch (format) {
+	    case AUDIO_U8:
+		TO_FLOAT((src[count] - 128) * (1.0f / 128.0f));
+		break;
+	    case AUDIO_S8:
+		TO_FLOAT((Sint8)src[count] * (1.0f / 128.0f));
+		break;
+	    case AUDIO_U16LSB:
+		TO_FLOAT((((src[2*count+1] << 8) | src[2*count]) - 32768) *
+		         (1.0f / S16_SCALE));
+		break;
+	    case AUDIO_S16LSB:
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#if SSE2_TYPECVT
+		if ( SDL_HasSSE2() ) {
+			count = S16ToFloatSSE2(src, dst, count);
+		}
+#endif
+#if NEON_TYPECVT
+		if ( SDL_HasNEON() ) {
+			count = S16ToFloatNEON(src, dst, count);
+		}
+#endif
+#endif
+		TO_FLOAT((Sint16)((src[2*count+1] << 8) | src[2*count]) *
+		         (1.0f / S16_SCALE));
+		break;
+	    case AUDIO_U16MSB:
+		TO_FLOAT((((src[2*count] << 8) | src[2*count+1]) - 32768) *
+		         (1.0f / S16_SCALE));
+		break;
+	    case AUDIO_S16MSB:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+#if NEON_TYPECVT
+		if ( SDL_HasNEON() ) {
+			count = S16ToFloatNEON(src, dst, count);
+		}
+#endif
+#endif
+		TO_FLOAT((Sint16)((src[2*count] << 8) | src[2*count+1]) *
+		         (1.0f / S16_SCALE));
+		break;
+	    case AUDIO_S32LSB:
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#if SSE2_TYPECVT
+		if ( SDL_HasSSE2() ) {
+			count = S32ToFloatSSE2(src, dst, count);
+		}
+#endif
+#if NEON_TYPECVT
+		if ( SDL_HasNEON() ) {
+			count = S32ToFloatNEON(src, dst, count);
+		}
+#endif
+#endif
+		TO_FLOAT((Sint32)SDL_AUDIO_GET32LSB(src + 4*count) *
+		         (1.0f / S32_SCALE));
+		break;
+	    case AUDIO_S32MSB:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+#if NEON_TYPECVT
+		if ( SDL_HasNEON() ) {
+			count = S32ToFloatNEON(src, dst, count);
+		}
+#endif
+#endif
+		TO_FLOAT((Sint32)SDL_AUDIO_GET32MSB(src + 4*count) *
+		         (1.0f / S32_SCALE));
+		break;
+	    case AUDIO_F32LSB:
+		TO_FLOAT(SDL_AudioBitsToFloat(
+		         SDL_AUDIO_GET32LSB(src + 4*count)));
+		break;
+	    case AUDIO_F32MSB:
+		TO_FLOAT(SDL_AudioBitsToFloat(
+		         SDL_AUDIO_GET32MSB(src + 4*count)));
+		break;
+	}
+}
+
+#define FROM_FLOAT(scale, lo, hi, store) \
+	for ( ; i < count; ++i ) { \
+		float x = src[i] * (scale); \
+		int v = SDL_AUDIO_ROUND(x, lo, hi); \
+		store; \
+	}
+
+void SDL_ConvertSamplesFromFloat(Uint16 format, const float *src,
+                                 Uint8 *dst, int count)
+{
+	int i = 0;
+
+	switch (format) {
+	    case AUDIO_U8:
+		FROM_FLOAT(128.0f, -128, 127,
+		           dst[i] = (Uint8)(v + 128));
+		break;
+	    case AUDIO_S8:
+		FROM_FLOAT(128.0f, -128, 127,
+		           dst[i] = (Uint8)v);
+		break;
+	    case AUDIO_U16LSB:
+		FROM_FLOAT(S16_SCALE, -32768, 32767,
+		           v += 32768;
+		           dst[2*i] = (Uint8)v;
+		           dst[2*i+1] = (Uint8)(v >> 8));
+		break;
+	    case AUDIO_S16LSB:
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#if SSE2_TYPECVT
+		if ( SDL_HasSSE2() ) {
+			i = FloatToS16SSE2(src, dst, count);
+		}
+#endif
+#if NEON_TYPECVT
+		if ( SDL_HasNEON() ) {
+			i = FloatToS16NEON(src, dst, count);
+		}
+#endif
+#endif
+		FROM_FLOAT(S16_SCALE, -32768, 32767,
+		           dst[2*i] = (Uint8)v;
+		           dst[2*i+1] = (Uint8)(v >> 8));
+		break;
+	    case AUDIO_U16MSB:
+		FROM_FLOAT(S16_SCALE, -32768, 32767,
+		           v += 32768;
+		           dst[2*i] = (Uint8)(v >> 8);
+		           dst[2*i+1] = (Uint8)v);
+		break;
+	    case AUDIO_S16MSB:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+#if NEON_TYPECVT
+		if ( SDL_HasNEON() ) {
+			i = FloatToS16NEON(src, dst, count);
+		}
+#endif
+#endif
+		FROM_FLOAT(S16_SCALE, -32768, 32767,
+		           dst[2*i] = (Uint8)(v >> 8);
+		           dst[2*i+1] = (Uint8)v);
+		break;
+	    case AUDIO_S32LSB:
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#if SSE2_TYPECVT
+		if ( SDL_HasSSE2() ) {
+			i = FloatToS32SSE2(src, dst, count);
+		}
+#endif
+#if NEON_TYPECVT
+		if ( SDL_HasNEON() ) {
+			i = FloatToS32NEON(src, dst, count);
+		}
+#endif
+#endif
+		FROM_FLOAT(S32_SCALE, (-2147483647-1), 2147483647,
+		           SDL_AUDIO_PUT32LSB(dst + 4*i, (Uint32)v));
+		break;
+	    case AUDIO_S32MSB:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+#if NEON_TYPECVT
+		if ( SDL_HasNEON() ) {
+			i = FloatToS32NEON(src, dst, count);
+		}
+#endif
+#endif
+		FROM_FLOAT(S32_SCALE, (-2147483647-1), 2147483647,
+		           SDL_AUDIO_PUT32MSB(dst + 4*i, (Uint32)v));
+		break;
+	    case AUDIO_F32LSB:
+		for ( ; i < count; ++i ) {
+			Uint32 v = SDL_AudioFloatToBits(src[i]);
+			SDL_AUDIO_PUT32LSB(dst + 4*i, v);
+		}
+		break;
+	    case AUDIO_F32MSB:
+		for ( ; i < count; ++i ) {
+			Uint32 v = SDL_AudioFloatToBits(src[i]);
+			SDL_AUDIO_PUT32MSB(dst + 4*i, v);
+		}
+		break;
+	}
+}
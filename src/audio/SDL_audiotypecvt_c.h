@@ -0,0 +1,83 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Conversion of whole buffers of samples to and from native floats */
+
+#ifndef _SDL_audiotypecvt_c_h
+#define _SDL_audiotypecvt_c_h
+
+#include "SDL_audio.h"
+
+/* Read and write 32-bit samples stored in either byte order */
+#define SDL_AUDIO_GET32LSB(p) \
+	((Uint32)(p)[0] | ((Uint32)(p)[1] << 8) | \
+	 ((Uint32)(p)[2] << 16) | ((Uint32)(p)[3] << 24))
+#define SDL_AUDIO_GET32MSB(p) \
+	((Uint32)(p)[3] | ((Uint32)(p)[2] << 8) | \
+	 ((Uint32)(p)[1] << 16) | ((Uint32)(p)[0] << 24))
+#define SDL_AUDIO_PUT32LSB(p, v) \
+	((p)[0] = (Uint8)(v), (p)[1] = (Uint8)((v) >> 8), \
+	 (p)[2] = (Uint8)((v) >> 16), (p)[3] = (Uint8)((v) >> 24))
+#define SDL_AUDIO_PUT32MSB(p, v) \
+	((p)[3] = (Uint8)(v), (p)[2] = (Uint8)((v) >> 8), \
+	 (p)[1] = (Uint8)((v) >> 16), (p)[0] = (Uint8)((v) >> 24))
+
+/* Reinterpret the bits of a float sample */
+typedef union {
+	float f;
+	Uint32 u;
+} SDL_AudioFloatBits;
+
+static __inline__ float SDL_AudioBitsToFloat(Uint32 u)
+{
+	SDL_AudioFloatBits bits;
+	bits.u = u;
+	return bits.f;
+}
+
+static __inline__ Uint32 SDL_AudioFloatToBits(float f)
+{
+	SDL_AudioFloatBits bits;
+	bits.f = f;
+	return bits.u;
+}
+
+/* Clip and round a sample scaled to the output range, halves away from 0 */
+#define SDL_AUDIO_ROUND(x, lo, hi) \
+	((x) <= (float)(lo) ? (lo) : (x) >= (float)(hi) ? (hi) : \
+	 (x) < 0.0f ? (int)((x) - 0.5f) : (int)((x) + 0.5f))
+
+/* Convert 'count' samples in 'format' to floats from -1.0 to 1.0.  The
+   output may overwrite the input if both start at the same address.
+ */
+extern void SDL_ConvertSamplesToFloat(Uint16 format, const Uint8 *src,
+                                      float *dst, int count);
+
+/* Convert 'count' floats to samples in 'format', clipping and rounding
+   them.  The output may overwrite the input if both start at the same
+   address.
+ */
+extern void SDL_ConvertSamplesFromFloat(Uint16 format, const float *src,
+                                        Uint8 *dst, int count);
+
+#endif /* _SDL_audiotypecvt_c_h */
@@ -27,9 +27,11 @@
 #include "SDL_timer.h"
 #include "SDL_audio.h"
 #include "SDL_sysaudio.h"
+#include "SDL_audiotypecvt_c.h"
 #include "SDL_mixer_MMX.h"
 #include "SDL_mixer_MMX_VC.h"
 #include "SDL_mixer_m68k.h"
+#include "SDL_mixer_SIMD.h"
 
 /* This table is used to add two sound values together and pin
  * the value to avoid overflow.  (used with permission from ARDI)
@@ -90,6 +92,27 @@ static const Uint8 mix8[] =
 #define ADJUST_VOLUME(s, v)	(s = (s*v)/SDL_MIX_MAXVOLUME)
 #define ADJUST_VOLUME_U8(s, v)	(s = (((s-128)*v)/SDL_MIX_MAXVOLUME)+128)
 
+/* Mix as much as possible with a vector version, leaving the rest */
+#if SSE2_MIXER
+#define MIX_SIMD(type) \
+	if ( (volume > 0) && (volume <= SDL_MIX_MAXVOLUME) && SDL_HasSSE2() ) { \
+		Uint32 done = SDL_MixAudio_SSE2_##type(dst, src, len, volume); \
+		dst += done; \
+		src += done; \
+		len -= done; \
+	}
+#elif NEON_MIXER
+#define MIX_SIMD(type) \
+	if ( (volume > 0) && (volume <= SDL_MIX_MAXVOLUME) && SDL_HasNEON() ) { \
+		Uint32 done = SDL_MixAudio_NEON_##type(dst, src, len, volume); \
+		dst += done; \
+		src += done; \
+		len -= done; \
+	}
+#else
+#define MIX_SIMD(type)
+#endif
+
 void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 {
 	Uint16 format;
@@ -116,6 +139,7 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 #else
 			Uint8 src_sample;
 
+			MIX_SIMD(U8)
 			while ( len-- ) {
 				src_sample = *src;
 				ADJUST_VOLUME_U8(src_sample, volume);
@@ -154,6 +178,7 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 			const int max_audioval = ((1<<(8-1))-1);
 			const int min_audioval = -(1<<(8-1));
 
+			MIX_SIMD(S8)
 			src8 = (Sint8 *)src;
 			dst8 = (Sint8 *)dst;
 			while ( len-- ) {
@@ -202,6 +227,11 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 			const int max_audioval = ((1<<(16-1))-1);
 			const int min_audioval = -(1<<(16-1));
 
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+			MIX_SIMD(S16)
+#else
+			MIX_SIMD(S16Swap)
+#endif
 			len /= 2;
 			while ( len-- ) {
 				src1 = ((src[1])<<8|src[0]);
@@ -234,6 +264,11 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 			const int max_audioval = ((1<<(16-1))-1);
 			const int min_audioval = -(1<<(16-1));
 
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+			MIX_SIMD(S16)
+#else
+			MIX_SIMD(S16Swap)
+#endif
 			len /= 2;
 			while ( len-- ) {
 				src1 = ((src[0])<<8|src[1]);
@@ -256,9 +291,498 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 		}
 		break;
 
+		case AUDIO_S32LSB:
+		case AUDIO_S32MSB: {
+			double src1, src2, dst_sample;
+			const double max_audioval = 2147483647.0;
+			const double min_audioval = -2147483648.0;
+			Uint32 sample;
+
+			/* Doubles hold the scaled and summed samples exactly */
+			len /= 4;
+			while ( len-- ) {
+				if ( format == AUDIO_S32LSB ) {
+					src1 = (Sint32)SDL_AUDIO_GET32LSB(src);
+					src2 = (Sint32)SDL_AUDIO_GET32LSB(dst);
+				} else {
+					src1 = (Sint32)SDL_AUDIO_GET32MSB(src);
+					src2 = (Sint32)SDL_AUDIO_GET32MSB(dst);
+				}
+				src += 4;
+				src1 = (Sint32)(src1 * volume / SDL_MIX_MAXVOLUME);
+				dst_sample = src1+src2;
+				if ( dst_sample > max_audioval ) {
+					dst_sample = max_audioval;
+				} else
+				if ( dst_sample < min_audioval ) {
+					dst_sample = min_audioval;
+				}
+				sample = (Uint32)(Sint32)dst_sample;
+				if ( format == AUDIO_S32LSB ) {
+					SDL_AUDIO_PUT32LSB(dst, sample);
+				} else {
+					SDL_AUDIO_PUT32MSB(dst, sample);
+				}
+				dst += 4;
+			}
+		}
+		break;
+
+		case AUDIO_F32LSB:
+		case AUDIO_F32MSB: {
+			float src1, src2, dst_sample;
+			const float fvolume = (float)volume / SDL_MIX_MAXVOLUME;
+			const float max_audioval = 1.0f;
+			const float min_audioval = -1.0f;
+			Uint32 sample;
+
+			len /= 4;
+			while ( len-- ) {
+				if ( format == AUDIO_F32LSB ) {
+					src1 = SDL_AudioBitsToFloat(SDL_AUDIO_GET32LSB(src));
+					src2 = SDL_AudioBitsToFloat(SDL_AUDIO_GET32LSB(dst));
+				} else {
+					src1 = SDL_AudioBitsToFloat(SDL_AUDIO_GET32MSB(src));
+					src2 = SDL_AudioBitsToFloat(SDL_AUDIO_GET32MSB(dst));
+				}
+				src += 4;
+				dst_sample = src1*fvolume + src2;
+				if ( dst_sample > max_audioval ) {
+					dst_sample = max_audioval;
+				} else
+				if ( dst_sample < min_audioval ) {
+					dst_sample = min_audioval;
+				}
+				sample = SDL_AudioFloatToBits(dst_sample);
+				if ( format == AUDIO_F32LSB ) {
+					SDL_AUDIO_PUT32LSB(dst, sample);
+				} else {
+					SDL_AUDIO_PUT32MSB(dst, sample);
+				}
+				dst += 4;
+			}
+		}
+		break;
+
 		default: /* If this happens... FIXME! */
 			SDL_SetError("SDL_MixAudio(): unknown audio format");
 			return;
 	}
 }
 
+
+/* SDL_MixAudioMulti() sums this many samples of all the voices at a time,
+   few enough that the sums stay in the cache, and an even number so the
+   left and right channels stay put from one block to the next.
+*/
+#define MIX_BLOCK	512
+
+#if SSE2_MIXER
+#define MIX_HAS_SIMD()	SDL_HasSSE2()
+#define MIX_ACCUMULATE(type, sums) \
+	if ( simd ) { \
+		i = SDL_MixAccumulate_SSE2_##type(sums, src, vol, num, count); \
+	}
+#define MIX_LOAD(type, sums) \
+	if ( simd ) { \
+		i = SDL_MixLoad_SSE2_##type(sums, dst, count); \
+	}
+#define MIX_CLIP(type, sums) \
+	if ( simd ) { \
+		i = SDL_MixClip_SSE2_##type(sums, dst, count); \
+	}
+#elif NEON_MIXER
+#define MIX_HAS_SIMD()	SDL_HasNEON()
+#define MIX_ACCUMULATE(type, sums) \
+	if ( simd ) { \
+		i = SDL_MixAccumulate_NEON_##type(sums, src, vol, num, count); \
+	}
+#define MIX_LOAD(type, sums) \
+	if ( simd ) { \
+		i = SDL_MixLoad_NEON_##type(sums, dst, count); \
+	}
+#define MIX_CLIP(type, sums) \
+	if ( simd ) { \
+		i = SDL_MixClip_NEON_##type(sums, dst, count); \
+	}
+#else
+#define MIX_HAS_SIMD()	SDL_FALSE
+#define MIX_ACCUMULATE(type, sums)
+#define MIX_LOAD(type, sums)
+#define MIX_CLIP(type, sums)
+#endif
+
+typedef union {
+	Sint32 i[MIX_BLOCK];	/* 8-bit and 16-bit samples */
+	float f[MIX_BLOCK];	/* 32-bit float samples */
+	double d[MIX_BLOCK];	/* 32-bit integer samples */
+} MixSums;
+
+static void MixLoad(Uint16 format, MixSums *sums, const Uint8 *dst,
+                    int count, SDL_bool simd)
+{
+	int i = 0;
+
+	switch (format) {
+		case AUDIO_U8:
+			for ( ; i < count; ++i ) {
+				sums->i[i] = dst[i];
+			}
+			break;
+		case AUDIO_S8:
+			for ( ; i < count; ++i ) {
+				sums->i[i] = (Sint8)dst[i];
+			}
+			break;
+		case AUDIO_S16LSB:
+		case AUDIO_S16MSB:
+			if ( format == AUDIO_S16SYS ) {
+				MIX_LOAD(S16, sums->i)
+			}
+			for ( dst += i * 2; i < count; ++i, dst += 2 ) {
+				if ( format == AUDIO_S16LSB ) {
+					sums->i[i] = (Sint16)((dst[1]<<8)|dst[0]);
+				} else {
+					sums->i[i] = (Sint16)((dst[0]<<8)|dst[1]);
+				}
+			}
+			break;
+		case AUDIO_S32LSB:
+			for ( ; i < count; ++i, dst += 4 ) {
+				sums->d[i] = (Sint32)SDL_AUDIO_GET32LSB(dst);
+			}
+			break;
+		case AUDIO_S32MSB:
+			for ( ; i < count; ++i, dst += 4 ) {
+				sums->d[i] = (Sint32)SDL_AUDIO_GET32MSB(dst);
+			}
+			break;
+		case AUDIO_F32LSB:
+		case AUDIO_F32MSB:
+			if ( format == AUDIO_F32SYS ) {
+				MIX_LOAD(F32, sums->f)
+			}
+			for ( dst += i * 4; i < count; ++i, dst += 4 ) {
+				if ( format == AUDIO_F32LSB ) {
+					sums->f[i] = SDL_AudioBitsToFloat(SDL_AUDIO_GET32LSB(dst));
+				} else {
+					sums->f[i] = SDL_AudioBitsToFloat(SDL_AUDIO_GET32MSB(dst));
+				}
+			}
+			break;
+	}
+}
+
+/* Add samples from 'src' up to 'count', scaled like SDL_MixAudio() does,
+   using 'lvol' for the even (left) samples and 'rvol' for the odd (right)
+   ones, starting at sample 'i'.
+*/
+static void MixVoice(Uint16 format, MixSums *sums, const Uint8 *src,
+                     int i, int count, int lvol, int rvol)
+{
+	Sint32 sample;
+
+	switch (format) {
+		case AUDIO_U8:
+			for ( ; i < count; ++i ) {
+				sample = src[i] - 128;
+				sums->i[i] += (sample * ((i&1) ? rvol : lvol)) / SDL_MIX_MAXVOLUME;
+			}
+			break;
+		case AUDIO_S8:
+			for ( ; i < count; ++i ) {
+				sample = (Sint8)src[i];
+				sums->i[i] += (sample * ((i&1) ? rvol : lvol)) / SDL_MIX_MAXVOLUME;
+			}
+			break;
+		case AUDIO_S16LSB:
+			for ( ; i < count; ++i ) {
+				sample = (Sint16)((src[i*2+1]<<8)|src[i*2]);
+				sums->i[i] += (sample * ((i&1) ? rvol : lvol)) / SDL_MIX_MAXVOLUME;
+			}
+			break;
+		case AUDIO_S16MSB:
+			for ( ; i < count; ++i ) {
+				sample = (Sint16)((src[i*2]<<8)|src[i*2+1]);
+				sums->i[i] += (sample * ((i&1) ? rvol : lvol)) / SDL_MIX_MAXVOLUME;
+			}
+			break;
+		case AUDIO_S32LSB:
+		case AUDIO_S32MSB: {
+			double value;
+
+			for ( src += i * 4; i < count; ++i, src += 4 ) {
+				if ( format == AUDIO_S32LSB ) {
+					value = (Sint32)SDL_AUDIO_GET32LSB(src);
+				} else {
+					value = (Sint32)SDL_AUDIO_GET32MSB(src);
+				}
+				sums->d[i] += (Sint32)(value * ((i&1) ? rvol : lvol) / SDL_MIX_MAXVOLUME);
+			}
+		}
+		break;
+		case AUDIO_F32LSB:
+		case AUDIO_F32MSB: {
+			const float lvolume = (float)lvol / SDL_MIX_MAXVOLUME;
+			const float rvolume = (float)rvol / SDL_MIX_MAXVOLUME;
+			float value;
+
+			for ( src += i * 4; i < count; ++i, src += 4 ) {
+				if ( format == AUDIO_F32LSB ) {
+					value = SDL_AudioBitsToFloat(SDL_AUDIO_GET32LSB(src));
+				} else {
+					value = SDL_AudioBitsToFloat(SDL_AUDIO_GET32MSB(src));
+				}
+				sums->f[i] += value * ((i&1) ? rvolume : lvolume);
+			}
+		}
+		break;
+	}
+}
+
+/* Add 'count' samples of up to MIX_SIMD_VOICES sources, with their left
+   and right volumes in 'vol', adding all of them at once to each vector
+   of sums before going on to the next.
+*/
+static void MixAccumulate(Uint16 format, MixSums *sums, const Uint8 **src,
+                          const int *vol, int num, int count, SDL_bool simd)
+{
+	int i = 0;
+	int k;
+
+	switch (format) {
+		case AUDIO_U8:
+			MIX_ACCUMULATE(U8, sums->i)
+			break;
+		case AUDIO_S8:
+			MIX_ACCUMULATE(S8, sums->i)
+			break;
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+		case AUDIO_S16LSB:
+			MIX_ACCUMULATE(S16, sums->i)
+			break;
+		case AUDIO_S16MSB:
+			MIX_ACCUMULATE(S16Swap, sums->i)
+			break;
+		case AUDIO_F32LSB:
+			MIX_ACCUMULATE(F32, sums->f)
+			break;
+#else
+		case AUDIO_S16LSB:
+			MIX_ACCUMULATE(S16Swap, sums->i)
+			break;
+		case AUDIO_S16MSB:
+			MIX_ACCUMULATE(S16, sums->i)
+			break;
+		case AUDIO_F32MSB:
+			MIX_ACCUMULATE(F32, sums->f)
+			break;
+#endif
+	}
+	for ( k = 0; k < num; ++k ) {
+		MixVoice(format, sums, src[k], i, count, vol[k*2], vol[k*2+1]);
+	}
+}
+
+/* Clip the sums to the range of the format and store them in 'dst' */
+static void MixStore(Uint16 format, const MixSums *sums, Uint8 *dst,
+                     int count, SDL_bool simd)
+{
+	int i = 0;
+
+	switch (format) {
+		case AUDIO_U8: {
+			Sint32 sample;
+
+			for ( ; i < count; ++i ) {
+				sample = sums->i[i];
+				if ( sample > 0xFE ) {
+					sample = 0xFE;
+				} else
+				if ( sample < 0 ) {
+					sample = 0;
+				}
+				dst[i] = (Uint8)sample;
+			}
+		}
+		break;
+		case AUDIO_S8: {
+			Sint32 sample;
+
+			for ( ; i < count; ++i ) {
+				sample = sums->i[i];
+				if ( sample > 127 ) {
+					sample = 127;
+				} else
+				if ( sample < -128 ) {
+					sample = -128;
+				}
+				dst[i] = (Uint8)sample;
+			}
+		}
+		break;
+		case AUDIO_S16LSB:
+		case AUDIO_S16MSB: {
+			Sint32 sample;
+
+			if ( format == AUDIO_S16SYS ) {
+				MIX_CLIP(S16, sums->i)
+				dst += i * 2;
+			}
+			for ( ; i < count; ++i, dst += 2 ) {
+				sample = sums->i[i];
+				if ( sample > 32767 ) {
+					sample = 32767;
+				} else
+				if ( sample < -32768 ) {
+					sample = -32768;
+				}
+				if ( format == AUDIO_S16LSB ) {
+					dst[0] = sample&0xFF;
+					dst[1] = (sample>>8)&0xFF;
+				} else {
+					dst[0] = (sample>>8)&0xFF;
+					dst[1] = sample&0xFF;
+				}
+			}
+		}
+		break;
+		case AUDIO_S32LSB:
+		case AUDIO_S32MSB: {
+			double sample;
+			Uint32 value;
+
+			for ( ; i < count; ++i, dst += 4 ) {
+				sample = sums->d[i];
+				if ( sample > 2147483647.0 ) {
+					sample = 2147483647.0;
+				} else
+				if ( sample < -2147483648.0 ) {
+					sample = -2147483648.0;
+				}
+				value = (Uint32)(Sint32)sample;
+				if ( format == AUDIO_S32LSB ) {
+					SDL_AUDIO_PUT32LSB(dst, value);
+				} else {
+					SDL_AUDIO_PUT32MSB(dst, value);
+				}
+			}
+		}
+		break;
+		case AUDIO_F32LSB:
+		case AUDIO_F32MSB: {
+			float sample;
+			Uint32 value;
+
+			if ( format == AUDIO_F32SYS ) {
+				MIX_CLIP(F32, sums->f)
+				dst += i * 4;
+			}
+			for ( ; i < count; ++i, dst += 4 ) {
+				sample = sums->f[i];
+				if ( sample > 1.0f ) {
+					sample = 1.0f;
+				} else
+				if ( sample < -1.0f ) {
+					sample = -1.0f;
+				}
+				value = SDL_AudioFloatToBits(sample);
+				if ( format == AUDIO_F32LSB ) {
+					SDL_AUDIO_PUT32LSB(dst, value);
+				} else {
+					SDL_AUDIO_PUT32MSB(dst, value);
+				}
+			}
+		}
+		break;
+	}
+}
+
+int SDL_MixAudioMulti(Uint8 *dst, Uint16 format, Uint8 channels, Uint32 len,
+                      const SDL_MixVoice *voices, int num_voices)
+{
+	MixSums sums;
+	const Uint8 *src[MIX_SIMD_VOICES];
+	int vol[MIX_SIMD_VOICES*2];
+	SDL_bool simd;
+	int size, total, pos, count;
+	int i, num, volume, pan, lvol, rvol;
+
+	switch (format) {
+		case AUDIO_U8:
+		case AUDIO_S8:
+		case AUDIO_S16LSB:
+		case AUDIO_S16MSB:
+		case AUDIO_S32LSB:
+		case AUDIO_S32MSB:
+		case AUDIO_F32LSB:
+		case AUDIO_F32MSB:
+			break;
+		default:
+			SDL_SetError("SDL_MixAudioMulti(): unknown audio format");
+			return(-1);
+	}
+	if ( (num_voices > 0) && !voices ) {
+		SDL_SetError("SDL_MixAudioMulti(): no voices");
+		return(-1);
+	}
+
+	/* With nothing to mix leave 'dst' alone, as SDL_MixAudio() does,
+	   instead of clipping it on the way through */
+	for ( i = 0; i < num_voices; ++i ) {
+		if ( voices[i].src && (voices[i].volume > 0) ) {
+			break;
+		}
+	}
+	if ( i == num_voices ) {
+		return(0);
+	}
+
+	size = (format & 0xFF) / 8;
+	total = (int)(len / size);
+	simd = MIX_HAS_SIMD();
+	for ( pos = 0; pos < total; pos += count ) {
+		count = total - pos;
+		if ( count > MIX_BLOCK ) {
+			count = MIX_BLOCK;
+		}
+		MixLoad(format, &sums, dst + pos * size, count, simd);
+		num = 0;
+		for ( i = 0; i < num_voices; ++i ) {
+			volume = voices[i].volume;
+			if ( !voices[i].src || (volume <= 0) ) {
+				continue;
+			}
+			if ( volume > SDL_MIX_MAXVOLUME ) {
+				volume = SDL_MIX_MAXVOLUME;
+			}
+			lvol = rvol = volume;
+			if ( (channels == 2) || (channels == 4) ) {
+				pan = voices[i].pan;
+				if ( pan > SDL_MIX_MAXVOLUME ) {
+					pan = SDL_MIX_MAXVOLUME;
+				} else
+				if ( pan < -SDL_MIX_MAXVOLUME ) {
+					pan = -SDL_MIX_MAXVOLUME;
+				}
+				if ( pan > 0 ) {
+					lvol = (volume * (SDL_MIX_MAXVOLUME - pan)) / SDL_MIX_MAXVOLUME;
+				} else {
+					rvol = (volume * (SDL_MIX_MAXVOLUME + pan)) / SDL_MIX_MAXVOLUME;
+				}
+			}
+			src[num] = voices[i].src + pos * size;
+			vol[num*2] = lvol;
+			vol[num*2+1] = rvol;
+			if ( ++num == MIX_SIMD_VOICES ) {
+				MixAccumulate(format, &sums, src, vol, num, count, simd);
+				num = 0;
+			}
+		}
+		if ( num > 0 ) {
+			MixAccumulate(format, &sums, src, vol, num, count, simd);
+		}
+		MixStore(format, &sums, dst + pos * size, count, simd);
+	}
+	return(0);
+}
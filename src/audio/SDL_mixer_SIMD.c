@@ -0,0 +1,646 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Vector versions of SDL_MixAudio
+
+   The C code scales a sample by (sample*volume)/SDL_MIX_MAXVOLUME, which
+   rounds towards zero, so the products are made in wider lanes and
+   negative ones are biased by SDL_MIX_MAXVOLUME-1 before the shift.
+   Clipping the sum is a saturating add, or a clamp for unsigned 8-bit
+   samples, which the C code pins to 0..0xFE with its lookup table.
+*/
+
+#include "SDL_audio.h"
+#include "SDL_mixer_SIMD.h"
+
+#if SSE2_MIXER
+#include <emmintrin.h>
+
+/* (s*v)/128 for signed 16-bit lanes, rounding towards zero, in 32 bits */
+static __inline__ void ScaleS16x32SSE2(__m128i s, __m128i v,
+                                       __m128i *a, __m128i *b)
+{
+	__m128i lo = _mm_mullo_epi16(s, v);
+	__m128i hi = _mm_mulhi_epi16(s, v);
+	__m128i x = _mm_unpacklo_epi16(lo, hi);
+	__m128i y = _mm_unpackhi_epi16(lo, hi);
+
+	x = _mm_add_epi32(x, _mm_srli_epi32(_mm_srai_epi32(x, 31), 25));
+	y = _mm_add_epi32(y, _mm_srli_epi32(_mm_srai_epi32(y, 31), 25));
+	*a = _mm_srai_epi32(x, 7);
+	*b = _mm_srai_epi32(y, 7);
+}
+
+static __inline__ __m128i ScaleS16SSE2(__m128i s, __m128i v)
+{
+	__m128i a, b;
+
+	ScaleS16x32SSE2(s, v, &a, &b);
+	return _mm_packs_epi32(a, b);
+}
+
+/* The same for 8-bit samples widened to 16 bits, where the product fits */
+static __inline__ __m128i ScaleS8SSE2(__m128i s, __m128i v)
+{
+	s = _mm_mullo_epi16(s, v);
+	s = _mm_add_epi16(s, _mm_srli_epi16(_mm_srai_epi16(s, 15), 9));
+	return _mm_srai_epi16(s, 7);
+}
+
+static __inline__ __m128i Swap16SSE2(__m128i x)
+{
+	return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+Uint32 SDL_MixAudio_SSE2_U8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m128i v = _mm_set1_epi16((short)volume);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(128);
+	const __m128i max = _mm_set1_epi16(0xFE);
+	__m128i s, d, slo, shi, dlo, dhi;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = _mm_loadu_si128((const __m128i *)(src + i));
+		d = _mm_loadu_si128((const __m128i *)(dst + i));
+		slo = _mm_sub_epi16(_mm_unpacklo_epi8(s, zero), bias);
+		shi = _mm_sub_epi16(_mm_unpackhi_epi8(s, zero), bias);
+		if ( volume < SDL_MIX_MAXVOLUME ) {
+			slo = ScaleS8SSE2(slo, v);
+			shi = ScaleS8SSE2(shi, v);
+		}
+		dlo = _mm_add_epi16(_mm_unpacklo_epi8(d, zero), slo);
+		dhi = _mm_add_epi16(_mm_unpackhi_epi8(d, zero), shi);
+		dlo = _mm_min_epi16(_mm_max_epi16(dlo, zero), max);
+		dhi = _mm_min_epi16(_mm_max_epi16(dhi, zero), max);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(dlo, dhi));
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_SSE2_S8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m128i v = _mm_set1_epi16((short)volume);
+	__m128i s, d, lo, hi;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = _mm_loadu_si128((const __m128i *)(src + i));
+		d = _mm_loadu_si128((const __m128i *)(dst + i));
+		if ( volume < SDL_MIX_MAXVOLUME ) {
+			lo = _mm_srai_epi16(_mm_unpacklo_epi8(s, s), 8);
+			hi = _mm_srai_epi16(_mm_unpackhi_epi8(s, s), 8);
+			s = _mm_packs_epi16(ScaleS8SSE2(lo, v),
+			                    ScaleS8SSE2(hi, v));
+		}
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_adds_epi8(d, s));
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_SSE2_S16(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m128i v = _mm_set1_epi16((short)volume);
+	__m128i s, d;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = _mm_loadu_si128((const __m128i *)(src + i));
+		d = _mm_loadu_si128((const __m128i *)(dst + i));
+		if ( volume < SDL_MIX_MAXVOLUME ) {
+			s = ScaleS16SSE2(s, v);
+		}
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_adds_epi16(d, s));
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_SSE2_S16Swap(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m128i v = _mm_set1_epi16((short)volume);
+	__m128i s, d;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = Swap16SSE2(_mm_loadu_si128((const __m128i *)(src + i)));
+		d = Swap16SSE2(_mm_loadu_si128((const __m128i *)(dst + i)));
+		if ( volume < SDL_MIX_MAXVOLUME ) {
+			s = ScaleS16SSE2(s, v);
+		}
+		_mm_storeu_si128((__m128i *)(dst + i),
+		                 Swap16SSE2(_mm_adds_epi16(d, s)));
+	}
+	return i;
+}
+/* Alternate the volumes of the left and right channels of each source */
+static __inline__ void PanVolumesSSE2(__m128i *v, const int *vol, int num)
+{
+	int k;
+
+	for ( k = 0; k < num; ++k, vol += 2 ) {
+		v[k] = _mm_set_epi16((short)vol[1], (short)vol[0],
+		                     (short)vol[1], (short)vol[0],
+		                     (short)vol[1], (short)vol[0],
+		                     (short)vol[1], (short)vol[0]);
+	}
+}
+
+/* Add 16-bit lanes to four sums each of 'acc' */
+static __inline__ void Add16x32SSE2(Sint32 *acc, __m128i x)
+{
+	__m128i *p = (__m128i *)acc;
+
+	_mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p),
+	                 _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)));
+	_mm_storeu_si128(p + 1, _mm_add_epi32(_mm_loadu_si128(p + 1),
+	                 _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)));
+}
+
+/* Scaled 8-bit samples of up to 255 sources can be summed in 16 bits */
+int SDL_MixAccumulate_SSE2_U8(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(128);
+	__m128i v[MIX_SIMD_VOICES];
+	__m128i s, lo, hi;
+	int i, k;
+
+	PanVolumesSSE2(v, vol, num);
+	for ( i = 0; i + 16 <= count; i += 16 ) {
+		lo = hi = zero;
+		for ( k = 0; k < num; ++k ) {
+			s = _mm_loadu_si128((const __m128i *)(src[k] + i));
+			lo = _mm_add_epi16(lo, ScaleS8SSE2(
+			         _mm_sub_epi16(_mm_unpacklo_epi8(s, zero), bias), v[k]));
+			hi = _mm_add_epi16(hi, ScaleS8SSE2(
+			         _mm_sub_epi16(_mm_unpackhi_epi8(s, zero), bias), v[k]));
+		}
+		Add16x32SSE2(acc + i, lo);
+		Add16x32SSE2(acc + i + 8, hi);
+	}
+	return i;
+}
+
+int SDL_MixAccumulate_SSE2_S8(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count)
+{
+	__m128i v[MIX_SIMD_VOICES];
+	__m128i s, lo, hi;
+	int i, k;
+
+	PanVolumesSSE2(v, vol, num);
+	for ( i = 0; i + 16 <= count; i += 16 ) {
+		lo = hi = _mm_setzero_si128();
+		for ( k = 0; k < num; ++k ) {
+			s = _mm_loadu_si128((const __m128i *)(src[k] + i));
+			lo = _mm_add_epi16(lo, ScaleS8SSE2(
+			         _mm_srai_epi16(_mm_unpacklo_epi8(s, s), 8), v[k]));
+			hi = _mm_add_epi16(hi, ScaleS8SSE2(
+			         _mm_srai_epi16(_mm_unpackhi_epi8(s, s), 8), v[k]));
+		}
+		Add16x32SSE2(acc + i, lo);
+		Add16x32SSE2(acc + i + 8, hi);
+	}
+	return i;
+}
+
+static __inline__ int AccumulateS16SSE2(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count, int swap)
+{
+	__m128i v[MIX_SIMD_VOICES];
+	__m128i s, a, b, x, y;
+	int i, k;
+
+	PanVolumesSSE2(v, vol, num);
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		a = _mm_loadu_si128((const __m128i *)(acc + i));
+		b = _mm_loadu_si128((const __m128i *)(acc + i + 4));
+		for ( k = 0; k < num; ++k ) {
+			s = _mm_loadu_si128((const __m128i *)(src[k] + i * 2));
+			if ( swap ) {
+				s = Swap16SSE2(s);
+			}
+			ScaleS16x32SSE2(s, v[k], &x, &y);
+			a = _mm_add_epi32(a, x);
+			b = _mm_add_epi32(b, y);
+		}
+		_mm_storeu_si128((__m128i *)(acc + i), a);
+		_mm_storeu_si128((__m128i *)(acc + i + 4), b);
+	}
+	return i;
+}
+
+int SDL_MixAccumulate_SSE2_S16(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count)
+{
+	return AccumulateS16SSE2(acc, src, vol, num, count, 0);
+}
+
+int SDL_MixAccumulate_SSE2_S16Swap(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count)
+{
+	return AccumulateS16SSE2(acc, src, vol, num, count, 1);
+}
+
+int SDL_MixAccumulate_SSE2_F32(float *acc, const Uint8 **src, const int *vol, int num, int count)
+{
+	__m128 v[MIX_SIMD_VOICES];
+	__m128 a, b;
+	const float *s;
+	int i, k;
+
+	for ( k = 0; k < num; ++k ) {
+		v[k] = _mm_set_ps((float)vol[k*2+1] / SDL_MIX_MAXVOLUME,
+		                  (float)vol[k*2] / SDL_MIX_MAXVOLUME,
+		                  (float)vol[k*2+1] / SDL_MIX_MAXVOLUME,
+		                  (float)vol[k*2] / SDL_MIX_MAXVOLUME);
+	}
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		a = _mm_loadu_ps(acc + i);
+		b = _mm_loadu_ps(acc + i + 4);
+		for ( k = 0; k < num; ++k ) {
+			s = (const float *)src[k] + i;
+			a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(s), v[k]));
+			b = _mm_add_ps(b, _mm_mul_ps(_mm_loadu_ps(s + 4), v[k]));
+		}
+		_mm_storeu_ps(acc + i, a);
+		_mm_storeu_ps(acc + i + 4, b);
+	}
+	return i;
+}
+
+int SDL_MixLoad_SSE2_S16(Sint32 *acc, const Uint8 *dst, int count)
+{
+	__m128i d;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		d = _mm_loadu_si128((const __m128i *)(dst + i * 2));
+		_mm_storeu_si128((__m128i *)(acc + i),
+		                 _mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16));
+		_mm_storeu_si128((__m128i *)(acc + i + 4),
+		                 _mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16));
+	}
+	return i;
+}
+
+int SDL_MixLoad_SSE2_F32(float *acc, const Uint8 *dst, int count)
+{
+	const float *d = (const float *)dst;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		_mm_storeu_ps(acc + i, _mm_loadu_ps(d + i));
+		_mm_storeu_ps(acc + i + 4, _mm_loadu_ps(d + i + 4));
+	}
+	return i;
+}
+
+int SDL_MixClip_SSE2_S16(const Sint32 *acc, Uint8 *dst, int count)
+{
+	const __m128i *p = (const __m128i *)acc;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8, p += 2 ) {
+		_mm_storeu_si128((__m128i *)(dst + i * 2),
+		                 _mm_packs_epi32(_mm_loadu_si128(p),
+		                                 _mm_loadu_si128(p + 1)));
+	}
+	return i;
+}
+
+int SDL_MixClip_SSE2_F32(const float *acc, Uint8 *dst, int count)
+{
+	const __m128 lo = _mm_set1_ps(-1.0f);
+	const __m128 hi = _mm_set1_ps(1.0f);
+	float *d = (float *)dst;
+	int i;
+
+	/* The sums are the second operands, so NaNs pass like in C */
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		_mm_storeu_ps(d + i, _mm_min_ps(hi,
+		              _mm_max_ps(lo, _mm_loadu_ps(acc + i))));
+		_mm_storeu_ps(d + i + 4, _mm_min_ps(hi,
+		              _mm_max_ps(lo, _mm_loadu_ps(acc + i + 4))));
+	}
+	return i;
+}
+#endif /* SSE2_MIXER */
+
+#if NEON_MIXER
+#include <arm_neon.h>
+
+/* (s*v)/128 for signed 16-bit lanes, rounding towards zero, in 32 bits */
+static __inline__ int32x4_t ScaleS16x32NEON(int16x4_t s, int16x4_t v)
+{
+	int32x4_t a = vmull_s16(s, v);
+
+	a = vaddq_s32(a, vreinterpretq_s32_u32(
+	        vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(a, 31)), 25)));
+	return vshrq_n_s32(a, 7);
+}
+
+static __inline__ int16x8_t ScaleS16NEON(int16x8_t s, int16x4_t v)
+{
+	return vcombine_s16(
+	           vqmovn_s32(ScaleS16x32NEON(vget_low_s16(s), v)),
+	           vqmovn_s32(ScaleS16x32NEON(vget_high_s16(s), v)));
+}
+
+/* The same for 8-bit samples widened to 16 bits, where the product fits */
+static __inline__ int16x8_t ScaleS8NEON(int16x8_t s, int16x8_t v)
+{
+	s = vmulq_s16(s, v);
+	s = vaddq_s16(s, vreinterpretq_s16_u16(
+	        vshrq_n_u16(vreinterpretq_u16_s16(vshrq_n_s16(s, 15)), 9)));
+	return vshrq_n_s16(s, 7);
+}
+
+Uint32 SDL_MixAudio_NEON_U8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const int16x8_t v = vdupq_n_s16((int16_t)volume);
+	const int16x8_t bias = vdupq_n_s16(128);
+	const int16x8_t max = vdupq_n_s16(0xFE);
+	uint8x16_t s, d;
+	int16x8_t lo, hi;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = vld1q_u8(src + i);
+		d = vld1q_u8(dst + i);
+		lo = vsubq_s16(vreinterpretq_s16_u16(
+		         vmovl_u8(vget_low_u8(s))), bias);
+		hi = vsubq_s16(vreinterpretq_s16_u16(
+		         vmovl_u8(vget_high_u8(s))), bias);
+		if ( volume < SDL_MIX_MAXVOLUME ) {
+			lo = ScaleS8NEON(lo, v);
+			hi = ScaleS8NEON(hi, v);
+		}
+		lo = vaddq_s16(vreinterpretq_s16_u16(
+		         vmovl_u8(vget_low_u8(d))), lo);
+		hi = vaddq_s16(vreinterpretq_s16_u16(
+		         vmovl_u8(vget_high_u8(d))), hi);
+		vst1q_u8(dst + i, vcombine_u8(vqmovun_s16(vminq_s16(lo, max)),
+		                              vqmovun_s16(vminq_s16(hi, max))));
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_NEON_S8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const int16x8_t v = vdupq_n_s16((int16_t)volume);
+	int8x16_t s, d;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = vld1q_s8((const int8_t *)(src + i));
+		d = vld1q_s8((const int8_t *)(dst + i));
+		if ( volume < SDL_MIX_MAXVOLUME ) {
+			s = vcombine_s8(
+			    vqmovn_s16(ScaleS8NEON(vmovl_s8(vget_low_s8(s)), v)),
+			    vqmovn_s16(ScaleS8NEON(vmovl_s8(vget_high_s8(s)), v)));
+		}
+		vst1q_s8((int8_t *)(dst + i), vqaddq_s8(d, s));
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_NEON_S16(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const int16x4_t v = vdup_n_s16((int16_t)volume);
+	int16x8_t s, d;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = vld1q_s16((const int16_t *)(src + i));
+		d = vld1q_s16((const int16_t *)(dst + i));
+		if ( volume < SDL_MIX_MAXVOLUME ) {
+			s = ScaleS16NEON(s, v);
+		}
+		vst1q_s16((int16_t *)(dst + i), vqaddq_s16(d, s));
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_NEON_S16Swap(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const int16x4_t v = vdup_n_s16((int16_t)volume);
+	int16x8_t s, d;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(src + i)));
+		d = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(dst + i)));
+		if ( volume < SDL_MIX_MAXVOLUME ) {
+			s = ScaleS16NEON(s, v);
+		}
+		vst1q_u8(dst + i, vrev16q_u8(vreinterpretq_u8_s16(
+		                             vqaddq_s16(d, s))));
+	}
+	return i;
+}
+/* Alternate the volumes of the left and right channels of each source */
+static __inline__ void PanVolumesNEON(int16x8_t *v, const int *vol, int num)
+{
+	int16x4_t x;
+	int k;
+
+	for ( k = 0; k < num; ++k, vol += 2 ) {
+		x = vdup_n_s16((int16_t)vol[0]);
+		x = vset_lane_s16((int16_t)vol[1], x, 1);
+		x = vset_lane_s16((int16_t)vol[1], x, 3);
+		v[k] = vcombine_s16(x, x);
+	}
+}
+
+/* Add 16-bit lanes to four sums each of 'acc' */
+static __inline__ void Add16x32NEON(Sint32 *acc, int16x8_t x)
+{
+	vst1q_s32(acc, vaddw_s16(vld1q_s32(acc), vget_low_s16(x)));
+	vst1q_s32(acc + 4, vaddw_s16(vld1q_s32(acc + 4), vget_high_s16(x)));
+}
+
+/* Scaled 8-bit samples of up to 255 sources can be summed in 16 bits */
+int SDL_MixAccumulate_NEON_U8(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count)
+{
+	const int16x8_t bias = vdupq_n_s16(128);
+	int16x8_t v[MIX_SIMD_VOICES];
+	int16x8_t lo, hi;
+	uint8x16_t s;
+	int i, k;
+
+	PanVolumesNEON(v, vol, num);
+	for ( i = 0; i + 16 <= count; i += 16 ) {
+		lo = hi = vdupq_n_s16(0);
+		for ( k = 0; k < num; ++k ) {
+			s = vld1q_u8(src[k] + i);
+			lo = vaddq_s16(lo, ScaleS8NEON(vsubq_s16(
+			         vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(s))),
+			         bias), v[k]));
+			hi = vaddq_s16(hi, ScaleS8NEON(vsubq_s16(
+			         vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(s))),
+			         bias), v[k]));
+		}
+		Add16x32NEON(acc + i, lo);
+		Add16x32NEON(acc + i + 8, hi);
+	}
+	return i;
+}
+
+int SDL_MixAccumulate_NEON_S8(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count)
+{
+	int16x8_t v[MIX_SIMD_VOICES];
+	int16x8_t lo, hi;
+	int8x16_t s;
+	int i, k;
+
+	PanVolumesNEON(v, vol, num);
+	for ( i = 0; i + 16 <= count; i += 16 ) {
+		lo = hi = vdupq_n_s16(0);
+		for ( k = 0; k < num; ++k ) {
+			s = vld1q_s8((const int8_t *)(src[k] + i));
+			lo = vaddq_s16(lo,
+			         ScaleS8NEON(vmovl_s8(vget_low_s8(s)), v[k]));
+			hi = vaddq_s16(hi,
+			         ScaleS8NEON(vmovl_s8(vget_high_s8(s)), v[k]));
+		}
+		Add16x32NEON(acc + i, lo);
+		Add16x32NEON(acc + i + 8, hi);
+	}
+	return i;
+}
+
+static __inline__ int AccumulateS16NEON(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count, int swap)
+{
+	int16x8_t v[MIX_SIMD_VOICES];
+	int16x8_t s;
+	int32x4_t a, b;
+	int i, k;
+
+	PanVolumesNEON(v, vol, num);
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		a = vld1q_s32(acc + i);
+		b = vld1q_s32(acc + i + 4);
+		for ( k = 0; k < num; ++k ) {
+			if ( swap ) {
+				s = vreinterpretq_s16_u8(vrev16q_u8(
+				        vld1q_u8(src[k] + i * 2)));
+			} else {
+				s = vld1q_s16((const int16_t *)(src[k] + i * 2));
+			}
+			a = vaddq_s32(a, ScaleS16x32NEON(vget_low_s16(s),
+			                                 vget_low_s16(v[k])));
+			b = vaddq_s32(b, ScaleS16x32NEON(vget_high_s16(s),
+			                                 vget_high_s16(v[k])));
+		}
+		vst1q_s32(acc + i, a);
+		vst1q_s32(acc + i + 4, b);
+	}
+	return i;
+}
+
+int SDL_MixAccumulate_NEON_S16(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count)
+{
+	return AccumulateS16NEON(acc, src, vol, num, count, 0);
+}
+
+int SDL_MixAccumulate_NEON_S16Swap(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count)
+{
+	return AccumulateS16NEON(acc, src, vol, num, count, 1);
+}
+
+int SDL_MixAccumulate_NEON_F32(float *acc, const Uint8 **src, const int *vol, int num, int count)
+{
+	float32x4_t v[MIX_SIMD_VOICES];
+	float32x4_t a, b;
+	const float *s;
+	int i, k;
+
+	for ( k = 0; k < num; ++k ) {
+		v[k] = vdupq_n_f32((float)vol[k*2] / SDL_MIX_MAXVOLUME);
+		v[k] = vsetq_lane_f32((float)vol[k*2+1] / SDL_MIX_MAXVOLUME, v[k], 1);
+		v[k] = vsetq_lane_f32((float)vol[k*2+1] / SDL_MIX_MAXVOLUME, v[k], 3);
+	}
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		a = vld1q_f32(acc + i);
+		b = vld1q_f32(acc + i + 4);
+		for ( k = 0; k < num; ++k ) {
+			s = (const float *)src[k] + i;
+			a = vaddq_f32(a, vmulq_f32(vld1q_f32(s), v[k]));
+			b = vaddq_f32(b, vmulq_f32(vld1q_f32(s + 4), v[k]));
+		}
+		vst1q_f32(acc + i, a);
+		vst1q_f32(acc + i + 4, b);
+	}
+	return i;
+}
+
+int SDL_MixLoad_NEON_S16(Sint32 *acc, const Uint8 *dst, int count)
+{
+	int16x8_t d;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		d = vld1q_s16((const int16_t *)(dst + i * 2));
+		vst1q_s32(acc + i, vmovl_s16(vget_low_s16(d)));
+		vst1q_s32(acc + i + 4, vmovl_s16(vget_high_s16(d)));
+	}
+	return i;
+}
+
+int SDL_MixLoad_NEON_F32(float *acc, const Uint8 *dst, int count)
+{
+	const float *d = (const float *)dst;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		vst1q_f32(acc + i, vld1q_f32(d + i));
+		vst1q_f32(acc + i + 4, vld1q_f32(d + i + 4));
+	}
+	return i;
+}
+
+int SDL_MixClip_NEON_S16(const Sint32 *acc, Uint8 *dst, int count)
+{
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		vst1q_s16((int16_t *)(dst + i * 2),
+		          vcombine_s16(vqmovn_s32(vld1q_s32(acc + i)),
+		                       vqmovn_s32(vld1q_s32(acc + i + 4))));
+	}
+	return i;
+}
+
+int SDL_MixClip_NEON_F32(const float *acc, Uint8 *dst, int count)
+{
+	const float32x4_t lo = vdupq_n_f32(-1.0f);
+	const float32x4_t hi = vdupq_n_f32(1.0f);
+	float *d = (float *)dst;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		vst1q_f32(d + i, vminq_f32(vmaxq_f32(vld1q_f32(acc + i), lo), hi));
+		vst1q_f32(d + i + 4,
+		          vminq_f32(vmaxq_f32(vld1q_f32(acc + i + 4), lo), hi));
+	}
+	return i;
+}
+#endif /* NEON_MIXER */
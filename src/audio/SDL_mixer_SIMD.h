@@ -0,0 +1,82 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* SSE2 and NEON versions of SDL_MixAudio for 8-bit and 16-bit samples.
+   These give exactly the same results as the C loops in SDL_mixer.c for
+   volumes from 1 to SDL_MIX_MAXVOLUME.  Each mixes whole 16 byte blocks
+   from the start of the buffers and returns the number of bytes mixed,
+   leaving the rest to the C code.
+
+   The SDL_MixAccumulate functions add the samples of up to MIX_SIMD_VOICES
+   sources, scaled the same way, to the sums of SDL_MixAudioMulti().  'vol'
+   holds the left and right volume of each source, which alternate between
+   the samples.  The SDL_MixLoad functions start the sums from the native
+   16-bit or float samples already in the destination, and SDL_MixClip
+   stores them.  They work on a
+   multiple of 8 samples and return how many they did.
+*/
+
+#define MIX_SIMD_VOICES	8
+
+#if SDL_ASSEMBLY_ROUTINES
+#  if (defined(__GNUC__) && defined(__SSE2__)) || \
+      (defined(_MSC_VER) && (defined(_M_X64) || (_M_IX86_FP >= 2)))
+#    define SSE2_MIXER 1
+#  endif
+#  if defined(__GNUC__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#    define NEON_MIXER 1
+#  endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
+
+#if SSE2_MIXER
+extern Uint32 SDL_MixAudio_SSE2_U8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+extern Uint32 SDL_MixAudio_SSE2_S8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+extern Uint32 SDL_MixAudio_SSE2_S16(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+extern Uint32 SDL_MixAudio_SSE2_S16Swap(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+extern int SDL_MixAccumulate_SSE2_U8(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count);
+extern int SDL_MixAccumulate_SSE2_S8(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count);
+extern int SDL_MixAccumulate_SSE2_S16(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count);
+extern int SDL_MixAccumulate_SSE2_S16Swap(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count);
+extern int SDL_MixAccumulate_SSE2_F32(float *acc, const Uint8 **src, const int *vol, int num, int count);
+extern int SDL_MixLoad_SSE2_S16(Sint32 *acc, const Uint8 *dst, int count);
+extern int SDL_MixLoad_SSE2_F32(float *acc, const Uint8 *dst, int count);
+extern int SDL_MixClip_SSE2_S16(const Sint32 *acc, Uint8 *dst, int count);
+extern int SDL_MixClip_SSE2_F32(const float *acc, Uint8 *dst, int count);
+#endif
+
+#if NEON_MIXER
+extern SDL_bool SDL_HasNEON(void);
+extern Uint32 SDL_MixAudio_NEON_U8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+extern Uint32 SDL_MixAudio_NEON_S8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+extern Uint32 SDL_MixAudio_NEON_S16(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+extern Uint32 SDL_MixAudio_NEON_S16Swap(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+extern int SDL_MixAccumulate_NEON_U8(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count);
+extern int SDL_MixAccumulate_NEON_S8(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count);
+extern int SDL_MixAccumulate_NEON_S16(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count);
+extern int SDL_MixAccumulate_NEON_S16Swap(Sint32 *acc, const Uint8 **src, const int *vol, int num, int count);
+extern int SDL_MixAccumulate_NEON_F32(float *acc, const Uint8 **src, const int *vol, int num, int count);
+extern int SDL_MixLoad_NEON_S16(Sint32 *acc, const Uint8 *dst, int count);
+extern int SDL_MixLoad_NEON_F32(float *acc, const Uint8 *dst, int count);
+extern int SDL_MixClip_NEON_S16(const Sint32 *acc, Uint8 *dst, int count);
+extern int SDL_MixClip_NEON_F32(const float *acc, Uint8 *dst, int count);
+#endif
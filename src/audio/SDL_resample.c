@@ -0,0 +1,760 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Band-limited sample rate conversion
+
+   Every output frame is a dot product of the input frames around it with
+   one phase of a Kaiser windowed sinc filter.  The rate ratio is reduced
+   to 'up' output frames per 'down' input frames, so the filter has 'up'
+   phases that are computed once, and the position in the input advances
+   by 'down' phases per output frame.  The input is kept per channel as
+   floats, so the dot products run over contiguous memory.  The frames
+   still needed for future outputs stay buffered between calls, so the
+   filtering is continuous across buffers.
+*/
+
+#ifdef HAVE_MATH_H
+#include <math.h>
+#endif
+
+#include "SDL_audio.h"
+#include "SDL_mutex.h"
+#include "SDL_resample_c.h"
+#include "SDL_audiotypecvt_c.h"
+
+#if SDL_ASSEMBLY_ROUTINES
+#  if (defined(__GNUC__) && defined(__SSE2__)) || \
+      (defined(_MSC_VER) && (defined(_M_X64) || (_M_IX86_FP >= 2)))
+#    define SSE2_RESAMPLE 1
+#  endif
+#  if defined(__GNUC__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#    define NEON_RESAMPLE 1
+#  endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
+
+/* Function to check the CPU flags */
+#include "SDL_cpuinfo.h"
+#if SSE2_RESAMPLE
+#include <emmintrin.h>
+#endif
+#if NEON_RESAMPLE
+#include <arm_neon.h>
+extern SDL_bool SDL_HasNEON(void);
+#endif
+
+#define RESAMPLE_PI	3.14159265358979323846
+
+/* The longest filter used when decimating by a large factor */
+#define SDL_RESAMPLE_MAX_TAPS	1024
+
+/* Output frames converted per block when reading */
+#define SDL_RESAMPLE_BLOCK	256
+
+/* Taps per output frame and Kaiser window shape for each quality level */
+static const struct {
+	int taps;
+	double beta;
+} resample_quality[] = {
+	{  8,  4.0 },		/* about 45 dB stopband attenuation */
+	{ 16,  6.0 },		/* about 63 dB */
+	{ 32,  8.0 },		/* about 81 dB */
+	{ 64, 10.0 }		/* about 99 dB */
+};
+
+typedef float (*SDL_DotFunc)(const float *a, const float *b, int n);
+
+typedef struct SDL_ResampleFilter {
+	int up, down, quality;
+	int taps;		/* Always a multiple of 4 */
+	float *coeffs;		/* 'up' phases of 'taps' coefficients */
+	int refcount;
+	int cached;
+	struct SDL_ResampleFilter *next;
+} SDL_ResampleFilter;
+
+struct SDL_Resampler {
+	Uint16 format;
+	int channels;
+	int framesize;
+	SDL_ResampleFilter *filter;
+	SDL_DotFunc dot;
+
+	/* The input, one plane of 'capacity' frames per channel */
+	float *input;
+	int capacity;
+	int frames;		/* Frames in each plane */
+	int pos;		/* First frame under the filter */
+	int phase;		/* Filter phase for the next output */
+	int padding;		/* Silence added by SDL_ResamplerFlush() */
+
+	float *output;		/* One block of interleaved output */
+};
+
+/* Filter tables shared between resamplers, while the audio is initialized */
+static SDL_mutex *filter_lock = NULL;
+static SDL_ResampleFilter *filter_cache = NULL;
+
+#ifndef HAVE_MATH_H
+/* Good to about 1e-9 after reduction to [-pi/2,pi/2] */
+static double ResampleSin(double x)
+{
+	double x2, r;
+	int n;
+
+	n = (int)(x / RESAMPLE_PI + (x < 0.0 ? -0.5 : 0.5));
+	x -= n * RESAMPLE_PI;
+	x2 = x * x;
+	r = x * (1.0 - x2/6.0 * (1.0 - x2/20.0 * (1.0 - x2/42.0 *
+	        (1.0 - x2/72.0 * (1.0 - x2/110.0 * (1.0 - x2/156.0))))));
+	return (n & 1) ? -r : r;
+}
+#define sin(x)	ResampleSin(x)
+
+static double ResampleSqrt(double x)
+{
+	double r = (x > 1.0) ? x : 1.0;
+	int i;
+
+	if ( x <= 0.0 ) {
+		return 0.0;
+	}
+	for ( i = 0; i < 64; ++i ) {
+		double next = 0.5 * (r + x / r);
+		if ( next >= r ) {
+			break;
+		}
+		r = next;
+	}
+	return r;
+}
+#define sqrt(x)	ResampleSqrt(x)
+#endif /* !HAVE_MATH_H */
+
+/* Modified Bessel function of the first kind, order zero */
+static double BesselI0(double x)
+{
+	double sum = 1.0, term = 1.0, q = x * x / 4.0;
+	int k;
+
+	for ( k = 1; k < 64; ++k ) {
+		term *= q / ((double)k * k);
+		sum += term;
+		if ( term < sum * 1e-12 ) {
+			break;
+		}
+	}
+	return sum;
+}
+
+static SDL_ResampleFilter *SDL_BuildResampleFilter(int up, int down,
+                                                   int quality)
+{
+	SDL_ResampleFilter *filter;
+	double beta, atten, width, cutoff, i0beta, x, r, v, sum;
+	int taps, half, p, k;
+	float *h;
+
+	/* Place the stopband edge at the lower of the two Nyquist rates,
+	   using Kaiser's estimate of the transition width of the window.
+	 */
+	taps = resample_quality[quality].taps;
+	beta = resample_quality[quality].beta;
+	atten = beta / 0.1102 + 8.7;
+	width = (atten - 7.95) / (2.285 * 2.0 * RESAMPLE_PI * taps);
+	cutoff = 0.5 - width / 2.0;
+
+	/* When decimating, stretch the filter over more input frames */
+	if ( down > up ) {
+		cutoff = cutoff * up / down;
+		if ( (double)taps * down / up > SDL_RESAMPLE_MAX_TAPS ) {
+			taps = SDL_RESAMPLE_MAX_TAPS;
+		} else {
+			taps = (taps * down + up - 1) / up;
+			taps = (taps + 3) & ~3;
+		}
+	}
+	half = taps / 2;
+
+	filter = (SDL_ResampleFilter *)SDL_malloc(sizeof(*filter));
+	if ( filter == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	filter->coeffs = (float *)SDL_malloc(up * taps * sizeof(float));
+	if ( filter->coeffs == NULL ) {
+		SDL_free(filter);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	filter->up = up;
+	filter->down = down;
+	filter->quality = quality;
+	filter->taps = taps;
+	filter->refcount = 1;
+	filter->cached = 0;
+	filter->next = NULL;
+
+	/* Phase 'p' is the filter centred 'p'/'up' of a frame before tap
+	   'half'-1, and is normalized for unity gain.
+	 */
+	i0beta = BesselI0(beta);
+	for ( p = 0; p < up; ++p ) {
+		h = filter->coeffs + p * taps;
+		sum = 0.0;
+		for ( k = 0; k < taps; ++k ) {
+			x = (k - half + 1) - (double)p / up;
+			if ( x == 0.0 ) {
+				v = 2.0 * cutoff;
+			} else {
+				v = sin(2.0 * RESAMPLE_PI * cutoff * x) /
+				    (RESAMPLE_PI * x);
+			}
+			r = x / half;
+			r = (r < 1.0) ? (1.0 - r * r) : 0.0;
+			v *= BesselI0(beta * sqrt(r)) / i0beta;
+			h[k] = (float)v;
+			sum += v;
+		}
+		for ( k = 0; k < taps; ++k ) {
+			h[k] = (float)(h[k] / sum);
+		}
+	}
+	return(filter);
+}
+
+static SDL_ResampleFilter *SDL_GetResampleFilter(int up, int down,
+                                                 int quality)
+{
+	SDL_ResampleFilter *filter;
+
+	if ( filter_lock ) {
+		SDL_mutexP(filter_lock);
+		for ( filter = filter_cache; filter; filter = filter->next ) {
+			if ( (filter->up == up) && (filter->down == down) &&
+			     (filter->quality == quality) ) {
+				++filter->refcount;
+				SDL_mutexV(filter_lock);
+				return(filter);
+			}
+		}
+		SDL_mutexV(filter_lock);
+	}
+
+	filter = SDL_BuildResampleFilter(up, down, quality);
+	if ( filter && filter_lock ) {
+		SDL_mutexP(filter_lock);
+		filter->cached = 1;
+		filter->next = filter_cache;
+		filter_cache = filter;
+		SDL_mutexV(filter_lock);
+	}
+	return(filter);
+}
+
+static void SDL_ReleaseResampleFilter(SDL_ResampleFilter *filter)
+{
+	if ( filter_lock ) {
+		SDL_mutexP(filter_lock);
+		--filter->refcount;
+		if ( filter->cached ) {
+			filter = NULL;	/* Kept for the next resampler */
+		}
+		SDL_mutexV(filter_lock);
+	} else {
+		--filter->refcount;
+	}
+	if ( filter && (filter->refcount == 0) ) {
+		SDL_free(filter->coeffs);
+		SDL_free(filter);
+	}
+}
+
+void SDL_ResamplerInit(void)
+{
+	if ( filter_lock == NULL ) {
+		filter_lock = SDL_CreateMutex();
+	}
+}
+
+void SDL_ResamplerQuit(void)
+{
+	SDL_ResampleFilter *filter, *next;
+
+	if ( filter_lock == NULL ) {
+		return;
+	}
+	SDL_mutexP(filter_lock);
+	for ( filter = filter_cache; filter; filter = next ) {
+		next = filter->next;
+		filter->cached = 0;
+		if ( filter->refcount == 0 ) {
+			SDL_free(filter->coeffs);
+			SDL_free(filter);
+		}
+	}
+	filter_cache = NULL;
+	SDL_mutexV(filter_lock);
+	SDL_DestroyMutex(filter_lock);
+	filter_lock = NULL;
+}
+
+int SDL_GetResampleQuality(void)
+{
+	const char *env;
+	int quality = SDL_RESAMPLE_HIGH;
+
+	env = SDL_getenv("SDL_AUDIO_RESAMPLE_QUALITY");
+	if ( env ) {
+		quality = SDL_atoi(env);
+	}
+	if ( quality < SDL_RESAMPLE_FAST ) {
+		quality = SDL_RESAMPLE_FAST;
+	}
+	if ( quality > SDL_RESAMPLE_BEST ) {
+		quality = SDL_RESAMPLE_BEST;
+	}
+	return(quality);
+}
+
+void SDL_FindRateRatio(double ratio, int *up, int *down)
+{
+	double x, frac, h, k, h1, k1, h2, k2, a;
+	int i;
+
+	/* Walk the continued fraction convergents of the ratio until one is
+	   exact, or the next would need too many filter phases.
+	 */
+	*up = 1;
+	*down = 1;
+	if ( ratio <= 0.0 ) {
+		return;
+	}
+	if ( ratio * SDL_RESAMPLE_MAX_PHASES < 1.0 ) {
+		*down = (int)(1.0 / ratio + 0.5);
+		return;
+	}
+	x = ratio;
+	h1 = 1.0; k1 = 0.0;
+	h2 = 0.0; k2 = 1.0;
+	for ( i = 0; i < 32; ++i ) {
+		a = (double)(int)x;
+		h = a * h1 + h2;
+		k = a * k1 + k2;
+		if ( (h > SDL_RESAMPLE_MAX_PHASES) || (k > 0x7FFFFF) ) {
+			break;
+		}
+		if ( h > 0.0 ) {
+			*up = (int)h;
+			*down = (int)k;
+		}
+		frac = x - a;
+		if ( (frac < 1e-9) ||
+		     ((h > 0.0) && (h / k - ratio < ratio * 1e-12) &&
+		                   (ratio - h / k < ratio * 1e-12)) ) {
+			break;
+		}
+		x = 1.0 / frac;
+		h2 = h1; k2 = k1;
+		h1 = h; k1 = k;
+	}
+}
+
+/* Dot products of 'n' floats, 'n' being a multiple of 4 */
+static float DotProduct(const float *a, const float *b, int n)
+{
+	float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+
+	for ( ; n; n -= 4, a += 4, b += 4 ) {
+		s0 += a[0] * b[0];
+		s1 += a[1] * b[1];
+		s2 += a[2] * b[2];
+		s3 += a[3] * b[3];
+	}
+	return (s0 + s2) + (s1 + s3);
+}
+
+#if SSE2_RESAMPLE
+static float DotProductSSE2(const float *a, const float *b, int n)
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+
+	for ( ; n >= 8; n -= 8, a += 8, b += 8 ) {
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a),
+		                                   _mm_loadu_ps(b)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + 4),
+		                                   _mm_loadu_ps(b + 4)));
+	}
+	if ( n ) {
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a),
+		                                   _mm_loadu_ps(b)));
+	}
+	sum0 = _mm_add_ps(sum0, sum1);
+	sum0 = _mm_add_ps(sum0, _mm_movehl_ps(sum0, sum0));
+	sum0 = _mm_add_ss(sum0, _mm_shuffle_ps(sum0, sum0, 1));
+	return _mm_cvtss_f32(sum0);
+}
+#endif /* SSE2_RESAMPLE */
+
+#if NEON_RESAMPLE
+static float DotProductNEON(const float *a, const float *b, int n)
+{
+	float32x4_t sum0 = vdupq_n_f32(0.0f);
+	float32x4_t sum1 = vdupq_n_f32(0.0f);
+	float32x2_t sum;
+
+	for ( ; n >= 8; n -= 8, a += 8, b += 8 ) {
+		sum0 = vmlaq_f32(sum0, vld1q_f32(a), vld1q_f32(b));
+		sum1 = vmlaq_f32(sum1, vld1q_f32(a + 4), vld1q_f32(b + 4));
+	}
+	if ( n ) {
+		sum0 = vmlaq_f32(sum0, vld1q_f32(a), vld1q_f32(b));
+	}
+	sum0 = vaddq_f32(sum0, sum1);
+	sum = vadd_f32(vget_low_f32(sum0), vget_high_f32(sum0));
+	return vget_lane_f32(vpadd_f32(sum, sum), 0);
+}
+#endif /* NEON_RESAMPLE */
+
+SDL_Resampler *SDL_CreateResampler(Uint16 format, int channels,
+                                   int up, int down, int quality)
+{
+	SDL_Resampler *resampler;
+
+	switch (format) {
+	    case AUDIO_U8:
+	    case AUDIO_S8:
+	    case AUDIO_U16LSB:
+	    case AUDIO_S16LSB:
+	    case AUDIO_U16MSB:
+	    case AUDIO_S16MSB:
+	    case AUDIO_S32LSB:
+	    case AUDIO_S32MSB:
+	    case AUDIO_F32LSB:
+	    case AUDIO_F32MSB:
+		break;
+	    default:
+		SDL_SetError("Unsupported audio format for resampling");
+		return(NULL);
+	}
+	if ( (channels <= 0) || (up <= 0) || (down <= 0) ||
+	     (up > SDL_RESAMPLE_MAX_PHASES) ) {
+		SDL_SetError("Invalid resampling parameters");
+		return(NULL);
+	}
+	if ( quality < SDL_RESAMPLE_FAST ) {
+		quality = SDL_RESAMPLE_FAST;
+	}
+	if ( quality > SDL_RESAMPLE_BEST ) {
+		quality = SDL_RESAMPLE_BEST;
+	}
+
+	resampler = (SDL_Resampler *)SDL_malloc(sizeof(*resampler));
+	if ( resampler == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_memset(resampler, 0, sizeof(*resampler));
+	resampler->format = format;
+	resampler->channels = channels;
+	resampler->framesize = ((format & 0xFF) / 8) * channels;
+
+	resampler->filter = SDL_GetResampleFilter(up, down, quality);
+	resampler->output = (float *)SDL_malloc(
+			SDL_RESAMPLE_BLOCK * channels * sizeof(float));
+	if ( (resampler->filter == NULL) || (resampler->output == NULL) ) {
+		SDL_FreeResampler(resampler);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+
+	resampler->dot = DotProduct;
+#if SSE2_RESAMPLE
+	if ( SDL_HasSSE2() ) {
+		resampler->dot = DotProductSSE2;
+	}
+#endif
+#if NEON_RESAMPLE
+	if ( SDL_HasNEON() ) {
+		resampler->dot = DotProductNEON;
+	}
+#endif
+
+	SDL_ResamplerClear(resampler);
+	if ( resampler->input == NULL ) {
+		SDL_FreeResampler(resampler);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	return(resampler);
+}
+
+void SDL_FreeResampler(SDL_Resampler *resampler)
+{
+	if ( resampler ) {
+		if ( resampler->filter ) {
+			SDL_ReleaseResampleFilter(resampler->filter);
+		}
+		if ( resampler->input ) {
+			SDL_free(resampler->input);
+		}
+		if ( resampler->output ) {
+			SDL_free(resampler->output);
+		}
+		SDL_free(resampler);
+	}
+}
+
+/* Make room for 'count' more input frames */
+static int SDL_ReserveFrames(SDL_Resampler *resampler, int count)
+{
+	float *input;
+	int capacity, c;
+
+	/* First drop the frames the filter has moved past */
+	if ( (resampler->frames + count > resampler->capacity) &&
+	     (resampler->pos > 0) ) {
+		for ( c = 0; c < resampler->channels; ++c ) {
+			input = resampler->input + c * resampler->capacity;
+			SDL_memmove(input, input + resampler->pos,
+			     (resampler->frames - resampler->pos) * sizeof(float));
+		}
+		resampler->frames -= resampler->pos;
+		resampler->pos = 0;
+	}
+	if ( resampler->frames + count <= resampler->capacity ) {
+		return(0);
+	}
+
+	capacity = resampler->capacity;
+	while ( capacity < resampler->frames + count ) {
+		capacity = capacity ? capacity * 2 : SDL_RESAMPLE_BLOCK;
+	}
+	input = (float *)SDL_malloc(capacity * resampler->channels *
+	                            sizeof(float));
+	if ( input == NULL ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	if ( resampler->input ) {
+		for ( c = 0; c < resampler->channels; ++c ) {
+			SDL_memcpy(input + c * capacity,
+			           resampler->input + c * resampler->capacity,
+			           resampler->frames * sizeof(float));
+		}
+		SDL_free(resampler->input);
+	}
+	resampler->input = input;
+	resampler->capacity = capacity;
+	return(0);
+}
+
+static void SDL_SilenceFrames(SDL_Resampler *resampler, int count)
+{
+	int c;
+
+	for ( c = 0; c < resampler->channels; ++c ) {
+		SDL_memset(resampler->input + c * resampler->capacity +
+		           resampler->frames, 0, count * sizeof(float));
+	}
+	resampler->frames += count;
+}
+
+void SDL_ResamplerClear(SDL_Resampler *resampler)
+{
+	int history = resampler->filter->taps / 2 - 1;
+
+	/* Start with silence before the first frame */
+	resampler->frames = 0;
+	resampler->pos = 0;
+	resampler->phase = 0;
+	resampler->padding = 0;
+	if ( SDL_ReserveFrames(resampler, history) == 0 ) {
+		SDL_SilenceFrames(resampler, history);
+	}
+}
+
+#define LOAD_FRAMES(value) \
+	for ( i = 0; i < count; ++i ) { \
+		for ( c = 0; c < channels; ++c, ++n ) { \
+			input[c * capacity + i] = (value); \
+		} \
+	}
+
+int SDL_ResamplerPut(SDL_Resampler *resampler, const Uint8 *src, int len)
+{
+	int count = len / resampler->framesize;
+	int channels = resampler->channels;
+	int capacity, i, c, n = 0;
+	float *input;
+
+	if ( resampler->padding ) {
+		resampler->frames -= resampler->padding;
+		resampler->padding = 0;
+	}
+	if ( SDL_ReserveFrames(resampler, count) < 0 ) {
+		return(-1);
+	}
+	capacity = resampler->capacity;
+	input = resampler->input + resampler->frames;
+	switch (resampler->format) {
+	    case AUDIO_U8:
+		LOAD_FRAMES((src[n] - 128) * (1.0f / 128.0f));
+		break;
+	    case AUDIO_S8:
+		LOAD_FRAMES((Sint8)src[n] * (1.0f / 128.0f));
+		break;
+	    case AUDIO_U16LSB:
+		LOAD_FRAMES((((src[2*n+1] << 8) | src[2*n]) - 32768) *
+		            (1.0f / 32768.0f));
+		break;
+	    case AUDIO_S16LSB:
+		LOAD_FRAMES((Sint16)((src[2*n+1] << 8) | src[2*n]) *
+		            (1.0f / 32768.0f));
+		break;
+	    case AUDIO_U16MSB:
+		LOAD_FRAMES((((src[2*n] << 8) | src[2*n+1]) - 32768) *
+		            (1.0f / 32768.0f));
+		break;
+	    case AUDIO_S16MSB:
+		LOAD_FRAMES((Sint16)((src[2*n] << 8) | src[2*n+1]) *
+		            (1.0f / 32768.0f));
+		break;
+	    case AUDIO_S32LSB:
+		LOAD_FRAMES((Sint32)SDL_AUDIO_GET32LSB(src + 4*n) *
+		            (1.0f / 2147483648.0f));
+		break;
+	    case AUDIO_S32MSB:
+		LOAD_FRAMES((Sint32)SDL_AUDIO_GET32MSB(src + 4*n) *
+		            (1.0f / 2147483648.0f));
+		break;
+	    case AUDIO_F32LSB:
+		LOAD_FRAMES(SDL_AudioBitsToFloat(SDL_AUDIO_GET32LSB(src + 4*n)));
+		break;
+	    case AUDIO_F32MSB:
+		LOAD_FRAMES(SDL_AudioBitsToFloat(SDL_AUDIO_GET32MSB(src + 4*n)));
+		break;
+	}
+	resampler->frames += count;
+	return(0);
+}
+
+int SDL_ResamplerFlush(SDL_Resampler *resampler)
+{
+	int padding = resampler->filter->taps / 2;
+
+	if ( resampler->padding ) {
+		return(0);
+	}
+	if ( SDL_ReserveFrames(resampler, padding) < 0 ) {
+		return(-1);
+	}
+	SDL_SilenceFrames(resampler, padding);
+	resampler->padding = padding;
+	return(0);
+}
+
+/* The number of output frames the buffered input is enough for */
+static int SDL_ResampleFramesReady(SDL_Resampler *resampler)
+{
+	SDL_ResampleFilter *filter = resampler->filter;
+	double last, ready, end;
+
+	/* Outputs whose whole filter window has been put */
+	last = resampler->frames - filter->taps - resampler->pos;
+	if ( last < 0 ) {
+		return(0);
+	}
+	ready = (double)(int)(((last + 1) * filter->up - resampler->phase - 1) /
+	                      filter->down) + 1;
+
+	/* After a flush, only outputs up to the end of the real input */
+	if ( resampler->padding ) {
+		end = (resampler->frames - resampler->padding -
+		       resampler->pos - filter->taps / 2 + 1) * filter->up -
+		      resampler->phase;
+		if ( end <= 0 ) {
+			return(0);
+		}
+		end = (double)(int)((end - 1) / filter->down) + 1;
+		if ( ready > end ) {
+			ready = end;
+		}
+	}
+	if ( ready > 0x7FFFFFFF / resampler->framesize ) {
+		ready = 0x7FFFFFFF / resampler->framesize;
+	}
+	return (int)ready;
+}
+
+int SDL_ResamplerAvailable(SDL_Resampler *resampler)
+{
+	return SDL_ResampleFramesReady(resampler) * resampler->framesize;
+}
+
+int SDL_ResamplerGet(SDL_Resampler *resampler, Uint8 *dst, int len)
+{
+	SDL_ResampleFilter *filter = resampler->filter;
+	int channels = resampler->channels;
+	int capacity = resampler->capacity;
+	int count, block, total, f, c;
+	const float *input;
+	const float *coeffs;
+	float *output;
+
+	count = len / resampler->framesize;
+	total = SDL_ResampleFramesReady(resampler);
+	if ( count > total ) {
+		count = total;
+	}
+	total = count;
+
+	while ( count > 0 ) {
+		block = count;
+		if ( block > SDL_RESAMPLE_BLOCK ) {
+			block = SDL_RESAMPLE_BLOCK;
+		}
+
+		output = resampler->output;
+		for ( f = 0; f < block; ++f ) {
+			input = resampler->input + resampler->pos;
+			coeffs = filter->coeffs + resampler->phase * filter->taps;
+			for ( c = 0; c < channels; ++c ) {
+				*output++ = resampler->dot(input + c * capacity,
+				                           coeffs, filter->taps);
+			}
+			resampler->phase += filter->down;
+			if ( resampler->phase >= filter->up ) {
+				resampler->pos += resampler->phase / filter->up;
+				resampler->phase %= filter->up;
+			}
+		}
+
+		SDL_ConvertSamplesFromFloat(resampler->format,
+		                            resampler->output, dst,
+		                            block * channels);
+		dst += block * resampler->framesize;
+		count -= block;
+	}
+	return total * resampler->framesize;
+}
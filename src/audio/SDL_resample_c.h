@@ -0,0 +1,79 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Band-limited sample rate conversion with polyphase windowed-sinc filters */
+
+#ifndef _SDL_resample_c_h
+#define _SDL_resample_c_h
+
+#include "SDL_audio.h"
+
+typedef struct SDL_Resampler SDL_Resampler;
+
+/* Ratios needing more filter phases than this are approximated */
+#define SDL_RESAMPLE_MAX_PHASES	1024
+
+/* Quality levels, selecting 8, 16, 32 or 64 taps per output sample */
+#define SDL_RESAMPLE_FAST	0
+#define SDL_RESAMPLE_MEDIUM	1
+#define SDL_RESAMPLE_HIGH	2
+#define SDL_RESAMPLE_BEST	3
+
+/* Share filter tables between resamplers while the audio is initialized */
+extern void SDL_ResamplerInit(void);
+extern void SDL_ResamplerQuit(void);
+
+/* The quality set with SDL_AUDIO_RESAMPLE_QUALITY, or the default */
+extern int SDL_GetResampleQuality(void);
+
+/* Find 'up'/'down' close to 'ratio' (output rate over input rate), with
+   'up' no more than SDL_RESAMPLE_MAX_PHASES.
+ */
+extern void SDL_FindRateRatio(double ratio, int *up, int *down);
+
+/* Create a resampler producing 'up' output frames per 'down' input frames */
+extern SDL_Resampler *SDL_CreateResampler(Uint16 format, int channels,
+                                          int up, int down, int quality);
+extern void SDL_FreeResampler(SDL_Resampler *resampler);
+
+/* Add input bytes, which must be whole frames.  Returns 0, or -1 if out
+   of memory.
+ */
+extern int SDL_ResamplerPut(SDL_Resampler *resampler,
+                            const Uint8 *src, int len);
+
+/* Pad the input with silence, so everything put so far can be read.
+   Putting more input afterwards discards the padding again.
+ */
+extern int SDL_ResamplerFlush(SDL_Resampler *resampler);
+
+/* The number of output bytes that can be read */
+extern int SDL_ResamplerAvailable(SDL_Resampler *resampler);
+
+/* Read up to 'len' bytes of output, returning the number read */
+extern int SDL_ResamplerGet(SDL_Resampler *resampler, Uint8 *dst, int len);
+
+/* Throw away all input and output, starting again from silence */
+extern void SDL_ResamplerClear(SDL_Resampler *resampler);
+
+#endif /* _SDL_resample_c_h */
@@ -61,6 +61,9 @@ struct SDL_AudioDevice {
 
 	void (*SetCaption)(_THIS, const char *caption);
 
+	/* Milliseconds until audio written now is heard, or -1 if unknown */
+	int (*GetLatency)(_THIS);
+
 	/* * * */
 	/* Data common to all devices */
 
@@ -70,6 +73,12 @@ struct SDL_AudioDevice {
 	/* An audio conversion block for audio format emulation */
 	SDL_AudioCVT convert;
 
+	/* Rate conversion run by the audio thread, after the format */
+	struct SDL_Resampler *resampler;
+
+	/* Audio pushed with SDL_QueueAudio(), when there's no callback */
+	struct SDL_AudioQueue *queue;
+
 	/* Current state flags */
 	int enabled;
 	int paused;
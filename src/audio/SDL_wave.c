@@ -441,6 +441,7 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 	int lenread;
 	int MS_ADPCM_encoded, IMA_ADPCM_encoded;
 	int samplesize;
+	Uint16 encoding;
 
 	/* WAV magic header */
 	Uint32 RIFFchunk;
@@ -499,8 +500,14 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 		goto done;
 	}
 	MS_ADPCM_encoded = IMA_ADPCM_encoded = 0;
-	switch (SDL_SwapLE16(format->encoding)) {
+	encoding = SDL_SwapLE16(format->encoding);
+	if ( (encoding == EXTENSIBLE_CODE) && (lenread >= 26) ) {
+		/* The sub-format GUID starts with the real format code */
+		encoding = (chunk.data[25] << 8) | chunk.data[24];
+	}
+	switch (encoding) {
 		case PCM_CODE:
+		case IEEE_FLOAT_CODE:
 			/* We can understand this */
 			break;
 		case MS_ADPCM_CODE:
@@ -526,7 +533,7 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 			goto done;
 		default:
 			SDL_SetError("Unknown WAVE data format: 0x%.4x",
-					SDL_SwapLE16(format->encoding));
+					encoding);
 			was_error = 1;
 			goto done;
 	}
@@ -546,10 +553,20 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 		case 16:
 			spec->format = AUDIO_S16;
 			break;
+		case 32:
+			if ( encoding == IEEE_FLOAT_CODE ) {
+				spec->format = AUDIO_F32;
+			} else {
+				spec->format = AUDIO_S32;
+			}
+			break;
 		default:
 			was_error = 1;
 			break;
 	}
+	if ( (encoding == IEEE_FLOAT_CODE) && (spec->format != AUDIO_F32) ) {
+		was_error = 1;
+	}
 	if ( was_error ) {
 		SDL_SetError("Unknown %d-bit PCM data format",
 			SDL_SwapLE16(format->bitspersample));
@@ -25,6 +25,8 @@
 
 #include <sys/types.h>
 #include <signal.h>	/* For kill() */
+#include <errno.h>
+#include <poll.h>
 
 #include "SDL_timer.h"
 #include "SDL_audio.h"
@@ -85,6 +87,19 @@ static int (*SDL_NAME(snd_pcm_sw_params_current))(snd_pcm_t *pcm, snd_pcm_sw_par
 static int (*SDL_NAME(snd_pcm_sw_params_set_start_threshold))(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, snd_pcm_uframes_t val);
 static int (*SDL_NAME(snd_pcm_sw_params))(snd_pcm_t *pcm, snd_pcm_sw_params_t *params);
 static int (*SDL_NAME(snd_pcm_nonblock))(snd_pcm_t *pcm, int nonblock);
+static int (*SDL_NAME(snd_pcm_sw_params_get_boundary))(const snd_pcm_sw_params_t *params, snd_pcm_uframes_t *val);
+static int (*SDL_NAME(snd_pcm_sw_params_set_stop_threshold))(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, snd_pcm_uframes_t val);
+static int (*SDL_NAME(snd_pcm_sw_params_set_silence_threshold))(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, snd_pcm_uframes_t val);
+static int (*SDL_NAME(snd_pcm_sw_params_set_silence_size))(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, snd_pcm_uframes_t val);
+static snd_pcm_state_t (*SDL_NAME(snd_pcm_state))(snd_pcm_t *pcm);
+static int (*SDL_NAME(snd_pcm_start))(snd_pcm_t *pcm);
+static snd_pcm_sframes_t (*SDL_NAME(snd_pcm_avail_update))(snd_pcm_t *pcm);
+static snd_pcm_sframes_t (*SDL_NAME(snd_pcm_forward))(snd_pcm_t *pcm, snd_pcm_uframes_t frames);
+static int (*SDL_NAME(snd_pcm_mmap_begin))(snd_pcm_t *pcm, const snd_pcm_channel_area_t **areas, snd_pcm_uframes_t *offset, snd_pcm_uframes_t *frames);
+static snd_pcm_sframes_t (*SDL_NAME(snd_pcm_mmap_commit))(snd_pcm_t *pcm, snd_pcm_uframes_t offset, snd_pcm_uframes_t frames);
+static int (*SDL_NAME(snd_pcm_poll_descriptors_count))(snd_pcm_t *pcm);
+static int (*SDL_NAME(snd_pcm_poll_descriptors))(snd_pcm_t *pcm, struct pollfd *pfds, unsigned int space);
+static int (*SDL_NAME(snd_pcm_poll_descriptors_revents))(snd_pcm_t *pcm, struct pollfd *pfds, unsigned int nfds, unsigned short *revents);
 #define snd_pcm_hw_params_sizeof SDL_NAME(snd_pcm_hw_params_sizeof)
 #define snd_pcm_sw_params_sizeof SDL_NAME(snd_pcm_sw_params_sizeof)
 
@@ -121,6 +136,19 @@ static struct {
 	{ "snd_pcm_sw_params_set_start_threshold",	(void**)(char*)&SDL_NAME(snd_pcm_sw_params_set_start_threshold)	},
 	{ "snd_pcm_sw_params",	(void**)(char*)&SDL_NAME(snd_pcm_sw_params)	},
 	{ "snd_pcm_nonblock",	(void**)(char*)&SDL_NAME(snd_pcm_nonblock)	},
+	{ "snd_pcm_sw_params_get_boundary",	(void**)(char*)&SDL_NAME(snd_pcm_sw_params_get_boundary)	},
+	{ "snd_pcm_sw_params_set_stop_threshold",	(void**)(char*)&SDL_NAME(snd_pcm_sw_params_set_stop_threshold)	},
+	{ "snd_pcm_sw_params_set_silence_threshold",	(void**)(char*)&SDL_NAME(snd_pcm_sw_params_set_silence_threshold)	},
+	{ "snd_pcm_sw_params_set_silence_size",	(void**)(char*)&SDL_NAME(snd_pcm_sw_params_set_silence_size)	},
+	{ "snd_pcm_state",	(void**)(char*)&SDL_NAME(snd_pcm_state)	},
+	{ "snd_pcm_start",	(void**)(char*)&SDL_NAME(snd_pcm_start)	},
+	{ "snd_pcm_avail_update",	(void**)(char*)&SDL_NAME(snd_pcm_avail_update)	},
+	{ "snd_pcm_forward",	(void**)(char*)&SDL_NAME(snd_pcm_forward)	},
+	{ "snd_pcm_mmap_begin",	(void**)(char*)&SDL_NAME(snd_pcm_mmap_begin)	},
+	{ "snd_pcm_mmap_commit",	(void**)(char*)&SDL_NAME(snd_pcm_mmap_commit)	},
+	{ "snd_pcm_poll_descriptors_count",	(void**)(char*)&SDL_NAME(snd_pcm_poll_descriptors_count)	},
+	{ "snd_pcm_poll_descriptors",	(void**)(char*)&SDL_NAME(snd_pcm_poll_descriptors)	},
+	{ "snd_pcm_poll_descriptors_revents",	(void**)(char*)&SDL_NAME(snd_pcm_poll_descriptors_revents)	},
 };
 
 static void UnloadALSALibrary(void) {
@@ -249,20 +277,13 @@ AudioBootStrap ALSA_bootstrap = {
 	Audio_Available, Audio_CreateDevice
 };
 
-/* This function waits until it is possible to write a full sound buffer */
-static void ALSA_WaitAudio(_THIS)
-{
-	/* We're in blocking mode, so there's nothing to do here */
-}
-
-
 /*
  * http://bugzilla.libsdl.org/show_bug.cgi?id=110
  * "For Linux ALSA, this is FL-FR-RL-RR-C-LFE
  *  and for Windows DirectX [and CoreAudio], this is FL-FR-C-LFE-RL-RR"
  */
 #define SWIZ6(T) \
-    T *ptr = (T *) mixbuf; \
+    T *ptr = (T *) buf; \
     Uint32 i; \
     for (i = 0; i < this->spec.samples; i++, ptr += 6) { \
         T tmp; \
@@ -270,30 +291,30 @@ static void ALSA_WaitAudio(_THIS)
         tmp = ptr[3]; ptr[3] = ptr[5]; ptr[5] = tmp; \
     }
 
-static __inline__ void swizzle_alsa_channels_6_64bit(_THIS) { SWIZ6(Uint64); }
-static __inline__ void swizzle_alsa_channels_6_32bit(_THIS) { SWIZ6(Uint32); }
-static __inline__ void swizzle_alsa_channels_6_16bit(_THIS) { SWIZ6(Uint16); }
-static __inline__ void swizzle_alsa_channels_6_8bit(_THIS) { SWIZ6(Uint8); }
+static __inline__ void swizzle_alsa_channels_6_64bit(_THIS, Uint8 *buf) { SWIZ6(Uint64); }
+static __inline__ void swizzle_alsa_channels_6_32bit(_THIS, Uint8 *buf) { SWIZ6(Uint32); }
+static __inline__ void swizzle_alsa_channels_6_16bit(_THIS, Uint8 *buf) { SWIZ6(Uint16); }
+static __inline__ void swizzle_alsa_channels_6_8bit(_THIS, Uint8 *buf) { SWIZ6(Uint8); }
 
 #undef SWIZ6
 
 
 /*
- * Called right before feeding this->mixbuf to the hardware. Swizzle channels
- *  from Windows/Mac order to the format alsalib will want.
+ * Called right before feeding a buffer from GetAudioBuf to the hardware.
+ *  Swizzle channels from Windows/Mac order to the format alsalib will want.
  */
-static __inline__ void swizzle_alsa_channels(_THIS)
+static __inline__ void swizzle_alsa_channels(_THIS, Uint8 *buf)
 {
     if (this->spec.channels == 6) {
         const Uint16 fmtsize = (this->spec.format & 0xFF); /* bits/channel. */
         if (fmtsize == 16)
-            swizzle_alsa_channels_6_16bit(this);
+            swizzle_alsa_channels_6_16bit(this, buf);
         else if (fmtsize == 8)
-            swizzle_alsa_channels_6_8bit(this);
+            swizzle_alsa_channels_6_8bit(this, buf);
         else if (fmtsize == 32)
-            swizzle_alsa_channels_6_32bit(this);
+            swizzle_alsa_channels_6_32bit(this, buf);
         else if (fmtsize == 64)
-            swizzle_alsa_channels_6_64bit(this);
+            swizzle_alsa_channels_6_64bit(this, buf);
     }
 
     /* !!! FIXME: update this for 7.1 if needed, later. */
@@ -319,26 +340,157 @@ static int ALSA_pcm_recover(snd_pcm_t *handle, int err, int silent)
 	return err;
 }
 
+/* Returns how many frames can be written, or a negative error code */
+static snd_pcm_sframes_t ALSA_avail(_THIS)
+{
+	snd_pcm_sframes_t avail;
+
+	avail = SDL_NAME(snd_pcm_avail_update)(pcm_handle);
+	if ( avail < 0 ) {
+		return(avail);
+	}
+
+	/* The stream keeps running through an underrun and plays silence,
+	   so our write position may have fallen behind the hardware.
+	   Skip ahead to it instead of stopping and re-preparing the stream.
+	 */
+	if ( (snd_pcm_uframes_t)avail > this->hidden->bufsize ) {
+		SDL_NAME(snd_pcm_forward)(pcm_handle, avail - this->hidden->bufsize);
+		avail = this->hidden->bufsize;
+	}
+	return(avail);
+}
+
+/* Sleep in poll() until the device wants more audio */
+static int ALSA_poll(_THIS)
+{
+	unsigned short revents;
+	int timeout;
+	int status;
+
+	/* Wake up at least once per buffer so closing the device isn't held up */
+	timeout = (int)((this->hidden->bufsize * 1000) / this->spec.freq) + 1;
+	status = poll(this->hidden->pollfds, this->hidden->npollfds, timeout);
+	if ( status < 0 ) {
+		return (errno == EINTR) ? 0 : -errno;
+	}
+	if ( status > 0 ) {
+		/* Some plugins need this to clear their wakeup */
+		status = SDL_NAME(snd_pcm_poll_descriptors_revents)(pcm_handle, this->hidden->pollfds, this->hidden->npollfds, &revents);
+		if ( status < 0 ) {
+			return(status);
+		}
+	}
+	return(0);
+}
+
+/* This function waits until it is possible to write a full sound buffer */
+static void ALSA_WaitAudio(_THIS)
+{
+	snd_pcm_sframes_t avail;
+	int status;
+
+	while ( this->enabled ) {
+		avail = ALSA_avail(this);
+		if ( avail < 0 ) {
+			status = ALSA_pcm_recover(pcm_handle, (int)avail, 0);
+		} else if ( avail >= (snd_pcm_sframes_t)this->spec.samples ) {
+			break;
+		} else {
+			status = ALSA_poll(this);
+		}
+		if ( status < 0 ) {
+			/* Hmm, not much we can do - abort */
+			fprintf(stderr, "ALSA wait failed (unrecoverable): %s\n", SDL_NAME(snd_strerror)(status));
+			this->enabled = 0;
+		}
+	}
+}
+
+/* Returns the address of 'offset' frames into the mmap ring buffer */
+static __inline__ Uint8 *ALSA_mmap_address(const snd_pcm_channel_area_t *areas, snd_pcm_uframes_t offset)
+{
+	return (Uint8 *)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8;
+}
+
+static snd_pcm_sframes_t ALSA_mmap_commit(_THIS, snd_pcm_uframes_t offset, snd_pcm_uframes_t frames)
+{
+	snd_pcm_sframes_t status;
+
+	status = SDL_NAME(snd_pcm_mmap_commit)(pcm_handle, offset, frames);
+
+	/* Unlike snd_pcm_writei(), committing doesn't start the stream */
+	if ( status > 0 &&
+	     SDL_NAME(snd_pcm_state)(pcm_handle) == SND_PCM_STATE_PREPARED ) {
+		SDL_NAME(snd_pcm_start)(pcm_handle);
+	}
+	return(status);
+}
+
+/* Copies as much of 'buf' into the mmap ring buffer as will fit in one go */
+static snd_pcm_sframes_t ALSA_mmap_write(_THIS, const Uint8 *buf, snd_pcm_uframes_t frames)
+{
+	const int frame_size = (((int) (this->spec.format & 0xFF)) / 8) * this->spec.channels;
+	const snd_pcm_channel_area_t *areas;
+	snd_pcm_uframes_t offset;
+	snd_pcm_sframes_t avail;
+	int status;
+
+	avail = ALSA_avail(this);
+	if ( avail <= 0 ) {
+		return (avail < 0) ? avail : -EAGAIN;
+	}
+	if ( frames > (snd_pcm_uframes_t)avail ) {
+		frames = avail;
+	}
+	status = SDL_NAME(snd_pcm_mmap_begin)(pcm_handle, &areas, &offset, &frames);
+	if ( status < 0 ) {
+		return(status);
+	}
+	SDL_memcpy(ALSA_mmap_address(areas, offset), buf, frames * frame_size);
+	return ALSA_mmap_commit(this, offset, frames);
+}
+
 static void ALSA_PlayAudio(_THIS)
 {
 	int status;
+	snd_pcm_sframes_t written;
 	snd_pcm_uframes_t frames_left;
 	const Uint8 *sample_buf = (const Uint8 *) mixbuf;
 	const int frame_size = (((int) (this->spec.format & 0xFF)) / 8) * this->spec.channels;
 
-	swizzle_alsa_channels(this);
+	if ( this->hidden->mmap_frames ) {
+		/* The audio was written straight into the ring buffer */
+		swizzle_alsa_channels(this, this->hidden->mmap_buf);
+		written = ALSA_mmap_commit(this, this->hidden->mmap_offset, this->hidden->mmap_frames);
+		this->hidden->mmap_frames = 0;
+		if ( written < 0 ) {
+			status = ALSA_pcm_recover(pcm_handle, (int)written, 0);
+			if ( status < 0 ) {
+				fprintf(stderr, "ALSA write failed (unrecoverable): %s\n", SDL_NAME(snd_strerror)(status));
+				this->enabled = 0;
+			}
+		}
+		return;
+	}
+
+	swizzle_alsa_channels(this, mixbuf);
 
 	frames_left = ((snd_pcm_uframes_t) this->spec.samples);
 
 	while ( frames_left > 0 && this->enabled ) {
-		status = SDL_NAME(snd_pcm_writei)(pcm_handle, sample_buf, frames_left);
-		if ( status < 0 ) {
-			if ( status == -EAGAIN ) {
+		if ( this->hidden->mmap ) {
+			written = ALSA_mmap_write(this, sample_buf, frames_left);
+		} else {
+			written = SDL_NAME(snd_pcm_writei)(pcm_handle, sample_buf, frames_left);
+		}
+		if ( written < 0 ) {
+			if ( written == -EAGAIN ) {
 				/* Apparently snd_pcm_recover() doesn't handle this case. Foo. */
-				SDL_Delay(1);
-				continue;
+				status = ALSA_poll(this);
+			} else {
+				status = ALSA_pcm_recover(pcm_handle, (int)written, 0);
 			}
-			status = ALSA_pcm_recover(pcm_handle, status, 0);
 			if ( status < 0 ) {
 				/* Hmm, not much we can do - abort */
 				fprintf(stderr, "ALSA write failed (unrecoverable): %s\n", SDL_NAME(snd_strerror)(status));
@@ -347,13 +499,32 @@ static void ALSA_PlayAudio(_THIS)
 			}
 			continue;
 		}
-		sample_buf += status * frame_size;
-		frames_left -= status;
+		sample_buf += written * frame_size;
+		frames_left -= written;
 	}
 }
 
 static Uint8 *ALSA_GetAudioBuf(_THIS)
 {
+	const snd_pcm_channel_area_t *areas;
+	snd_pcm_uframes_t offset;
+	snd_pcm_uframes_t frames;
+
+	/* If a whole period is free and doesn't wrap around the end of the
+	   ring buffer, let the audio be written straight into it.
+	 */
+	this->hidden->mmap_frames = 0;
+	if ( this->hidden->mmap &&
+	     ALSA_avail(this) >= (snd_pcm_sframes_t)this->spec.samples ) {
+		frames = this->spec.samples;
+		if ( SDL_NAME(snd_pcm_mmap_begin)(pcm_handle, &areas, &offset, &frames) >= 0 &&
+		     frames == this->spec.samples ) {
+			this->hidden->mmap_buf = ALSA_mmap_address(areas, offset);
+			this->hidden->mmap_offset = offset;
+			this->hidden->mmap_frames = frames;
+			return(this->hidden->mmap_buf);
+		}
+	}
 	return(mixbuf);
 }
 
@@ -367,17 +538,26 @@ static void ALSA_CloseAudio(_THIS)
 		/* Wait for the submitted audio to drain
 		   snd_pcm_drop() can hang, so don't use that.
 		 */
-		Uint32 delay = ((this->spec.samples * 1000) / this->spec.freq) * 2;
+		Uint32 delay = (this->hidden->bufsize * 1000) / this->spec.freq;
 		SDL_Delay(delay);
 		SDL_NAME(snd_pcm_close)(pcm_handle);
 		pcm_handle = NULL;
 	}
+	if ( this->hidden->pollfds != NULL ) {
+		SDL_free(this->hidden->pollfds);
+		this->hidden->pollfds = NULL;
+		this->hidden->npollfds = 0;
+	}
+	this->hidden->mmap = 0;
+	this->hidden->mmap_frames = 0;
+	this->hidden->bufsize = 0;
 }
 
 static int ALSA_finalize_hardware(_THIS, SDL_AudioSpec *spec, snd_pcm_hw_params_t *hwparams, int override)
 {
 	int status;
 	snd_pcm_uframes_t bufsize;
+	unsigned int periods;
 
 	/* "set" the hardware with the desired parameters */
 	status = SDL_NAME(snd_pcm_hw_params)(pcm_handle, hwparams);
@@ -390,22 +570,25 @@ static int ALSA_finalize_hardware(_THIS, SDL_AudioSpec *spec, snd_pcm_hw_params_
 	if ( status < 0 ) {
 		return(-1);
 	}
-	if ( !override && bufsize != spec->samples * 2 ) {
+	if ( !override && bufsize != spec->samples * this->hidden->periods ) {
 		return(-1);
 	}
+	status = SDL_NAME(snd_pcm_hw_params_get_periods)(hwparams, &periods, NULL);
+	if ( status < 0 || periods == 0 ) {
+		periods = this->hidden->periods;
+	}
 
 	/* FIXME: Is this safe to do? */
-	spec->samples = bufsize / 2;
+	spec->samples = bufsize / periods;
+	this->hidden->bufsize = bufsize;
 
 	/* This is useful for debugging */
 	if ( getenv("SDL_AUDIO_ALSA_DEBUG") ) {
 		snd_pcm_uframes_t persize = 0;
-		unsigned int periods = 0;
 
 		SDL_NAME(snd_pcm_hw_params_get_period_size)(hwparams, &persize, NULL);
-		SDL_NAME(snd_pcm_hw_params_get_periods)(hwparams, &periods, NULL);
 
-		fprintf(stderr, "ALSA: period size = %ld, periods = %u, buffer size = %lu\n", persize, periods, bufsize);
+		fprintf(stderr, "ALSA: period size = %ld, periods = %u, buffer size = %lu, %s\n", persize, periods, bufsize, this->hidden->mmap ? "mmap" : "read/write");
 	}
 	return(0);
 }
@@ -438,7 +621,7 @@ static int ALSA_set_period_size(_THIS, SDL_AudioSpec *spec, snd_pcm_hw_params_t
 		return(-1);
 	}
 
-	periods = 2;
+	periods = this->hidden->periods;
 	status = SDL_NAME(snd_pcm_hw_params_set_periods_near)(pcm_handle, hwparams, &periods, NULL);
 	if ( status < 0 ) {
 		return(-1);
@@ -468,7 +651,7 @@ static int ALSA_set_buffer_size(_THIS, SDL_AudioSpec *spec, snd_pcm_hw_params_t
 		}
 	}
 
-	frames = spec->samples * 2;
+	frames = spec->samples * this->hidden->periods;
 	status = SDL_NAME(snd_pcm_hw_params_set_buffer_size_near)(pcm_handle, hwparams, &frames);
 	if ( status < 0 ) {
 		return(-1);
@@ -479,9 +662,11 @@ static int ALSA_set_buffer_size(_THIS, SDL_AudioSpec *spec, snd_pcm_hw_params_t
 
 static int ALSA_OpenAudio(_THIS, SDL_AudioSpec *spec)
 {
+	const char          *env;
 	int                  status;
 	snd_pcm_hw_params_t *hwparams;
 	snd_pcm_sw_params_t *swparams;
+	snd_pcm_uframes_t    boundary;
 	snd_pcm_format_t     format;
 	unsigned int         rate;
 	unsigned int 	     channels;
@@ -496,9 +681,9 @@ static int ALSA_OpenAudio(_THIS, SDL_AudioSpec *spec)
 		return(-1);
 	}
 
-	/* Switch to blocking mode for playback */
-	/* Note: this must happen before hw/sw params are set. */
-	SDL_NAME(snd_pcm_nonblock)(pcm_handle, 0);
+	/* Stay in non-blocking mode for playback, ALSA_WaitAudio() sleeps
+	   in poll() until there is room for another period.
+	 */
 
 	/* Figure out what the hardware is capable of */
 	snd_pcm_hw_params_alloca(&hwparams);
@@ -509,8 +694,18 @@ static int ALSA_OpenAudio(_THIS, SDL_AudioSpec *spec)
 		return(-1);
 	}
 
-	/* SDL only uses interleaved sample output */
-	status = SDL_NAME(snd_pcm_hw_params_set_access)(pcm_handle, hwparams, SND_PCM_ACCESS_RW_INTERLEAVED);
+	/* SDL only uses interleaved sample output, and would rather write it
+	   straight into the ring buffer than have it copied there.
+	 */
+	status = -1;
+	env = SDL_getenv("SDL_AUDIO_ALSA_MMAP");
+	if ( !env || SDL_atoi(env) ) {
+		status = SDL_NAME(snd_pcm_hw_params_set_access)(pcm_handle, hwparams, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+	}
+	this->hidden->mmap = (status >= 0);
+	if ( !this->hidden->mmap ) {
+		status = SDL_NAME(snd_pcm_hw_params_set_access)(pcm_handle, hwparams, SND_PCM_ACCESS_RW_INTERLEAVED);
+	}
 	if ( status < 0 ) {
 		SDL_SetError("Couldn't set interleaved access: %s", SDL_NAME(snd_strerror)(status));
 		ALSA_CloseAudio(this);
@@ -540,6 +735,18 @@ static int ALSA_OpenAudio(_THIS, SDL_AudioSpec *spec)
 			case AUDIO_U16MSB:
 				format = SND_PCM_FORMAT_U16_BE;
 				break;
+			case AUDIO_S32LSB:
+				format = SND_PCM_FORMAT_S32_LE;
+				break;
+			case AUDIO_S32MSB:
+				format = SND_PCM_FORMAT_S32_BE;
+				break;
+			case AUDIO_F32LSB:
+				format = SND_PCM_FORMAT_FLOAT_LE;
+				break;
+			case AUDIO_F32MSB:
+				format = SND_PCM_FORMAT_FLOAT_BE;
+				break;
 			default:
 				format = 0;
 				break;
@@ -583,6 +790,11 @@ static int ALSA_OpenAudio(_THIS, SDL_AudioSpec *spec)
 	spec->freq = rate;
 
 	/* Set the buffer size, in samples */
+	this->hidden->periods = 2;
+	env = SDL_getenv("SDL_AUDIO_ALSA_PERIODS");
+	if ( env && SDL_atoi(env) > 2 ) {
+		this->hidden->periods = SDL_atoi(env);
+	}
 	if ( ALSA_set_period_size(this, spec, hwparams, 0) < 0 &&
 	     ALSA_set_buffer_size(this, spec, hwparams, 0) < 0 ) {
 		/* Failed to set desired buffer size, do the best you can... */
@@ -613,6 +825,24 @@ static int ALSA_OpenAudio(_THIS, SDL_AudioSpec *spec)
 		ALSA_CloseAudio(this);
 		return(-1);
 	}
+	/* Keep running through underruns, playing silence, rather than
+	   stopping the stream and stalling until it is prepared again.
+	 */
+	status = SDL_NAME(snd_pcm_sw_params_get_boundary)(swparams, &boundary);
+	if ( status >= 0 ) {
+		status = SDL_NAME(snd_pcm_sw_params_set_stop_threshold)(pcm_handle, swparams, boundary);
+	}
+	if ( status >= 0 ) {
+		status = SDL_NAME(snd_pcm_sw_params_set_silence_threshold)(pcm_handle, swparams, 0);
+	}
+	if ( status >= 0 ) {
+		status = SDL_NAME(snd_pcm_sw_params_set_silence_size)(pcm_handle, swparams, boundary);
+	}
+	if ( status < 0 ) {
+		SDL_SetError("Couldn't set underrun handling: %s", SDL_NAME(snd_strerror)(status));
+		ALSA_CloseAudio(this);
+		return(-1);
+	}
 	status = SDL_NAME(snd_pcm_sw_params)(pcm_handle, swparams);
 	if ( status < 0 ) {
 		SDL_SetError("Couldn't set software audio parameters: %s", SDL_NAME(snd_strerror)(status));
@@ -620,6 +850,27 @@ static int ALSA_OpenAudio(_THIS, SDL_AudioSpec *spec)
 		return(-1);
 	}
 
+	/* Get the descriptors to poll() for room in the ring buffer */
+	status = SDL_NAME(snd_pcm_poll_descriptors_count)(pcm_handle);
+	if ( status <= 0 ) {
+		SDL_SetError("Couldn't get poll descriptors");
+		ALSA_CloseAudio(this);
+		return(-1);
+	}
+	this->hidden->npollfds = status;
+	this->hidden->pollfds = (struct pollfd *)SDL_malloc(status * sizeof(struct pollfd));
+	if ( this->hidden->pollfds == NULL ) {
+		SDL_OutOfMemory();
+		ALSA_CloseAudio(this);
+		return(-1);
+	}
+	status = SDL_NAME(snd_pcm_poll_descriptors)(pcm_handle, this->hidden->pollfds, this->hidden->npollfds);
+	if ( status < 0 ) {
+		SDL_SetError("Couldn't get poll descriptors: %s", SDL_NAME(snd_strerror)(status));
+		ALSA_CloseAudio(this);
+		return(-1);
+	}
+
 	/* Calculate the final parameters for this audio specification */
 	SDL_CalculateAudioSpec(spec);
 
@@ -38,6 +38,21 @@ struct SDL_PrivateAudioData {
 	/* Raw mixing buffer */
 	Uint8 *mixbuf;
 	int    mixlen;
+
+	/* The ring buffer size in frames, split into this many periods */
+	snd_pcm_uframes_t bufsize;
+	unsigned int periods;
+
+	/* Whether the ring buffer is written through mmap, and the part of
+	   it handed out by the last GetAudioBuf, if any */
+	int mmap;
+	Uint8 *mmap_buf;
+	snd_pcm_uframes_t mmap_offset;
+	snd_pcm_uframes_t mmap_frames;
+
+	/* The descriptors to poll() for room in the ring buffer */
+	struct pollfd *pollfds;
+	unsigned int npollfds;
 };
 
 /* Old variable names */
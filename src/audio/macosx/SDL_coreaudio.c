@@ -222,7 +222,9 @@ int Core_OpenAudio(_THIS, SDL_AudioSpec *spec)
     requestedDesc.mSampleRate = spec->freq;
 
     requestedDesc.mBitsPerChannel = spec->format & 0xFF;
-    if (spec->format & 0x8000)
+    if (spec->format & 0x0100)
+        requestedDesc.mFormatFlags |= kLinearPCMFormatFlagIsFloat;
+    else if (spec->format & 0x8000)
         requestedDesc.mFormatFlags |= kLinearPCMFormatFlagIsSignedInteger;
     if (spec->format & 0x1000)
         requestedDesc.mFormatFlags |= kLinearPCMFormatFlagIsBigEndian;
@@ -58,6 +58,7 @@ static Uint8 *PULSE_GetAudioBuf(_THIS);
 static void PULSE_CloseAudio(_THIS);
 static void PULSE_WaitDone(_THIS);
 static void PULSE_SetCaption(_THIS, const char *str);
+static int PULSE_GetLatency(_THIS);
 
 #ifdef SDL_AUDIO_DRIVER_PULSE_DYNAMIC
 
@@ -117,6 +118,15 @@ static int (*SDL_NAME(pa_stream_disconnect))(pa_stream *s);
 static void (*SDL_NAME(pa_stream_unref))(pa_stream *s);
 static pa_operation* (*SDL_NAME(pa_context_set_name))(pa_context *c,
 	const char *name, pa_context_success_cb_t cb, void *userdata);
+static void (*SDL_NAME(pa_stream_set_write_callback))(pa_stream *s,
+	pa_stream_request_cb_t cb, void *userdata);
+static int (*SDL_NAME(pa_stream_get_latency))(pa_stream *s,
+	pa_usec_t *r_usec, int *negative);
+#ifdef SDL_PULSE_BEGIN_WRITE
+static int (*SDL_NAME(pa_stream_begin_write))(pa_stream *s,
+	void **data, size_t *nbytes);
+static int (*SDL_NAME(pa_stream_cancel_write))(pa_stream *s);
+#endif
 
 static struct {
 	const char *name;
@@ -170,6 +180,16 @@ static struct {
 		(void **)&SDL_NAME(pa_stream_unref)		},
 	{ "pa_context_set_name",
 		(void **)&SDL_NAME(pa_context_set_name)		},
+	{ "pa_stream_set_write_callback",
+		(void **)&SDL_NAME(pa_stream_set_write_callback)	},
+	{ "pa_stream_get_latency",
+		(void **)&SDL_NAME(pa_stream_get_latency)	},
+#ifdef SDL_PULSE_BEGIN_WRITE
+	{ "pa_stream_begin_write",
+		(void **)&SDL_NAME(pa_stream_begin_write)	},
+	{ "pa_stream_cancel_write",
+		(void **)&SDL_NAME(pa_stream_cancel_write)	},
+#endif
 };
 
 static void UnloadPulseLibrary()
@@ -289,6 +309,7 @@ static SDL_AudioDevice *Audio_CreateDevice(int devindex)
 	this->CloseAudio = PULSE_CloseAudio;
 	this->WaitDone = PULSE_WaitDone;
 	this->SetCaption = PULSE_SetCaption;
+	this->GetLatency = PULSE_GetLatency;
 
 	this->free = Audio_DeleteDevice;
 
@@ -300,35 +321,83 @@ AudioBootStrap PULSE_bootstrap = {
 	Audio_Available, Audio_CreateDevice
 };
 
+/* Called from the main loop when the server wants more audio */
+static void stream_write_request(pa_stream *s, size_t nbytes, void *userdata)
+{
+	SDL_AudioDevice *this = (SDL_AudioDevice *)userdata;
+
+	this->hidden->writable = nbytes;
+}
+
 /* This function waits until it is possible to write a full sound buffer */
 static void PULSE_WaitAudio(_THIS)
 {
-	int size;
-	while(1) {
+	pa_usec_t usec;
+	int negative;
+	int block;
+
+	/* Handle anything that has already arrived, then sleep until the
+	   write callback says there is room for a whole buffer.
+	 */
+	block = 0;
+	do {
 		if (SDL_NAME(pa_context_get_state)(context) != PA_CONTEXT_READY ||
 		    SDL_NAME(pa_stream_get_state)(stream) != PA_STREAM_READY ||
-		    SDL_NAME(pa_mainloop_iterate)(mainloop, 1, NULL) < 0) {
+		    SDL_NAME(pa_mainloop_iterate)(mainloop, block, NULL) < 0) {
 			this->enabled = 0;
 			return;
 		}
-		size = SDL_NAME(pa_stream_writable_size)(stream);
-		if (size >= mixlen)
-			return;
+		block = 1;
+	} while (this->hidden->writable < (size_t)mixlen);
+
+	/* Timing info is kept up to date by the server, so this is cheap */
+	if (SDL_NAME(pa_stream_get_latency)(stream, &usec, &negative) == 0) {
+		this->hidden->latency = negative ? 0 : (int)(usec / 1000);
 	}
 }
 
 static void PULSE_PlayAudio(_THIS)
 {
-	/* Write the audio data */
-	if (SDL_NAME(pa_stream_write)(stream, mixbuf, mixlen, NULL, 0LL, PA_SEEK_RELATIVE) < 0)
+	void *buf;
+
+	/* Write the audio data, without a copy if it's in the server's block */
+	buf = this->hidden->writebuf ? this->hidden->writebuf : mixbuf;
+	this->hidden->writebuf = NULL;
+	if (SDL_NAME(pa_stream_write)(stream, buf, mixlen, NULL, 0LL, PA_SEEK_RELATIVE) < 0) {
 		this->enabled = 0;
+		return;
+	}
+	if (this->hidden->writable > (size_t)mixlen) {
+		this->hidden->writable -= mixlen;
+	} else {
+		this->hidden->writable = 0;
+	}
 }
 
 static Uint8 *PULSE_GetAudioBuf(_THIS)
 {
+#ifdef SDL_PULSE_BEGIN_WRITE
+	void *data;
+	size_t nbytes;
+
+	/* Have the audio written straight into a block the server can use */
+	nbytes = mixlen;
+	if (SDL_NAME(pa_stream_begin_write)(stream, &data, &nbytes) == 0) {
+		if (nbytes >= (size_t)mixlen) {
+			this->hidden->writebuf = data;
+			return((Uint8 *)data);
+		}
+		SDL_NAME(pa_stream_cancel_write)(stream);
+	}
+#endif
 	return(mixbuf);
 }
 
+static int PULSE_GetLatency(_THIS)
+{
+	return(this->hidden->latency);
+}
+
 static void PULSE_CloseAudio(_THIS)
 {
 	if ( mixbuf != NULL ) {
@@ -349,6 +418,23 @@ static void PULSE_CloseAudio(_THIS)
 		SDL_NAME(pa_mainloop_free)(mainloop);
 		mainloop = NULL;
 	}
+	this->hidden->writable = 0;
+	this->hidden->writebuf = NULL;
+	this->hidden->latency = -1;
+}
+
+/* Get a buffer attribute from the environment, in milliseconds */
+static Uint32 get_buffer_attr(const char *name, Uint32 bytes, const SDL_AudioSpec *spec)
+{
+	const char *env;
+	int ms;
+
+	env = SDL_getenv(name);
+	if ( env && (ms = SDL_atoi(env)) > 0 ) {
+		bytes = ((Uint32)spec->freq * ms / 1000) *
+		        ((spec->format & 0xFF) / 8) * spec->channels;
+	}
+	return(bytes);
 }
 
 /* Try to get the name of the program */
@@ -426,6 +512,7 @@ static int PULSE_OpenAudio(_THIS, SDL_AudioSpec *spec)
 {
 	int             state;
 	Uint16          test_format;
+	Uint32          tlength;
 	pa_sample_spec  paspec;
 	pa_buffer_attr  paattr;
 	pa_channel_map  pacmap;
@@ -443,6 +530,18 @@ static int PULSE_OpenAudio(_THIS, SDL_AudioSpec *spec)
 			case AUDIO_S16MSB:
 				paspec.format = PA_SAMPLE_S16BE;
 				break;
+			case AUDIO_S32LSB:
+				paspec.format = PA_SAMPLE_S32LE;
+				break;
+			case AUDIO_S32MSB:
+				paspec.format = PA_SAMPLE_S32BE;
+				break;
+			case AUDIO_F32LSB:
+				paspec.format = PA_SAMPLE_FLOAT32LE;
+				break;
+			case AUDIO_F32MSB:
+				paspec.format = PA_SAMPLE_FLOAT32BE;
+				break;
 		}
 		if ( paspec.format != PA_SAMPLE_INVALID )
 			break;
@@ -473,18 +572,32 @@ static int PULSE_OpenAudio(_THIS, SDL_AudioSpec *spec)
 
 	/* Reduced prebuffering compared to the defaults. */
 #ifdef PA_STREAM_ADJUST_LATENCY
-	paattr.tlength = mixlen * 4; /* 2x original requested bufsize */
+	tlength = mixlen * 4; /* 2x original requested bufsize */
+#else
+	tlength = mixlen * 2;
+#endif
+	tlength = get_buffer_attr("SDL_AUDIO_PULSE_TLENGTH", tlength, spec);
+	if ( tlength < (Uint32)mixlen * 2 ) {
+		tlength = mixlen * 2; /* Must have room for a whole buffer */
+	}
+#ifdef PA_STREAM_ADJUST_LATENCY
+	paattr.tlength = tlength;
 	paattr.prebuf = -1;
 	paattr.maxlength = -1;
-	paattr.minreq = mixlen; /* -1 can lead to pa_stream_writable_size()
-				   >= mixlen never becoming true */
+	paattr.minreq = mixlen; /* -1 can lead to the write callback never
+				   asking for a whole mixlen */
 	flags = PA_STREAM_ADJUST_LATENCY;
 #else
-	paattr.tlength = mixlen*2;
-	paattr.prebuf = mixlen*2;
-	paattr.maxlength = mixlen*2;
+	paattr.tlength = tlength;
+	paattr.prebuf = tlength;
+	paattr.maxlength = tlength;
 	paattr.minreq = mixlen;
 #endif
+	paattr.minreq = get_buffer_attr("SDL_AUDIO_PULSE_MINREQ", paattr.minreq, spec);
+
+	/* Keep the stream latency up to date for SDL_GetAudioLatency() */
+	flags |= PA_STREAM_INTERPOLATE_TIMING | PA_STREAM_AUTO_TIMING_UPDATE;
+	this->hidden->latency = -1;
 
 	/* The SDL ALSA output hints us that we use Windows' channel mapping */
 	/* http://bugzilla.libsdl.org/show_bug.cgi?id=110 */
@@ -545,6 +658,8 @@ static int PULSE_OpenAudio(_THIS, SDL_AudioSpec *spec)
 		return(-1);
 	}
 
+	SDL_NAME(pa_stream_set_write_callback)(stream, stream_write_request, this);
+
 	if (SDL_NAME(pa_stream_connect_playback)(stream, NULL, &paattr, flags,
 			NULL, NULL) < 0) {
 		PULSE_CloseAudio(this);
@@ -42,8 +42,24 @@ struct SDL_PrivateAudioData {
 	/* Raw mixing buffer */
 	Uint8 *mixbuf;
 	int    mixlen;
+
+	/* Bytes the server last asked for, less what has been written since */
+	size_t writable;
+
+	/* The server's memory block handed out by GetAudioBuf, if any */
+	void *writebuf;
+
+	/* The stream latency in milliseconds, as of the last write, or -1 */
+	int latency;
 };
 
+/* pa_stream_begin_write() was added in pulseaudio 0.9.16 */
+#ifdef PA_CHECK_VERSION
+#if PA_CHECK_VERSION(0,9,16)
+#define SDL_PULSE_BEGIN_WRITE	1
+#endif
+#endif
+
 #if (PA_API_VERSION < 12)
 /** Return non-zero if the passed state is one of the connected states */
 static inline int PA_CONTEXT_IS_GOOD(pa_context_state_t x) {
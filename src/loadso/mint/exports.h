@@ -287,6 +287,45 @@
 	LIBFUNCRET64(115, SDL_ReadLE64_purec, 2)
 	LIBFUNCRET64(116, SDL_ReadBE64_purec, 2)
 
+/* Video extensions */
+	LIBFUNC(SDL_SetBlendMode, 2)
+	LIBFUNC(SDL_GetBlendMode, 1)
+	LIBFUNC(SDL_TransformBlit, 11)
+	LIBFUNC(SDL_MapRGBAArray, 4)
+	LIBFUNC(SDL_GetRGBAArray, 4)
+	LIBFUNC(SDL_GetRGBAPlanar, 7)
+	LIBFUNC(SDL_GetSurfacePitch, 1)
+	LIBFUNC(SDL_UpperBlitLarge, 4)
+	LIBFUNC(SDL_LowerBlitLarge, 4)
+	LIBFUNC(SDL_FillRectLarge, 3)
+	LIBFUNC(SDL_LoadBMPFromMem, 2)
+	LIBFUNC(SDL_ConvertSurfaces, 5)
+	LIBFUNC(SDL_ConvertSurfaceInPlace, 3)
+	LIBFUNC(SDL_CreateCommandList, 0)
+	LIBFUNC(SDL_FreeCommandList, 1)
+	LIBFUNC(SDL_RecordBlit, 5)
+	LIBFUNC(SDL_RecordFillRect, 4)
+	LIBFUNC(SDL_RecordStretch, 5)
+	LIBFUNC(SDL_RecordUpdateRects, 4)
+	LIBFUNC(SDL_SubmitCommandList, 1)
+	LIBFUNC(SDL_WaitCommandList, 1)
+	LIBFUNC(SDL_CreateYUVOverlayFrom, 6)
+	LIBFUNC(SDL_SetYUVOverlayPlanes, 3)
+
+/* Audio extensions */
+	LIBFUNC(SDL_NewAudioStream, 6)
+	LIBFUNC(SDL_AudioStreamPut, 3)
+	LIBFUNC(SDL_AudioStreamGet, 3)
+	LIBFUNC(SDL_AudioStreamAvailable, 1)
+	LIBFUNC(SDL_AudioStreamFlush, 1)
+	LIBFUNC(SDL_AudioStreamClear, 1)
+	LIBFUNC(SDL_FreeAudioStream, 1)
+	LIBFUNC(SDL_MixAudioMulti, 6)
+	LIBFUNC(SDL_QueueAudio, 2)
+	LIBFUNC(SDL_GetQueuedAudioSize, 0)
+	LIBFUNC(SDL_ClearQueuedAudio, 0)
+	LIBFUNC(SDL_GetAudioLatency, 0)
+
 #undef LIBFUNC
 #undef LIBFUNC2
 #undef LIBFUNCRET64
@@ -39,9 +39,9 @@
 #include "mmx.h"
 #endif
 
-/* The general purpose software blit routine */
-static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
-			SDL_Surface *dst, SDL_Rect *dstrect)
+/* The general purpose software blit routine, on 32-bit coordinates */
+int SDL_SoftBlitLarge(SDL_Surface *src, const SDL_LargeRect *srcrect,
+		      SDL_Surface *dst, const SDL_LargeRect *dstrect)
 {
 	int okay;
 	int src_locked;
@@ -73,24 +73,27 @@ static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 	if ( okay  && srcrect->w && srcrect->h ) {
 		SDL_BlitInfo info;
 		SDL_loblit RunBlit;
+		Uint32 src_pitch = SURFACE_PITCH(src);
+		Uint32 dst_pitch = SURFACE_PITCH(dst);
 
-		/* Set up the blit information */
+		/* Set up the blit information, the offsets may exceed 4 GB */
 		info.s_pixels = (Uint8 *)src->pixels +
-				(Uint16)srcrect->y*src->pitch +
-				(Uint16)srcrect->x*src->format->BytesPerPixel;
+				(size_t)srcrect->y*src_pitch +
+				(size_t)srcrect->x*src->format->BytesPerPixel;
 		info.s_width = srcrect->w;
 		info.s_height = srcrect->h;
-		info.s_skip=src->pitch-info.s_width*src->format->BytesPerPixel;
+		info.s_skip=src_pitch-info.s_width*src->format->BytesPerPixel;
 		info.d_pixels = (Uint8 *)dst->pixels +
-				(Uint16)dstrect->y*dst->pitch +
-				(Uint16)dstrect->x*dst->format->BytesPerPixel;
+				(size_t)dstrect->y*dst_pitch +
+				(size_t)dstrect->x*dst->format->BytesPerPixel;
 		info.d_width = dstrect->w;
 		info.d_height = dstrect->h;
-		info.d_skip=dst->pitch-info.d_width*dst->format->BytesPerPixel;
+		info.d_skip=dst_pitch-info.d_width*dst->format->BytesPerPixel;
 		info.aux_data = src->map->sw_data->aux_data;
 		info.src = src->format;
 		info.table = src->map->table;
 		info.dst = dst->format;
+		info.flags = src->flags;
 		RunBlit = src->map->sw_data->blit;
 
 		/* Run the actual software blit */
@@ -108,6 +111,22 @@ static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 	return(okay ? 0 : -1);
 }
 
+static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
+			SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	SDL_LargeRect sr, dr;
+
+	sr.x = (Uint16)srcrect->x;
+	sr.y = (Uint16)srcrect->y;
+	sr.w = srcrect->w;
+	sr.h = srcrect->h;
+	dr.x = (Uint16)dstrect->x;
+	dr.y = (Uint16)dstrect->y;
+	dr.w = dstrect->w;
+	dr.h = dstrect->h;
+	return(SDL_SoftBlitLarge(src, &sr, dst, &dr));
+}
+
 #ifdef MMX_ASMBLIT
 static __inline__ void SDL_memcpyMMX(Uint8 *to, const Uint8 *from, int len)
 {
@@ -242,7 +261,8 @@ int SDL_CalculateBlit(SDL_Surface *surface)
 
 	/* Figure out if an accelerated hardware blit is possible */
 	surface->flags &= ~SDL_HWACCEL;
-	if ( surface->map->identity ) {
+	if ( surface->map->identity &&
+	     surface->map->blendmode == SDL_BLENDMODE_NONE ) {
 		int hw_blit_ok;
 
 		if ( (surface->flags & SDL_HWSURFACE) == SDL_HWSURFACE ) {
@@ -280,7 +300,8 @@ int SDL_CalculateBlit(SDL_Surface *surface)
 	}
 	
 	/* if an alpha pixel format is specified, we can accelerate alpha blits */
-	if (((surface->flags & SDL_HWSURFACE) == SDL_HWSURFACE )&&(current_video->displayformatalphapixel)) 
+	if (((surface->flags & SDL_HWSURFACE) == SDL_HWSURFACE )&&(current_video->displayformatalphapixel)
+	    && (surface->map->blendmode == SDL_BLENDMODE_NONE)) 
 	{
 		if ( (surface->flags & SDL_SRCALPHA) ) 
 			if ( current_video->info.blit_hw_A ) {
@@ -300,6 +321,11 @@ int SDL_CalculateBlit(SDL_Surface *surface)
 	        blit_index |= 2;
 	}
 
+	/* Blend modes have their own set of blitters */
+	if ( surface->map->blendmode != SDL_BLENDMODE_NONE ) {
+		surface->map->sw_data->blit =
+		    SDL_CalculateBlendBlit(surface, blit_index);
+	} else
 	/* Check for special "identity" case -- copy blit */
 	if ( surface->map->identity && blit_index == 0 ) {
 	        surface->map->sw_data->blit = SDL_BlitCopy;
@@ -339,7 +365,10 @@ int SDL_CalculateBlit(SDL_Surface *surface)
 
 	/* Choose software blitting function */
 	if(surface->flags & SDL_RLEACCELOK
-	   && (surface->flags & SDL_HWACCEL) != SDL_HWACCEL) {
+	   && (surface->flags & SDL_HWACCEL) != SDL_HWACCEL
+	   && surface->map->blendmode == SDL_BLENDMODE_NONE
+	   && !(surface->flags & SDL_LARGESURFACE)
+	   && !(surface->map->dst->flags & SDL_LARGESURFACE)) {
 
 	        if(surface->map->identity
 		   && (blit_index == 1
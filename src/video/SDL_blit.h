@@ -43,6 +43,7 @@ typedef struct {
 	SDL_PixelFormat *src;
 	Uint8 *table;
 	SDL_PixelFormat *dst;
+	Uint32 flags;		/* flags of the source surface */
 } SDL_BlitInfo;
 
 /* The type definition for the low level blit functions */
@@ -67,17 +68,41 @@ typedef struct SDL_BlitMap {
 	/* the version count matches the destination; mismatch indicates
 	   an invalid mapping */
         unsigned int format_version;
+
+	/* SDL_BLENDMODE_* used when blitting from the owning surface,
+	   survives SDL_InvalidateMap() */
+	int blendmode;
+
+	/* Palette entries of the owning surface changed since its format
+	   version 'palette_base', so maps targeting it can be patched
+	   instead of rebuilt.  Also survives SDL_InvalidateMap() */
+	unsigned int palette_base;
+	Uint32 palette_dirty[256/32];
+
+	/* Palette entries of the owning surface changed since this map was
+	   made, patched into the table before the next blit */
+	int remap_pending;
+	Uint32 remap_dirty[256/32];
 } SDL_BlitMap;
 
 
+/* The row pitch of a surface, which may exceed 65535 bytes for surfaces
+   created with SDL_LARGESURFACE */
+#define SURFACE_PITCH(surface)						\
+	(((surface)->flags & SDL_LARGESURFACE) ?			\
+	 (surface)->unused1 : (Uint32)(surface)->pitch)
+
 /* Functions found in SDL_blit.c */
 extern int SDL_CalculateBlit(SDL_Surface *surface);
+extern int SDL_SoftBlitLarge(SDL_Surface *src, const SDL_LargeRect *srcrect,
+			     SDL_Surface *dst, const SDL_LargeRect *dstrect);
 
-/* Functions found in SDL_blit_{0,1,N,A}.c */
+/* Functions found in SDL_blit_{0,1,N,A,B}.c */
 extern SDL_loblit SDL_CalculateBlit0(SDL_Surface *surface, int complex);
 extern SDL_loblit SDL_CalculateBlit1(SDL_Surface *surface, int complex);
 extern SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int complex);
 extern SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int complex);
+extern SDL_loblit SDL_CalculateBlendBlit(SDL_Surface *surface, int complex);
 
 /*
  * Useful macros for blitting routines
@@ -0,0 +1,490 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+#include "SDL_video.h"
+#include "SDL_blit.h"
+
+/* Functions to perform additive, modulating and multiplying blits.
+   All of them leave the destination alpha channel untouched.
+ */
+
+#if SDL_ASSEMBLY_ROUTINES
+#  if (defined(__GNUC__) && defined(__SSE2__)) || \
+      (defined(_MSC_VER) && (defined(_M_X64) || (_M_IX86_FP >= 2)))
+#    define SSE2_BLENDBLIT 1
+#  endif
+#  if defined(__GNUC__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#    define NEON_BLENDBLIT 1
+#  endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
+
+/* Function to check the CPU flags */
+#include "SDL_cpuinfo.h"
+#if SSE2_BLENDBLIT
+#include <emmintrin.h>
+#endif
+#if NEON_BLENDBLIT
+#include <arm_neon.h>
+#endif
+
+/* x*y/255, correctly rounded for all 8-bit x and y */
+static __inline__ unsigned Mul8(unsigned x, unsigned y)
+{
+	unsigned t = x*y + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+/* The per-channel operations; every SIMD path must match these exactly */
+#define BLEND_ADD(s, d, a)	(d + Mul8(s, a))
+#define BLEND_MOD(s, d, a)	((void)(a), Mul8(s, d))
+#define BLEND_MUL(s, d, a)	(Mul8(s, d) + Mul8(d, 255 - (a)))
+
+#define CLAMP8(v)	((v) > 255 ? 255 : (v))
+
+/* Get the blend alpha of the source pixel, 255 if alpha is disabled */
+#define BLEND_ALPHA(info, Pixel, sA)					\
+do {									\
+	if ( !((info)->flags & SDL_SRCALPHA) ) {			\
+		sA = SDL_ALPHA_OPAQUE;					\
+	} else if ( (info)->src->Amask ) {				\
+		sA = (((Pixel)&(info)->src->Amask)>>(info)->src->Ashift)\
+		     <<(info)->src->Aloss;				\
+	} else {							\
+		sA = (info)->src->alpha;				\
+	}								\
+} while(0)
+
+/* General (slow) N->N blend, for any 16, 24 or 32 bit source and target */
+#define DEFINE_BLITNTON_BLEND(name, OP)					\
+static void name(SDL_BlitInfo *info)					\
+{									\
+	int width = info->d_width;					\
+	int height = info->d_height;					\
+	Uint8 *src = info->s_pixels;					\
+	int srcskip = info->s_skip;					\
+	Uint8 *dst = info->d_pixels;					\
+	int dstskip = info->d_skip;					\
+	SDL_PixelFormat *srcfmt = info->src;				\
+	SDL_PixelFormat *dstfmt = info->dst;				\
+	int srcbpp = srcfmt->BytesPerPixel;				\
+	int dstbpp = dstfmt->BytesPerPixel;				\
+	Uint32 rgbmask = srcfmt->Rmask | srcfmt->Gmask | srcfmt->Bmask;	\
+	Uint32 ckey = srcfmt->colorkey & rgbmask;			\
+	int use_key = (info->flags & SDL_SRCCOLORKEY);			\
+									\
+	while ( height-- ) {						\
+	    DUFFS_LOOP4(						\
+	    {								\
+		Uint32 Pixel;						\
+		unsigned sR;						\
+		unsigned sG;						\
+		unsigned sB;						\
+		unsigned sA;						\
+		unsigned dR;						\
+		unsigned dG;						\
+		unsigned dB;						\
+		unsigned dA;						\
+		RETRIEVE_RGB_PIXEL(src, srcbpp, Pixel);			\
+		if ( !use_key || (Pixel & rgbmask) != ckey ) {		\
+		    BLEND_ALPHA(info, Pixel, sA);			\
+		    RGB_FROM_PIXEL(Pixel, srcfmt, sR, sG, sB);		\
+		    DISEMBLE_RGBA(dst, dstbpp, dstfmt, Pixel,		\
+				  dR, dG, dB, dA);			\
+		    dR = OP(sR, dR, sA); dR = CLAMP8(dR);		\
+		    dG = OP(sG, dG, sA); dG = CLAMP8(dG);		\
+		    dB = OP(sB, dB, sA); dB = CLAMP8(dB);		\
+		    ASSEMBLE_RGBA(dst, dstbpp, dstfmt, dR, dG, dB, dA);	\
+		}							\
+		src += srcbpp;						\
+		dst += dstbpp;						\
+	    },								\
+	    width);							\
+	    src += srcskip;						\
+	    dst += dstskip;						\
+	}								\
+}
+
+DEFINE_BLITNTON_BLEND(BlitNtoNBlendAdd, BLEND_ADD)
+DEFINE_BLITNTON_BLEND(BlitNtoNBlendMod, BLEND_MOD)
+DEFINE_BLITNTON_BLEND(BlitNtoNBlendMul, BLEND_MUL)
+
+/* Blend one pixel between two 32-bit surfaces with the same 8-bit RGB
+   channel layout.  This is also used for the tails of the SIMD rows. */
+static __inline__ Uint32 BlendPixelRGB(int mode, Uint32 s, Uint32 d,
+				       unsigned a, Uint32 keep)
+{
+	Uint32 out = d & keep;
+	int shift;
+
+	for ( shift = 0; shift < 32; shift += 8 ) {
+		unsigned sc, dc, v;
+
+		if ( (keep >> shift) & 0xff ) {
+			continue;
+		}
+		sc = (s >> shift) & 0xff;
+		dc = (d >> shift) & 0xff;
+		switch (mode) {
+		    case SDL_BLENDMODE_ADD:
+			v = BLEND_ADD(sc, dc, a);
+			break;
+		    case SDL_BLENDMODE_MOD:
+			v = BLEND_MOD(sc, dc, a);
+			break;
+		    default:
+			v = BLEND_MUL(sc, dc, a);
+			break;
+		}
+		out |= (Uint32)CLAMP8(v) << shift;
+	}
+	return out;
+}
+
+/* Blend one row of 32-bit pixels with the portable code */
+static void BlendRowRGB(int mode, SDL_BlitInfo *info,
+			const Uint32 *srcp, Uint32 *dstp, int width)
+{
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	Uint32 rgbmask = srcfmt->Rmask | srcfmt->Gmask | srcfmt->Bmask;
+	Uint32 ckey = srcfmt->colorkey & rgbmask;
+	Uint32 keep = ~(dstfmt->Rmask | dstfmt->Gmask | dstfmt->Bmask);
+	int use_key = (info->flags & SDL_SRCCOLORKEY);
+
+	while ( width-- ) {
+		Uint32 s = *srcp++;
+		unsigned sA;
+		if ( !use_key || (s & rgbmask) != ckey ) {
+			BLEND_ALPHA(info, s, sA);
+			*dstp = BlendPixelRGB(mode, s, *dstp, sA, keep);
+		}
+		++dstp;
+	}
+}
+
+/* fast RGB888->(A)RGB888 blends, for all three modes */
+static void BlitRGBtoRGBBlend(int mode, SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+
+	while ( height-- ) {
+		BlendRowRGB(mode, info, srcp, dstp, width);
+		srcp += width + srcskip;
+		dstp += width + dstskip;
+	}
+}
+
+static void BlitRGBtoRGBBlendAdd(SDL_BlitInfo *info)
+{
+	BlitRGBtoRGBBlend(SDL_BLENDMODE_ADD, info);
+}
+
+static void BlitRGBtoRGBBlendMod(SDL_BlitInfo *info)
+{
+	BlitRGBtoRGBBlend(SDL_BLENDMODE_MOD, info);
+}
+
+static void BlitRGBtoRGBBlendMul(SDL_BlitInfo *info)
+{
+	BlitRGBtoRGBBlend(SDL_BLENDMODE_MUL, info);
+}
+
+#if SSE2_BLENDBLIT
+/* x*y/255 on 16-bit lanes, same rounding as Mul8() */
+static __inline__ __m128i Mul8SSE2(__m128i x, __m128i y)
+{
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/* SSE2 RGB888->(A)RGB888 blends, 4 pixels at a time */
+static void BlitRGBtoRGBBlendSSE2(int mode, SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	Uint32 rgbmask = srcfmt->Rmask | srcfmt->Gmask | srcfmt->Bmask;
+	int use_key = (info->flags & SDL_SRCCOLORKEY);
+	int pixel_alpha = (info->flags & SDL_SRCALPHA) && srcfmt->Amask;
+	unsigned sA = (info->flags & SDL_SRCALPHA) ?
+	              srcfmt->alpha : SDL_ALPHA_OPAQUE;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mm_rgb = _mm_set1_epi32(rgbmask);
+	const __m128i mm_key = _mm_set1_epi32(srcfmt->colorkey & rgbmask);
+	const __m128i mm_keep = _mm_set1_epi32(
+		~(dstfmt->Rmask | dstfmt->Gmask | dstfmt->Bmask));
+	const __m128i mm_ashift = _mm_cvtsi32_si128(srcfmt->Ashift);
+	const __m128i mm_aff = _mm_set1_epi32(0xff);
+	const __m128i mm_255 = _mm_set1_epi16(255);
+	const __m128i mm_salpha = _mm_set1_epi16(sA);
+
+	while ( height-- ) {
+		int n = width >> 2;
+		while ( n-- ) {
+			__m128i s = _mm_loadu_si128((__m128i *)src);
+			__m128i d = _mm_loadu_si128((__m128i *)dst);
+			__m128i slo = _mm_unpacklo_epi8(s, zero);
+			__m128i shi = _mm_unpackhi_epi8(s, zero);
+			__m128i dlo = _mm_unpacklo_epi8(d, zero);
+			__m128i dhi = _mm_unpackhi_epi8(d, zero);
+			__m128i alo = mm_salpha, ahi = mm_salpha;
+			__m128i r;
+
+			if ( pixel_alpha ) {
+				/* replicate each pixel's alpha into its 4 words */
+				__m128i a = _mm_and_si128(
+					_mm_srl_epi32(s, mm_ashift), mm_aff);
+				a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+				alo = _mm_unpacklo_epi32(a, a);
+				ahi = _mm_unpackhi_epi32(a, a);
+			}
+			switch (mode) {
+			    case SDL_BLENDMODE_ADD:
+				r = _mm_packus_epi16(Mul8SSE2(slo, alo),
+				                     Mul8SSE2(shi, ahi));
+				r = _mm_adds_epu8(d, r);
+				break;
+			    case SDL_BLENDMODE_MOD:
+				r = _mm_packus_epi16(Mul8SSE2(slo, dlo),
+				                     Mul8SSE2(shi, dhi));
+				break;
+			    default:
+				slo = _mm_adds_epu16(Mul8SSE2(slo, dlo),
+					Mul8SSE2(dlo, _mm_sub_epi16(mm_255, alo)));
+				shi = _mm_adds_epu16(Mul8SSE2(shi, dhi),
+					Mul8SSE2(dhi, _mm_sub_epi16(mm_255, ahi)));
+				r = _mm_packus_epi16(slo, shi);
+				break;
+			}
+			/* keep the destination alpha (or padding) bits */
+			r = _mm_or_si128(_mm_and_si128(d, mm_keep),
+			                 _mm_andnot_si128(mm_keep, r));
+			if ( use_key ) {
+				__m128i k = _mm_cmpeq_epi32(
+					_mm_and_si128(s, mm_rgb), mm_key);
+				r = _mm_or_si128(_mm_and_si128(k, d),
+				                 _mm_andnot_si128(k, r));
+			}
+			_mm_storeu_si128((__m128i *)dst, r);
+			src += 16;
+			dst += 16;
+		}
+		n = width & 3;
+		BlendRowRGB(mode, info, (Uint32 *)src, (Uint32 *)dst, n);
+		src += n * 4 + srcskip;
+		dst += n * 4 + dstskip;
+	}
+}
+
+static void BlitRGBtoRGBBlendAddSSE2(SDL_BlitInfo *info)
+{
+	BlitRGBtoRGBBlendSSE2(SDL_BLENDMODE_ADD, info);
+}
+
+static void BlitRGBtoRGBBlendModSSE2(SDL_BlitInfo *info)
+{
+	BlitRGBtoRGBBlendSSE2(SDL_BLENDMODE_MOD, info);
+}
+
+static void BlitRGBtoRGBBlendMulSSE2(SDL_BlitInfo *info)
+{
+	BlitRGBtoRGBBlendSSE2(SDL_BLENDMODE_MUL, info);
+}
+#endif /* SSE2_BLENDBLIT */
+
+#if NEON_BLENDBLIT
+/* x*y/255 with NEON rounding shifts, same rounding as Mul8() */
+static __inline__ uint8x8_t Mul8NEON(uint8x8_t x, uint8x8_t y)
+{
+	uint16x8_t p = vmull_u8(x, y);
+	return vrshrn_n_u16(vrsraq_n_u16(p, p, 8), 8);
+}
+
+static __inline__ uint8x16_t Mul8qNEON(uint8x16_t x, uint8x16_t y)
+{
+	return vcombine_u8(Mul8NEON(vget_low_u8(x), vget_low_u8(y)),
+	                   Mul8NEON(vget_high_u8(x), vget_high_u8(y)));
+}
+
+/* NEON RGB888->(A)RGB888 blends, 4 pixels at a time */
+static void BlitRGBtoRGBBlendNEON(int mode, SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	Uint32 rgbmask = srcfmt->Rmask | srcfmt->Gmask | srcfmt->Bmask;
+	int use_key = (info->flags & SDL_SRCCOLORKEY);
+	int pixel_alpha = (info->flags & SDL_SRCALPHA) && srcfmt->Amask;
+	unsigned sA = (info->flags & SDL_SRCALPHA) ?
+	              srcfmt->alpha : SDL_ALPHA_OPAQUE;
+	const uint32x4_t mm_rgb = vdupq_n_u32(rgbmask);
+	const uint32x4_t mm_key = vdupq_n_u32(srcfmt->colorkey & rgbmask);
+	const uint32x4_t mm_keep = vdupq_n_u32(
+		~(dstfmt->Rmask | dstfmt->Gmask | dstfmt->Bmask));
+	const int32x4_t mm_ashift = vdupq_n_s32(-(int)srcfmt->Ashift);
+	const uint8x16_t mm_salpha = vdupq_n_u8(sA);
+
+	while ( height-- ) {
+		int n = width >> 2;
+		while ( n-- ) {
+			uint32x4_t s32 = vld1q_u32((const uint32_t *)src);
+			uint32x4_t d32 = vld1q_u32((const uint32_t *)dst);
+			uint8x16_t s = vreinterpretq_u8_u32(s32);
+			uint8x16_t d = vreinterpretq_u8_u32(d32);
+			uint8x16_t a = mm_salpha;
+			uint32x4_t r;
+
+			if ( pixel_alpha ) {
+				uint32x4_t a32 = vandq_u32(
+					vshlq_u32(s32, mm_ashift), vdupq_n_u32(0xff));
+				a = vreinterpretq_u8_u32(
+					vmulq_n_u32(a32, 0x01010101));
+			}
+			switch (mode) {
+			    case SDL_BLENDMODE_ADD:
+				r = vreinterpretq_u32_u8(
+					vqaddq_u8(d, Mul8qNEON(s, a)));
+				break;
+			    case SDL_BLENDMODE_MOD:
+				r = vreinterpretq_u32_u8(Mul8qNEON(s, d));
+				break;
+			    default:
+				r = vreinterpretq_u32_u8(
+					vqaddq_u8(Mul8qNEON(s, d),
+					          Mul8qNEON(d, vmvnq_u8(a))));
+				break;
+			}
+			/* keep the destination alpha (or padding) bits */
+			r = vbslq_u32(mm_keep, d32, r);
+			if ( use_key ) {
+				uint32x4_t k = vceqq_u32(
+					vandq_u32(s32, mm_rgb), mm_key);
+				r = vbslq_u32(k, d32, r);
+			}
+			vst1q_u32((uint32_t *)dst, r);
+			src += 16;
+			dst += 16;
+		}
+		n = width & 3;
+		BlendRowRGB(mode, info, (Uint32 *)src, (Uint32 *)dst, n);
+		src += n * 4 + srcskip;
+		dst += n * 4 + dstskip;
+	}
+}
+
+static void BlitRGBtoRGBBlendAddNEON(SDL_BlitInfo *info)
+{
+	BlitRGBtoRGBBlendNEON(SDL_BLENDMODE_ADD, info);
+}
+
+static void BlitRGBtoRGBBlendModNEON(SDL_BlitInfo *info)
+{
+	BlitRGBtoRGBBlendNEON(SDL_BLENDMODE_MOD, info);
+}
+
+static void BlitRGBtoRGBBlendMulNEON(SDL_BlitInfo *info)
+{
+	BlitRGBtoRGBBlendNEON(SDL_BLENDMODE_MUL, info);
+}
+#endif /* NEON_BLENDBLIT */
+
+
+SDL_loblit SDL_CalculateBlendBlit(SDL_Surface *surface, int blit_index)
+{
+    SDL_PixelFormat *sf = surface->format;
+    SDL_PixelFormat *df = surface->map->dst->format;
+    int mode = surface->map->blendmode;
+
+    /* Palettized surfaces can't be blended */
+    if(sf->BytesPerPixel == 1 || df->BytesPerPixel == 1)
+	return NULL;
+
+    if(sf->BytesPerPixel == 4 && df->BytesPerPixel == 4
+       && sf->Rmask == df->Rmask
+       && sf->Gmask == df->Gmask
+       && sf->Bmask == df->Bmask
+       && sf->Rloss == 0 && sf->Gloss == 0 && sf->Bloss == 0
+       && (sf->Amask == 0 || sf->Aloss == 0)
+       && sf->Rshift % 8 == 0 && sf->Gshift % 8 == 0
+       && sf->Bshift % 8 == 0 && sf->Ashift % 8 == 0)
+    {
+#if SSE2_BLENDBLIT
+	if(SDL_HasSSE2()) {
+	    switch(mode) {
+	    case SDL_BLENDMODE_ADD:
+		return BlitRGBtoRGBBlendAddSSE2;
+	    case SDL_BLENDMODE_MOD:
+		return BlitRGBtoRGBBlendModSSE2;
+	    case SDL_BLENDMODE_MUL:
+		return BlitRGBtoRGBBlendMulSSE2;
+	    }
+	}
+#endif
+#if NEON_BLENDBLIT
+	if(SDL_HasNEON()) {
+	    switch(mode) {
+	    case SDL_BLENDMODE_ADD:
+		return BlitRGBtoRGBBlendAddNEON;
+	    case SDL_BLENDMODE_MOD:
+		return BlitRGBtoRGBBlendModNEON;
+	    case SDL_BLENDMODE_MUL:
+		return BlitRGBtoRGBBlendMulNEON;
+	    }
+	}
+#endif
+	switch(mode) {
+	case SDL_BLENDMODE_ADD:
+	    return BlitRGBtoRGBBlendAdd;
+	case SDL_BLENDMODE_MOD:
+	    return BlitRGBtoRGBBlendMod;
+	case SDL_BLENDMODE_MUL:
+	    return BlitRGBtoRGBBlendMul;
+	}
+    }
+
+    switch(mode) {
+    case SDL_BLENDMODE_ADD:
+	return BlitNtoNBlendAdd;
+    case SDL_BLENDMODE_MOD:
+	return BlitNtoNBlendMod;
+    case SDL_BLENDMODE_MUL:
+	return BlitNtoNBlendMul;
+    default:
+	return NULL;
+    }
+}
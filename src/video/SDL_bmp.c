@@ -30,11 +30,31 @@
    and save, and since PNG is so complex that it would bloat the library,
    BMP is a good alternative. 
 
-   This code currently supports Win32 DIBs in uncompressed 8 and 24 bpp.
+   This code currently supports Win32 DIBs in uncompressed 1, 4, 8, 16,
+   24 and 32 bpp, and RLE4/RLE8 compressed 4 and 8 bpp.
 */
 
 #include "SDL_video.h"
 #include "SDL_endian.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_blit.h"
+
+#if SDL_ASSEMBLY_ROUTINES
+#  if (defined(__GNUC__) && defined(__SSE2__)) || \
+      (defined(_MSC_VER) && (defined(_M_X64) || (_M_IX86_FP >= 2)))
+#    define SSE2_BMP 1
+#  endif
+#  if defined(__GNUC__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#    define NEON_BMP 1
+#  endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
+
+#if SSE2_BMP
+#include <emmintrin.h>
+#endif
+#if NEON_BMP
+#include <arm_neon.h>
+#endif
 
 /* Compression encodings for BMP files */
 #ifndef BI_RGB
@@ -45,19 +65,230 @@
 #endif
 
 
-SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
+/* Exchange two rows of 'len' bytes, used to turn bottom-up images over */
+static void SwapRows(Uint8 *a, Uint8 *b, int len)
+{
+#if SSE2_BMP
+	if ( SDL_HasSSE2() ) {
+		while ( len >= 16 ) {
+			__m128i x = _mm_loadu_si128((const __m128i *)a);
+			__m128i y = _mm_loadu_si128((const __m128i *)b);
+			_mm_storeu_si128((__m128i *)a, y);
+			_mm_storeu_si128((__m128i *)b, x);
+			a += 16;
+			b += 16;
+			len -= 16;
+		}
+	}
+#endif
+#if NEON_BMP
+	if ( SDL_HasNEON() ) {
+		while ( len >= 16 ) {
+			uint8x16_t x = vld1q_u8(a);
+			uint8x16_t y = vld1q_u8(b);
+			vst1q_u8(a, y);
+			vst1q_u8(b, x);
+			a += 16;
+			b += 16;
+			len -= 16;
+		}
+	}
+#endif
+	while ( len >= 4 ) {
+		Uint32 x, y;
+		SDL_memcpy(&x, a, 4);
+		SDL_memcpy(&y, b, 4);
+		SDL_memcpy(a, &y, 4);
+		SDL_memcpy(b, &x, 4);
+		a += 4;
+		b += 4;
+		len -= 4;
+	}
+	while ( len-- ) {
+		Uint8 x = *a;
+		*a++ = *b;
+		*b++ = x;
+	}
+}
+
+static void FlipRows(SDL_Surface *surface)
+{
+	Uint8 *top = (Uint8 *)surface->pixels;
+	Uint8 *bottom = top + (surface->h-1)*surface->pitch;
+	int len = surface->w * surface->format->BytesPerPixel;
+
+	while ( top < bottom ) {
+		SwapRows(top, bottom, len);
+		top += surface->pitch;
+		bottom -= surface->pitch;
+	}
+}
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+/* BMP pixels are little endian, the 24bpp case is handled by the masks */
+static void SwapPixels(SDL_Surface *surface)
+{
+	Uint8 *bits = (Uint8 *)surface->pixels;
+	int i, y;
+
+	for ( y = 0; y < surface->h; ++y ) {
+		switch (surface->format->BytesPerPixel) {
+			case 2: {
+				Uint16 *pix = (Uint16 *)bits;
+				for ( i = 0; i < surface->w; ++i )
+					pix[i] = SDL_Swap16(pix[i]);
+				break;
+			}
+			case 4: {
+				Uint32 *pix = (Uint32 *)bits;
+				for ( i = 0; i < surface->w; ++i )
+					pix[i] = SDL_Swap32(pix[i]);
+				break;
+			}
+		}
+		bits += surface->pitch;
+	}
+}
+#endif /* SDL_BYTEORDER == SDL_BIG_ENDIAN */
+
+/* Check that all the pixels of an 8-bit image are in the palette */
+static int CheckPaletteIndices(SDL_Surface *surface, Uint32 ncolors)
+{
+	Uint8 *bits = (Uint8 *)surface->pixels;
+	int i, y;
+
+	if ( ncolors >= 256 ) {
+		return 0;
+	}
+	for ( y = 0; y < surface->h; ++y ) {
+		for ( i = 0; i < surface->w; ++i ) {
+			if ( bits[i] >= ncolors ) {
+				SDL_SetError("A BMP image contains a pixel with a color out of the palette");
+				return -1;
+			}
+		}
+		bits += surface->pitch;
+	}
+	return 0;
+}
+
+/* Expand rows of 1 or 4 bit pixels to 8 bits per pixel */
+static void ExpandRow(const Uint8 *packed, Uint8 *bits, int w, int depth)
+{
+	int i;
+
+	if ( depth == 4 ) {
+		for ( i = 0; i + 1 < w; i += 2 ) {
+			bits[i] = *packed >> 4;
+			bits[i+1] = *packed++ & 0x0F;
+		}
+		if ( i < w ) {
+			bits[i] = *packed >> 4;
+		}
+	} else {
+		for ( i = 0; i < w; ++i ) {
+			bits[i] = (packed[i >> 3] >> (7 - (i & 7))) & 1;
+		}
+	}
+}
+
+/* Decode RLE8 or RLE4 (depth 8 or 4) data into an 8-bit surface.
+   Pixels the data skips over are left at color 0.
+ */
+static int DecodeRLE(const Uint8 *data, const Uint8 *stop,
+                     SDL_Surface *surface, int depth, SDL_bool topDown)
+{
+	int x, y, i, n;
+	int step = topDown ? surface->pitch : -(int)surface->pitch;
+	Uint8 *row;
+
+	x = 0;
+	y = 0;
+	row = (Uint8 *)surface->pixels;
+	if ( !topDown ) {
+		row += (surface->h-1)*surface->pitch;
+	}
+	while ( data + 2 <= stop && y < surface->h ) {
+		int count = *data++;
+		int value = *data++;
+
+		if ( count ) {
+			/* Encoded mode: 'count' pixels of one value (or pair) */
+			n = SDL_min(count, surface->w - x);
+			if ( depth == 8 ) {
+				if ( n > 0 ) {
+					SDL_memset(row + x, value, n);
+				}
+			} else {
+				for ( i = 0; i < n; ++i ) {
+					row[x+i] = (i & 1) ? (value & 0x0F)
+					                   : (value >> 4);
+				}
+			}
+			x += count;
+			continue;
+		}
+		switch (value) {
+			case 0:	/* End of line */
+				x = 0;
+				++y;
+				row += step;
+				break;
+			case 1:	/* End of bitmap */
+				return 0;
+			case 2:	/* Delta */
+				if ( data + 2 > stop ) {
+					return -1;
+				}
+				x += *data++;
+				n = *data++;
+				y += n;
+				row += n*step;
+				break;
+			default: /* Absolute mode: 'value' literal pixels */
+				count = (depth == 8) ? value : (value+1) >> 1;
+				if ( data + count > stop ) {
+					return -1;
+				}
+				n = SDL_min(value, surface->w - x);
+				if ( depth == 8 ) {
+					if ( n > 0 ) {
+						SDL_memcpy(row + x, data, n);
+					}
+				} else {
+					for ( i = 0; i < n; ++i ) {
+						row[x+i] = (i & 1) ?
+						    (data[i>>1] & 0x0F) :
+						    (data[i>>1] >> 4);
+					}
+				}
+				x += value;
+				/* Runs are padded to a 16-bit boundary */
+				data += (count + 1) & ~1;
+				break;
+		}
+	}
+	return 0;
+}
+
+/* Load a BMP image, with the pixels left in place if 'mem' is the memory
+   'src' reads from and the file layout matches a surface.
+ */
+static SDL_Surface *LoadBMP(SDL_RWops *src, int freesrc, Uint8 *mem)
 {
 	SDL_bool was_error;
 	long fp_offset = 0;
 	int bmpPitch;
 	int i, pad;
+	int pitch;
+	Uint64 pitch64;
 	SDL_Surface *surface;
 	Uint32 Rmask;
 	Uint32 Gmask;
 	Uint32 Bmask;
 	SDL_Palette *palette;
 	Uint8 *bits;
-	Uint8 *top, *end;
+	Uint8 *buffer;
 	SDL_bool topDown;
 	int ExpandBMP;
 
@@ -83,6 +314,7 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 
 	/* Make sure we are passed a valid data source */
 	surface = NULL;
+	buffer = NULL;
 	was_error = SDL_FALSE;
 	if ( src == NULL ) {
 		was_error = SDL_TRUE;
@@ -138,7 +370,6 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 	(void) bfReserved1;
 	(void) bfReserved2;
 	(void) biPlanes;
-	(void) biSizeImage;
 	(void) biXPelsPerMeter;
 	(void) biYPelsPerMeter;
 	(void) biClrImportant;
@@ -182,7 +413,7 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 			break;
 	}
 
-	/* We don't support any BMP compression right now */
+	/* Read the color masks and check the compression */
 	Rmask = Gmask = Bmask = 0;
 	switch (biCompression) {
 		case BI_RGB:
@@ -228,15 +459,64 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 					break;
 			}
 			break;
+		case BI_RLE8:
+			if ( biBitCount != 8 || ExpandBMP ) {
+				SDL_SetError("RLE8 compression requires 8-bpp");
+				was_error = SDL_TRUE;
+				goto done;
+			}
+			break;
+		case BI_RLE4:
+			if ( ExpandBMP != 4 ) {
+				SDL_SetError("RLE4 compression requires 4-bpp");
+				was_error = SDL_TRUE;
+				goto done;
+			}
+			break;
 		default:
 			SDL_SetError("Compressed BMP files not supported");
 			was_error = SDL_TRUE;
 			goto done;
 	}
 
-	/* Create a compatible surface, note that the colors are RGB ordered */
-	surface = SDL_CreateRGBSurface(SDL_SWSURFACE,
+	/* Create a compatible surface, note that the colors are RGB ordered.
+	   Uncompressed top-down images in memory can be used in place, if
+	   the pixels are suitably aligned and need no byte swapping.
+	 */
+	pitch64 = (((Uint64)biWidth * ((biBitCount + 7) / 8)) + 3) & ~(Uint64)3;
+	if ( pitch64 == 0 || pitch64 > 0x7FFFFFFF ) {
+		SDL_SetError("BMP file with bad dimensions (%dx%d)", biWidth, biHeight);
+		was_error = SDL_TRUE;
+		goto done;
+	}
+	pitch = (int)pitch64;
+	bits = NULL;
+	if ( mem && !ExpandBMP &&
+	     (biCompression == BI_RGB || biCompression == BI_BITFIELDS) &&
+	     (topDown || biHeight == 1) && pitch <= 0xFFFF ) {
+		long offset = fp_offset + bfOffBits;
+		long avail = src->hidden.mem.stop - mem;
+
+		if ( offset >= 0 && offset <= avail &&
+		     (avail - offset) / pitch >= biHeight ) {
+			bits = mem + offset;
+		}
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		if ( biBitCount != 8 && biBitCount != 24 ) {
+			bits = NULL;
+		}
+#endif
+		if ( ((size_t)bits % 4) != 0 ) {
+			bits = NULL;
+		}
+	}
+	if ( bits ) {
+		surface = SDL_CreateRGBSurfaceFrom(bits, biWidth, biHeight,
+				biBitCount, pitch, Rmask, Gmask, Bmask, 0);
+	} else {
+		surface = SDL_CreateRGBSurface(SDL_SWSURFACE,
 			biWidth, biHeight, biBitCount, Rmask, Gmask, Bmask, 0);
+	}
 	if ( surface == NULL ) {
 		was_error = SDL_TRUE;
 		goto done;
@@ -245,6 +525,9 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 	/* Load the palette, if any */
 	palette = (surface->format)->palette;
 	if ( palette ) {
+		Uint8 colors[256*4];
+		int size = (biSize == 12) ? 3 : 4;
+
 		if ( biClrUsed == 0 ) {
 			biClrUsed = 1 << biBitCount;
 		} else if ( biClrUsed > (1 << biBitCount) ) {
@@ -252,32 +535,68 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 			was_error = SDL_TRUE;
 			goto done;
 		}
-		if ( biSize == 12 ) {
-			for ( i = 0; i < (int)biClrUsed; ++i ) {
-				SDL_RWread(src, &palette->colors[i].b, 1, 1);
-				SDL_RWread(src, &palette->colors[i].g, 1, 1);
-				SDL_RWread(src, &palette->colors[i].r, 1, 1);
-				palette->colors[i].unused = 0;
-			}	
-		} else {
-			for ( i = 0; i < (int)biClrUsed; ++i ) {
-				SDL_RWread(src, &palette->colors[i].b, 1, 1);
-				SDL_RWread(src, &palette->colors[i].g, 1, 1);
-				SDL_RWread(src, &palette->colors[i].r, 1, 1);
-				SDL_RWread(src, &palette->colors[i].unused, 1, 1);
-			}	
+		if ( SDL_RWread(src, colors, size, biClrUsed) != (int)biClrUsed ) {
+			SDL_Error(SDL_EFREAD);
+			was_error = SDL_TRUE;
+			goto done;
+		}
+		for ( i = 0; i < (int)biClrUsed; ++i ) {
+			palette->colors[i].b = colors[i*size+0];
+			palette->colors[i].g = colors[i*size+1];
+			palette->colors[i].r = colors[i*size+2];
+			palette->colors[i].unused = (size == 4) ? colors[i*size+3] : 0;
 		}
 		palette->ncolors = biClrUsed;
 	}
 
+	/* The pixels are already in place */
+	if ( bits ) {
+		if ( palette && CheckPaletteIndices(surface, biClrUsed) < 0 ) {
+			was_error = SDL_TRUE;
+		}
+		goto done;
+	}
+
 	/* Read the surface pixels.  Note that the bmp image is upside down */
 	if ( SDL_RWseek(src, fp_offset+bfOffBits, RW_SEEK_SET) < 0 ) {
 		SDL_Error(SDL_EFSEEK);
 		was_error = SDL_TRUE;
 		goto done;
 	}
-	top = (Uint8 *)surface->pixels;
-	end = (Uint8 *)surface->pixels+(surface->h*surface->pitch);
+	if ( biCompression == BI_RLE8 || biCompression == BI_RLE4 ) {
+		/* Read all the compressed data at once and decode it, the size
+		   in the header is only trusted as far as the data goes */
+		long here = SDL_RWtell(src);
+		long left = SDL_RWseek(src, 0, RW_SEEK_END) - here;
+
+		if ( (here < 0) || (left < 0) ||
+		     (SDL_RWseek(src, here, RW_SEEK_SET) < 0) ) {
+			SDL_Error(SDL_EFSEEK);
+			was_error = SDL_TRUE;
+			goto done;
+		}
+		if ( biSizeImage == 0 || biSizeImage > (Uint32)left ) {
+			biSizeImage = (Uint32)left;
+		}
+		buffer = (Uint8 *)SDL_malloc(biSizeImage ? biSizeImage : 1);
+		if ( buffer == NULL ) {
+			SDL_OutOfMemory();
+			was_error = SDL_TRUE;
+			goto done;
+		}
+		biSizeImage = SDL_RWread(src, buffer, 1, biSizeImage);
+		if ( (int)biSizeImage < 0 ||
+		     DecodeRLE(buffer, buffer + biSizeImage, surface,
+		               ExpandBMP ? ExpandBMP : 8, topDown) < 0 ) {
+			SDL_SetError("Error reading from BMP");
+			was_error = SDL_TRUE;
+			goto done;
+		}
+		if ( CheckPaletteIndices(surface, biClrUsed) < 0 ) {
+			was_error = SDL_TRUE;
+		}
+		goto done;
+	}
 	switch (ExpandBMP) {
 		case 1:
 			bmpPitch = (biWidth + 7) >> 3;
@@ -288,94 +607,56 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 			pad  = (((bmpPitch)%4) ? (4-((bmpPitch)%4)) : 0);
 			break;
 		default:
-			pad  = ((surface->pitch%4) ?
-					(4-(surface->pitch%4)) : 0);
+			bmpPitch = surface->pitch;
+			pad  = 0;
 			break;
 	}
-	if ( topDown ) {
-		bits = top;
-	} else {
-		bits = end - surface->pitch;
-	}
-	while ( bits >= top && bits < end ) {
-		switch (ExpandBMP) {
-			case 1:
-			case 4: {
-			Uint8 pixel = 0;
-			int   shift = (8-ExpandBMP);
-			for ( i=0; i<surface->w; ++i ) {
-				if ( i%(8/ExpandBMP) == 0 ) {
-					if ( !SDL_RWread(src, &pixel, 1, 1) ) {
-						SDL_SetError(
-					"Error reading from BMP");
-						was_error = SDL_TRUE;
-						goto done;
-					}
-				}
-				*(bits+i) = (pixel>>shift);
-				pixel <<= ExpandBMP;
-				if ( bits[i] >= biClrUsed ) {
-					SDL_SetError(
-						"A BMP image contains a pixel with a color out of the palette");
-					was_error = SDL_TRUE;
-					goto done;
-				}
-			} }
-			break;
+	if ( ExpandBMP ) {
+		/* Read the packed image at once, then expand each row */
+		Uint8 *packed;
 
-			default:
-			if ( SDL_RWread(src, bits, 1, surface->pitch)
-							 != surface->pitch ) {
-				SDL_Error(SDL_EFREAD);
-				was_error = SDL_TRUE;
-				goto done;
-			}
-			if ( 8 == biBitCount && palette && biClrUsed < (1 << biBitCount ) ) {
-				for ( i=0; i<surface->w; ++i ) {
-					if ( bits[i] >= biClrUsed ) {
-						SDL_SetError(
-							"A BMP image contains a pixel with a color out of the palette");
-						was_error = SDL_TRUE;
-						goto done;
-					}
-				}
-			}
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-			/* Byte-swap the pixels if needed. Note that the 24bpp
-			   case has already been taken care of above. */
-			switch(biBitCount) {
-				case 15:
-				case 16: {
-				        Uint16 *pix = (Uint16 *)bits;
-					for(i = 0; i < surface->w; i++)
-					        pix[i] = SDL_Swap16(pix[i]);
-					break;
-				}
-
-				case 32: {
-				        Uint32 *pix = (Uint32 *)bits;
-					for(i = 0; i < surface->w; i++)
-					        pix[i] = SDL_Swap32(pix[i]);
-					break;
-				}
-			}
-#endif
-			break;
+		buffer = (Uint8 *)SDL_malloc((bmpPitch+pad) * surface->h);
+		if ( buffer == NULL ) {
+			SDL_OutOfMemory();
+			was_error = SDL_TRUE;
+			goto done;
 		}
-		/* Skip padding bytes, ugh */
-		if ( pad ) {
-			Uint8 padbyte;
-			for ( i=0; i<pad; ++i ) {
-				SDL_RWread(src, &padbyte, 1, 1);
-			}
+		if ( SDL_RWread(src, buffer, bmpPitch+pad, surface->h)
+							!= surface->h ) {
+			SDL_SetError("Error reading from BMP");
+			was_error = SDL_TRUE;
+			goto done;
 		}
-		if ( topDown ) {
-			bits += surface->pitch;
-		} else {
-			bits -= surface->pitch;
+		packed = buffer;
+		for ( i = 0; i < surface->h; ++i ) {
+			bits = (Uint8 *)surface->pixels + (topDown ? i :
+					surface->h-1-i) * surface->pitch;
+			ExpandRow(packed, bits, surface->w, ExpandBMP);
+			packed += bmpPitch+pad;
+		}
+	} else {
+		/* The BMP rows are laid out exactly like the surface rows */
+		if ( SDL_RWread(src, surface->pixels, surface->pitch,
+						surface->h) != surface->h ) {
+			SDL_Error(SDL_EFREAD);
+			was_error = SDL_TRUE;
+			goto done;
+		}
+		if ( !topDown ) {
+			FlipRows(surface);
 		}
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		SwapPixels(surface);
+#endif
+	}
+	if ( palette && CheckPaletteIndices(surface, biClrUsed) < 0 ) {
+		was_error = SDL_TRUE;
+		goto done;
 	}
 done:
+	if ( buffer ) {
+		SDL_free(buffer);
+	}
 	if ( was_error ) {
 		if ( src ) {
 			SDL_RWseek(src, fp_offset, RW_SEEK_SET);
@@ -391,6 +672,22 @@ done:
 	return(surface);
 }
 
+SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
+{
+	return LoadBMP(src, freesrc, NULL);
+}
+
+SDL_Surface * SDL_LoadBMPFromMem (void *mem, int size)
+{
+	SDL_RWops *src;
+
+	src = SDL_RWFromMem(mem, size);
+	if ( src == NULL ) {
+		return(NULL);
+	}
+	return LoadBMP(src, 1, (Uint8 *)mem);
+}
+
 int SDL_SaveBMP_RW (SDL_Surface *saveme, SDL_RWops *dst, int freedst)
 {
 	long fp_offset;
@@ -445,7 +742,8 @@ int SDL_SaveBMP_RW (SDL_Surface *saveme, SDL_RWops *dst, int freedst)
 			SDL_Rect bounds;
 
 			/* Convert to 24 bits per pixel */
-			surface = SDL_CreateRGBSurface(SDL_SWSURFACE,
+			surface = SDL_CreateRGBSurface(SDL_SWSURFACE |
+					(saveme->flags & SDL_LARGESURFACE),
 					saveme->w, saveme->h, 24,
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
 					0x00FF0000, 0x0000FF00, 0x000000FF,
@@ -469,8 +767,19 @@ int SDL_SaveBMP_RW (SDL_Surface *saveme, SDL_RWops *dst, int freedst)
 		}
 	}
 
+	/* The image size has to fit in the 32-bit BMP header fields */
+	if ( surface && surface->h > 0 &&
+	     SURFACE_PITCH(surface) > 0xFFFFFFFF / (Uint32)surface->h ) {
+		SDL_SetError("Surface is too large to save as BMP");
+		if ( surface != saveme ) {
+			SDL_FreeSurface(surface);
+		}
+		surface = NULL;
+	}
+
 	if ( surface && (SDL_LockSurface(surface) == 0) ) {
 		const int bw = surface->w*surface->format->BytesPerPixel;
+		const Uint32 pitch = SURFACE_PITCH(surface);
 
 		/* Set the BMP file header values */
 		bfSize = 0;		 /* We'll write this when we're done */
@@ -494,7 +803,7 @@ int SDL_SaveBMP_RW (SDL_Surface *saveme, SDL_RWops *dst, int freedst)
 		biPlanes = 1;
 		biBitCount = surface->format->BitsPerPixel;
 		biCompression = BI_RGB;
-		biSizeImage = surface->h*surface->pitch;
+		biSizeImage = surface->h*pitch;
 		biXPelsPerMeter = 0;
 		biYPelsPerMeter = 0;
 		if ( surface->format->palette ) {
@@ -543,10 +852,10 @@ int SDL_SaveBMP_RW (SDL_Surface *saveme, SDL_RWops *dst, int freedst)
 		}
 
 		/* Write the bitmap image upside down */
-		bits = (Uint8 *)surface->pixels+(surface->h*surface->pitch);
+		bits = (Uint8 *)surface->pixels+((size_t)surface->h*pitch);
 		pad  = ((bw%4) ? (4-(bw%4)) : 0);
 		while ( bits > (Uint8 *)surface->pixels ) {
-			bits -= surface->pitch;
+			bits -= pitch;
 			if ( SDL_RWwrite(dst, bits, 1, bw) != bw) {
 				SDL_Error(SDL_EFWRITE);
 				break;
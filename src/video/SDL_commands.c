@@ -0,0 +1,535 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Command lists of surface operations, run later on a render thread */
+
+#include "SDL_video.h"
+#include "SDL_thread.h"
+#include "SDL_mutex.h"
+#include "SDL_sysvideo.h"
+#include "SDL_commands_c.h"
+#include "SDL_workers_c.h"
+
+enum {
+	SDL_CMD_BLIT,
+	SDL_CMD_FILL,
+	SDL_CMD_STRETCH,
+	SDL_CMD_UPDATE
+};
+
+#define SDL_CMD_SRCRECT	0x01
+#define SDL_CMD_DSTRECT	0x02
+
+typedef struct {
+	Uint8 type;
+	Uint8 flags;
+	SDL_Surface *src;
+	SDL_Surface *dst;
+	SDL_Rect srcrect;
+	SDL_Rect dstrect;
+	Uint32 color;
+	int firstrect;		/* Update rectangles are kept in list->rects */
+	int numrects;
+	int next;		/* The next command in the same group */
+} SDL_Command;
+
+struct SDL_CommandList {
+	SDL_Command *cmds;
+	int numcmds;
+	int maxcmds;
+	SDL_Rect *rects;
+	int numrects;
+	int maxrects;
+
+	/* Groups of commands sharing surfaces, each run in order */
+	int *groups;
+	int numgroups;
+
+	/* Protected by command_lock while the list is submitted */
+	int submitted;
+	int finished;
+	int failed;
+	char error[256];
+	struct SDL_CommandList *next;
+};
+
+#if !SDL_THREADS_DISABLED
+static SDL_mutex *command_lock = NULL;	/* Protects everything below */
+static SDL_cond *command_wake = NULL;	/* Signalled when a list is queued */
+static SDL_cond *command_done = NULL;	/* Signalled when a list finishes */
+static SDL_Thread *render_thread = NULL;
+static SDL_CommandList *queue_head = NULL;
+static SDL_CommandList *queue_tail = NULL;
+static int render_quit = 0;
+#endif
+
+/* Stands for video memory and the display surface when grouping commands */
+static SDL_Surface SDL_DisplayNode;
+
+SDL_CommandList *SDL_CreateCommandList(void)
+{
+	SDL_CommandList *list;
+
+	list = (SDL_CommandList *)SDL_malloc(sizeof(*list));
+	if ( list == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_memset(list, 0, sizeof(*list));
+	return(list);
+}
+
+void SDL_FreeCommandList(SDL_CommandList *list)
+{
+	if ( list ) {
+		if ( list->submitted ) {
+			SDL_WaitCommandList(list);
+		}
+		SDL_free(list->cmds);
+		SDL_free(list->rects);
+		SDL_free(list->groups);
+		SDL_free(list);
+	}
+}
+
+static SDL_Command *SDL_AddCommand(SDL_CommandList *list, int type,
+				SDL_Surface *src, SDL_Rect *srcrect,
+				SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	SDL_Command *cmd;
+
+	if ( list == NULL ) {
+		SDL_SetError("Passed a NULL command list");
+		return(NULL);
+	}
+	if ( list->submitted ) {
+		SDL_SetError("Command list has been submitted");
+		return(NULL);
+	}
+	if ( (dst == NULL) || ((type != SDL_CMD_FILL) &&
+	                       (type != SDL_CMD_UPDATE) && (src == NULL)) ) {
+		SDL_SetError("Passed a NULL surface");
+		return(NULL);
+	}
+	if ( list->numcmds == list->maxcmds ) {
+		int maxcmds = list->maxcmds ? (list->maxcmds * 2) : 64;
+		SDL_Command *cmds;
+
+		cmds = (SDL_Command *)SDL_realloc(list->cmds,
+		                                  maxcmds*sizeof(*cmds));
+		if ( cmds == NULL ) {
+			SDL_OutOfMemory();
+			return(NULL);
+		}
+		list->cmds = cmds;
+		list->maxcmds = maxcmds;
+	}
+	cmd = &list->cmds[list->numcmds++];
+	SDL_memset(cmd, 0, sizeof(*cmd));
+	cmd->type = type;
+	cmd->src = src;
+	cmd->dst = dst;
+	if ( srcrect ) {
+		cmd->srcrect = *srcrect;
+		cmd->flags |= SDL_CMD_SRCRECT;
+	}
+	if ( dstrect ) {
+		cmd->dstrect = *dstrect;
+		cmd->flags |= SDL_CMD_DSTRECT;
+	}
+	return(cmd);
+}
+
+int SDL_RecordBlit(SDL_CommandList *list, SDL_Surface *src, SDL_Rect *srcrect,
+					SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	if ( !SDL_AddCommand(list, SDL_CMD_BLIT, src, srcrect, dst, dstrect) ) {
+		return(-1);
+	}
+	return(0);
+}
+
+int SDL_RecordFillRect(SDL_CommandList *list,
+			SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+{
+	SDL_Command *cmd;
+
+	cmd = SDL_AddCommand(list, SDL_CMD_FILL, NULL, NULL, dst, dstrect);
+	if ( cmd == NULL ) {
+		return(-1);
+	}
+	cmd->color = color;
+	return(0);
+}
+
+int SDL_RecordStretch(SDL_CommandList *list, SDL_Surface *src, SDL_Rect *srcrect,
+					SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	if ( !SDL_AddCommand(list, SDL_CMD_STRETCH, src, srcrect, dst, dstrect) ) {
+		return(-1);
+	}
+	return(0);
+}
+
+int SDL_RecordUpdateRects(SDL_CommandList *list,
+			SDL_Surface *screen, int numrects, SDL_Rect *rects)
+{
+	SDL_Command *cmd;
+
+	if ( numrects < 0 || (numrects && !rects) ) {
+		SDL_SetError("Invalid update rectangles");
+		return(-1);
+	}
+	if ( list && (list->numrects + numrects > list->maxrects) ) {
+		int maxrects = list->maxrects ? list->maxrects : 64;
+		SDL_Rect *newrects;
+
+		while ( maxrects < list->numrects + numrects ) {
+			maxrects *= 2;
+		}
+		newrects = (SDL_Rect *)SDL_realloc(list->rects,
+		                                   maxrects*sizeof(*newrects));
+		if ( newrects == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		list->rects = newrects;
+		list->maxrects = maxrects;
+	}
+	cmd = SDL_AddCommand(list, SDL_CMD_UPDATE, NULL, NULL, screen, NULL);
+	if ( cmd == NULL ) {
+		return(-1);
+	}
+	cmd->firstrect = list->numrects;
+	cmd->numrects = numrects;
+	SDL_memcpy(&list->rects[list->numrects], rects,
+	           numrects*sizeof(*rects));
+	list->numrects += numrects;
+	return(0);
+}
+
+/*
+ * Split the commands into groups that share no surfaces, using a hash
+ * table of the surfaces seen with a union-find forest on top.  A blit
+ * changes the blit map of its source as well as the pixels of its
+ * destination, so both count as used.
+ */
+typedef struct {
+	SDL_Surface *surface;
+	int parent;
+	int group;
+} SDL_CommandNode;
+
+static int SDL_FindNode(SDL_CommandNode *nodes, int mask, SDL_Surface *surface)
+{
+	SDL_VideoDevice *video = current_video;
+	int i;
+
+	if ( (surface->flags & SDL_HWSURFACE) ||
+	     (video && ((surface == SDL_VideoSurface) ||
+	                (surface == SDL_ShadowSurface))) ) {
+		surface = &SDL_DisplayNode;
+	}
+	i = (int)(((size_t)surface >> 4) * 2654435761u) & mask;
+	while ( nodes[i].surface && (nodes[i].surface != surface) ) {
+		i = (i + 1) & mask;
+	}
+	if ( ! nodes[i].surface ) {
+		nodes[i].surface = surface;
+		nodes[i].parent = i;
+		nodes[i].group = -1;
+	}
+	while ( nodes[i].parent != i ) {
+		nodes[i].parent = nodes[nodes[i].parent].parent;
+		i = nodes[i].parent;
+	}
+	return(i);
+}
+
+static int SDL_GroupCommands(SDL_CommandList *list)
+{
+	SDL_CommandNode *nodes;
+	int *tails;
+	int size, mask;
+	int i;
+
+	/* Room for two surfaces per command, at most half full */
+	size = 16;
+	while ( size < list->numcmds * 4 ) {
+		size *= 2;
+	}
+	mask = size - 1;
+	nodes = (SDL_CommandNode *)SDL_malloc(size*sizeof(*nodes));
+	tails = (int *)SDL_malloc(list->numcmds*sizeof(*tails));
+	SDL_free(list->groups);
+	list->groups = (int *)SDL_malloc(list->numcmds*sizeof(*list->groups));
+	if ( !nodes || !tails || !list->groups ) {
+		SDL_free(nodes);
+		SDL_free(tails);
+		SDL_free(list->groups);
+		list->groups = NULL;
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	SDL_memset(nodes, 0, size*sizeof(*nodes));
+
+	for ( i = 0; i < list->numcmds; ++i ) {
+		SDL_Command *cmd = &list->cmds[i];
+		int root = SDL_FindNode(nodes, mask, cmd->dst);
+
+		if ( cmd->type == SDL_CMD_UPDATE ) {
+			nodes[root].parent = SDL_FindNode(nodes, mask,
+			                                  &SDL_DisplayNode);
+		} else if ( cmd->src ) {
+			nodes[root].parent = SDL_FindNode(nodes, mask, cmd->src);
+		}
+	}
+
+	/* Chain the commands of each group, keeping their order */
+	list->numgroups = 0;
+	for ( i = 0; i < list->numcmds; ++i ) {
+		SDL_Command *cmd = &list->cmds[i];
+		int root = SDL_FindNode(nodes, mask, cmd->dst);
+		int group = nodes[root].group;
+
+		if ( group < 0 ) {
+			group = list->numgroups++;
+			nodes[root].group = group;
+			list->groups[group] = i;
+		} else {
+			list->cmds[tails[group]].next = i;
+		}
+		tails[group] = i;
+		cmd->next = -1;
+	}
+	SDL_free(nodes);
+	SDL_free(tails);
+	return(0);
+}
+
+static void SDL_CommandFailed(SDL_CommandList *list)
+{
+#if !SDL_THREADS_DISABLED
+	if ( command_lock ) {
+		SDL_mutexP(command_lock);
+	}
+#endif
+	if ( ! list->failed ) {
+		list->failed = 1;
+		SDL_strlcpy(list->error, SDL_GetError(), sizeof(list->error));
+	}
+#if !SDL_THREADS_DISABLED
+	if ( command_lock ) {
+		SDL_mutexV(command_lock);
+	}
+#endif
+}
+
+static void SDLCALL SDL_RunGroup(void *data, int group)
+{
+	SDL_CommandList *list = (SDL_CommandList *)data;
+	int i;
+
+	for ( i = list->groups[group]; i >= 0; i = list->cmds[i].next ) {
+		SDL_Command *cmd = &list->cmds[i];
+		SDL_Rect *srcrect, *dstrect;
+		int retval = 0;
+
+		srcrect = (cmd->flags & SDL_CMD_SRCRECT) ? &cmd->srcrect : NULL;
+		dstrect = (cmd->flags & SDL_CMD_DSTRECT) ? &cmd->dstrect : NULL;
+		switch (cmd->type) {
+		    case SDL_CMD_BLIT:
+			retval = SDL_UpperBlit(cmd->src, srcrect,
+			                       cmd->dst, dstrect);
+			break;
+		    case SDL_CMD_FILL:
+			retval = SDL_FillRect(cmd->dst, dstrect, cmd->color);
+			break;
+		    case SDL_CMD_STRETCH:
+			retval = SDL_SoftStretch(cmd->src, srcrect,
+			                         cmd->dst, dstrect);
+			break;
+		    case SDL_CMD_UPDATE:
+			SDL_UpdateRects(cmd->dst, cmd->numrects,
+			                &list->rects[cmd->firstrect]);
+			break;
+		}
+		if ( retval < 0 ) {
+			SDL_CommandFailed(list);
+		}
+	}
+}
+
+static void SDL_RunCommands(SDL_CommandList *list)
+{
+	if ( list->numcmds == 0 ) {
+		return;
+	}
+	if ( SDL_GroupCommands(list) < 0 ) {
+		SDL_CommandFailed(list);
+		return;
+	}
+	SDL_RunWorkers(SDL_RunGroup, list, list->numgroups);
+}
+
+#if !SDL_THREADS_DISABLED
+static int SDLCALL SDL_RenderThread(void *unused)
+{
+	SDL_mutexP(command_lock);
+	for ( ; ; ) {
+		SDL_CommandList *list;
+
+		while ( !queue_head && !render_quit ) {
+			SDL_CondWait(command_wake, command_lock);
+		}
+		list = queue_head;
+		if ( list == NULL ) {
+			break;
+		}
+		SDL_mutexV(command_lock);
+
+		SDL_RunCommands(list);
+
+		SDL_mutexP(command_lock);
+		queue_head = list->next;
+		if ( queue_head == NULL ) {
+			queue_tail = NULL;
+		}
+		list->finished = 1;
+		SDL_CondBroadcast(command_done);
+	}
+	SDL_mutexV(command_lock);
+	return(0);
+}
+#endif /* !SDL_THREADS_DISABLED */
+
+void SDL_CommandsInit(void)
+{
+#if !SDL_THREADS_DISABLED
+	command_lock = SDL_CreateMutex();
+	command_wake = SDL_CreateCond();
+	command_done = SDL_CreateCond();
+	if ( !command_lock || !command_wake || !command_done ) {
+		SDL_CommandsQuit();
+		SDL_ClearError();
+	}
+#endif
+}
+
+void SDL_CommandsQuit(void)
+{
+#if !SDL_THREADS_DISABLED
+	if ( render_thread ) {
+		/* Pending lists are finished first */
+		SDL_mutexP(command_lock);
+		render_quit = 1;
+		SDL_CondBroadcast(command_wake);
+		SDL_mutexV(command_lock);
+		SDL_WaitThread(render_thread, NULL);
+		render_thread = NULL;
+		render_quit = 0;
+	}
+	if ( command_done ) {
+		SDL_DestroyCond(command_done);
+		command_done = NULL;
+	}
+	if ( command_wake ) {
+		SDL_DestroyCond(command_wake);
+		command_wake = NULL;
+	}
+	if ( command_lock ) {
+		SDL_DestroyMutex(command_lock);
+		command_lock = NULL;
+	}
+#endif
+}
+
+int SDL_SubmitCommandList(SDL_CommandList *list)
+{
+	if ( list == NULL ) {
+		SDL_SetError("Passed a NULL command list");
+		return(-1);
+	}
+	if ( list->submitted ) {
+		SDL_SetError("Command list has been submitted");
+		return(-1);
+	}
+	list->submitted = 1;
+	list->finished = 0;
+	list->failed = 0;
+	list->next = NULL;
+
+#if !SDL_THREADS_DISABLED
+	if ( command_lock ) {
+		SDL_mutexP(command_lock);
+		if ( ! render_thread ) {
+			render_thread = SDL_CreateThread(SDL_RenderThread, NULL);
+		}
+		if ( render_thread ) {
+			if ( queue_tail ) {
+				queue_tail->next = list;
+			} else {
+				queue_head = list;
+			}
+			queue_tail = list;
+			SDL_CondSignal(command_wake);
+			SDL_mutexV(command_lock);
+			return(0);
+		}
+		SDL_mutexV(command_lock);
+		SDL_ClearError();
+	}
+#endif
+	/* No render thread, run the commands here */
+	SDL_RunCommands(list);
+	list->finished = 1;
+	return(0);
+}
+
+int SDL_WaitCommandList(SDL_CommandList *list)
+{
+	if ( list == NULL ) {
+		SDL_SetError("Passed a NULL command list");
+		return(-1);
+	}
+	if ( ! list->submitted ) {
+		return(0);
+	}
+#if !SDL_THREADS_DISABLED
+	if ( command_lock ) {
+		SDL_mutexP(command_lock);
+		while ( ! list->finished ) {
+			SDL_CondWait(command_done, command_lock);
+		}
+		SDL_mutexV(command_lock);
+	}
+#endif
+	list->submitted = 0;
+	list->numcmds = 0;
+	list->numrects = 0;
+	if ( list->failed ) {
+		SDL_SetError("%s", list->error);
+		return(-1);
+	}
+	return(0);
+}
@@ -30,16 +30,52 @@
 #include "SDL_sysvideo.h"
 #include "SDL_cursor_c.h"
 #include "SDL_pixels_c.h"
+#include "SDL_cpuinfo.h"
 #include "default_cursor.h"
 #include "../events/SDL_sysevents.h"
 #include "../events/SDL_events_c.h"
 
+#if SDL_ASSEMBLY_ROUTINES
+#  if (defined(__GNUC__) && defined(__SSE2__)) || \
+      (defined(_MSC_VER) && (defined(_M_X64) || (_M_IX86_FP >= 2)))
+#    define SSE2_CURSOR 1
+#  endif
+#  if defined(__GNUC__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#    define NEON_CURSOR 1
+#  endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
+
+#if SSE2_CURSOR
+#include <emmintrin.h>
+#endif
+#if NEON_CURSOR
+#include <arm_neon.h>
+#endif
+
 /* These are static for our cursor handling code */
 volatile int SDL_cursorstate = CURSOR_VISIBLE;
 SDL_Cursor *SDL_cursor = NULL;
 static SDL_Cursor *SDL_defcursor = NULL;
 SDL_mutex *SDL_cursorlock = NULL;
 
+/* The current cursor pre-rendered for the screen pixel size: the pixel
+   bytes to draw, and a mask that has all bits of the visible pixels set */
+static SDL_Cursor *sprite_cursor = NULL;
+static int sprite_bpp = 0;
+static Uint8 *sprite_pixels = NULL;
+static Uint8 *sprite_mask = NULL;
+
+static void SDL_FreeCursorSprite(void)
+{
+	if ( sprite_pixels ) {
+		SDL_free(sprite_pixels);
+		sprite_pixels = NULL;
+		sprite_mask = NULL;
+	}
+	sprite_cursor = NULL;
+	sprite_bpp = 0;
+}
+
 /* Public functions */
 void SDL_CursorQuit(void)
 {
@@ -57,6 +93,7 @@ void SDL_CursorQuit(void)
 			SDL_FreeCursor(cursor);
 		}
 	}
+	SDL_FreeCursorSprite();
 	if ( SDL_cursorlock != NULL ) {
 		SDL_DestroyMutex(SDL_cursorlock);
 		SDL_cursorlock = NULL;
@@ -246,6 +283,9 @@ void SDL_FreeCursor (SDL_Cursor *cursor)
 			SDL_VideoDevice *video = current_video;
 			SDL_VideoDevice *this  = current_video;
 
+			if ( cursor == sprite_cursor ) {
+				SDL_FreeCursorSprite();
+			}
 			if ( cursor->data ) {
 				SDL_free(cursor->data);
 			}
@@ -340,11 +380,106 @@ void SDL_MoveCursor(int x, int y)
 static int palette_changed = 1;
 static Uint8 pixels8[2];
 
+/* The area last saved under the cursor on a surface other than the screen */
+static SDL_Rect shadow_area;
+
 void SDL_CursorPaletteChanged(void)
 {
 	palette_changed = 1;
 }
 
+static int SDL_RenderCursorSprite(SDL_Surface *screen)
+{
+	int bpp = screen->format->BytesPerPixel;
+	int w = SDL_cursor->area.w;
+	int h = SDL_cursor->area.h;
+	Uint8 white, black;
+	Uint8 *pixels, *mask;
+	int i, x;
+
+	if ( bpp == 1 ) {
+		if ( palette_changed ) {
+			pixels8[0] = (Uint8)SDL_MapRGB(screen->format, 255, 255, 255);
+			pixels8[1] = (Uint8)SDL_MapRGB(screen->format, 0, 0, 0);
+			palette_changed = 0;
+			sprite_cursor = NULL;
+		}
+		white = pixels8[0];
+		black = pixels8[1];
+	} else {
+		white = 0xFF;
+		black = 0x00;
+	}
+	if ( (sprite_cursor == SDL_cursor) && (sprite_bpp == bpp) ) {
+		return(0);
+	}
+
+	SDL_FreeCursorSprite();
+	sprite_pixels = (Uint8 *)SDL_malloc(w*h*bpp*2);
+	if ( sprite_pixels == NULL ) {
+		return(-1);
+	}
+	sprite_mask = sprite_pixels + w*h*bpp;
+	pixels = sprite_pixels;
+	mask = sprite_mask;
+	for ( i = 0; i < (w/8)*h; ++i ) {
+		Uint8 datab = SDL_cursor->data[i];
+		Uint8 maskb = SDL_cursor->mask[i];
+
+		for ( x = 0; x < 8; ++x ) {
+			SDL_memset(pixels, (datab & 0x80) ? black : white, bpp);
+			SDL_memset(mask, (maskb & 0x80) ? 0xFF : 0x00, bpp);
+			pixels += bpp;
+			mask += bpp;
+			datab <<= 1;
+			maskb <<= 1;
+		}
+	}
+	sprite_cursor = SDL_cursor;
+	sprite_bpp = bpp;
+	return(0);
+}
+
+/* Merge 'len' bytes of the cursor sprite into the screen */
+static void SDL_BlendCursor(Uint8 *dst, const Uint8 *pixels,
+					const Uint8 *mask, int len)
+{
+#if SSE2_CURSOR
+	if ( SDL_HasSSE2() ) {
+		while ( len >= 16 ) {
+			__m128i d = _mm_loadu_si128((const __m128i *)dst);
+			__m128i p = _mm_loadu_si128((const __m128i *)pixels);
+			__m128i m = _mm_loadu_si128((const __m128i *)mask);
+			d = _mm_or_si128(_mm_and_si128(m, p),
+			                 _mm_andnot_si128(m, d));
+			_mm_storeu_si128((__m128i *)dst, d);
+			dst += 16;
+			pixels += 16;
+			mask += 16;
+			len -= 16;
+		}
+	}
+#endif
+#if NEON_CURSOR
+	if ( SDL_HasNEON() ) {
+		while ( len >= 16 ) {
+			uint8x16_t d = vld1q_u8(dst);
+			d = vbslq_u8(vld1q_u8(mask), vld1q_u8(pixels), d);
+			vst1q_u8(dst, d);
+			dst += 16;
+			pixels += 16;
+			mask += 16;
+			len -= 16;
+		}
+	}
+#endif
+	while ( len-- ) {
+		*dst = (*pixels++ & *mask) | (*dst & ~*mask);
+		++dst;
+		++mask;
+	}
+}
+
 void SDL_MouseRect(SDL_Rect *area)
 {
 	int clip_diff;
@@ -368,205 +503,31 @@ void SDL_MouseRect(SDL_Rect *area)
 	}
 }
 
-static void SDL_DrawCursorFast(SDL_Surface *screen, SDL_Rect *area)
+/* The save buffer used for a surface: the screen format one, or the one
+   for a shadow surface of another format */
+static Uint8 *SDL_CursorSave(SDL_Surface *screen)
 {
-	const Uint32 pixels[2] = { 0xFFFFFFFF, 0x00000000 };
-	int i, w, h;
-	Uint8 *data, datab;
-	Uint8 *mask, maskb;
-
-	data = SDL_cursor->data + area->y * SDL_cursor->area.w/8;
-	mask = SDL_cursor->mask + area->y * SDL_cursor->area.w/8;
-	switch (screen->format->BytesPerPixel) {
-
-	    case 1: {
-		Uint8 *dst;
-		int dstskip;
-
-		if ( palette_changed ) {
-			pixels8[0] = (Uint8)SDL_MapRGB(screen->format, 255, 255, 255);
-			pixels8[1] = (Uint8)SDL_MapRGB(screen->format, 0, 0, 0);
-			palette_changed = 0;
-		}
-		dst = (Uint8 *)screen->pixels +
-                       (SDL_cursor->area.y+area->y)*screen->pitch +
-                       SDL_cursor->area.x;
-		dstskip = screen->pitch-area->w;
-
-		for ( h=area->h; h; h-- ) {
-			for ( w=area->w/8; w; w-- ) {
-				maskb = *mask++;
-				datab = *data++;
-				for ( i=0; i<8; ++i ) {
-					if ( maskb & 0x80 ) {
-						*dst = pixels8[datab>>7];
-					}
-					maskb <<= 1;
-					datab <<= 1;
-					dst++;
-				}
-			}
-			dst += dstskip;
-		}
-	    }
-	    break;
-
-	    case 2: {
-		Uint16 *dst;
-		int dstskip;
-
-		dst = (Uint16 *)screen->pixels +
-                       (SDL_cursor->area.y+area->y)*screen->pitch/2 +
-                       SDL_cursor->area.x;
-		dstskip = (screen->pitch/2)-area->w;
-
-		for ( h=area->h; h; h-- ) {
-			for ( w=area->w/8; w; w-- ) {
-				maskb = *mask++;
-				datab = *data++;
-				for ( i=0; i<8; ++i ) {
-					if ( maskb & 0x80 ) {
-						*dst = (Uint16)pixels[datab>>7];
-					}
-					maskb <<= 1;
-					datab <<= 1;
-					dst++;
-				}
-			}
-			dst += dstskip;
-		}
-	    }
-	    break;
-
-	    case 3: {
-		Uint8 *dst;
-		int dstskip;
-
-		dst = (Uint8 *)screen->pixels +
-                       (SDL_cursor->area.y+area->y)*screen->pitch +
-                       SDL_cursor->area.x*3;
-		dstskip = screen->pitch-area->w*3;
-
-		for ( h=area->h; h; h-- ) {
-			for ( w=area->w/8; w; w-- ) {
-				maskb = *mask++;
-				datab = *data++;
-				for ( i=0; i<8; ++i ) {
-					if ( maskb & 0x80 ) {
-						SDL_memset(dst,pixels[datab>>7],3);
-					}
-					maskb <<= 1;
-					datab <<= 1;
-					dst += 3;
-				}
-			}
-			dst += dstskip;
-		}
-	    }
-	    break;
-
-	    case 4: {
-		Uint32 *dst;
-		int dstskip;
-
-		dst = (Uint32 *)screen->pixels +
-                       (SDL_cursor->area.y+area->y)*screen->pitch/4 +
-                       SDL_cursor->area.x;
-		dstskip = (screen->pitch/4)-area->w;
-
-		for ( h=area->h; h; h-- ) {
-			for ( w=area->w/8; w; w-- ) {
-				maskb = *mask++;
-				datab = *data++;
-				for ( i=0; i<8; ++i ) {
-					if ( maskb & 0x80 ) {
-						*dst = pixels[datab>>7];
-					}
-					maskb <<= 1;
-					datab <<= 1;
-					dst++;
-				}
-			}
-			dst += dstskip;
-		}
-	    }
-	    break;
-	}
-}
-
-static void SDL_DrawCursorSlow(SDL_Surface *screen, SDL_Rect *area)
-{
-	const Uint32 pixels[2] = { 0xFFFFFF, 0x000000 };
-	int h;
-	int x, minx, maxx;
-	Uint8 *data, datab = 0;
-	Uint8 *mask, maskb = 0;
-	Uint8 *dst;
-	int dstbpp, dstskip;
-
-	data = SDL_cursor->data + area->y * SDL_cursor->area.w/8;
-	mask = SDL_cursor->mask + area->y * SDL_cursor->area.w/8;
-	dstbpp = screen->format->BytesPerPixel;
-	dst = (Uint8 *)screen->pixels +
-                       (SDL_cursor->area.y+area->y)*screen->pitch +
-                       SDL_cursor->area.x*dstbpp;
-	dstskip = screen->pitch-SDL_cursor->area.w*dstbpp;
-
-	minx = area->x;
-	maxx = area->x+area->w;
-	if ( screen->format->BytesPerPixel == 1 ) {
-		if ( palette_changed ) {
-			pixels8[0] = (Uint8)SDL_MapRGB(screen->format, 255, 255, 255);
-			pixels8[1] = (Uint8)SDL_MapRGB(screen->format, 0, 0, 0);
-			palette_changed = 0;
-		}
-		for ( h=area->h; h; h-- ) {
-			for ( x=0; x<SDL_cursor->area.w; ++x ) {
-				if ( (x%8) == 0 ) {
-					maskb = *mask++;
-					datab = *data++;
-				}
-				if ( (x >= minx) && (x < maxx) ) {
-					if ( maskb & 0x80 ) {
-						SDL_memset(dst, pixels8[datab>>7], dstbpp);
-					}
-				}
-				maskb <<= 1;
-				datab <<= 1;
-				dst += dstbpp;
-			}
-			dst += dstskip;
-		}
-	} else {
-		for ( h=area->h; h; h-- ) {
-			for ( x=0; x<SDL_cursor->area.w; ++x ) {
-				if ( (x%8) == 0 ) {
-					maskb = *mask++;
-					datab = *data++;
-				}
-				if ( (x >= minx) && (x < maxx) ) {
-					if ( maskb & 0x80 ) {
-						SDL_memset(dst, pixels[datab>>7], dstbpp);
-					}
-				}
-				maskb <<= 1;
-				datab <<= 1;
-				dst += dstbpp;
-			}
-			dst += dstskip;
-		}
+	if ( (screen == SDL_VideoSurface) ||
+	     FORMAT_EQUAL(screen->format, SDL_VideoSurface->format) ) {
+		return SDL_cursor->save[0];
 	}
+	return SDL_cursor->save[1];
 }
 
 /* This handles the ugly work of converting the saved cursor background from
    the pixel format of the shadow surface to that of the video surface.
    This is only necessary when blitting from a shadow surface of a different
    pixel format than the video surface, and using a software rendered cursor.
+   The save buffers are laid out like the whole cursor, 'area' is the part
+   of it to convert.
 */
-static void SDL_ConvertCursorSave(SDL_Surface *screen, int w, int h)
+static void SDL_ConvertCursorSave(SDL_Surface *screen, SDL_Rect *area)
 {
 	SDL_BlitInfo info;
 	SDL_loblit RunBlit;
+	int srcbpp = screen->format->BytesPerPixel;
+	int dstbpp = SDL_VideoSurface->format->BytesPerPixel;
+	int w = SDL_cursor->area.w;
 
 	/* Make sure we can steal the blit mapping */
 	if ( screen->map->dst != SDL_VideoSurface ) {
@@ -574,24 +535,61 @@ static void SDL_ConvertCursorSave(SDL_Surface *screen, int w, int h)
 	}
 
 	/* Set up the blit information */
-	info.s_pixels = SDL_cursor->save[1];
-	info.s_width = w;
-	info.s_height = h;
-	info.s_skip = 0;
-	info.d_pixels = SDL_cursor->save[0];
-	info.d_width = w;
-	info.d_height = h;
-	info.d_skip = 0;
+	info.s_pixels = SDL_cursor->save[1] +
+	                (area->y * w + area->x) * srcbpp;
+	info.s_width = area->w;
+	info.s_height = area->h;
+	info.s_skip = (w - area->w) * srcbpp;
+	info.d_pixels = SDL_cursor->save[0] +
+	                (area->y * w + area->x) * dstbpp;
+	info.d_width = area->w;
+	info.d_height = area->h;
+	info.d_skip = (w - area->w) * dstbpp;
 	info.aux_data = screen->map->sw_data->aux_data;
 	info.src = screen->format;
 	info.table = screen->map->table;
 	info.dst = SDL_VideoSurface->format;
+	info.flags = screen->flags;
 	RunBlit = screen->map->sw_data->blit;
 
 	/* Run the actual software blit */
 	RunBlit(&info);
 }
 
+/* Save the background of 'area', which lies within the cursor and the
+   screen, and draw that part of the cursor */
+static void SDL_DrawCursorArea(SDL_Surface *screen, SDL_Rect *area)
+{
+	int bpp = screen->format->BytesPerPixel;
+	int stride = SDL_cursor->area.w * bpp;
+	int offset = (area->y - SDL_cursor->area.y) * stride +
+	             (area->x - SDL_cursor->area.x) * bpp;
+	int len = area->w * bpp;
+	int drawing;
+	Uint8 *save, *dst;
+	int h;
+
+	if ( screen != SDL_VideoSurface ) {
+		shadow_area = *area;
+	}
+
+	/* If there's no memory for the sprite, just keep the background */
+	drawing = (SDL_RenderCursorSprite(screen) == 0);
+	save = SDL_CursorSave(screen) + offset;
+	dst = (Uint8 *)screen->pixels + area->y * screen->pitch +
+	                                area->x * bpp;
+	for ( h = area->h; h; --h ) {
+		SDL_memcpy(save, dst, len);
+		if ( drawing ) {
+			SDL_BlendCursor(dst, sprite_pixels + offset,
+			                sprite_mask + offset, len);
+		}
+		save += stride;
+		offset += stride;
+		dst += screen->pitch;
+	}
+}
+
 void SDL_DrawCursorNoLock(SDL_Surface *screen)
 {
 	SDL_Rect area;
@@ -599,42 +597,10 @@ void SDL_DrawCursorNoLock(SDL_Surface *screen)
 	/* Get the mouse rectangle, clipped to the screen */
 	SDL_MouseRect(&area);
 	if ( (area.w == 0) || (area.h == 0) ) {
+		shadow_area.w = 0;
 		return;
 	}
-
-	/* Copy mouse background */
-	{ int w, h, screenbpp;
-	  Uint8 *src, *dst;
-
-	  /* Set up the copy pointers */
-	  screenbpp = screen->format->BytesPerPixel;
-	  if ( (screen == SDL_VideoSurface) ||
-	          FORMAT_EQUAL(screen->format, SDL_VideoSurface->format) ) {
-		dst = SDL_cursor->save[0];
-	  } else {
-		dst = SDL_cursor->save[1];
-	  }
-	  src = (Uint8 *)screen->pixels + area.y * screen->pitch +
-                                          area.x * screenbpp;
-
-	  /* Perform the copy */
-	  w = area.w*screenbpp;
-	  h = area.h;
-	  while ( h-- ) {
-		  SDL_memcpy(dst, src, w);
-		  dst += w;
-		  src += screen->pitch;
-	  }
-	}
-
-	/* Draw the mouse cursor */
-	area.x -= SDL_cursor->area.x;
-	area.y -= SDL_cursor->area.y;
-	if ( (area.x == 0) && (area.w == SDL_cursor->area.w) ) {
-		SDL_DrawCursorFast(screen, &area);
-	} else {
-		SDL_DrawCursorSlow(screen, &area);
-	}
+	SDL_DrawCursorArea(screen, &area);
 }
 
 void SDL_DrawCursor(SDL_Surface *screen)
@@ -670,44 +636,89 @@ void SDL_DrawCursor(SDL_Surface *screen)
 	}
 }
 
-void SDL_EraseCursorNoLock(SDL_Surface *screen)
+int SDL_DrawCursorRects(SDL_Surface *screen, int numrects, SDL_Rect *rects)
 {
 	SDL_Rect area;
+	int minx, miny, maxx, maxy;
+	int i;
 
-	/* Get the mouse rectangle, clipped to the screen */
+	/* Find the part of the cursor covered by the rectangles */
 	SDL_MouseRect(&area);
+	minx = area.x + area.w;
+	miny = area.y + area.h;
+	maxx = area.x;
+	maxy = area.y;
+	for ( i = 0; i < numrects; ++i ) {
+		int x1 = area.x, y1 = area.y;
+		int x2 = area.x + area.w, y2 = area.y + area.h;
+
+		if ( rects[i].x > x1 ) x1 = rects[i].x;
+		if ( rects[i].y > y1 ) y1 = rects[i].y;
+		if ( rects[i].x + rects[i].w < x2 ) x2 = rects[i].x + rects[i].w;
+		if ( rects[i].y + rects[i].h < y2 ) y2 = rects[i].y + rects[i].h;
+		if ( (x1 < x2) && (y1 < y2) ) {
+			if ( x1 < minx ) minx = x1;
+			if ( y1 < miny ) miny = y1;
+			if ( x2 > maxx ) maxx = x2;
+			if ( y2 > maxy ) maxy = y2;
+		}
+	}
+	if ( (minx >= maxx) || (miny >= maxy) ) {
+		return(0);
+	}
+	area.x = minx;
+	area.y = miny;
+	area.w = maxx - minx;
+	area.h = maxy - miny;
+
+	if ( SDL_MUSTLOCK(screen) ) {
+		if ( SDL_LockSurface(screen) < 0 ) {
+			return(0);
+		}
+	}
+	SDL_DrawCursorArea(screen, &area);
+	if ( SDL_MUSTLOCK(screen) ) {
+		SDL_UnlockSurface(screen);
+	}
+	return(1);
+}
+
+void SDL_EraseCursorNoLock(SDL_Surface *screen)
+{
+	SDL_Rect area;
+	int bpp, stride, len, h;
+	Uint8 *src, *dst;
+
+	/* Get the area saved under the cursor */
+	if ( screen == SDL_VideoSurface ) {
+		SDL_MouseRect(&area);
+	} else {
+		area = shadow_area;
+		shadow_area.w = 0;
+	}
 	if ( (area.w == 0) || (area.h == 0) ) {
 		return;
 	}
 
 	/* Copy mouse background */
-	{ int w, h, screenbpp;
-	  Uint8 *src, *dst;
-
-	  /* Set up the copy pointers */
-	  screenbpp = screen->format->BytesPerPixel;
-	  if ( (screen == SDL_VideoSurface) ||
-	          FORMAT_EQUAL(screen->format, SDL_VideoSurface->format) ) {
-		src = SDL_cursor->save[0];
-	  } else {
-		src = SDL_cursor->save[1];
-	  }
-	  dst = (Uint8 *)screen->pixels + area.y * screen->pitch +
-                                          area.x * screenbpp;
-
-	  /* Perform the copy */
-	  w = area.w*screenbpp;
-	  h = area.h;
-	  while ( h-- ) {
-		  SDL_memcpy(dst, src, w);
-		  src += w;
-		  dst += screen->pitch;
-	  }
-
-	  /* Perform pixel conversion on cursor background */
-	  if ( src > SDL_cursor->save[1] ) {
-		SDL_ConvertCursorSave(screen, area.w, area.h);
-	  }
+	bpp = screen->format->BytesPerPixel;
+	stride = SDL_cursor->area.w * bpp;
+	len = area.w * bpp;
+	src = SDL_CursorSave(screen) +
+	      (area.y - SDL_cursor->area.y) * stride +
+	      (area.x - SDL_cursor->area.x) * bpp;
+	dst = (Uint8 *)screen->pixels + area.y * screen->pitch + area.x * bpp;
+	for ( h = area.h; h; --h ) {
+		SDL_memcpy(dst, src, len);
+		src += stride;
+		dst += screen->pitch;
+	}
+
+	/* Perform pixel conversion on cursor background */
+	if ( SDL_CursorSave(screen) == SDL_cursor->save[1] ) {
+		area.x -= SDL_cursor->area.x;
+		area.y -= SDL_cursor->area.y;
+		SDL_ConvertCursorSave(screen, &area);
 	}
 }
 
@@ -28,6 +28,11 @@ extern int  SDL_CursorInit(Uint32 flags);
 extern void SDL_CursorPaletteChanged(void);
 extern void SDL_DrawCursor(SDL_Surface *screen);
 extern void SDL_DrawCursorNoLock(SDL_Surface *screen);
+/* Draw the cursor on a shadow surface only where it overlaps the given
+   rectangles, and return 0 if it doesn't overlap them at all, in which
+   case there is nothing to erase afterwards.
+ */
+extern int  SDL_DrawCursorRects(SDL_Surface *screen, int numrects, SDL_Rect *rects);
 extern void SDL_EraseCursor(SDL_Surface *screen);
 extern void SDL_EraseCursorNoLock(SDL_Surface *screen);
 extern void SDL_UpdateCursor(SDL_Surface *screen);
@@ -0,0 +1,118 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Find the parts of a frame that changed since the previous one */
+
+#include "SDL_video.h"
+#include "SDL_dirty_c.h"
+
+int SDL_FindChangedRect(SDL_Surface *screen, Uint8 *previous,
+                        SDL_Rect *rect)
+{
+	const Uint8 *src;
+	Uint8 *dst;
+	int bpp;
+	int x1, x2, y1, y2, y;
+	int left, right, top, bottom;
+	int l, r;
+
+	x1 = (rect->x > 0) ? rect->x : 0;
+	y1 = (rect->y > 0) ? rect->y : 0;
+	x2 = rect->x + rect->w;
+	if ( x2 > screen->w ) {
+		x2 = screen->w;
+	}
+	y2 = rect->y + rect->h;
+	if ( y2 > screen->h ) {
+		y2 = screen->h;
+	}
+	if ( (x1 >= x2) || (y1 >= y2) ) {
+		return(0);
+	}
+
+	bpp = screen->format->BytesPerPixel;
+	x1 *= bpp;
+	x2 *= bpp;
+	left = x2;
+	right = x1;
+	top = -1;
+	bottom = -1;
+	for ( y = y1; y < y2; ++y ) {
+		src = (const Uint8 *)screen->pixels + y * screen->pitch;
+		dst = previous + y * screen->pitch;
+
+		/* Most rows are usually unchanged, let memcmp() skip them */
+		if ( SDL_memcmp(src + x1, dst + x1, x2 - x1) == 0 ) {
+			continue;
+		}
+		if ( top < 0 ) {
+			top = y;
+		}
+		bottom = y;
+
+		/* Only look for changes outside the columns already found */
+		for ( l = x1; (l < left) && (src[l] == dst[l]); ++l )
+			;
+		if ( l < left ) {
+			left = l;
+		}
+		for ( r = x2; (r > right) && (src[r-1] == dst[r-1]); --r )
+			;
+		if ( r > right ) {
+			right = r;
+		}
+		SDL_memcpy(dst + x1, src + x1, x2 - x1);
+	}
+	if ( top < 0 ) {
+		return(0);
+	}
+	rect->x = left / bpp;
+	rect->y = top;
+	rect->w = (right + bpp - 1) / bpp - rect->x;
+	rect->h = bottom + 1 - top;
+	return(1);
+}
+
+void SDL_UnionRect(SDL_Rect *dirty, const SDL_Rect *rect)
+{
+	int x1, y1, x2, y2;
+
+	if ( ! dirty->w || ! dirty->h ) {
+		*dirty = *rect;
+		return;
+	}
+	x1 = (dirty->x < rect->x) ? dirty->x : rect->x;
+	y1 = (dirty->y < rect->y) ? dirty->y : rect->y;
+	x2 = dirty->x + dirty->w;
+	if ( x2 < rect->x + rect->w ) {
+		x2 = rect->x + rect->w;
+	}
+	y2 = dirty->y + dirty->h;
+	if ( y2 < rect->y + rect->h ) {
+		y2 = rect->y + rect->h;
+	}
+	dirty->x = x1;
+	dirty->y = y1;
+	dirty->w = x2 - x1;
+	dirty->h = y2 - y1;
+}
@@ -0,0 +1,37 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Change tracking for drivers that redraw the screen in software (such as
+   the text mode drivers), so they only redraw what actually changed.
+ */
+#include "SDL_video.h"
+
+/* Clip rect to the screen and shrink it to the pixels that differ from
+   previous, a copy of the screen pixels with the same pitch, then copy
+   those pixels into previous.  Returns 0 if nothing in rect changed.
+ */
+extern int SDL_FindChangedRect(SDL_Surface *screen, Uint8 *previous,
+                               SDL_Rect *rect);
+
+/* Grow dirty to also cover rect.  An empty dirty rectangle is replaced. */
+extern void SDL_UnionRect(SDL_Rect *dirty, const SDL_Rect *rect);
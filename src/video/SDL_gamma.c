@@ -36,6 +36,7 @@
 #endif
 
 #include "SDL_sysvideo.h"
+#include "SDL_pixels_c.h"
 
 
 static void CalculateGammaRamp(float gamma, Uint16 *ramp)
@@ -90,6 +91,167 @@ static void CalculateGammaFromRamp(float *gamma, Uint16 *ramp)
 	}
 }
 
+/* Software gamma correction
+
+   Drivers that can't change the gamma ramp get it applied while the
+   shadow surface is copied to the video surface.  Every raw channel
+   value of the shadow format indexes a table holding the corrected
+   value already packed into the video pixel format, so the correction
+   replaces the conversion the shadow blit would have done anyway.
+ */
+static int SDL_SetSoftGammaRamp(SDL_VideoDevice *video)
+{
+	SDL_PixelFormat *src, *dst;
+	Uint32 *table;
+	Uint32 mask;
+	Uint8 loss, dloss, dshift;
+	int i, channel;
+
+	if ( !SDL_ShadowSurface ||
+	     SDL_ShadowSurface->format->palette ||
+	     SDL_VideoSurface->format->palette ||
+	     SDL_VideoSurface->format->BytesPerPixel < 2 ) {
+		SDL_SetError("Gamma ramp manipulation not supported");
+		return -1;
+	}
+	/* An identity ramp needs no correction at all */
+	for ( i = 0; i < 3*256; ++i ) {
+		if ( (video->gamma[i] >> 8) != (i & 0xFF) ) {
+			break;
+		}
+	}
+	if ( i == 3*256 ) {
+		if ( video->gamma_tables ) {
+			SDL_free(video->gamma_tables);
+			video->gamma_tables = NULL;
+		}
+		return 0;
+	}
+	if ( ! video->gamma_tables ) {
+		video->gamma_tables = SDL_malloc(3*256*sizeof(Uint32));
+		if ( ! video->gamma_tables ) {
+			SDL_OutOfMemory();
+			return -1;
+		}
+	}
+
+	src = SDL_ShadowSurface->format;
+	dst = SDL_VideoSurface->format;
+	for ( channel = 0; channel < 3; ++channel ) {
+		switch (channel) {
+		    case 0:
+			mask = src->Rmask; loss = src->Rloss;
+			dloss = dst->Rloss; dshift = dst->Rshift;
+			break;
+		    case 1:
+			mask = src->Gmask; loss = src->Gloss;
+			dloss = dst->Gloss; dshift = dst->Gshift;
+			break;
+		    default:
+			mask = src->Bmask; loss = src->Bloss;
+			dloss = dst->Bloss; dshift = dst->Bshift;
+			break;
+		}
+		table = &video->gamma_tables[channel*256];
+		for ( i = 0; i < 256; ++i ) {
+			int value;
+
+			if ( !mask || (i > (0xFF >> loss)) ) {
+				table[i] = 0;
+				continue;
+			}
+			/* Expand to 8 bits the way SDL_GetRGB() does */
+			value = i << loss;
+			if ( loss && (loss <= 4) ) {
+				value += i >> (8 - (loss << 1));
+			}
+			value = video->gamma[channel*256+value] >> 8;
+			table[i] = (Uint32)(value >> dloss) << dshift;
+		}
+	}
+	/* The video surface alpha, if any, is opaque */
+	for ( i = 0; i < 256; ++i ) {
+		video->gamma_tables[i] |= dst->Amask;
+	}
+	return 0;
+}
+
+/* Copy an area of the shadow surface to the video surface, applying the
+   software gamma tables on the way.
+ */
+void SDL_GammaBlit(SDL_Surface *src, SDL_Rect *rect,
+                   SDL_Surface *dst, const Uint32 *tables)
+{
+	const Uint32 *rtable = &tables[0*256];
+	const Uint32 *gtable = &tables[1*256];
+	const Uint32 *btable = &tables[2*256];
+	SDL_PixelFormat *fmt = src->format;
+	int srcbpp = fmt->BytesPerPixel;
+	int dstbpp = dst->format->BytesPerPixel;
+	Uint8 *srcrow, *dstrow;
+	int x, y;
+
+#define GAMMA_PIXEL(srcp, pixel)					\
+	do {								\
+		RETRIEVE_RGB_PIXEL(srcp, srcbpp, pixel);		\
+		pixel = rtable[(pixel & fmt->Rmask) >> fmt->Rshift] |	\
+		        gtable[(pixel & fmt->Gmask) >> fmt->Gshift] |	\
+		        btable[(pixel & fmt->Bmask) >> fmt->Bshift];	\
+		srcp += srcbpp;						\
+	} while(0)
+
+	if ( SDL_MUSTLOCK(dst) ) {
+		if ( SDL_LockSurface(dst) < 0 ) {
+			return;
+		}
+	}
+	srcrow = (Uint8 *)src->pixels + rect->y*src->pitch + rect->x*srcbpp;
+	dstrow = (Uint8 *)dst->pixels + rect->y*dst->pitch + rect->x*dstbpp;
+	for ( y = rect->h; y; --y ) {
+		Uint8 *srcp = srcrow;
+		Uint8 *dstp = dstrow;
+		Uint32 pixel;
+
+		switch (dstbpp) {
+		    case 2:
+			for ( x = rect->w; x; --x ) {
+				GAMMA_PIXEL(srcp, pixel);
+				*(Uint16 *)dstp = (Uint16)pixel;
+				dstp += 2;
+			}
+			break;
+		    case 3:
+			for ( x = rect->w; x; --x ) {
+				GAMMA_PIXEL(srcp, pixel);
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+				dstp[0] = (Uint8)pixel;
+				dstp[1] = (Uint8)(pixel >> 8);
+				dstp[2] = (Uint8)(pixel >> 16);
+#else
+				dstp[0] = (Uint8)(pixel >> 16);
+				dstp[1] = (Uint8)(pixel >> 8);
+				dstp[2] = (Uint8)pixel;
+#endif
+				dstp += 3;
+			}
+			break;
+		    default:
+			for ( x = rect->w; x; --x ) {
+				GAMMA_PIXEL(srcp, pixel);
+				*(Uint32 *)dstp = pixel;
+				dstp += 4;
+			}
+			break;
+		}
+		srcrow += src->pitch;
+		dstrow += dst->pitch;
+	}
+	if ( SDL_MUSTLOCK(dst) ) {
+		SDL_UnlockSurface(dst);
+	}
+#undef GAMMA_PIXEL
+}
+
 int SDL_SetGamma(float red, float green, float blue)
 {
 	int succeeded;
@@ -185,11 +347,26 @@ int SDL_SetGammaRamp(const Uint16 *red, const Uint16 *green, const Uint16 *blue)
 
 	/* Try to set the gamma ramp in the driver */
 	succeeded = -1;
-	if ( video->SetGammaRamp ) {
+	if ( SDL_getenv("SDL_VIDEO_SOFTWARE_GAMMA") ) {
+		SDL_SetError("Software gamma requested");
+	} else if ( video->SetGammaRamp ) {
 		succeeded = video->SetGammaRamp(this, video->gamma);
 	} else {
 		SDL_SetError("Gamma ramp manipulation not supported");
 	}
+	if ( succeeded == 0 ) {
+		if ( video->gamma_tables ) {
+			SDL_free(video->gamma_tables);
+			video->gamma_tables = NULL;
+		}
+	} else if ( SDL_ShadowSurface ) {
+		/* Correct the colors while copying the shadow surface */
+		if ( SDL_SetSoftGammaRamp(video) == 0 ) {
+			SDL_ClearError();
+			SDL_UpdateRect(SDL_ShadowSurface, 0, 0, 0, 0);
+			succeeded = 0;
+		}
+	}
 	return succeeded;
 }
 
@@ -30,6 +30,25 @@
 #include "SDL_pixels_c.h"
 #include "SDL_RLEaccel_c.h"
 
+#if SDL_ASSEMBLY_ROUTINES
+#  if (defined(__GNUC__) && defined(__SSE2__)) || \
+      (defined(_MSC_VER) && (defined(_M_X64) || (_M_IX86_FP >= 2)))
+#    define SSE2_PIXELS 1
+#  endif
+#  if defined(__GNUC__) && (defined(__ARM_NEON__) || defined(__ARM_NEON)) && \
+      (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#    define NEON_PIXELS 1
+#  endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
+
+#include "SDL_cpuinfo.h"
+#if SSE2_PIXELS
+#include <emmintrin.h>
+#endif
+#if NEON_PIXELS
+#include <arm_neon.h>
+#endif
+
 /* Helper functions */
 /*
  * Allocate a pixel format structure and fill it according to the given info.
@@ -232,19 +251,75 @@ SDL_PixelFormat *SDL_ReallocFormat(SDL_Surface *surface, int bpp,
 	return surface->format;
 }
 
-/*
- * Change any previous mappings from/to the new surface format
- */
-void SDL_FormatChanged(SDL_Surface *surface)
+static int SDL_NextFormatVersion(void)
 {
 	static int format_version = 0;
 	++format_version;
 	if ( format_version < 0 ) { /* It wrapped... */
 		format_version = 1;
 	}
-	surface->format_version = format_version;
+	return(format_version);
+}
+
+/*
+ * Change any previous mappings from/to the new surface format
+ */
+void SDL_FormatChanged(SDL_Surface *surface)
+{
+	surface->format_version = SDL_NextFormatVersion();
+	if ( surface->map ) {
+		/* Mappings onto this surface can't be patched any more */
+		surface->map->palette_base = surface->format_version;
+		SDL_memset(surface->map->palette_dirty, 0,
+		           sizeof(surface->map->palette_dirty));
+	}
 	SDL_InvalidateMap(surface->map);
 }
+
+/*
+ * Like SDL_FormatChanged(), but only palette entries firstcolor to
+ * firstcolor+ncolors-1 changed: the mapping from the surface is patched
+ * in place, and mappings onto it are patched on their next use.
+ */
+void SDL_PaletteChanged(SDL_Surface *surface, int firstcolor, int ncolors)
+{
+	SDL_BlitMap *map = surface->map;
+	int version;
+	int ndirty;
+	int i;
+
+	if ( ! map ) {
+		SDL_FormatChanged(surface);
+		return;
+	}
+	version = SDL_NextFormatVersion();
+	ndirty = 256;
+	if ( version > surface->format_version ) {
+		for ( i = firstcolor; i < firstcolor + ncolors; ++i ) {
+			map->palette_dirty[i >> 5] |= (Uint32)1 << (i & 31);
+		}
+		ndirty = 0;
+		for ( i = 0; i < 256; ++i ) {
+			if ( map->palette_dirty[i >> 5] & ((Uint32)1 << (i & 31)) ) {
+				++ndirty;
+			}
+		}
+	}
+	if ( ndirty > 128 ) {
+		/* Wrapped, or patching would cost as much as a rebuild:
+		   start over, so mappings made before now are rebuilt */
+		map->palette_base = version;
+		SDL_memset(map->palette_dirty, 0, sizeof(map->palette_dirty));
+	}
+	surface->format_version = version;
+
+	/* The blit target may be gone by now, so the mapping from this
+	   surface is patched when it is next used, by SDL_RefreshMap() */
+	for ( i = firstcolor; i < firstcolor + ncolors; ++i ) {
+		map->remap_dirty[i >> 5] |= (Uint32)1 << (i & 31);
+	}
+	map->remap_pending = 1;
+}
 /*
  * Free a previously allocated format structure
  */
@@ -289,13 +364,14 @@ void SDL_DitherColors(SDL_Color *colors, int bpp)
  * Calculate the pad-aligned scanline width of a surface. Return 0 in case of
  * an error.
  */
-Uint16 SDL_CalculatePitch(SDL_Surface *surface)
+Uint32 SDL_CalculatePitch(SDL_Surface *surface)
 {
 	unsigned int pitch = 0;
 	Uint8 byte;
 
 	/* Surface should be 4-byte aligned for speed */
-	/* The code tries to prevent from an Uint16 overflow. */;
+	/* The code tries to prevent from an Uint16 overflow, or an
+	   overflow of the signed blit skips for large surfaces. */
 	for (byte = surface->format->BytesPerPixel; byte; byte--) {
 		pitch += (unsigned int)surface->w;
 		if (pitch < surface->w) {
@@ -329,11 +405,11 @@ Uint16 SDL_CalculatePitch(SDL_Surface *surface)
 		}
 		pitch = (pitch + 3) & ~3;
 	}
-	if (pitch > 0xFFFF) {
+	if (pitch > ((surface->flags & SDL_LARGESURFACE) ? 0x7FFFFFFF : 0xFFFF)) {
 		SDL_SetError("A scanline is too wide");
 		return(0);
 	}
-	return((Uint16)pitch);
+	return((Uint32)pitch);
 }
 /*
  * Match an RGB value to a particular palette index
@@ -447,6 +523,327 @@ void SDL_GetRGB(Uint32 pixel, const SDL_PixelFormat * const fmt,
 	}
 }
 
+/* The body of SDL_GetRGBA() for one component of a bit field format */
+#define GET_COMPONENT(pixel, mask, shift, loss, c)			\
+do {									\
+	unsigned v = ((pixel) & (mask)) >> (shift);			\
+	c = (v << (loss)) + (v >> (8 - ((loss) << 1)));			\
+} while(0)
+
+/* The SIMD versions of SDL_GetRGBA() handle components of 4 bits or more */
+#define SIMD_GETRGBA_OK(fmt)						\
+	((fmt)->Rloss <= 4 && (fmt)->Gloss <= 4 && (fmt)->Bloss <= 4 &&	\
+	 (!(fmt)->Amask || (fmt)->Aloss <= 4))
+
+/* Entries of the cache used for palette lookups in SDL_MapRGBAArray() */
+#define INVERSE_CACHE_BITS	10
+
+#if SSE2_PIXELS
+/* 4 RGBA byte quadruples to pixels */
+static __inline__ __m128i MapRGBA_SSE2(const SDL_PixelFormat *fmt, __m128i in)
+{
+	const __m128i mask8 = _mm_set1_epi32(0xff);
+	__m128i r, g, b, a;
+
+	r = _mm_and_si128(in, mask8);
+	g = _mm_and_si128(_mm_srli_epi32(in, 8), mask8);
+	b = _mm_and_si128(_mm_srli_epi32(in, 16), mask8);
+	a = _mm_srli_epi32(in, 24);
+	r = _mm_sll_epi32(_mm_srl_epi32(r, _mm_cvtsi32_si128(fmt->Rloss)),
+	                  _mm_cvtsi32_si128(fmt->Rshift));
+	g = _mm_sll_epi32(_mm_srl_epi32(g, _mm_cvtsi32_si128(fmt->Gloss)),
+	                  _mm_cvtsi32_si128(fmt->Gshift));
+	b = _mm_sll_epi32(_mm_srl_epi32(b, _mm_cvtsi32_si128(fmt->Bloss)),
+	                  _mm_cvtsi32_si128(fmt->Bshift));
+	a = _mm_sll_epi32(_mm_srl_epi32(a, _mm_cvtsi32_si128(fmt->Aloss)),
+	                  _mm_cvtsi32_si128(fmt->Ashift));
+	a = _mm_and_si128(a, _mm_set1_epi32(fmt->Amask));
+	return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+}
+
+static __inline__ __m128i GetComponent_SSE2(__m128i p, Uint32 mask,
+                                            int shift, int loss)
+{
+	__m128i v = _mm_srl_epi32(_mm_and_si128(p, _mm_set1_epi32(mask)),
+	                          _mm_cvtsi32_si128(shift));
+	return _mm_add_epi32(_mm_sll_epi32(v, _mm_cvtsi32_si128(loss)),
+	                     _mm_srl_epi32(v, _mm_cvtsi32_si128(8 - (loss << 1))));
+}
+
+/* 4 pixels to their components in the low byte of each 32-bit lane */
+static __inline__ void GetRGBA_SSE2(const SDL_PixelFormat *fmt, __m128i p,
+                                    __m128i *r, __m128i *g,
+                                    __m128i *b, __m128i *a)
+{
+	*r = GetComponent_SSE2(p, fmt->Rmask, fmt->Rshift, fmt->Rloss);
+	*g = GetComponent_SSE2(p, fmt->Gmask, fmt->Gshift, fmt->Gloss);
+	*b = GetComponent_SSE2(p, fmt->Bmask, fmt->Bshift, fmt->Bloss);
+	if ( fmt->Amask ) {
+		*a = GetComponent_SSE2(p, fmt->Amask, fmt->Ashift, fmt->Aloss);
+	} else {
+		*a = _mm_set1_epi32(SDL_ALPHA_OPAQUE);
+	}
+}
+
+/* Pack 16 components of 4 vectors into 16 bytes */
+static __inline__ void StorePlane_SSE2(Uint8 *dst, __m128i c0, __m128i c1,
+                                       __m128i c2, __m128i c3)
+{
+	_mm_storeu_si128((__m128i *)dst,
+	                 _mm_packus_epi16(_mm_packs_epi32(c0, c1),
+	                                  _mm_packs_epi32(c2, c3)));
+}
+#endif /* SSE2_PIXELS */
+
+#if NEON_PIXELS
+/* Positive counts shift left, negative ones right */
+#define NEON_SHIFT(v, n)	vshlq_u32(v, vdupq_n_s32(n))
+
+static __inline__ uint32x4_t MapRGBA_NEON(const SDL_PixelFormat *fmt,
+                                          uint32x4_t in)
+{
+	const uint32x4_t mask8 = vdupq_n_u32(0xff);
+	uint32x4_t r, g, b, a;
+
+	r = vandq_u32(in, mask8);
+	g = vandq_u32(vshrq_n_u32(in, 8), mask8);
+	b = vandq_u32(vshrq_n_u32(in, 16), mask8);
+	a = vshrq_n_u32(in, 24);
+	r = NEON_SHIFT(NEON_SHIFT(r, -fmt->Rloss), fmt->Rshift);
+	g = NEON_SHIFT(NEON_SHIFT(g, -fmt->Gloss), fmt->Gshift);
+	b = NEON_SHIFT(NEON_SHIFT(b, -fmt->Bloss), fmt->Bshift);
+	a = NEON_SHIFT(NEON_SHIFT(a, -fmt->Aloss), fmt->Ashift);
+	a = vandq_u32(a, vdupq_n_u32(fmt->Amask));
+	return vorrq_u32(vorrq_u32(r, g), vorrq_u32(b, a));
+}
+
+static __inline__ uint32x4_t GetComponent_NEON(uint32x4_t p, Uint32 mask,
+                                               int shift, int loss)
+{
+	uint32x4_t v = NEON_SHIFT(vandq_u32(p, vdupq_n_u32(mask)), -shift);
+	return vaddq_u32(NEON_SHIFT(v, loss),
+	                 NEON_SHIFT(v, (loss << 1) - 8));
+}
+
+static __inline__ void GetRGBA_NEON(const SDL_PixelFormat *fmt, uint32x4_t p,
+                                    uint32x4_t *r, uint32x4_t *g,
+                                    uint32x4_t *b, uint32x4_t *a)
+{
+	*r = GetComponent_NEON(p, fmt->Rmask, fmt->Rshift, fmt->Rloss);
+	*g = GetComponent_NEON(p, fmt->Gmask, fmt->Gshift, fmt->Gloss);
+	*b = GetComponent_NEON(p, fmt->Bmask, fmt->Bshift, fmt->Bloss);
+	if ( fmt->Amask ) {
+		*a = GetComponent_NEON(p, fmt->Amask, fmt->Ashift, fmt->Aloss);
+	} else {
+		*a = vdupq_n_u32(SDL_ALPHA_OPAQUE);
+	}
+}
+
+static __inline__ void StorePlane_NEON(Uint8 *dst, uint32x4_t c0,
+                                       uint32x4_t c1, uint32x4_t c2,
+                                       uint32x4_t c3)
+{
+	uint16x8_t lo = vcombine_u16(vmovn_u32(c0), vmovn_u32(c1));
+	uint16x8_t hi = vcombine_u16(vmovn_u32(c2), vmovn_u32(c3));
+	vst1q_u8(dst, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+}
+#endif /* NEON_PIXELS */
+
+/* Map an array of RGBA quadruples to pixel values */
+void SDL_MapRGBAArray(const SDL_PixelFormat * const format,
+		      const Uint8 *rgba, Uint32 *pixels, int count)
+{
+	int i;
+
+	if ( format->palette ) {
+		/* Direct mapped cache of colors already looked up,
+		   each entry is the RGB value and the palette index */
+		Uint32 cache[1 << INVERSE_CACHE_BITS];
+		Uint32 rgb;
+		unsigned slot;
+
+		if ( count < (1 << INVERSE_CACHE_BITS) / 16 ) {
+			for ( i = 0; i < count; ++i, rgba += 4 ) {
+				pixels[i] = SDL_FindColor(format->palette,
+				                          rgba[0], rgba[1], rgba[2]);
+			}
+			return;
+		}
+		/* Every 32-bit pattern is a possible entry, so there's no
+		   empty value; start every slot out as black instead, which
+		   is a real entry wherever it sits */
+		rgb = SDL_FindColor(format->palette, 0, 0, 0);
+		for ( slot = 0; slot < (1 << INVERSE_CACHE_BITS); ++slot ) {
+			cache[slot] = rgb;
+		}
+		for ( i = 0; i < count; ++i, rgba += 4 ) {
+			rgb = ((Uint32)rgba[0] << 16) | (rgba[1] << 8) | rgba[2];
+			slot = (rgb * 2654435761u) >> (32 - INVERSE_CACHE_BITS);
+			if ( (cache[slot] >> 8) != rgb ) {
+				cache[slot] = (rgb << 8) |
+				              SDL_FindColor(format->palette,
+				                            rgba[0], rgba[1], rgba[2]);
+			}
+			pixels[i] = cache[slot] & 0xff;
+		}
+		return;
+	}
+
+	i = 0;
+#if SSE2_PIXELS
+	if ( SDL_HasSSE2() ) {
+		for ( ; i + 4 <= count; i += 4, rgba += 16 ) {
+			_mm_storeu_si128((__m128i *)&pixels[i],
+			    MapRGBA_SSE2(format,
+			                 _mm_loadu_si128((const __m128i *)rgba)));
+		}
+	}
+#endif
+#if NEON_PIXELS
+	if ( SDL_HasNEON() ) {
+		for ( ; i + 4 <= count; i += 4, rgba += 16 ) {
+			vst1q_u32(&pixels[i],
+			    MapRGBA_NEON(format, vreinterpretq_u32_u8(vld1q_u8(rgba))));
+		}
+	}
+#endif
+	for ( ; i < count; ++i, rgba += 4 ) {
+		pixels[i] = (rgba[0] >> format->Rloss) << format->Rshift
+		    | (rgba[1] >> format->Gloss) << format->Gshift
+		    | (rgba[2] >> format->Bloss) << format->Bshift
+		    | ((rgba[3] >> format->Aloss) << format->Ashift & format->Amask);
+	}
+}
+
+/* Unpack an array of pixel values to RGBA quadruples */
+void SDL_GetRGBAArray(const SDL_PixelFormat * const fmt,
+		      const Uint32 *pixels, Uint8 *rgba, int count)
+{
+	int i;
+
+	if ( fmt->palette ) {
+		for ( i = 0; i < count; ++i, rgba += 4 ) {
+			rgba[0] = fmt->palette->colors[pixels[i]].r;
+			rgba[1] = fmt->palette->colors[pixels[i]].g;
+			rgba[2] = fmt->palette->colors[pixels[i]].b;
+			rgba[3] = SDL_ALPHA_OPAQUE;
+		}
+		return;
+	}
+
+	i = 0;
+#if SSE2_PIXELS
+	if ( SIMD_GETRGBA_OK(fmt) && SDL_HasSSE2() ) {
+		__m128i r, g, b, a;
+		for ( ; i + 4 <= count; i += 4, rgba += 16 ) {
+			GetRGBA_SSE2(fmt,
+			             _mm_loadu_si128((const __m128i *)&pixels[i]),
+			             &r, &g, &b, &a);
+			_mm_storeu_si128((__m128i *)rgba,
+			    _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)),
+			                 _mm_or_si128(_mm_slli_epi32(b, 16),
+			                              _mm_slli_epi32(a, 24))));
+		}
+	}
+#endif
+#if NEON_PIXELS
+	if ( SIMD_GETRGBA_OK(fmt) && SDL_HasNEON() ) {
+		uint32x4_t r, g, b, a;
+		for ( ; i + 4 <= count; i += 4, rgba += 16 ) {
+			GetRGBA_NEON(fmt, vld1q_u32(&pixels[i]), &r, &g, &b, &a);
+			vst1q_u8(rgba, vreinterpretq_u8_u32(
+			    vorrq_u32(vorrq_u32(r, vshlq_n_u32(g, 8)),
+			              vorrq_u32(vshlq_n_u32(b, 16),
+			                        vshlq_n_u32(a, 24)))));
+		}
+	}
+#endif
+	for ( ; i < count; ++i, rgba += 4 ) {
+		GET_COMPONENT(pixels[i], fmt->Rmask, fmt->Rshift, fmt->Rloss, rgba[0]);
+		GET_COMPONENT(pixels[i], fmt->Gmask, fmt->Gshift, fmt->Gloss, rgba[1]);
+		GET_COMPONENT(pixels[i], fmt->Bmask, fmt->Bshift, fmt->Bloss, rgba[2]);
+		if ( fmt->Amask ) {
+			GET_COMPONENT(pixels[i], fmt->Amask, fmt->Ashift,
+			              fmt->Aloss, rgba[3]);
+		} else {
+			rgba[3] = SDL_ALPHA_OPAQUE;
+		}
+	}
+}
+
+/* Unpack an array of pixel values to separate component arrays */
+void SDL_GetRGBAPlanar(const SDL_PixelFormat * const fmt,
+		       const Uint32 *pixels, Uint8 *r, Uint8 *g, Uint8 *b,
+		       Uint8 *a, int count)
+{
+	int i;
+
+	if ( fmt->palette ) {
+		for ( i = 0; i < count; ++i ) {
+			r[i] = fmt->palette->colors[pixels[i]].r;
+			g[i] = fmt->palette->colors[pixels[i]].g;
+			b[i] = fmt->palette->colors[pixels[i]].b;
+			if ( a ) {
+				a[i] = SDL_ALPHA_OPAQUE;
+			}
+		}
+		return;
+	}
+
+	i = 0;
+#if SSE2_PIXELS
+	if ( SIMD_GETRGBA_OK(fmt) && SDL_HasSSE2() ) {
+		__m128i r4[4], g4[4], b4[4], a4[4];
+		int j;
+		for ( ; i + 16 <= count; i += 16 ) {
+			for ( j = 0; j < 4; ++j ) {
+				GetRGBA_SSE2(fmt,
+				    _mm_loadu_si128((const __m128i *)&pixels[i+j*4]),
+				    &r4[j], &g4[j], &b4[j], &a4[j]);
+			}
+			StorePlane_SSE2(&r[i], r4[0], r4[1], r4[2], r4[3]);
+			StorePlane_SSE2(&g[i], g4[0], g4[1], g4[2], g4[3]);
+			StorePlane_SSE2(&b[i], b4[0], b4[1], b4[2], b4[3]);
+			if ( a ) {
+				StorePlane_SSE2(&a[i], a4[0], a4[1], a4[2], a4[3]);
+			}
+		}
+	}
+#endif
+#if NEON_PIXELS
+	if ( SIMD_GETRGBA_OK(fmt) && SDL_HasNEON() ) {
+		uint32x4_t r4[4], g4[4], b4[4], a4[4];
+		int j;
+		for ( ; i + 16 <= count; i += 16 ) {
+			for ( j = 0; j < 4; ++j ) {
+				GetRGBA_NEON(fmt, vld1q_u32(&pixels[i+j*4]),
+				             &r4[j], &g4[j], &b4[j], &a4[j]);
+			}
+			StorePlane_NEON(&r[i], r4[0], r4[1], r4[2], r4[3]);
+			StorePlane_NEON(&g[i], g4[0], g4[1], g4[2], g4[3]);
+			StorePlane_NEON(&b[i], b4[0], b4[1], b4[2], b4[3]);
+			if ( a ) {
+				StorePlane_NEON(&a[i], a4[0], a4[1], a4[2], a4[3]);
+			}
+		}
+	}
+#endif
+	for ( ; i < count; ++i ) {
+		GET_COMPONENT(pixels[i], fmt->Rmask, fmt->Rshift, fmt->Rloss, r[i]);
+		GET_COMPONENT(pixels[i], fmt->Gmask, fmt->Gshift, fmt->Gloss, g[i]);
+		GET_COMPONENT(pixels[i], fmt->Bmask, fmt->Bshift, fmt->Bloss, b[i]);
+		if ( ! a ) {
+			continue;
+		}
+		if ( fmt->Amask ) {
+			GET_COMPONENT(pixels[i], fmt->Amask, fmt->Ashift,
+			              fmt->Aloss, a[i]);
+		} else {
+			a[i] = SDL_ALPHA_OPAQUE;
+		}
+	}
+}
+
 /* Apply gamma to a set of colors - this is easy. :) */
 void SDL_ApplyGamma(Uint16 *gamma, SDL_Color *colors, SDL_Color *output,
 							int ncolors)
@@ -562,6 +959,8 @@ void SDL_InvalidateMap(SDL_BlitMap *map)
 	}
 	map->dst = NULL;
 	map->format_version = (unsigned int)-1;
+	map->remap_pending = 0;
+	SDL_memset(map->remap_dirty, 0, sizeof(map->remap_dirty));
 	if ( map->table ) {
 		SDL_free(map->table);
 		map->table = NULL;
@@ -642,6 +1041,154 @@ int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 	/* Choose your blitters wisely */
 	return(SDL_CalculateBlit(src));
 }
+/*
+ * Patch the entries firstcolor to firstcolor+ncolors-1 of the lookup table
+ * from the (palettized) surface to its current blit target, which are
+ * mapped as if the source palette had the given colors there.
+ */
+void SDL_RemapColors(SDL_Surface *surface, const SDL_Color *colors,
+		     int firstcolor, int ncolors)
+{
+	SDL_BlitMap *map = surface->map;
+	SDL_Surface *dst = map->dst;
+	SDL_PixelFormat *dstfmt;
+	unsigned alpha;
+	int bpp;
+	int i;
+
+	if ( ! dst ) {
+		return;
+	}
+	/* Stale and identity mappings have to be worked out from scratch */
+	if ( map->format_version != (unsigned int)dst->format_version ||
+	     map->identity || ! map->table ||
+	     surface->format->BytesPerPixel != 1 ) {
+		SDL_InvalidateMap(map);
+		return;
+	}
+
+	dstfmt = dst->format;
+	if ( dstfmt->BytesPerPixel == 1 ) {
+		/* Palette --> Palette */
+		for ( i=0; i<ncolors; ++i ) {
+			map->table[firstcolor+i] = SDL_FindColor(dstfmt->palette,
+				colors[i].r, colors[i].g, colors[i].b);
+		}
+	} else {
+		/* Palette --> BitField, as in Map1toN() */
+		bpp = ((dstfmt->BytesPerPixel == 3) ? 4 : dstfmt->BytesPerPixel);
+		alpha = dstfmt->Amask ? surface->format->alpha : 0;
+		for ( i=0; i<ncolors; ++i ) {
+			ASSEMBLE_RGBA(&map->table[(firstcolor+i)*bpp],
+				      dstfmt->BytesPerPixel, dstfmt,
+				      colors[i].r, colors[i].g, colors[i].b,
+				      alpha);
+		}
+	}
+}
+
+/* SDL_FindColor() for a palette where only the entries in 'dirty' changed
+   since 'old' was the best match, giving exactly the same result */
+static Uint8 FindChangedColor(SDL_Palette *pal, const SDL_Color *color,
+			      Uint8 old, const Uint32 *dirtymask,
+			      const Uint8 *dirty, int ndirty)
+{
+	unsigned int smallest;
+	unsigned int distance;
+	int rd, gd, bd;
+	int i;
+	Uint8 pixel;
+
+	if ( old >= pal->ncolors ||
+	     (dirtymask[old >> 5] & ((Uint32)1 << (old & 31))) ) {
+		return SDL_FindColor(pal, color->r, color->g, color->b);
+	}
+	pixel = old;
+	rd = pal->colors[old].r - color->r;
+	gd = pal->colors[old].g - color->g;
+	bd = pal->colors[old].b - color->b;
+	smallest = (rd*rd)+(gd*gd)+(bd*bd);
+	for ( i=0; i<ndirty; ++i ) {
+		rd = pal->colors[dirty[i]].r - color->r;
+		gd = pal->colors[dirty[i]].g - color->g;
+		bd = pal->colors[dirty[i]].b - color->b;
+		distance = (rd*rd)+(gd*gd)+(bd*bd);
+		/* SDL_FindColor() prefers the lowest index on a tie */
+		if ( distance < smallest ||
+		     (distance == smallest && dirty[i] < pixel) ) {
+			pixel = dirty[i];
+			smallest = distance;
+		}
+	}
+	return(pixel);
+}
+
+/*
+ * Bring the mapping from src to dst up to date.  If only palette entries
+ * of dst changed since the mapping was made, the lookup table is patched
+ * for those entries, otherwise the mapping is rebuilt with SDL_MapSurface()
+ */
+int SDL_RefreshMap (SDL_Surface *src, SDL_Surface *dst)
+{
+	SDL_BlitMap *map = src->map;
+	SDL_BlitMap *dstmap = dst->map;
+	SDL_Palette *pal = dst->format->palette;
+	SDL_Color dithered[256];
+	SDL_Color *colors;
+	Uint8 dirty[256];
+	int ndirty, ncolors;
+	int i;
+
+	/* Patch in palette changes of the source first, now that the
+	   target is known to be alive */
+	if ( map->remap_pending ) {
+		map->remap_pending = 0;
+		for ( i=0; map->dst == dst && i<256; ++i ) {
+			if ( map->remap_dirty[i >> 5] & ((Uint32)1 << (i & 31)) ) {
+				SDL_RemapColors(src,
+				                &src->format->palette->colors[i],
+				                i, 1);
+			}
+		}
+		SDL_memset(map->remap_dirty, 0, sizeof(map->remap_dirty));
+		if ( map->dst == dst &&
+		     map->format_version == (unsigned int)dst->format_version ) {
+			return(0);
+		}
+	}
+
+	if ( map->dst != dst || ! map->table || map->identity ||
+	     dst->format->BytesPerPixel != 1 || ! pal || ! dstmap ||
+	     map->format_version < dstmap->palette_base ||
+	     map->format_version > (unsigned int)dst->format_version ) {
+		return(SDL_MapSurface(src, dst));
+	}
+
+	ndirty = 0;
+	for ( i=0; i<pal->ncolors; ++i ) {
+		if ( dstmap->palette_dirty[i >> 5] & ((Uint32)1 << (i & 31)) ) {
+			dirty[ndirty++] = i;
+		}
+	}
+	if ( src->format->BytesPerPixel == 1 ) {
+		/* Palette --> Palette, as in Map1to1() */
+		colors = src->format->palette->colors;
+		ncolors = src->format->palette->ncolors;
+	} else {
+		/* BitField --> Palette, as in MapNto1() */
+		SDL_DitherColors(dithered, 8);
+		colors = dithered;
+		ncolors = 256;
+	}
+	for ( i=0; i<ncolors; ++i ) {
+		map->table[i] = FindChangedColor(pal, &colors[i], map->table[i],
+		                                 dstmap->palette_dirty,
+		                                 dirty, ndirty);
+	}
+	map->format_version = dst->format_version;
+	return(0);
+}
+
 void SDL_FreeBlitMap(SDL_BlitMap *map)
 {
 	if ( map ) {
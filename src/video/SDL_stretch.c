@@ -309,10 +309,10 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 
 	/* Perform the stretch blit */
 	for ( dst_maxrow = dst_row+dstrect->h; dst_row<dst_maxrow; ++dst_row ) {
-		dstp = (Uint8 *)dst->pixels + (dst_row*dst->pitch)
+		dstp = (Uint8 *)dst->pixels + ((size_t)dst_row*SURFACE_PITCH(dst))
 		                            + (dstrect->x*bpp);
 		while ( pos >= 0x10000L ) {
-			srcp = (Uint8 *)src->pixels + (src_row*src->pitch)
+			srcp = (Uint8 *)src->pixels + ((size_t)src_row*SURFACE_PITCH(src))
 			                            + (srcrect->x*bpp);
 			++src_row;
 			pos -= 0x10000L;
@@ -24,6 +24,7 @@
 #include "SDL_video.h"
 #include "SDL_sysvideo.h"
 #include "SDL_cursor_c.h"
+#include "SDL_workers_c.h"
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
@@ -43,10 +44,19 @@ SDL_Surface * SDL_CreateRGBSurface (Uint32 flags,
 	SDL_VideoDevice *this  = current_video;
 	SDL_Surface *screen;
 	SDL_Surface *surface;
+	Uint32 pitch;
 
 	/* Make sure the size requested doesn't overflow our datatypes */
 	/* Next time I write a library like SDL, I'll use int for size. :) */
-	if ( width >= 16384 || height >= 65536 ) {
+	if ( flags & SDL_LARGESURFACE ) {
+		/* Large surfaces live in system memory, sizes are checked
+		   against the 32-bit pitch below */
+		flags &= ~SDL_HWSURFACE;
+		if ( width < 0 || height < 0 ) {
+			SDL_SetError("Width or height is too large");
+			return(NULL);
+		}
+	} else if ( width >= 16384 || height >= 65536 ) {
 		SDL_SetError("Width or height is too large");
 		return(NULL);
 	}
@@ -81,7 +91,7 @@ SDL_Surface * SDL_CreateRGBSurface (Uint32 flags,
 		SDL_OutOfMemory();
 		return(NULL);
 	}
-	surface->flags = SDL_SWSURFACE;
+	surface->flags = SDL_SWSURFACE | (flags & SDL_LARGESURFACE);
 	if ( (flags & SDL_HWSURFACE) == SDL_HWSURFACE ) {
 		if ((Amask) && (video->displayformatalphapixel))
 		{
@@ -110,13 +120,14 @@ SDL_Surface * SDL_CreateRGBSurface (Uint32 flags,
 	}
 	surface->w = width;
 	surface->h = height;
-	surface->pitch = SDL_CalculatePitch(surface);
+	pitch = SDL_CalculatePitch(surface);
+	surface->pitch = (pitch > 0xFFFF) ? 0 : pitch;
 	surface->pixels = NULL;
 	surface->offset = 0;
 	surface->hwdata = NULL;
 	surface->locked = 0;
 	surface->map = NULL;
-	surface->unused1 = 0;
+	surface->unused1 = (flags & SDL_LARGESURFACE) ? pitch : 0;
 	SDL_SetClipRect(surface, NULL);
 	SDL_FormatChanged(surface);
 
@@ -124,14 +135,24 @@ SDL_Surface * SDL_CreateRGBSurface (Uint32 flags,
 	if ( ((flags&SDL_HWSURFACE) == SDL_SWSURFACE) || 
 				(video->AllocHWSurface(this, surface) < 0) ) {
 		if ( surface->w && surface->h ) {
-			surface->pixels = SDL_malloc(surface->h*surface->pitch);
+			if ( ! pitch ) {
+				/* The scanline was too wide */
+				SDL_FreeSurface(surface);
+				return(NULL);
+			}
+			if ( (size_t)surface->h > ((size_t)-1) / pitch ) {
+				SDL_FreeSurface(surface);
+				SDL_SetError("Width or height is too large");
+				return(NULL);
+			}
+			surface->pixels = SDL_malloc((size_t)surface->h*pitch);
 			if ( surface->pixels == NULL ) {
 				SDL_FreeSurface(surface);
 				SDL_OutOfMemory();
 				return(NULL);
 			}
 			/* This is important for bitmaps */
-			SDL_memset(surface->pixels, 0, surface->h*surface->pitch);
+			SDL_memset(surface->pixels, 0, (size_t)surface->h*pitch);
 		}
 	}
 
@@ -165,11 +186,24 @@ SDL_Surface * SDL_CreateRGBSurfaceFrom (void *pixels,
 		surface->pixels = pixels;
 		surface->w = width;
 		surface->h = height;
-		surface->pitch = pitch;
+		if ( pitch > 0xFFFF ) {
+			surface->flags |= SDL_LARGESURFACE;
+			surface->pitch = 0;
+			surface->unused1 = pitch;
+		} else {
+			surface->pitch = pitch;
+		}
 		SDL_SetClipRect(surface, NULL);
 	}
 	return(surface);
 }
+/*
+ * Get the row length of a surface, which may not fit in its pitch member
+ */
+Uint32 SDL_GetSurfacePitch (SDL_Surface *surface)
+{
+	return(SURFACE_PITCH(surface));
+}
 /*
  * Set the color key in a blittable surface
  */
@@ -281,6 +315,32 @@ int SDL_SetAlpha (SDL_Surface *surface, Uint32 flag, Uint8 value)
 		SDL_InvalidateMap(surface->map);
 	return(0);
 }
+/* This function sets the blend mode used when blitting from a surface */
+int SDL_SetBlendMode (SDL_Surface *surface, int mode)
+{
+	switch (mode) {
+	    case SDL_BLENDMODE_NONE:
+	    case SDL_BLENDMODE_ADD:
+	    case SDL_BLENDMODE_MOD:
+	    case SDL_BLENDMODE_MUL:
+		break;
+	    default:
+		SDL_SetError("Unknown blend mode");
+		return(-1);
+	}
+
+	/* Optimize away operations that don't change anything */
+	if ( mode == surface->map->blendmode ) {
+		return(0);
+	}
+	surface->map->blendmode = mode;
+	SDL_InvalidateMap(surface->map);
+	return(0);
+}
+int SDL_GetBlendMode (SDL_Surface *surface)
+{
+	return(surface->map->blendmode);
+}
 int SDL_SetAlphaChannel(SDL_Surface *surface, Uint8 value)
 {
 	int row, col;
@@ -316,7 +376,8 @@ int SDL_SetAlphaChannel(SDL_Surface *surface, Uint8 value)
 	row = surface->h;
 	while (row--) {
 		col = surface->w;
-		buf = (Uint8 *)surface->pixels + row * surface->pitch + offset;
+		buf = (Uint8 *)surface->pixels +
+		      (size_t)row * SURFACE_PITCH(surface) + offset;
 		while(col--) {
 			*buf = value;
 			buf += 4;
@@ -375,11 +436,11 @@ SDL_bool SDL_SetClipRect(SDL_Surface *surface, const SDL_Rect *rect)
 		return SDL_FALSE;
 	}
 
-	/* Set up the full surface rectangle */
+	/* Set up the full surface rectangle, as far as it can be described */
 	full_rect.x = 0;
 	full_rect.y = 0;
-	full_rect.w = surface->w;
-	full_rect.h = surface->h;
+	full_rect.w = (surface->w > 0xFFFF) ? 0xFFFF : surface->w;
+	full_rect.h = (surface->h > 0xFFFF) ? 0xFFFF : surface->h;
 
 	/* Set the clipping rectangle */
 	if ( ! rect ) {
@@ -414,8 +475,9 @@ int SDL_LowerBlit (SDL_Surface *src, SDL_Rect *srcrect,
 
 	/* Check to make sure the blit mapping is valid */
 	if ( (src->map->dst != dst) ||
-             (src->map->dst->format_version != src->map->format_version) ) {
-		if ( SDL_MapSurface(src, dst) < 0 ) {
+             (src->map->dst->format_version != src->map->format_version) ||
+	     src->map->remap_pending ) {
+		if ( SDL_RefreshMap(src, dst) < 0 ) {
 			return(-1);
 		}
 	}
@@ -534,6 +596,152 @@ int SDL_UpperBlit (SDL_Surface *src, SDL_Rect *srcrect,
 	return 0;
 }
 
+/* Whether a rectangle can be passed on as an SDL_Rect */
+#define RECT_FITS(rect)							\
+	((rect)->x >= -32768 && (rect)->x <= 32767 &&			\
+	 (rect)->y >= -32768 && (rect)->y <= 32767 &&			\
+	 (rect)->w >= 0 && (rect)->w <= 0xFFFF &&			\
+	 (rect)->h >= 0 && (rect)->h <= 0xFFFF)
+
+/* The clip area of a surface for the SDL_LargeRect functions */
+static void SDL_GetLargeClip(SDL_Surface *surface, SDL_LargeRect *clip)
+{
+	if ( surface->flags & SDL_LARGESURFACE ) {
+		clip->x = 0;
+		clip->y = 0;
+		clip->w = surface->w;
+		clip->h = surface->h;
+	} else {
+		clip->x = surface->clip_rect.x;
+		clip->y = surface->clip_rect.y;
+		clip->w = surface->clip_rect.w;
+		clip->h = surface->clip_rect.h;
+	}
+}
+
+int SDL_LowerBlitLarge (SDL_Surface *src, SDL_LargeRect *srcrect,
+			SDL_Surface *dst, SDL_LargeRect *dstrect)
+{
+	/* Rectangles SDL_Rect can hold take the usual path, which
+	   includes hardware and RLE accelerated blits */
+	if ( RECT_FITS(srcrect) && RECT_FITS(dstrect) ) {
+		SDL_Rect sr, dr;
+
+		sr.x = srcrect->x;
+		sr.y = srcrect->y;
+		sr.w = srcrect->w;
+		sr.h = srcrect->h;
+		dr.x = dstrect->x;
+		dr.y = dstrect->y;
+		dr.w = dstrect->w;
+		dr.h = dstrect->h;
+		return(SDL_LowerBlit(src, &sr, dst, &dr));
+	}
+
+	/* Check to make sure the blit mapping is valid */
+	if ( (src->map->dst != dst) ||
+             (src->map->dst->format_version != src->map->format_version) ||
+	     src->map->remap_pending ) {
+		if ( SDL_RefreshMap(src, dst) < 0 ) {
+			return(-1);
+		}
+	}
+	return(SDL_SoftBlitLarge(src, srcrect, dst, dstrect));
+}
+
+int SDL_UpperBlitLarge (SDL_Surface *src, SDL_LargeRect *srcrect,
+			SDL_Surface *dst, SDL_LargeRect *dstrect)
+{
+	SDL_LargeRect fulldst;
+	SDL_LargeRect clip;
+	int srcx, srcy, w, h;
+
+	/* Make sure the surfaces aren't locked */
+	if ( ! src || ! dst ) {
+		SDL_SetError("SDL_UpperBlitLarge: passed a NULL surface");
+		return(-1);
+	}
+	if ( src->locked || dst->locked ) {
+		SDL_SetError("Surfaces must not be locked during blit");
+		return(-1);
+	}
+
+	/* If the destination rectangle is NULL, use the entire dest surface */
+	if ( dstrect == NULL ) {
+	        fulldst.x = fulldst.y = 0;
+		dstrect = &fulldst;
+	}
+
+	/* clip the source rectangle to the source surface */
+	if(srcrect) {
+	        int maxw, maxh;
+	
+		srcx = srcrect->x;
+		w = srcrect->w;
+		if(srcx < 0) {
+		        w += srcx;
+			dstrect->x -= srcx;
+			srcx = 0;
+		}
+		maxw = src->w - srcx;
+		if(maxw < w)
+			w = maxw;
+
+		srcy = srcrect->y;
+		h = srcrect->h;
+		if(srcy < 0) {
+		        h += srcy;
+			dstrect->y -= srcy;
+			srcy = 0;
+		}
+		maxh = src->h - srcy;
+		if(maxh < h)
+			h = maxh;
+	    
+	} else {
+	        srcx = srcy = 0;
+		w = src->w;
+		h = src->h;
+	}
+
+	/* clip the destination rectangle against the clip rectangle */
+	SDL_GetLargeClip(dst, &clip);
+	{
+		int dx, dy;
+
+		dx = clip.x - dstrect->x;
+		if(dx > 0) {
+			w -= dx;
+			dstrect->x += dx;
+			srcx += dx;
+		}
+		dx = dstrect->x + w - clip.x - clip.w;
+		if(dx > 0)
+			w -= dx;
+
+		dy = clip.y - dstrect->y;
+		if(dy > 0) {
+			h -= dy;
+			dstrect->y += dy;
+			srcy += dy;
+		}
+		dy = dstrect->y + h - clip.y - clip.h;
+		if(dy > 0)
+			h -= dy;
+	}
+
+	if(w > 0 && h > 0) {
+	        SDL_LargeRect sr;
+	        sr.x = srcx;
+		sr.y = srcy;
+		sr.w = dstrect->w = w;
+		sr.h = dstrect->h = h;
+		return SDL_LowerBlitLarge(src, &sr, dst, dstrect);
+	}
+	dstrect->w = dstrect->h = 0;
+	return 0;
+}
+
 static int SDL_FillRect1(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 {
 	/* FIXME: We have to worry about packing order.. *sigh* */
@@ -548,61 +756,21 @@ static int SDL_FillRect4(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	return -1;
 }
 
-/* 
- * This function performs a fast fill of the given rectangle with 'color'
+/*
+ * The software fill of an already clipped rectangle
  */
-int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+static int SDL_FillRectSW(SDL_Surface *dst, const SDL_LargeRect *rect,
+			  Uint32 color)
 {
-	SDL_VideoDevice *video = current_video;
-	SDL_VideoDevice *this  = current_video;
+	Uint32 pitch = SURFACE_PITCH(dst);
 	int x, y;
 	Uint8 *row;
 
-	/* This function doesn't work on surfaces < 8 bpp */
-	if ( dst->format->BitsPerPixel < 8 ) {
-		switch(dst->format->BitsPerPixel) {
-		    case 1:
-			return SDL_FillRect1(dst, dstrect, color);
-			break;
-		    case 4:
-			return SDL_FillRect4(dst, dstrect, color);
-			break;
-		    default:
-			SDL_SetError("Fill rect on unsupported surface format");
-			return(-1);
-			break;
-		}
-	}
-
-	/* If 'dstrect' == NULL, then fill the whole surface */
-	if ( dstrect ) {
-		/* Perform clipping */
-		if ( !SDL_IntersectRect(dstrect, &dst->clip_rect, dstrect) ) {
-			return(0);
-		}
-	} else {
-		dstrect = &dst->clip_rect;
-	}
-
-	/* Check for hardware acceleration */
-	if ( ((dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE) &&
-					video->info.blit_fill ) {
-		SDL_Rect hw_rect;
-		if ( dst == SDL_VideoSurface ) {
-			hw_rect = *dstrect;
-			hw_rect.x += current_video->offset_x;
-			hw_rect.y += current_video->offset_y;
-			dstrect = &hw_rect;
-		}
-		return(video->FillHWRect(this, dst, dstrect, color));
-	}
-
-	/* Perform software fill */
 	if ( SDL_LockSurface(dst) != 0 ) {
 		return(-1);
 	}
-	row = (Uint8 *)dst->pixels+dstrect->y*dst->pitch+
-			dstrect->x*dst->format->BytesPerPixel;
+	row = (Uint8 *)dst->pixels+(size_t)rect->y*pitch+
+			(size_t)rect->x*dst->format->BytesPerPixel;
 #if SDL_ARM_NEON_BLITTERS
     if (SDL_HasNEON() && dst->format->BytesPerPixel != 3) {
         void FillRect8ARMNEONAsm(int32_t w, int32_t h, uint8_t *dst, int32_t dst_stride, uint8_t src);
@@ -610,13 +778,13 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
         void FillRect32ARMNEONAsm(int32_t w, int32_t h, uint32_t *dst, int32_t dst_stride, uint32_t src);
         switch (dst->format->BytesPerPixel) {
         case 1:
-            FillRect8ARMNEONAsm(dstrect->w, dstrect->h, (uint8_t *) row, dst->pitch >> 0, color);
+            FillRect8ARMNEONAsm(rect->w, rect->h, (uint8_t *) row, pitch >> 0, color);
             break;
         case 2:
-            FillRect16ARMNEONAsm(dstrect->w, dstrect->h, (uint16_t *) row, dst->pitch >> 1, color);
+            FillRect16ARMNEONAsm(rect->w, rect->h, (uint16_t *) row, pitch >> 1, color);
             break;
         case 4:
-            FillRect32ARMNEONAsm(dstrect->w, dstrect->h, (uint32_t *) row, dst->pitch >> 2, color);
+            FillRect32ARMNEONAsm(rect->w, rect->h, (uint32_t *) row, pitch >> 2, color);
             break;
         }
 
@@ -631,13 +799,13 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 		void FillRect32ARMSIMDAsm(int32_t w, int32_t h, uint32_t *dst, int32_t dst_stride, uint32_t src);
 		switch (dst->format->BytesPerPixel) {
 		case 1:
-			FillRect8ARMSIMDAsm(dstrect->w, dstrect->h, (uint8_t *) row, dst->pitch >> 0, color);
+			FillRect8ARMSIMDAsm(rect->w, rect->h, (uint8_t *) row, pitch >> 0, color);
 			break;
 		case 2:
-			FillRect16ARMSIMDAsm(dstrect->w, dstrect->h, (uint16_t *) row, dst->pitch >> 1, color);
+			FillRect16ARMSIMDAsm(rect->w, rect->h, (uint16_t *) row, pitch >> 1, color);
 			break;
 		case 4:
-			FillRect32ARMSIMDAsm(dstrect->w, dstrect->h, (uint32_t *) row, dst->pitch >> 2, color);
+			FillRect32ARMSIMDAsm(rect->w, rect->h, (uint32_t *) row, pitch >> 2, color);
 			break;
 		}
 
@@ -646,12 +814,12 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	}
 #endif
 	if ( dst->format->palette || (color == 0) ) {
-		x = dstrect->w*dst->format->BytesPerPixel;
-		if ( !color && !((uintptr_t)row&3) && !(x&3) && !(dst->pitch&3) ) {
+		x = rect->w*dst->format->BytesPerPixel;
+		if ( !color && !((uintptr_t)row&3) && !(x&3) && !(pitch&3) ) {
 			int n = x >> 2;
-			for ( y=dstrect->h; y; --y ) {
+			for ( y=rect->h; y; --y ) {
 				SDL_memset4(row, 0, n);
-				row += dst->pitch;
+				row += pitch;
 			}
 		} else {
 #ifdef __powerpc__
@@ -662,14 +830,14 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 			 * uncachable, so only use it on software surfaces
 			 */
 			if((dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE) {
-				if(dstrect->w >= 8) {
+				if(rect->w >= 8) {
 					/*
 					 * 64-bit stores are probably most
 					 * efficient to uncached video memory
 					 */
 					double fill;
 					SDL_memset(&fill, color, (sizeof fill));
-					for(y = dstrect->h; y; y--) {
+					for(y = rect->h; y; y--) {
 						Uint8 *d = row;
 						unsigned n = x;
 						unsigned nn;
@@ -701,11 +869,11 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 							*d++ = c;
 							n--;
 						}
-						row += dst->pitch;
+						row += pitch;
 					}
 				} else {
 					/* narrow boxes */
-					for(y = dstrect->h; y; y--) {
+					for(y = rect->h; y; y--) {
 						Uint8 *d = row;
 						Uint8 c = color;
 						int n = x;
@@ -713,26 +881,26 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 							*d++ = c;
 							n--;
 						}
-						row += dst->pitch;
+						row += pitch;
 					}
 				}
 			} else
 #endif /* __powerpc__ */
 			{
-				for(y = dstrect->h; y; y--) {
+				for(y = rect->h; y; y--) {
 					SDL_memset(row, color, x);
-					row += dst->pitch;
+					row += pitch;
 				}
 			}
 		}
 	} else {
 		switch (dst->format->BytesPerPixel) {
 		    case 2:
-			for ( y=dstrect->h; y; --y ) {
+			for ( y=rect->h; y; --y ) {
 				Uint16 *pixels = (Uint16 *)row;
 				Uint16 c = (Uint16)color;
 				Uint32 cc = (Uint32)c << 16 | c;
-				int n = dstrect->w;
+				int n = rect->w;
 				if((uintptr_t)pixels & 3) {
 					*pixels++ = c;
 					n--;
@@ -741,7 +909,7 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 					SDL_memset4(pixels, cc, n >> 1);
 				if(n & 1)
 					pixels[n - 1] = c;
-				row += dst->pitch;
+				row += pitch;
 			}
 			break;
 
@@ -749,20 +917,20 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 			#if SDL_BYTEORDER == SDL_BIG_ENDIAN
 				color <<= 8;
 			#endif
-			for ( y=dstrect->h; y; --y ) {
+			for ( y=rect->h; y; --y ) {
 				Uint8 *pixels = row;
-				for ( x=dstrect->w; x; --x ) {
+				for ( x=rect->w; x; --x ) {
 					SDL_memcpy(pixels, &color, 3);
 					pixels += 3;
 				}
-				row += dst->pitch;
+				row += pitch;
 			}
 			break;
 
 		    case 4:
-			for(y = dstrect->h; y; --y) {
-				SDL_memset4(row, color, dstrect->w);
-				row += dst->pitch;
+			for(y = rect->h; y; --y) {
+				SDL_memset4(row, color, rect->w);
+				row += pitch;
 			}
 			break;
 		}
@@ -773,6 +941,120 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	return(0);
 }
 
+/* 
+ * This function performs a fast fill of the given rectangle with 'color'
+ */
+int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_VideoDevice *this  = current_video;
+	SDL_LargeRect lrect;
+
+	/* This function doesn't work on surfaces < 8 bpp */
+	if ( dst->format->BitsPerPixel < 8 ) {
+		switch(dst->format->BitsPerPixel) {
+		    case 1:
+			return SDL_FillRect1(dst, dstrect, color);
+			break;
+		    case 4:
+			return SDL_FillRect4(dst, dstrect, color);
+			break;
+		    default:
+			SDL_SetError("Fill rect on unsupported surface format");
+			return(-1);
+			break;
+		}
+	}
+
+	/* If 'dstrect' == NULL, then fill the whole surface */
+	if ( dstrect ) {
+		/* Perform clipping */
+		if ( !SDL_IntersectRect(dstrect, &dst->clip_rect, dstrect) ) {
+			return(0);
+		}
+	} else {
+		dstrect = &dst->clip_rect;
+	}
+
+	/* Check for hardware acceleration */
+	if ( ((dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE) &&
+					video->info.blit_fill ) {
+		SDL_Rect hw_rect;
+		if ( dst == SDL_VideoSurface ) {
+			hw_rect = *dstrect;
+			hw_rect.x += current_video->offset_x;
+			hw_rect.y += current_video->offset_y;
+			dstrect = &hw_rect;
+		}
+		return(video->FillHWRect(this, dst, dstrect, color));
+	}
+
+	/* Perform software fill */
+	lrect.x = dstrect->x;
+	lrect.y = dstrect->y;
+	lrect.w = dstrect->w;
+	lrect.h = dstrect->h;
+	return(SDL_FillRectSW(dst, &lrect, color));
+}
+
+int SDL_FillRectLarge(SDL_Surface *dst, SDL_LargeRect *dstrect, Uint32 color)
+{
+	SDL_LargeRect clip;
+	int x1, y1, x2, y2;
+
+	/* Rectangles SDL_Rect can hold may be filled in hardware */
+	if ( !(dst->flags & SDL_LARGESURFACE) &&
+	     (! dstrect || RECT_FITS(dstrect)) ) {
+		SDL_Rect rect;
+		int retval;
+
+		if ( ! dstrect ) {
+			return(SDL_FillRect(dst, NULL, color));
+		}
+		rect.x = dstrect->x;
+		rect.y = dstrect->y;
+		rect.w = dstrect->w;
+		rect.h = dstrect->h;
+		retval = SDL_FillRect(dst, &rect, color);
+		dstrect->x = rect.x;
+		dstrect->y = rect.y;
+		dstrect->w = rect.w;
+		dstrect->h = rect.h;
+		return(retval);
+	}
+	if ( dst->format->BitsPerPixel < 8 ) {
+		SDL_SetError("Fill rect on unsupported surface format");
+		return(-1);
+	}
+
+	/* Perform clipping, no rectangle means the whole surface */
+	SDL_GetLargeClip(dst, &clip);
+	if ( ! dstrect ) {
+		if ( ! clip.w || ! clip.h ) {
+			return(0);
+		}
+		return(SDL_FillRectSW(dst, &clip, color));
+	}
+	x1 = (dstrect->x > clip.x) ? dstrect->x : clip.x;
+	y1 = (dstrect->y > clip.y) ? dstrect->y : clip.y;
+	x2 = dstrect->x + dstrect->w;
+	if ( x2 > clip.x + clip.w ) {
+		x2 = clip.x + clip.w;
+	}
+	y2 = dstrect->y + dstrect->h;
+	if ( y2 > clip.y + clip.h ) {
+		y2 = clip.y + clip.h;
+	}
+	dstrect->x = x1;
+	dstrect->y = y1;
+	dstrect->w = (x2 > x1) ? x2 - x1 : 0;
+	dstrect->h = (y2 > y1) ? y2 - y1 : 0;
+	if ( ! dstrect->w || ! dstrect->h ) {
+		return(0);
+	}
+	return(SDL_FillRectSW(dst, dstrect, color));
+}
+
 /*
  * Lock a surface to directly access the pixels
  */
@@ -838,7 +1120,8 @@ SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
 	Uint32 colorkey = 0;
 	Uint8 alpha = 0;
 	Uint32 surface_flags;
-	SDL_Rect bounds;
+	int blendmode;
+	SDL_LargeRect bounds;
 
 	/* Check for empty destination palette! (results in empty image) */
 	if ( format->palette != NULL ) {
@@ -863,6 +1146,9 @@ SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
 			flags &= ~SDL_HWSURFACE;
 	}
 
+	/* Large surfaces stay large */
+	flags |= (surface->flags & SDL_LARGESURFACE);
+
 	/* Create a new surface with the desired format */
 	convert = SDL_CreateRGBSurface(flags,
 				surface->w, surface->h, format->BitsPerPixel,
@@ -901,12 +1187,17 @@ SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
 		}
 	}
 
+	blendmode = surface->map->blendmode;
+	if ( blendmode != SDL_BLENDMODE_NONE ) {
+		SDL_SetBlendMode(surface, SDL_BLENDMODE_NONE);
+	}
+
 	/* Copy over the image data */
 	bounds.x = 0;
 	bounds.y = 0;
 	bounds.w = surface->w;
 	bounds.h = surface->h;
-	SDL_LowerBlit(surface, &bounds, convert, &bounds);
+	SDL_LowerBlitLarge(surface, &bounds, convert, &bounds);
 
 	/* Clean up the original surface, and update converted surface */
 	if ( convert != NULL ) {
@@ -935,11 +1226,224 @@ SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
 			SDL_SetAlpha(surface, aflags, alpha);
 		}
 	}
+	if ( blendmode != SDL_BLENDMODE_NONE ) {
+		SDL_SetBlendMode(convert, blendmode);
+		SDL_SetBlendMode(surface, blendmode);
+	}
 
 	/* We're ready to go! */
 	return(convert);
 }
 
+/*
+ * Convert many surfaces at once, spread over the worker threads
+ */
+typedef struct {
+	SDL_Surface **src;
+	SDL_Surface **dst;
+	SDL_PixelFormat *format;
+	Uint32 flags;
+} SDL_ConvertJob;
+
+static void SDLCALL SDL_ConvertOne(void *data, int index)
+{
+	SDL_ConvertJob *job = (SDL_ConvertJob *)data;
+
+	if ( job->src[index] ) {
+		job->dst[index] = SDL_ConvertSurface(job->src[index],
+		                                     job->format, job->flags);
+	} else {
+		job->dst[index] = NULL;
+	}
+}
+
+int SDL_ConvertSurfaces(SDL_Surface **src, SDL_Surface **dst, int count,
+				SDL_PixelFormat *format, Uint32 flags)
+{
+	SDL_ConvertJob job;
+	SDL_Surface *screen = current_video ? SDL_PublicSurface : NULL;
+	int threaded;
+	int converted;
+	int i;
+
+	/* Anything involving video memory has to stay on this thread,
+	   including surfaces SDL_CreateRGBSurface() might put there */
+	threaded = !(flags & SDL_HWSURFACE);
+	if ( screen && (screen->flags & SDL_HWSURFACE) &&
+	     (flags & (SDL_SRCCOLORKEY|SDL_SRCALPHA)) ) {
+		threaded = 0;
+	}
+	for ( i = 0; threaded && (i < count); ++i ) {
+		if ( src[i] && (src[i]->flags & SDL_HWSURFACE) ) {
+			threaded = 0;
+		}
+	}
+
+	job.src = src;
+	job.dst = dst;
+	job.format = format;
+	job.flags = flags;
+	if ( threaded ) {
+		/* Make sure the CPU features are known before the blitters
+		   are picked on several threads at once */
+		SDL_HasMMX();
+		SDL_RunWorkers(SDL_ConvertOne, &job, count);
+	} else {
+		for ( i = 0; i < count; ++i ) {
+			SDL_ConvertOne(&job, i);
+		}
+	}
+
+	converted = 0;
+	for ( i = 0; i < count; ++i ) {
+		if ( dst[i] ) {
+			++converted;
+		}
+	}
+	for ( i = 0; i < count; ++i ) {
+		if ( src[i] && !dst[i] ) {
+			/* The reason was set on whichever thread failed */
+			SDL_SetError("Couldn't convert %d of %d surfaces",
+			             count - converted, count);
+			break;
+		}
+	}
+	return(converted);
+}
+
+/*
+ * Rewrite the pixels of a surface in a format of the same size
+ */
+static void SDL_SwizzleSurface(SDL_Surface *surface, SDL_PixelFormat *dstfmt,
+					int keyed, Uint32 ckey)
+{
+	SDL_PixelFormat *srcfmt = surface->format;
+	int bpp = srcfmt->BytesPerPixel;
+	size_t pitch = SURFACE_PITCH(surface);
+	Uint8 *row = (Uint8 *)surface->pixels;
+	int x, y;
+
+	if ( bpp == 1 ) {
+		Uint8 map[256];
+		int ncolors = srcfmt->palette->ncolors;
+
+		for ( x = 0; x < 256; ++x ) {
+			SDL_Color *c = &srcfmt->palette->colors[x < ncolors ? x : 0];
+			map[x] = SDL_FindColor(dstfmt->palette, c->r, c->g, c->b);
+		}
+		for ( y = 0; y < surface->h; ++y, row += pitch ) {
+			for ( x = 0; x < surface->w; ++x ) {
+				row[x] = map[row[x]];
+			}
+		}
+		return;
+	}
+
+	ckey &= ~srcfmt->Amask;
+	for ( y = 0; y < surface->h; ++y, row += pitch ) {
+		Uint8 *pixel = row;
+
+		for ( x = 0; x < surface->w; ++x, pixel += bpp ) {
+			Uint32 Pixel;
+			unsigned r, g, b, a;
+
+			DISEMBLE_RGBA(pixel, bpp, srcfmt, Pixel, r, g, b, a);
+			if ( ! srcfmt->Amask ) {
+				/* As SDL_ConvertSurface(), which only turns the
+				   per-surface alpha off for formats without an
+				   alpha channel, and blits it into the rest */
+				a = dstfmt->Amask ? srcfmt->alpha :
+				                    SDL_ALPHA_OPAQUE;
+			}
+			if ( keyed && (Pixel == ckey) ) {
+				a = SDL_ALPHA_TRANSPARENT;
+			}
+			ASSEMBLE_RGBA(pixel, bpp, dstfmt, r, g, b, a);
+		}
+	}
+}
+
+/*
+ * Convert a surface to a format with the same pixel size, in place
+ */
+int SDL_ConvertSurfaceInPlace(SDL_Surface *surface, SDL_PixelFormat *format,
+							Uint32 flags)
+{
+	SDL_PixelFormat *srcfmt = surface->format;
+	SDL_PixelFormat *dstfmt;
+	int keyed = 0;
+
+	if ( (surface->flags & SDL_HWSURFACE) || surface->locked ||
+	     (current_video && ((surface == SDL_ShadowSurface) ||
+	                        (surface == SDL_VideoSurface))) ) {
+		SDL_SetError("Only unlocked software surfaces can be converted in place");
+		return(-1);
+	}
+	if ( (srcfmt->BitsPerPixel < 8) ||
+	     (format->BytesPerPixel != srcfmt->BytesPerPixel) ||
+	     (!format->palette != !srcfmt->palette) ) {
+		SDL_SetError("Pixel formats differ in size");
+		return(-1);
+	}
+	if ( format->palette != NULL ) {
+		int i;
+		for ( i=0; i<format->palette->ncolors; ++i ) {
+			if ( (format->palette->colors[i].r != 0) ||
+			     (format->palette->colors[i].g != 0) ||
+			     (format->palette->colors[i].b != 0) )
+				break;
+		}
+		if ( i == format->palette->ncolors ) {
+			SDL_SetError("Empty destination palette");
+			return(-1);
+		}
+	}
+
+	dstfmt = SDL_AllocFormat(format->BitsPerPixel, format->Rmask,
+	                         format->Gmask, format->Bmask, format->Amask);
+	if ( dstfmt == NULL ) {
+		return(-1);
+	}
+	if ( format->palette && dstfmt->palette ) {
+		SDL_memcpy(dstfmt->palette->colors, format->palette->colors,
+		           format->palette->ncolors*sizeof(SDL_Color));
+		dstfmt->palette->ncolors = format->palette->ncolors;
+	}
+
+	/* Get at the pixels again */
+	if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
+		SDL_UnRLESurface(surface, 1);
+	}
+
+	/* Colourkeyed surfaces turn into RGBA ones unless asked not to */
+	if ( (surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY ) {
+		if ( !(flags & SDL_SRCCOLORKEY) && dstfmt->Amask &&
+		     !srcfmt->palette ) {
+			keyed = 1;
+			surface->flags &= ~SDL_SRCCOLORKEY;
+		} else {
+			Uint8 keyR, keyG, keyB;
+
+			SDL_GetRGB(srcfmt->colorkey, srcfmt, &keyR, &keyG, &keyB);
+			dstfmt->colorkey = SDL_MapRGB(dstfmt, keyR, keyG, keyB);
+		}
+	}
+	dstfmt->alpha = srcfmt->alpha;
+	SDL_SwizzleSurface(surface, dstfmt, keyed, srcfmt->colorkey);
+	if ( dstfmt->Amask ) {
+		surface->flags |= SDL_SRCALPHA;
+	}
+
+	if ( (flags & SDL_RLEACCELOK) &&
+	     (surface->flags & (SDL_SRCCOLORKEY|SDL_SRCALPHA)) ) {
+		surface->flags |= SDL_RLEACCELOK;
+	}
+	surface->format = dstfmt;
+	SDL_FreeFormat(srcfmt);
+	SDL_FormatChanged(surface);
+	return(0);
+}
+
 /*
  * Free a surface created by the above function.
  */
@@ -265,6 +265,7 @@ struct SDL_VideoDevice {
 	SDL_Surface *visible;
         SDL_Palette *physpal;	/* physical palette, if != logical palette */
         SDL_Color *gammacols;	/* gamma-corrected colours, or NULL */
+	Uint32 *gamma_tables;	/* software gamma for the shadow, or NULL */
 	char *wm_title;
 	char *wm_icon;
 	int offset_x;
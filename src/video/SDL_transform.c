@@ -0,0 +1,632 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Rotating and scaling blits.
+
+   The blit walks the destination: for every row of the clipped bounding
+   box the span of pixels that maps inside the source rectangle is solved
+   for, and the source is stepped across it in 16.16 fixed point.  The
+   fetched pixels are in the source format and go through the normal blit
+   mapping, so colorkey, alpha, blend modes and format conversion behave
+   exactly like SDL_BlitSurface().  When that mapping is a plain copy the
+   pixels are fetched straight into the destination.
+*/
+
+#ifdef HAVE_MATH_H
+#include <math.h>
+#endif
+
+#include "SDL_video.h"
+#include "SDL_blit.h"
+#include "SDL_pixels_c.h"
+
+#if SDL_ASSEMBLY_ROUTINES
+#  if (defined(__GNUC__) && defined(__SSE2__)) || \
+      (defined(_MSC_VER) && (defined(_M_X64) || (_M_IX86_FP >= 2)))
+#    define SSE2_TRANSFORM 1
+#  endif
+#  if defined(__GNUC__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#    define NEON_TRANSFORM 1
+#  endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
+
+/* Function to check the CPU flags */
+#include "SDL_cpuinfo.h"
+#if SSE2_TRANSFORM
+#include <emmintrin.h>
+#endif
+#if NEON_TRANSFORM
+#include <arm_neon.h>
+#endif
+
+/* Pixels fetched per call of the low level blitter (on the stack) */
+#define TRANSFORM_CHUNK	256
+
+typedef struct {
+	const Uint8 *pixels;	/* top left pixel of the source rectangle */
+	size_t pitch;
+	Sint32 umax;		/* (w-1)<<16, clamp for bilinear sampling */
+	Sint32 vmax;		/* (h-1)<<16 */
+} TransformSource;
+
+/* Fetch 'n' source pixels starting at (u,v), stepping by (du,dv) */
+typedef void (*TransformFetch)(const TransformSource *src, Uint8 *dst, int n,
+                               Sint32 u, Sint32 v, Sint32 du, Sint32 dv);
+
+#ifndef HAVE_MATH_H
+/* Good to about 1e-9 after reduction to [-pi/2,pi/2] */
+static double TransformSin(double x)
+{
+	const double pi = 3.14159265358979323846;
+	double x2, r;
+	int n;
+
+	n = (int)(x / pi + (x < 0.0 ? -0.5 : 0.5));
+	x -= n * pi;
+	x2 = x * x;
+	r = x * (1.0 - x2/6.0 * (1.0 - x2/20.0 * (1.0 - x2/42.0 *
+	        (1.0 - x2/72.0 * (1.0 - x2/110.0 * (1.0 - x2/156.0))))));
+	return (n & 1) ? -r : r;
+}
+#define sin(x)	TransformSin(x)
+#define cos(x)	TransformSin((x) + 1.57079632679489661923)
+#endif
+
+static double TransformFloor(double x)
+{
+	double i = (double)(Sint32)x;
+	return (i > x) ? i - 1.0 : i;
+}
+
+static double TransformCeil(double x)
+{
+	double i = (double)(Sint32)x;
+	return (i < x) ? i + 1.0 : i;
+}
+
+/* Nearest neighbour fetches, one per pixel size */
+static void FetchNearest1(const TransformSource *src, Uint8 *dst, int n,
+                          Sint32 u, Sint32 v, Sint32 du, Sint32 dv)
+{
+	while ( n-- ) {
+		*dst++ = src->pixels[(v >> 16) * src->pitch + (u >> 16)];
+		u += du;
+		v += dv;
+	}
+}
+
+static void FetchNearest2(const TransformSource *src, Uint8 *dst, int n,
+                          Sint32 u, Sint32 v, Sint32 du, Sint32 dv)
+{
+	Uint16 *d = (Uint16 *)dst;
+
+	while ( n-- ) {
+		*d++ = *(const Uint16 *)(src->pixels +
+		                         (v >> 16) * src->pitch + (u >> 16) * 2);
+		u += du;
+		v += dv;
+	}
+}
+
+static void FetchNearest3(const TransformSource *src, Uint8 *dst, int n,
+                          Sint32 u, Sint32 v, Sint32 du, Sint32 dv)
+{
+	const Uint8 *s;
+
+	while ( n-- ) {
+		s = src->pixels + (v >> 16) * src->pitch + (u >> 16) * 3;
+		dst[0] = s[0];
+		dst[1] = s[1];
+		dst[2] = s[2];
+		dst += 3;
+		u += du;
+		v += dv;
+	}
+}
+
+static void FetchNearest4(const TransformSource *src, Uint8 *dst, int n,
+                          Sint32 u, Sint32 v, Sint32 du, Sint32 dv)
+{
+	Uint32 *d = (Uint32 *)dst;
+
+	while ( n-- ) {
+		*d++ = *(const Uint32 *)(src->pixels +
+		                         (v >> 16) * src->pitch + (u >> 16) * 4);
+		u += du;
+		v += dv;
+	}
+}
+
+/* Bilinear sampling of 32-bit pixels with 8-bit channels.  The sample
+   point is clamped to the centres of the edge pixels, and each channel is
+   interpolated as  t = (c00*(256-fx) + c01*fx) >> 8,
+                    b = (c10*(256-fx) + c11*fx) >> 8,
+                    c = (t*(256-fy) + b*fy) >> 8
+   which the SIMD versions reproduce exactly.
+*/
+#define BILINEAR_SETUP(src, u, v, row0, row1, x0, x1, fx, fy)		\
+do {									\
+	Sint32 su = (u) - 0x8000;					\
+	Sint32 sv = (v) - 0x8000;					\
+	if ( su < 0 ) su = 0; else if ( su > (src)->umax ) su = (src)->umax;\
+	if ( sv < 0 ) sv = 0; else if ( sv > (src)->vmax ) sv = (src)->vmax;\
+	row0 = (const Uint32 *)((src)->pixels + (sv >> 16) * (src)->pitch);\
+	row1 = (const Uint32 *)((const Uint8 *)row0 +			\
+	                        (sv < (src)->vmax ? (src)->pitch : 0));	\
+	x0 = su >> 16;							\
+	x1 = x0 + (su < (src)->umax);					\
+	fx = (su >> 8) & 0xff;						\
+	fy = (sv >> 8) & 0xff;						\
+} while(0)
+
+static __inline__ Uint32 Bilinear(Uint32 p00, Uint32 p01,
+                                  Uint32 p10, Uint32 p11,
+                                  unsigned fx, unsigned fy)
+{
+	unsigned ix = 256 - fx;
+	unsigned iy = 256 - fy;
+	Uint32 rb0, rb1, ag0, ag1;
+
+	rb0 = (((p00 & 0xff00ff) * ix + (p01 & 0xff00ff) * fx) >> 8) & 0xff00ff;
+	rb1 = (((p10 & 0xff00ff) * ix + (p11 & 0xff00ff) * fx) >> 8) & 0xff00ff;
+	ag0 = ((((p00 >> 8) & 0xff00ff) * ix +
+	        ((p01 >> 8) & 0xff00ff) * fx) >> 8) & 0xff00ff;
+	ag1 = ((((p10 >> 8) & 0xff00ff) * ix +
+	        ((p11 >> 8) & 0xff00ff) * fx) >> 8) & 0xff00ff;
+	return (((rb0 * iy + rb1 * fy) >> 8) & 0xff00ff) |
+	       ((ag0 * iy + ag1 * fy) & 0xff00ff00);
+}
+
+static void FetchBilinear4(const TransformSource *src, Uint8 *dst, int n,
+                           Sint32 u, Sint32 v, Sint32 du, Sint32 dv)
+{
+	Uint32 *d = (Uint32 *)dst;
+	const Uint32 *row0, *row1;
+	int x0, x1;
+	unsigned fx, fy;
+
+	while ( n-- ) {
+		BILINEAR_SETUP(src, u, v, row0, row1, x0, x1, fx, fy);
+		*d++ = Bilinear(row0[x0], row0[x1], row1[x0], row1[x1], fx, fy);
+		u += du;
+		v += dv;
+	}
+}
+
+#if SSE2_TRANSFORM
+/* Two pixels per iteration, one per 64-bit half of the registers */
+static void FetchBilinear4SSE2(const TransformSource *src, Uint8 *dst, int n,
+                               Sint32 u, Sint32 v, Sint32 du, Sint32 dv)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i w256 = _mm_set1_epi16(256);
+	const Uint32 *a0, *a1, *b0, *b1;
+	int ax0, ax1, bx0, bx1;
+	unsigned afx, afy, bfx, bfy;
+	__m128i p00, p01, p10, p11, wx, wy, t, b;
+
+	while ( n >= 2 ) {
+		BILINEAR_SETUP(src, u, v, a0, a1, ax0, ax1, afx, afy);
+		u += du;
+		v += dv;
+		BILINEAR_SETUP(src, u, v, b0, b1, bx0, bx1, bfx, bfy);
+		u += du;
+		v += dv;
+
+		p00 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(a0[ax0]),
+		                         _mm_cvtsi32_si128(b0[bx0]));
+		p01 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(a0[ax1]),
+		                         _mm_cvtsi32_si128(b0[bx1]));
+		p10 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(a1[ax0]),
+		                         _mm_cvtsi32_si128(b1[bx0]));
+		p11 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(a1[ax1]),
+		                         _mm_cvtsi32_si128(b1[bx1]));
+		p00 = _mm_unpacklo_epi8(p00, zero);
+		p01 = _mm_unpacklo_epi8(p01, zero);
+		p10 = _mm_unpacklo_epi8(p10, zero);
+		p11 = _mm_unpacklo_epi8(p11, zero);
+
+		wx = _mm_set_epi16(bfx, bfx, bfx, bfx, afx, afx, afx, afx);
+		wy = _mm_set_epi16(bfy, bfy, bfy, bfy, afy, afy, afy, afy);
+
+		/* All intermediate sums are at most 255*256 */
+		t = _mm_add_epi16(_mm_mullo_epi16(p00, _mm_sub_epi16(w256, wx)),
+		                  _mm_mullo_epi16(p01, wx));
+		b = _mm_add_epi16(_mm_mullo_epi16(p10, _mm_sub_epi16(w256, wx)),
+		                  _mm_mullo_epi16(p11, wx));
+		t = _mm_srli_epi16(t, 8);
+		b = _mm_srli_epi16(b, 8);
+		t = _mm_add_epi16(_mm_mullo_epi16(t, _mm_sub_epi16(w256, wy)),
+		                  _mm_mullo_epi16(b, wy));
+		t = _mm_srli_epi16(t, 8);
+		_mm_storel_epi64((__m128i *)dst, _mm_packus_epi16(t, zero));
+		dst += 8;
+		n -= 2;
+	}
+	if ( n ) {
+		FetchBilinear4(src, dst, n, u, v, du, dv);
+	}
+}
+#endif /* SSE2_TRANSFORM */
+
+#if NEON_TRANSFORM
+static void FetchBilinear4NEON(const TransformSource *src, Uint8 *dst, int n,
+                               Sint32 u, Sint32 v, Sint32 du, Sint32 dv)
+{
+	const uint16x8_t w256 = vdupq_n_u16(256);
+	const Uint32 *a0, *a1, *b0, *b1;
+	int ax0, ax1, bx0, bx1;
+	unsigned afx, afy, bfx, bfy;
+	uint16x8_t p00, p01, p10, p11, wx, wy, t, b;
+
+	while ( n >= 2 ) {
+		BILINEAR_SETUP(src, u, v, a0, a1, ax0, ax1, afx, afy);
+		u += du;
+		v += dv;
+		BILINEAR_SETUP(src, u, v, b0, b1, bx0, bx1, bfx, bfy);
+		u += du;
+		v += dv;
+
+		p00 = vmovl_u8(vcreate_u8(a0[ax0] | ((uint64_t)b0[bx0] << 32)));
+		p01 = vmovl_u8(vcreate_u8(a0[ax1] | ((uint64_t)b0[bx1] << 32)));
+		p10 = vmovl_u8(vcreate_u8(a1[ax0] | ((uint64_t)b1[bx0] << 32)));
+		p11 = vmovl_u8(vcreate_u8(a1[ax1] | ((uint64_t)b1[bx1] << 32)));
+
+		wx = vcombine_u16(vdup_n_u16(afx), vdup_n_u16(bfx));
+		wy = vcombine_u16(vdup_n_u16(afy), vdup_n_u16(bfy));
+
+		t = vmlaq_u16(vmulq_u16(p00, vsubq_u16(w256, wx)), p01, wx);
+		b = vmlaq_u16(vmulq_u16(p10, vsubq_u16(w256, wx)), p11, wx);
+		t = vshrq_n_u16(t, 8);
+		b = vshrq_n_u16(b, 8);
+		t = vmlaq_u16(vmulq_u16(t, vsubq_u16(w256, wy)), b, wy);
+		vst1_u8(dst, vshrn_n_u16(t, 8));
+		dst += 8;
+		n -= 2;
+	}
+	if ( n ) {
+		FetchBilinear4(src, dst, n, u, v, du, dv);
+	}
+}
+#endif /* NEON_TRANSFORM */
+
+static TransformFetch TransformGetFetch(SDL_Surface *surface, Uint32 flags)
+{
+	SDL_PixelFormat *fmt = surface->format;
+
+	/* Smooth sampling needs 8-bit channels and no colorkey */
+	if ( (flags & SDL_TRANSFORM_SMOOTH) &&
+	     !(surface->flags & SDL_SRCCOLORKEY) &&
+	     fmt->BytesPerPixel == 4 &&
+	     !fmt->Rloss && !fmt->Gloss && !fmt->Bloss &&
+	     !(fmt->Rshift & 7) && !(fmt->Gshift & 7) && !(fmt->Bshift & 7) &&
+	     (!fmt->Amask || (!fmt->Aloss && !(fmt->Ashift & 7))) ) {
+#if SSE2_TRANSFORM
+		if ( SDL_HasSSE2() ) {
+			return FetchBilinear4SSE2;
+		}
+#endif
+#if NEON_TRANSFORM
+		if ( SDL_HasNEON() ) {
+			return FetchBilinear4NEON;
+		}
+#endif
+		return FetchBilinear4;
+	}
+	switch (fmt->BytesPerPixel) {
+	    case 1:
+		return FetchNearest1;
+	    case 2:
+		return FetchNearest2;
+	    case 3:
+		return FetchNearest3;
+	    default:
+		return FetchNearest4;
+	}
+}
+
+/* Restrict [*lo,*hi] to the i with 0 <= start + i*step < limit */
+static void TransformClipSpan(double start, double step, double limit,
+                              int *lo, int *hi)
+{
+	double first, last;
+
+	if ( step == 0.0 ) {
+		if ( start < 0.0 || start >= limit ) {
+			*hi = *lo - 1;
+		}
+		return;
+	}
+	if ( step > 0.0 ) {
+		first = TransformCeil(-start / step);
+		last = TransformCeil((limit - start) / step) - 1.0;
+	} else {
+		first = TransformFloor((limit - start) / step) + 1.0;
+		last = TransformFloor(-start / step);
+	}
+	if ( first > *lo ) {
+		*lo = (first > *hi) ? *hi + 1 : (int)first;
+	}
+	if ( last < *hi ) {
+		*hi = (last < *lo) ? *lo - 1 : (int)last;
+	}
+}
+
+int SDL_TransformBlit(SDL_Surface *src, SDL_Rect *srcrect,
+                      SDL_Surface *dst, SDL_Rect *dstrect,
+                      double angle, double zoomx, double zoomy, Uint32 flags)
+{
+	SDL_Rect full_src;
+	SDL_Rect *clip;
+	TransformSource source;
+	TransformFetch fetch;
+	SDL_loblit blit;
+	SDL_BlitInfo info;
+	Uint32 buffer[TRANSFORM_CHUNK];
+	double c, s, dudx, dudy, dvdx, dvdy, cx, cy, ex, ey;
+	double su, sv, uy, vy, umax, vmax;
+	int minx, miny, maxx, maxy;
+	int x, y, lo, hi, n, direct;
+	int left, top, right, bottom;
+	int bpp;
+	Sint32 u, v, du, dv;
+	Uint8 *dstrow;
+
+	if ( ! src || ! dst ) {
+		SDL_SetError("SDL_TransformBlit: passed a NULL surface");
+		return(-1);
+	}
+	if ( src->locked || dst->locked ) {
+		SDL_SetError("Surfaces must not be locked during blit");
+		return(-1);
+	}
+	if ( src == dst ) {
+		SDL_SetError("Can't transform a surface onto itself");
+		return(-1);
+	}
+	if ( src->format->BitsPerPixel < 8 || dst->format->BitsPerPixel < 8 ) {
+		SDL_SetError("Transform blits need 8 bits per pixel or more");
+		return(-1);
+	}
+	if ( zoomx == 0.0 || zoomy == 0.0 ) {
+		SDL_SetError("Invalid zoom factor");
+		return(-1);
+	}
+
+	/* Verify the source rectangle */
+	if ( srcrect ) {
+		if ( (srcrect->x < 0) || (srcrect->y < 0) ||
+		     ((srcrect->x+srcrect->w) > src->w) ||
+		     ((srcrect->y+srcrect->h) > src->h) ) {
+			SDL_SetError("Invalid source blit rectangle");
+			return(-1);
+		}
+	} else {
+		full_src.x = 0;
+		full_src.y = 0;
+		full_src.w = src->w;
+		full_src.h = src->h;
+		srcrect = &full_src;
+	}
+
+	/* The destination point the source centre is mapped to */
+	if ( dstrect ) {
+		cx = dstrect->x;
+		cy = dstrect->y;
+	} else {
+		cx = dst->w / 2;
+		cy = dst->h / 2;
+	}
+
+	/* Inverse mapping, from the destination back into the source.
+	   Positive angles rotate counter-clockwise on the screen. */
+	angle *= 3.14159265358979323846 / 180.0;
+	c = cos(angle);
+	s = sin(angle);
+	dudx = c / zoomx;
+	dudy = -s / zoomx;
+	dvdx = s / zoomy;
+	dvdy = c / zoomy;
+
+	/* Bounding box of the transformed source, clipped.  The source
+	   centre is rounded down to a pixel corner so that unrotated,
+	   unscaled blits sample pixel centres; one pixel of slack covers
+	   that offset. */
+	ex = (srcrect->w * (zoomx < 0.0 ? -zoomx : zoomx) * (c < 0.0 ? -c : c) +
+	      srcrect->h * (zoomy < 0.0 ? -zoomy : zoomy) * (s < 0.0 ? -s : s)) / 2 + 1.0;
+	ey = (srcrect->w * (zoomx < 0.0 ? -zoomx : zoomx) * (s < 0.0 ? -s : s) +
+	      srcrect->h * (zoomy < 0.0 ? -zoomy : zoomy) * (c < 0.0 ? -c : c)) / 2 + 1.0;
+	clip = &dst->clip_rect;
+	minx = clip->x;
+	miny = clip->y;
+	maxx = clip->x + clip->w;
+	maxy = clip->y + clip->h;
+	if ( cx - ex > minx ) {
+		minx = (int)TransformFloor(cx - ex);
+	}
+	if ( cy - ey > miny ) {
+		miny = (int)TransformFloor(cy - ey);
+	}
+	if ( cx + ex < maxx ) {
+		maxx = (int)TransformCeil(cx + ex);
+	}
+	if ( cy + ey < maxy ) {
+		maxy = (int)TransformCeil(cy + ey);
+	}
+	if ( minx >= maxx || miny >= maxy || !srcrect->w || !srcrect->h ) {
+		if ( dstrect ) {
+			dstrect->w = dstrect->h = 0;
+		}
+		return(0);
+	}
+
+	/* Check to make sure the blit mapping is valid */
+	if ( (src->map->dst != dst) ||
+             (src->map->dst->format_version != src->map->format_version) ||
+	     src->map->remap_pending ) {
+		if ( SDL_RefreshMap(src, dst) < 0 ) {
+			return(-1);
+		}
+	}
+
+	/* Lock the surfaces, this also decodes RLE sources */
+	if ( SDL_MUSTLOCK(dst) ) {
+		if ( SDL_LockSurface(dst) < 0 ) {
+			SDL_SetError("Unable to lock destination surface");
+			return(-1);
+		}
+	}
+	if ( SDL_MUSTLOCK(src) ) {
+		if ( SDL_LockSurface(src) < 0 ) {
+			if ( SDL_MUSTLOCK(dst) ) {
+				SDL_UnlockSurface(dst);
+			}
+			SDL_SetError("Unable to lock source surface");
+			return(-1);
+		}
+	}
+
+	bpp = src->format->BytesPerPixel;
+	source.pixels = (Uint8 *)src->pixels +
+	                (size_t)srcrect->y * SURFACE_PITCH(src) + srcrect->x * bpp;
+	source.pitch = SURFACE_PITCH(src);
+	source.umax = (srcrect->w - 1) << 16;
+	source.vmax = (srcrect->h - 1) << 16;
+	fetch = TransformGetFetch(src, flags);
+
+	/* Fetch straight into the destination if the blit is a plain copy */
+	direct = src->map->identity &&
+	         src->map->blendmode == SDL_BLENDMODE_NONE &&
+	         !(src->flags & SDL_SRCCOLORKEY) &&
+	         !((src->flags & SDL_SRCALPHA) &&
+	           (src->format->alpha != SDL_ALPHA_OPAQUE || src->format->Amask));
+	blit = src->map->sw_data->blit;
+	info.s_height = 1;
+	info.s_skip = 0;
+	info.d_height = 1;
+	info.d_skip = 0;
+	info.aux_data = src->map->sw_data->aux_data;
+	info.src = src->format;
+	info.table = src->map->table;
+	info.dst = dst->format;
+	info.flags = src->flags;
+
+	umax = srcrect->w * 65536.0;
+	vmax = srcrect->h * 65536.0;
+	du = (Sint32)(dudx * 65536.0 + (dudx < 0.0 ? -0.5 : 0.5));
+	dv = (Sint32)(dvdx * 65536.0 + (dvdx < 0.0 ? -0.5 : 0.5));
+	left = maxx;
+	top = maxy;
+	right = bottom = 0;
+	for ( y = miny; y < maxy; ++y ) {
+		/* Source position of the first pixel centre in the row */
+		uy = ((srcrect->w / 2) + (minx + 0.5 - cx) * dudx +
+		      (y + 0.5 - cy) * dudy) * 65536.0;
+		vy = ((srcrect->h / 2) + (minx + 0.5 - cx) * dvdx +
+		      (y + 0.5 - cy) * dvdy) * 65536.0;
+
+		lo = 0;
+		hi = maxx - minx - 1;
+		TransformClipSpan(uy, du, umax, &lo, &hi);
+		TransformClipSpan(vy, dv, vmax, &lo, &hi);
+		if ( lo > hi ) {
+			continue;
+		}
+		su = TransformFloor(uy + lo * (double)du);
+		sv = TransformFloor(vy + lo * (double)dv);
+		u = (Sint32)su;
+		v = (Sint32)sv;
+
+		/* Trim rounding errors so no fetch leaves the source */
+		while ( lo <= hi && (u < 0 || u > source.umax + 0xffff ||
+		                     v < 0 || v > source.vmax + 0xffff) ) {
+			++lo;
+			u += du;
+			v += dv;
+		}
+		while ( lo <= hi ) {
+			Sint32 eu = u + (hi - lo) * du;
+			Sint32 ev = v + (hi - lo) * dv;
+			if ( eu >= 0 && eu <= source.umax + 0xffff &&
+			     ev >= 0 && ev <= source.vmax + 0xffff ) {
+				break;
+			}
+			--hi;
+		}
+
+		x = minx + lo;
+		if ( x < left ) {
+			left = x;
+		}
+		if ( minx + hi + 1 > right ) {
+			right = minx + hi + 1;
+		}
+		if ( y < top ) {
+			top = y;
+		}
+		bottom = y + 1;
+		dstrow = (Uint8 *)dst->pixels + (size_t)y * SURFACE_PITCH(dst) +
+		         x * dst->format->BytesPerPixel;
+		if ( direct ) {
+			fetch(&source, dstrow, hi - lo + 1, u, v, du, dv);
+			continue;
+		}
+		while ( lo <= hi ) {
+			n = hi - lo + 1;
+			if ( n > TRANSFORM_CHUNK ) {
+				n = TRANSFORM_CHUNK;
+			}
+			fetch(&source, (Uint8 *)buffer, n, u, v, du, dv);
+			info.s_pixels = (Uint8 *)buffer;
+			info.s_width = n;
+			info.d_pixels = dstrow;
+			info.d_width = n;
+			blit(&info);
+			dstrow += n * dst->format->BytesPerPixel;
+			u += n * du;
+			v += n * dv;
+			lo += n;
+		}
+	}
+
+	/* We need to unlock the surfaces if they're locked */
+	if ( SDL_MUSTLOCK(src) ) {
+		SDL_UnlockSurface(src);
+	}
+	if ( SDL_MUSTLOCK(dst) ) {
+		SDL_UnlockSurface(dst);
+	}
+
+	/* Pass back the area that was drawn to */
+	if ( dstrect ) {
+		if ( left < right ) {
+			dstrect->x = left;
+			dstrect->y = top;
+			dstrect->w = right - left;
+			dstrect->h = bottom - top;
+		} else {
+			dstrect->w = dstrect->h = 0;
+		}
+	}
+	return(0);
+}
@@ -28,6 +28,8 @@
 #include "SDL_blit.h"
 #include "SDL_pixels_c.h"
 #include "SDL_cursor_c.h"
+#include "SDL_workers_c.h"
+#include "SDL_commands_c.h"
 #include "../events/SDL_sysevents.h"
 #include "../events/SDL_events_c.h"
 
@@ -220,6 +222,7 @@ int SDL_VideoInit (const char *driver_name, Uint32 flags)
 	video->visible = NULL;
 	video->physpal = NULL;
 	video->gammacols = NULL;
+	video->gamma_tables = NULL;
 	video->gamma = NULL;
 	video->wm_title = NULL;
 	video->wm_icon  = NULL;
@@ -288,6 +291,8 @@ int SDL_VideoInit (const char *driver_name, Uint32 flags)
 		return(-1);
 	}
 	SDL_CursorInit(flags & SDL_INIT_EVENTTHREAD);
+	SDL_WorkersInit();
+	SDL_CommandsInit();
 
 	/* We're ready to go! */
 	return(0);
@@ -681,6 +686,10 @@ SDL_Surface * SDL_SetVideoMode (int width, int height, int bpp, Uint32 flags)
 		SDL_free(video->gammacols);
 		video->gammacols = NULL;
 	}
+	if ( video->gamma_tables ) {
+		SDL_free(video->gamma_tables);
+		video->gamma_tables = NULL;
+	}
 
 	/* Save the previous grab state and turn off grab for mode switch */
 	saved_grab = SDL_WM_GrabInputOff();
@@ -893,10 +902,11 @@ SDL_Surface * SDL_SetVideoMode (int width, int height, int bpp, Uint32 flags)
 	}
 
 	/* Create a shadow surface if necessary */
-	/* There are three conditions under which we create a shadow surface:
+	/* There are four conditions under which we create a shadow surface:
 		1.  We need a particular bits-per-pixel that we didn't get.
 		2.  We need a hardware palette and didn't get one.
 		3.  We need a software surface and got a hardware surface.
+		4.  Software gamma was requested, it's applied when copying.
 	*/
 	if ( !(SDL_VideoSurface->flags & SDL_OPENGL) &&
 	     (
@@ -911,7 +921,9 @@ SDL_Surface * SDL_SetVideoMode (int width, int height, int bpp, Uint32 flags)
 				(SDL_VideoSurface->flags&SDL_HWSURFACE)) ||
 	     (   (flags&SDL_DOUBLEBUF) &&
 				(SDL_VideoSurface->flags&SDL_HWSURFACE) &&
-				!(SDL_VideoSurface->flags&SDL_DOUBLEBUF))
+				!(SDL_VideoSurface->flags&SDL_DOUBLEBUF)) ||
+	     (   SDL_getenv("SDL_VIDEO_SOFTWARE_GAMMA") &&
+				!SDL_VideoSurface->format->palette)
 	     ) ) {
 		SDL_CreateShadowSurface(bpp);
 		if ( SDL_ShadowSurface == NULL ) {
@@ -1043,6 +1055,20 @@ void SDL_UpdateRect(SDL_Surface *screen, Sint32 x, Sint32 y, Uint32 w, Uint32 h)
 		SDL_UpdateRects(screen, 1, &rect);
 	}
 }
+/*
+ * Copy an area of the shadow surface to the video surface
+ */
+static void SDL_BlitShadow(SDL_Rect *rect)
+{
+	SDL_VideoDevice *video = current_video;
+
+	if ( video->gamma_tables ) {
+		SDL_GammaBlit(SDL_ShadowSurface, rect,
+		              SDL_VideoSurface, video->gamma_tables);
+	} else {
+		SDL_LowerBlit(SDL_ShadowSurface, rect, SDL_VideoSurface, rect);
+	}
+}
 void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 {
 	int i;
@@ -1069,18 +1095,21 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 			}
 		}
 		if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
+			int drawn;
+
 			SDL_LockCursor();
-			SDL_DrawCursor(SDL_ShadowSurface);
+			drawn = SDL_DrawCursorRects(SDL_ShadowSurface,
+			                            numrects, rects);
 			for ( i=0; i<numrects; ++i ) {
-				SDL_LowerBlit(SDL_ShadowSurface, &rects[i], 
-						SDL_VideoSurface, &rects[i]);
+				SDL_BlitShadow(&rects[i]);
+			}
+			if ( drawn ) {
+				SDL_EraseCursor(SDL_ShadowSurface);
 			}
-			SDL_EraseCursor(SDL_ShadowSurface);
 			SDL_UnlockCursor();
 		} else {
 			for ( i=0; i<numrects; ++i ) {
-				SDL_LowerBlit(SDL_ShadowSurface, &rects[i], 
-						SDL_VideoSurface, &rects[i]);
+				SDL_BlitShadow(&rects[i]);
 			}
 		}
 		if ( saved_colors ) {
@@ -1138,13 +1167,11 @@ int SDL_Flip(SDL_Surface *screen)
 		if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
 			SDL_LockCursor();
 			SDL_DrawCursor(SDL_ShadowSurface);
-			SDL_LowerBlit(SDL_ShadowSurface, &rect,
-					SDL_VideoSurface, &rect);
+			SDL_BlitShadow(&rect);
 			SDL_EraseCursor(SDL_ShadowSurface);
 			SDL_UnlockCursor();
 		} else {
-			SDL_LowerBlit(SDL_ShadowSurface, &rect,
-					SDL_VideoSurface, &rect);
+			SDL_BlitShadow(&rect);
 		}
 		if ( saved_colors ) {
 			pal->colors = saved_colors;
@@ -1186,7 +1213,17 @@ static void SetPalette_logical(SDL_Surface *screen, SDL_Color *colors,
 			       ncolors * sizeof(*colors));
 		}
 	}
-	SDL_FormatChanged(screen);
+	if ( (screen == SDL_ShadowSurface) && current_video &&
+	     (current_video->physpal || current_video->gamma) ) {
+		/*
+		 * The shadow-to-video mapping is made from the physical
+		 * or gamma corrected colors that SDL_UpdateRects() swaps
+		 * in, not these, so it has to be rebuilt.
+		 */
+		SDL_FormatChanged(screen);
+	} else {
+		SDL_PaletteChanged(screen, firstcolor, ncolors);
+	}
 }
 
 static int SetPalette_physical(SDL_Surface *screen,
@@ -1213,12 +1250,11 @@ static int SetPalette_physical(SDL_Surface *screen,
 			screen = SDL_VideoSurface;
 		} else {
 			/*
-			 * The video surface is not indexed - invalidate any
-			 * active shadow-to-video blit mappings.
+			 * The video surface is not indexed - patch the changed
+			 * entries of the shadow-to-video blit mapping with the
+			 * colors that are really displayed.
 			 */
-			if ( screen->map->dst == SDL_VideoSurface ) {
-				SDL_InvalidateMap(screen->map);
-			}
+			SDL_Color *physcolors = colors;
 			if ( video->gamma ) {
 				if( ! video->gammacols ) {
 					SDL_Palette *pp = video->physpal;
@@ -1230,11 +1266,24 @@ static int SetPalette_physical(SDL_Surface *screen,
 						       pp->colors,
 						       video->gammacols,
 						       pp->ncolors);
+					physcolors = NULL;
 				} else {
 					SDL_ApplyGamma(video->gamma, colors,
 						       video->gammacols
 						       + firstcolor,
 						       ncolors);
+					physcolors = video->gammacols
+						     + firstcolor;
+				}
+			} else if ( video->physpal ) {
+				physcolors = video->physpal->colors + firstcolor;
+			}
+			if ( screen->map->dst == SDL_VideoSurface ) {
+				if ( physcolors ) {
+					SDL_RemapColors(screen, physcolors,
+							firstcolor, ncolors);
+				} else {
+					SDL_InvalidateMap(screen->map);
 				}
 			}
 			SDL_UpdateRect(screen, 0, 0, 0, 0);
@@ -1358,6 +1407,9 @@ void SDL_VideoQuit (void)
 		SDL_VideoDevice *video = current_video;
 		SDL_VideoDevice *this  = current_video;
 
+		/* Finish any submitted command lists */
+		SDL_CommandsQuit();
+
 		/* Halt event processing before doing anything else */
 		SDL_StopEventLoop();
 
@@ -1366,6 +1418,7 @@ void SDL_VideoQuit (void)
 			SDL_PublicSurface = NULL;
 		}
 		SDL_CursorQuit();
+		SDL_WorkersQuit();
 
 		/* Just in case... */
 		SDL_WM_GrabInputOff();
@@ -1394,6 +1447,10 @@ void SDL_VideoQuit (void)
 			SDL_free(video->gammacols);
 			video->gammacols = NULL;
 		}
+		if ( video->gamma_tables ) {
+			SDL_free(video->gamma_tables);
+			video->gamma_tables = NULL;
+		}
 		if ( video->gamma ) {
 			SDL_free(video->gamma);
 			video->gamma = NULL;
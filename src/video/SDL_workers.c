@@ -0,0 +1,276 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* A small pool of worker threads for software video work */
+
+#include "SDL_thread.h"
+#include "SDL_mutex.h"
+#include "SDL_workers_c.h"
+
+#if defined(__WIN32__)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__LINUX__) || defined(__MACOSX__) || defined(__FREEBSD__) || \
+      defined(__NETBSD__) || defined(__OPENBSD__) || defined(__SOLARIS__) || \
+      defined(__QNXNTO__)
+#include <unistd.h>
+#endif
+
+/* The most threads we'll ever use, including the caller */
+#define SDL_MAX_WORKERS	16
+
+#if !SDL_THREADS_DISABLED
+
+static SDL_mutex *worker_lock = NULL;	/* Protects everything below */
+static SDL_cond *worker_wake = NULL;	/* Signalled when work is queued */
+static SDL_cond *worker_done = NULL;	/* Signalled when a job completes */
+static SDL_Thread *workers[SDL_MAX_WORKERS-1];
+static Uint32 worker_ids[SDL_MAX_WORKERS-1];
+static int num_workers = 0;		/* Threads started so far */
+static int max_workers = 0;		/* Threads wanted, excluding caller */
+static int worker_quit = 0;
+
+/* The job being run, one at a time */
+static SDL_WorkerFunc job_func;
+static void *job_data;
+static int job_count = 0;
+static int job_next = 0;
+static int job_active = 0;		/* Calls in progress */
+static int job_running = 0;
+static Uint32 job_owner;
+
+static int SDL_GetCPUCount(void)
+{
+	int count = 1;
+#if defined(__WIN32__)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	count = (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return (count > 0) ? count : 1;
+}
+
+/* Run the remaining calls of the current job, with worker_lock held */
+static void SDL_DoWork(void)
+{
+	while ( job_next < job_count ) {
+		int index = job_next++;
+
+		++job_active;
+		SDL_mutexV(worker_lock);
+		job_func(job_data, index);
+		SDL_mutexP(worker_lock);
+		if ( (--job_active == 0) && (job_next >= job_count) ) {
+			SDL_CondBroadcast(worker_done);
+		}
+	}
+}
+
+static int SDLCALL SDL_WorkerThread(void *unused)
+{
+	SDL_mutexP(worker_lock);
+	for ( ; ; ) {
+		while ( !worker_quit && (job_next >= job_count) ) {
+			SDL_CondWait(worker_wake, worker_lock);
+		}
+		if ( worker_quit ) {
+			break;
+		}
+		SDL_DoWork();
+	}
+	SDL_mutexV(worker_lock);
+	return(0);
+}
+
+void SDL_WorkersInit(void)
+{
+	const char *env;
+
+	if ( worker_lock ) {
+		return;
+	}
+	max_workers = SDL_GetCPUCount();
+	env = SDL_getenv("SDL_VIDEO_WORKER_THREADS");
+	if ( env ) {
+		max_workers = SDL_atoi(env);
+	}
+	if ( max_workers > SDL_MAX_WORKERS ) {
+		max_workers = SDL_MAX_WORKERS;
+	}
+	--max_workers;
+	if ( max_workers <= 0 ) {
+		max_workers = 0;
+		return;
+	}
+
+	worker_lock = SDL_CreateMutex();
+	worker_wake = SDL_CreateCond();
+	worker_done = SDL_CreateCond();
+	if ( !worker_lock || !worker_wake || !worker_done ) {
+		SDL_WorkersQuit();
+		SDL_ClearError();
+	}
+}
+
+void SDL_WorkersQuit(void)
+{
+	int i;
+
+	if ( worker_lock ) {
+		SDL_mutexP(worker_lock);
+		worker_quit = 1;
+		if ( worker_wake ) {
+			SDL_CondBroadcast(worker_wake);
+		}
+		SDL_mutexV(worker_lock);
+	}
+	for ( i = 0; i < num_workers; ++i ) {
+		SDL_WaitThread(workers[i], NULL);
+		workers[i] = NULL;
+	}
+	num_workers = 0;
+	max_workers = 0;
+	worker_quit = 0;
+
+	if ( worker_done ) {
+		SDL_DestroyCond(worker_done);
+		worker_done = NULL;
+	}
+	if ( worker_wake ) {
+		SDL_DestroyCond(worker_wake);
+		worker_wake = NULL;
+	}
+	if ( worker_lock ) {
+		SDL_DestroyMutex(worker_lock);
+		worker_lock = NULL;
+	}
+}
+
+int SDL_NumWorkers(void)
+{
+	return worker_lock ? (max_workers + 1) : 1;
+}
+
+/* Start the worker threads if needed, with worker_lock held */
+static int SDL_StartWorkers(void)
+{
+	while ( num_workers < max_workers ) {
+		SDL_Thread *thread = SDL_CreateThread(SDL_WorkerThread, NULL);
+		if ( thread == NULL ) {
+			/* Make do with what we have */
+			SDL_ClearError();
+			max_workers = num_workers;
+			break;
+		}
+		workers[num_workers] = thread;
+		worker_ids[num_workers] = SDL_GetThreadID(thread);
+		++num_workers;
+	}
+	return num_workers;
+}
+
+/* Can this thread hand out work without deadlocking? */
+static int SDL_CanRunWorkers(void)
+{
+	Uint32 self = SDL_ThreadID();
+	int i;
+
+	if ( job_running && (job_owner == self) ) {
+		return 0;
+	}
+	for ( i = 0; i < num_workers; ++i ) {
+		if ( worker_ids[i] == self ) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void SDL_RunWorkers(SDL_WorkerFunc func, void *data, int count)
+{
+	int i;
+
+	if ( worker_lock && (count > 1) ) {
+		SDL_mutexP(worker_lock);
+		if ( SDL_CanRunWorkers() ) {
+			/* Wait for any other thread's job to finish */
+			while ( job_running ) {
+				SDL_CondWait(worker_done, worker_lock);
+			}
+			if ( SDL_StartWorkers() > 0 ) {
+				job_running = 1;
+				job_owner = SDL_ThreadID();
+				job_func = func;
+				job_data = data;
+				job_next = 0;
+				job_count = count;
+				SDL_CondBroadcast(worker_wake);
+
+				SDL_DoWork();
+				while ( job_active > 0 ) {
+					SDL_CondWait(worker_done, worker_lock);
+				}
+				job_count = 0;
+				job_next = 0;
+				job_running = 0;
+				/* Let any waiting callers in */
+				SDL_CondBroadcast(worker_done);
+				SDL_mutexV(worker_lock);
+				return;
+			}
+		}
+		SDL_mutexV(worker_lock);
+	}
+
+	for ( i = 0; i < count; ++i ) {
+		func(data, i);
+	}
+}
+
+#else
+
+void SDL_WorkersInit(void)
+{
+}
+
+void SDL_WorkersQuit(void)
+{
+}
+
+int SDL_NumWorkers(void)
+{
+	return(1);
+}
+
+void SDL_RunWorkers(SDL_WorkerFunc func, void *data, int count)
+{
+	int i;
+
+	for ( i = 0; i < count; ++i ) {
+		func(data, i);
+	}
+}
+
+#endif /* !SDL_THREADS_DISABLED */
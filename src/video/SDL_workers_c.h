@@ -0,0 +1,47 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* A pool of worker threads for splitting independent software video work
+   (batch surface conversion, band-wise pixel conversion) over the CPUs.
+   The pool lives as long as the video subsystem; the threads themselves
+   are only started the first time there is work for them.
+ */
+
+typedef void (SDLCALL *SDL_WorkerFunc)(void *data, int index);
+
+extern void SDL_WorkersInit(void);
+extern void SDL_WorkersQuit(void);
+
+/* The number of threads, including the caller, that SDL_RunWorkers()
+   spreads work over.  This is 1 when no worker threads are available.
+ */
+extern int SDL_NumWorkers(void);
+
+/* Call func(data, index) once for every index from 0 to count-1, using the
+   worker threads and the calling thread, and return when all calls have
+   completed.  The calls may run in any order and concurrently, so they
+   must not touch shared state.  Nested calls, from inside func or from
+   several threads at once, are safe: they are serialized or run on the
+   calling thread.
+ */
+extern void SDL_RunWorkers(SDL_WorkerFunc func, void *data, int count);
@@ -63,6 +63,85 @@ SDL_Overlay *SDL_CreateYUVOverlay(int w, int h, Uint32 format,
 	return overlay;
 }
 
+SDL_Overlay *SDL_CreateYUVOverlayFrom(Uint8 **pixels, Uint16 *pitches,
+                                      int w, int h, Uint32 format,
+                                      SDL_Surface *display)
+{
+	SDL_Overlay *overlay;
+
+	overlay = SDL_CreateYUVOverlay(w, h, format, display);
+	if ( overlay && !overlay->hwfuncs->SetPlanes ) {
+		/* This hardware overlay can't take the planes, convert them */
+		SDL_FreeYUVOverlay(overlay);
+		overlay = SDL_CreateYUV_SW(current_video, w, h, format, display);
+	}
+	if ( overlay && (SDL_SetYUVOverlayPlanes(overlay, pixels, pitches) < 0) ) {
+		SDL_FreeYUVOverlay(overlay);
+		overlay = NULL;
+	}
+	return overlay;
+}
+
+void SDL_GetYUVPlaneSize(Uint32 format, int plane, int w, int h,
+                         int *bytes, int *rows)
+{
+	*bytes = w;
+	*rows = h;
+	switch (format) {
+	    case SDL_YV12_OVERLAY:
+	    case SDL_IYUV_OVERLAY:
+		if ( plane > 0 ) {
+			*bytes = w / 2;
+			*rows = h / 2;
+		}
+		break;
+	    case SDL_NV12_OVERLAY:
+	    case SDL_NV21_OVERLAY:
+		if ( plane > 0 ) {
+			*bytes = (w / 2) * 2;
+			*rows = h / 2;
+		}
+		break;
+	    case SDL_YUY2_OVERLAY:
+	    case SDL_UYVY_OVERLAY:
+	    case SDL_YVYU_OVERLAY:
+		*bytes = w * 2;
+		break;
+	    default:
+		break;
+	}
+}
+
+int SDL_SetYUVOverlayPlanes(SDL_Overlay *overlay, Uint8 **pixels,
+                            Uint16 *pitches)
+{
+	int i, bytes, rows;
+
+	if ( overlay == NULL ) {
+		SDL_SetError("Passed NULL overlay");
+		return -1;
+	}
+	if ( !overlay->hwfuncs->SetPlanes ) {
+		SDL_SetError("Overlay can't use external planes");
+		return -1;
+	}
+	if ( pixels ) {
+		if ( pitches == NULL ) {
+			SDL_SetError("Passed NULL pitches");
+			return -1;
+		}
+		for ( i = 0; i < overlay->planes; ++i ) {
+			SDL_GetYUVPlaneSize(overlay->format, i,
+			                    overlay->w, overlay->h, &bytes, &rows);
+			if ( (pixels[i] == NULL) || (pitches[i] < bytes) ) {
+				SDL_SetError("Invalid pixels or pitch for plane %d", i);
+				return -1;
+			}
+		}
+	}
+	return overlay->hwfuncs->SetPlanes(current_video, overlay, pixels, pitches);
+}
+
 int SDL_LockYUVOverlay(SDL_Overlay *overlay)
 {
 	if ( overlay == NULL ) {
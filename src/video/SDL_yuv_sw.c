@@ -88,13 +88,15 @@
 #include "SDL_stretch_c.h"
 #include "SDL_yuvfuncs.h"
 #include "SDL_yuv_sw_c.h"
+#include "SDL_workers_c.h"
 
 /* The functions used to manipulate software video overlays */
 static struct private_yuvhwfuncs sw_yuvfuncs = {
 	SDL_LockYUV_SW,
 	SDL_UnlockYUV_SW,
 	SDL_DisplayYUV_SW,
-	SDL_FreeYUV_SW
+	SDL_FreeYUV_SW,
+	SDL_SetPlanesYUV_SW
 };
 
 /* RGB conversion lookup tables */
@@ -107,11 +109,19 @@ struct private_yuvhwdata {
 	void (*Display1X)(int *colortab, Uint32 *rgb_2_pix,
                           unsigned char *lum, unsigned char *cr,
                           unsigned char *cb, unsigned char *out,
-                          int rows, int cols, int mod );
+                          int rows, int cols, int mod,
+                          int lum_mod, int chroma_mod );
 	void (*Display2X)(int *colortab, Uint32 *rgb_2_pix,
 	                  unsigned char *lum, unsigned char *cr,
                           unsigned char *cb, unsigned char *out,
-                          int rows, int cols, int mod );
+                          int rows, int cols, int mod,
+                          int lum_mod, int chroma_mod );
+
+	/* Frames are converted in bands of at least band_rows rows,
+	   spread over at most max_bands worker threads.
+	 */
+	int band_rows;
+	int max_bands;
 
 	/* These are just so we don't have to allocate them separately */
 	Uint16 pitches[3];
@@ -132,10 +142,11 @@ extern void ColorRGBDitherYV12MMX1X( int *colortab, Uint32 *rgb_2_pix,
                                      int rows, int cols, int mod );
 #endif 
 
-static void Color16DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
-                                    unsigned char *lum, unsigned char *cr,
-                                    unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+static __inline__ void Color16Dither420Mod1X( int *colortab, Uint32 *rgb_2_pix,
+                                              unsigned char *lum, unsigned char *cr,
+                                              unsigned char *cb, unsigned char *out,
+                                              int rows, int cols, int mod,
+                                              int lum_mod, int chroma_mod, int cstep )
 {
     unsigned short* row1;
     unsigned short* row2;
@@ -148,7 +159,7 @@ static void Color16DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
 
     row1 = (unsigned short*) out;
     row2 = row1 + cols + mod;
-    lum2 = lum + cols;
+    lum2 = lum + cols + lum_mod;
 
     mod += cols + mod;
 
@@ -164,7 +175,7 @@ static void Color16DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
             crb_g  = 1*768+256 + colortab[ *cr + 1*256 ]
                                + colortab[ *cb + 2*256 ];
             cb_b   = 2*768+256 + colortab[ *cb + 3*256 ];
-            ++cr; ++cb;
+            cr += cstep; cb += cstep;
 
             L = *lum++;
             *row1++ = (unsigned short)(rgb_2_pix[ L + cr_r ] |
@@ -195,17 +206,40 @@ static void Color16DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
          * to the ++'s above),but they need to be at the start
          * of the line after that.
          */
-        lum  += cols;
-        lum2 += cols;
+        lum  += cols + 2*lum_mod;
+        lum2 += cols + 2*lum_mod;
+        cr += chroma_mod;
+        cb += chroma_mod;
         row1 += mod;
         row2 += mod;
     }
 }
 
-static void Color24DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
+static void Color16DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color16Dither420Mod1X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 1 );
+}
+
+static void Color16DitherNV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
+                                    unsigned char *lum, unsigned char *cr,
+                                    unsigned char *cb, unsigned char *out,
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color16Dither420Mod1X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 2 );
+}
+
+static __inline__ void Color24Dither420Mod1X( int *colortab, Uint32 *rgb_2_pix,
+                                              unsigned char *lum, unsigned char *cr,
+                                              unsigned char *cb, unsigned char *out,
+                                              int rows, int cols, int mod,
+                                              int lum_mod, int chroma_mod, int cstep )
 {
     unsigned int value;
     unsigned char* row1;
@@ -219,7 +253,7 @@ static void Color24DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
 
     row1 = out;
     row2 = row1 + cols*3 + mod*3;
-    lum2 = lum + cols;
+    lum2 = lum + cols + lum_mod;
 
     mod += cols + mod;
     mod *= 3;
@@ -236,7 +270,7 @@ static void Color24DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
             crb_g  = 1*768+256 + colortab[ *cr + 1*256 ]
                                + colortab[ *cb + 2*256 ];
             cb_b   = 2*768+256 + colortab[ *cb + 3*256 ];
-            ++cr; ++cb;
+            cr += cstep; cb += cstep;
 
             L = *lum++;
             value = (rgb_2_pix[ L + cr_r ] |
@@ -279,17 +313,40 @@ static void Color24DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
          * to the ++'s above),but they need to be at the start
          * of the line after that.
          */
-        lum  += cols;
-        lum2 += cols;
+        lum  += cols + 2*lum_mod;
+        lum2 += cols + 2*lum_mod;
+        cr += chroma_mod;
+        cb += chroma_mod;
         row1 += mod;
         row2 += mod;
     }
 }
 
-static void Color32DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
+static void Color24DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
+                                    unsigned char *lum, unsigned char *cr,
+                                    unsigned char *cb, unsigned char *out,
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color24Dither420Mod1X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 1 );
+}
+
+static void Color24DitherNV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color24Dither420Mod1X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 2 );
+}
+
+static __inline__ void Color32Dither420Mod1X( int *colortab, Uint32 *rgb_2_pix,
+                                              unsigned char *lum, unsigned char *cr,
+                                              unsigned char *cb, unsigned char *out,
+                                              int rows, int cols, int mod,
+                                              int lum_mod, int chroma_mod, int cstep )
 {
     unsigned int* row1;
     unsigned int* row2;
@@ -302,7 +359,7 @@ static void Color32DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
 
     row1 = (unsigned int*) out;
     row2 = row1 + cols + mod;
-    lum2 = lum + cols;
+    lum2 = lum + cols + lum_mod;
 
     mod += cols + mod;
 
@@ -318,7 +375,7 @@ static void Color32DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
             crb_g  = 1*768+256 + colortab[ *cr + 1*256 ]
                                + colortab[ *cb + 2*256 ];
             cb_b   = 2*768+256 + colortab[ *cb + 3*256 ];
-            ++cr; ++cb;
+            cr += cstep; cb += cstep;
 
             L = *lum++;
             *row1++ = (rgb_2_pix[ L + cr_r ] |
@@ -349,22 +406,45 @@ static void Color32DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
          * to the ++'s above),but they need to be at the start
          * of the line after that.
          */
-        lum  += cols;
-        lum2 += cols;
+        lum  += cols + 2*lum_mod;
+        lum2 += cols + 2*lum_mod;
+        cr += chroma_mod;
+        cb += chroma_mod;
         row1 += mod;
         row2 += mod;
     }
 }
 
+static void Color32DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
+                                    unsigned char *lum, unsigned char *cr,
+                                    unsigned char *cb, unsigned char *out,
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color32Dither420Mod1X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 1 );
+}
+
+static void Color32DitherNV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
+                                    unsigned char *lum, unsigned char *cr,
+                                    unsigned char *cb, unsigned char *out,
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color32Dither420Mod1X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 2 );
+}
+
 /*
  * In this function I make use of a nasty trick. The tables have the lower
  * 16 bits replicated in the upper 16. This means I can write ints and get
  * the horisontal doubling for free (almost).
  */
-static void Color16DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
-                                    unsigned char *lum, unsigned char *cr,
-                                    unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+static __inline__ void Color16Dither420Mod2X( int *colortab, Uint32 *rgb_2_pix,
+                                              unsigned char *lum, unsigned char *cr,
+                                              unsigned char *cb, unsigned char *out,
+                                              int rows, int cols, int mod,
+                                              int lum_mod, int chroma_mod, int cstep )
 {
     unsigned int* row1 = (unsigned int*) out;
     const int next_row = cols+(mod/2);
@@ -376,7 +456,7 @@ static void Color16DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
     int cb_b;
     int cols_2 = cols / 2;
 
-    lum2 = lum + cols;
+    lum2 = lum + cols + lum_mod;
 
     mod = (next_row * 3) + (mod/2);
 
@@ -392,7 +472,7 @@ static void Color16DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
             crb_g  = 1*768+256 + colortab[ *cr + 1*256 ]
                                + colortab[ *cb + 2*256 ];
             cb_b   = 2*768+256 + colortab[ *cb + 3*256 ];
-            ++cr; ++cb;
+            cr += cstep; cb += cstep;
 
             L = *lum++;
             row1[0] = row1[next_row] = (rgb_2_pix[ L + cr_r ] |
@@ -427,17 +507,40 @@ static void Color16DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
          * to the ++'s above),but they need to be at the start
          * of the line after that.
          */
-        lum  += cols;
-        lum2 += cols;
+        lum  += cols + 2*lum_mod;
+        lum2 += cols + 2*lum_mod;
+        cr += chroma_mod;
+        cb += chroma_mod;
         row1 += mod;
         row2 += mod;
     }
 }
 
-static void Color24DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
+static void Color16DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
+                                    unsigned char *lum, unsigned char *cr,
+                                    unsigned char *cb, unsigned char *out,
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color16Dither420Mod2X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 1 );
+}
+
+static void Color16DitherNV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color16Dither420Mod2X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 2 );
+}
+
+static __inline__ void Color24Dither420Mod2X( int *colortab, Uint32 *rgb_2_pix,
+                                              unsigned char *lum, unsigned char *cr,
+                                              unsigned char *cb, unsigned char *out,
+                                              int rows, int cols, int mod,
+                                              int lum_mod, int chroma_mod, int cstep )
 {
     unsigned int value;
     unsigned char* row1 = out;
@@ -450,7 +553,7 @@ static void Color24DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
     int cb_b;
     int cols_2 = cols / 2;
 
-    lum2 = lum + cols;
+    lum2 = lum + cols + lum_mod;
 
     mod = next_row*3 + mod*3;
 
@@ -466,7 +569,7 @@ static void Color24DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
             crb_g  = 1*768+256 + colortab[ *cr + 1*256 ]
                                + colortab[ *cb + 2*256 ];
             cb_b   = 2*768+256 + colortab[ *cb + 3*256 ];
-            ++cr; ++cb;
+            cr += cstep; cb += cstep;
 
             L = *lum++;
             value = (rgb_2_pix[ L + cr_r ] |
@@ -525,17 +628,40 @@ static void Color24DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
          * to the ++'s above),but they need to be at the start
          * of the line after that.
          */
-        lum  += cols;
-        lum2 += cols;
+        lum  += cols + 2*lum_mod;
+        lum2 += cols + 2*lum_mod;
+        cr += chroma_mod;
+        cb += chroma_mod;
         row1 += mod;
         row2 += mod;
     }
 }
 
-static void Color32DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
+static void Color24DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
+                                    unsigned char *lum, unsigned char *cr,
+                                    unsigned char *cb, unsigned char *out,
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color24Dither420Mod2X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 1 );
+}
+
+static void Color24DitherNV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color24Dither420Mod2X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 2 );
+}
+
+static __inline__ void Color32Dither420Mod2X( int *colortab, Uint32 *rgb_2_pix,
+                                              unsigned char *lum, unsigned char *cr,
+                                              unsigned char *cb, unsigned char *out,
+                                              int rows, int cols, int mod,
+                                              int lum_mod, int chroma_mod, int cstep )
 {
     unsigned int* row1 = (unsigned int*) out;
     const int next_row = cols*2+mod;
@@ -547,7 +673,7 @@ static void Color32DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
     int cb_b;
     int cols_2 = cols / 2;
 
-    lum2 = lum + cols;
+    lum2 = lum + cols + lum_mod;
 
     mod = (next_row * 3) + mod;
 
@@ -563,7 +689,7 @@ static void Color32DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
             crb_g  = 1*768+256 + colortab[ *cr + 1*256 ]
                                + colortab[ *cb + 2*256 ];
             cb_b   = 2*768+256 + colortab[ *cb + 3*256 ];
-            ++cr; ++cb;
+            cr += cstep; cb += cstep;
 
             L = *lum++;
             row1[0] = row1[1] = row1[next_row] = row1[next_row+1] =
@@ -602,17 +728,40 @@ static void Color32DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
          * to the ++'s above),but they need to be at the start
          * of the line after that.
          */
-        lum  += cols;
-        lum2 += cols;
+        lum  += cols + 2*lum_mod;
+        lum2 += cols + 2*lum_mod;
+        cr += chroma_mod;
+        cb += chroma_mod;
         row1 += mod;
         row2 += mod;
     }
 }
 
+static void Color32DitherYV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
+                                    unsigned char *lum, unsigned char *cr,
+                                    unsigned char *cb, unsigned char *out,
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color32Dither420Mod2X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 1 );
+}
+
+static void Color32DitherNV12Mod2X( int *colortab, Uint32 *rgb_2_pix,
+                                    unsigned char *lum, unsigned char *cr,
+                                    unsigned char *cb, unsigned char *out,
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
+{
+    Color32Dither420Mod2X( colortab, rgb_2_pix, lum, cr, cb, out,
+                           rows, cols, mod, lum_mod, chroma_mod, 2 );
+}
+
 static void Color16DitherYUY2Mod1X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
 {
     unsigned short* row;
     int x, y;
@@ -650,13 +799,17 @@ static void Color16DitherYUY2Mod1X( int *colortab, Uint32 *rgb_2_pix,
         }
 
         row += mod;
+        lum += lum_mod;
+        cr += lum_mod;
+        cb += lum_mod;
     }
 }
 
 static void Color24DitherYUY2Mod1X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
 {
     unsigned int value;
     unsigned char* row;
@@ -700,13 +853,17 @@ static void Color24DitherYUY2Mod1X( int *colortab, Uint32 *rgb_2_pix,
 
         }
         row += mod;
+        lum += lum_mod;
+        cr += lum_mod;
+        cb += lum_mod;
     }
 }
 
 static void Color32DitherYUY2Mod1X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
 {
     unsigned int* row;
     int x, y;
@@ -743,6 +900,9 @@ static void Color32DitherYUY2Mod1X( int *colortab, Uint32 *rgb_2_pix,
 
         }
         row += mod;
+        lum += lum_mod;
+        cr += lum_mod;
+        cb += lum_mod;
     }
 }
 
@@ -754,7 +914,8 @@ static void Color32DitherYUY2Mod1X( int *colortab, Uint32 *rgb_2_pix,
 static void Color16DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
 {
     unsigned int* row = (unsigned int*) out;
     const int next_row = cols+(mod/2);
@@ -791,14 +952,19 @@ static void Color16DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
             row++;
 
         }
-        row += next_row;
+        /* Skip the doubled row and the padding after it */
+        row += next_row + mod/2;
+        lum += lum_mod;
+        cr += lum_mod;
+        cb += lum_mod;
     }
 }
 
 static void Color24DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
 {
     unsigned int value;
     unsigned char* row = out;
@@ -847,14 +1013,19 @@ static void Color24DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
             row += 2*3;
 
         }
-        row += next_row;
+        /* Skip the doubled row and the padding after it */
+        row += next_row + mod*3;
+        lum += lum_mod;
+        cr += lum_mod;
+        cb += lum_mod;
     }
 }
 
 static void Color32DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
-                                    int rows, int cols, int mod )
+                                    int rows, int cols, int mod,
+                                    int lum_mod, int chroma_mod )
 {
     unsigned int* row = (unsigned int*) out;
     const int next_row = cols*2+mod;
@@ -863,7 +1034,6 @@ static void Color32DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
     int crb_g;
     int cb_b;
     int cols_2 = cols / 2;
-    mod+=mod;
     y = rows;
     while( y-- )
     {
@@ -895,7 +1065,11 @@ static void Color32DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
 
         }
 
-        row += next_row;
+        /* Skip the doubled row and the padding after it */
+        row += next_row + mod;
+        lum += lum_mod;
+        cr += lum_mod;
+        cb += lum_mod;
     }
 }
 
@@ -903,6 +1077,39 @@ static void Color32DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
  * How many 1 bits are there in the Uint32.
  * Low performance, do not call often.
  */
+#if (__GNUC__ > 2) && defined(__i386__) && __OPTIMIZE__ && SDL_ASSEMBLY_ROUTINES
+/* The MMX code only handles tightly packed planes */
+static void Color565DitherYV12MMX( int *colortab, Uint32 *rgb_2_pix,
+                                   unsigned char *lum, unsigned char *cr,
+                                   unsigned char *cb, unsigned char *out,
+                                   int rows, int cols, int mod,
+                                   int lum_mod, int chroma_mod )
+{
+    if ( lum_mod || chroma_mod ) {
+        Color16DitherYV12Mod1X( colortab, rgb_2_pix, lum, cr, cb, out,
+                                rows, cols, mod, lum_mod, chroma_mod );
+    } else {
+        Color565DitherYV12MMX1X( colortab, rgb_2_pix, lum, cr, cb, out,
+                                 rows, cols, mod );
+    }
+}
+
+static void ColorRGBDitherYV12MMX( int *colortab, Uint32 *rgb_2_pix,
+                                   unsigned char *lum, unsigned char *cr,
+                                   unsigned char *cb, unsigned char *out,
+                                   int rows, int cols, int mod,
+                                   int lum_mod, int chroma_mod )
+{
+    if ( lum_mod || chroma_mod ) {
+        Color32DitherYV12Mod1X( colortab, rgb_2_pix, lum, cr, cb, out,
+                                rows, cols, mod, lum_mod, chroma_mod );
+    } else {
+        ColorRGBDitherYV12MMX1X( colortab, rgb_2_pix, lum, cr, cb, out,
+                                 rows, cols, mod );
+    }
+}
+#endif
+
 static int number_of_bits_set( Uint32 a )
 {
     if(!a) return 0;
@@ -923,6 +1130,48 @@ static int free_bits_at_bottom( Uint32 a )
 }
 
 
+/* Point the overlay planes back at our own buffer */
+static void SDL_SetNativePlanesYUV_SW(SDL_Overlay *overlay)
+{
+	struct private_yuvhwdata *swdata;
+
+	swdata = overlay->hwdata;
+	switch (overlay->format) {
+	    case SDL_YV12_OVERLAY:
+	    case SDL_IYUV_OVERLAY:
+		overlay->pitches[0] = overlay->w;
+		overlay->pitches[1] = overlay->pitches[0] / 2;
+		overlay->pitches[2] = overlay->pitches[0] / 2;
+	        overlay->pixels[0] = swdata->pixels;
+	        overlay->pixels[1] = overlay->pixels[0] +
+		                     overlay->pitches[0] * overlay->h;
+	        overlay->pixels[2] = overlay->pixels[1] +
+		                     overlay->pitches[1] * overlay->h / 2;
+		overlay->planes = 3;
+		break;
+	    case SDL_NV12_OVERLAY:
+	    case SDL_NV21_OVERLAY:
+		/* The chroma plane holds interleaved pairs at half height */
+		overlay->pitches[0] = overlay->w;
+		overlay->pitches[1] = overlay->w;
+	        overlay->pixels[0] = swdata->pixels;
+	        overlay->pixels[1] = overlay->pixels[0] +
+		                     overlay->pitches[0] * overlay->h;
+		overlay->planes = 2;
+		break;
+	    case SDL_YUY2_OVERLAY:
+	    case SDL_UYVY_OVERLAY:
+	    case SDL_YVYU_OVERLAY:
+		overlay->pitches[0] = overlay->w*2;
+	        overlay->pixels[0] = swdata->pixels;
+		overlay->planes = 1;
+		break;
+	    default:
+		/* We should never get here (caught in SDL_CreateYUV_SW) */
+		break;
+	}
+}
+
 SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_Surface *display)
 {
 	SDL_Overlay *overlay;
@@ -937,6 +1186,7 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 	int i;
 	int CR, CB;
 	Uint32 Rmask, Gmask, Bmask;
+	const char *env;
 
 	/* Only RGB packed pixel conversion supported */
 	if ( (display->format->BytesPerPixel != 2) &&
@@ -953,6 +1203,8 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 	    case SDL_YUY2_OVERLAY:
 	    case SDL_UYVY_OVERLAY:
 	    case SDL_YVYU_OVERLAY:
+	    case SDL_NV12_OVERLAY:
+	    case SDL_NV21_OVERLAY:
 		break;
 	    default:
 		SDL_SetError("Unsupported YUV format");
@@ -985,6 +1237,18 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 	}
 	swdata->stretch = NULL;
 	swdata->display = display;
+	swdata->band_rows = 64;
+	env = SDL_getenv("SDL_VIDEO_YUV_BAND_HEIGHT");
+	if ( env && (SDL_atoi(env) > 0) ) {
+		swdata->band_rows = SDL_atoi(env);
+	}
+	/* Keep the bands aligned to the vertical chroma subsampling */
+	swdata->band_rows = (swdata->band_rows + 1) & ~1;
+	swdata->max_bands = SDL_NumWorkers();
+	env = SDL_getenv("SDL_VIDEO_YUV_THREADS");
+	if ( env && (SDL_atoi(env) > 0) ) {
+		swdata->max_bands = SDL_atoi(env);
+	}
 	swdata->pixels = (Uint8 *) SDL_malloc(width*height*2);
 	swdata->colortab = (int *)SDL_malloc(4*256*sizeof(int));
 	Cr_r_tab = &swdata->colortab[0*256];
@@ -1068,7 +1332,7 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 				             (Bmask == 0x001F) &&
 			                     (width & 15) == 0) {
 /*printf("Using MMX 16-bit 565 dither\n");*/
-				swdata->Display1X = Color565DitherYV12MMX1X;
+				swdata->Display1X = Color565DitherYV12MMX;
 			} else {
 /*printf("Using C 16-bit dither\n");*/
 				swdata->Display1X = Color16DitherYV12Mod1X;
@@ -1090,7 +1354,7 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 				             (Bmask == 0x000000FF) && 
 			                     (width & 15) == 0) {
 /*printf("Using MMX 32-bit dither\n");*/
-				swdata->Display1X = ColorRGBDitherYV12MMX1X;
+				swdata->Display1X = ColorRGBDitherYV12MMX;
 			} else {
 /*printf("Using C 32-bit dither\n");*/
 				swdata->Display1X = Color32DitherYV12Mod1X;
@@ -1117,6 +1381,21 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 			swdata->Display2X = Color32DitherYUY2Mod2X;
 		}
 		break;
+	    case SDL_NV12_OVERLAY:
+	    case SDL_NV21_OVERLAY:
+		if ( display->format->BytesPerPixel == 2 ) {
+			swdata->Display1X = Color16DitherNV12Mod1X;
+			swdata->Display2X = Color16DitherNV12Mod2X;
+		}
+		if ( display->format->BytesPerPixel == 3 ) {
+			swdata->Display1X = Color24DitherNV12Mod1X;
+			swdata->Display2X = Color24DitherNV12Mod2X;
+		}
+		if ( display->format->BytesPerPixel == 4 ) {
+			swdata->Display1X = Color32DitherNV12Mod1X;
+			swdata->Display2X = Color32DitherNV12Mod2X;
+		}
+		break;
 	    default:
 		/* We should never get here (caught above) */
 		break;
@@ -1125,30 +1404,7 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 	/* Find the pitch and offset values for the overlay */
 	overlay->pitches = swdata->pitches;
 	overlay->pixels = swdata->planes;
-	switch (format) {
-	    case SDL_YV12_OVERLAY:
-	    case SDL_IYUV_OVERLAY:
-		overlay->pitches[0] = overlay->w;
-		overlay->pitches[1] = overlay->pitches[0] / 2;
-		overlay->pitches[2] = overlay->pitches[0] / 2;
-	        overlay->pixels[0] = swdata->pixels;
-	        overlay->pixels[1] = overlay->pixels[0] +
-		                     overlay->pitches[0] * overlay->h;
-	        overlay->pixels[2] = overlay->pixels[1] +
-		                     overlay->pitches[1] * overlay->h / 2;
-		overlay->planes = 3;
-		break;
-	    case SDL_YUY2_OVERLAY:
-	    case SDL_UYVY_OVERLAY:
-	    case SDL_YVYU_OVERLAY:
-		overlay->pitches[0] = overlay->w*2;
-	        overlay->pixels[0] = swdata->pixels;
-		overlay->planes = 1;
-		break;
-	    default:
-		/* We should never get here (caught above) */
-		break;
-	}
+	SDL_SetNativePlanesYUV_SW(overlay);
 
 	/* We're all done.. */
 	return(overlay);
@@ -1164,6 +1420,103 @@ void SDL_UnlockYUV_SW(_THIS, SDL_Overlay *overlay)
 	return;
 }
 
+int SDL_SetPlanesYUV_SW(_THIS, SDL_Overlay *overlay, Uint8 **pixels, Uint16 *pitches)
+{
+	struct private_yuvhwdata *swdata;
+	int i;
+
+	swdata = overlay->hwdata;
+	if ( pixels ) {
+		/* The converters step through both chroma planes together */
+		if ( (overlay->planes == 3) && (pitches[1] != pitches[2]) ) {
+			SDL_SetError("U and V planes must have the same pitch");
+			return(-1);
+		}
+		for ( i = 0; i < overlay->planes; ++i ) {
+			overlay->pixels[i] = pixels[i];
+			overlay->pitches[i] = pitches[i];
+		}
+
+		/* Convert straight from the caller's planes */
+		if ( swdata->pixels ) {
+			SDL_free(swdata->pixels);
+			swdata->pixels = NULL;
+		}
+	} else {
+		if ( ! swdata->pixels ) {
+			swdata->pixels = (Uint8 *)
+				SDL_malloc(overlay->w*overlay->h*2);
+			if ( ! swdata->pixels ) {
+				SDL_OutOfMemory();
+				return(-1);
+			}
+		}
+		SDL_SetNativePlanesYUV_SW(overlay);
+	}
+	return(0);
+}
+
+/* A horizontal band of the overlay for one worker thread to convert */
+typedef struct {
+	void (*Convert)(int *colortab, Uint32 *rgb_2_pix,
+	                unsigned char *lum, unsigned char *cr,
+	                unsigned char *cb, unsigned char *out,
+	                int rows, int cols, int mod,
+	                int lum_mod, int chroma_mod );
+	int *colortab;
+	Uint32 *rgb_2_pix;
+	Uint8 *lum, *Cr, *Cb, *dstp;
+	int lum_pitch;
+	int chroma_pitch;
+	int chroma_shift;
+	int dst_pitch;
+	int rows, cols, mod;
+	int lum_mod, chroma_mod;
+	int band_rows;
+} SDL_YUVBandJob;
+
+static void SDLCALL SDL_ConvertYUVBand(void *data, int index)
+{
+	SDL_YUVBandJob *job = (SDL_YUVBandJob *)data;
+	int y, rows, chroma;
+
+	y = index * job->band_rows;
+	rows = job->rows - y;
+	if ( rows > job->band_rows ) {
+		rows = job->band_rows;
+	}
+	chroma = (y >> job->chroma_shift) * job->chroma_pitch;
+	job->Convert(job->colortab, job->rgb_2_pix,
+	             job->lum + y * job->lum_pitch,
+	             job->Cr + chroma, job->Cb + chroma,
+	             job->dstp + y * job->dst_pitch,
+	             rows, job->cols, job->mod,
+	             job->lum_mod, job->chroma_mod);
+}
+
+/* Convert the whole overlay, in parallel bands if it is tall enough */
+static void SDL_ConvertYUVBands(SDL_Overlay *overlay, SDL_YUVBandJob *job)
+{
+	struct private_yuvhwdata *swdata;
+	int bands;
+
+	swdata = overlay->hwdata;
+	bands = overlay->h / swdata->band_rows;
+	if ( bands > swdata->max_bands ) {
+		bands = swdata->max_bands;
+	}
+	if ( bands <= 1 ) {
+		job->band_rows = overlay->h;
+		SDL_ConvertYUVBand(job, 0);
+		return;
+	}
+
+	/* Share the rows out evenly, in whole chroma rows */
+	job->band_rows = (((overlay->h + bands - 1) / bands) + 1) & ~1;
+	bands = (overlay->h + job->band_rows - 1) / job->band_rows;
+	SDL_RunWorkers(SDL_ConvertYUVBand, job, bands);
+}
+
 int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 {
 	struct private_yuvhwdata *swdata;
@@ -1173,6 +1526,8 @@ int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 	Uint8 *lum, *Cr, *Cb;
 	Uint8 *dstp;
 	int mod;
+	int lum_mod, chroma_mod;
+	SDL_YUVBandJob job;
 
 	swdata = overlay->hwdata;
 	stretch = 0;
@@ -1215,31 +1570,54 @@ int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 		lum = overlay->pixels[0];
 		Cr =  overlay->pixels[1];
 		Cb =  overlay->pixels[2];
+		chroma_mod = overlay->pitches[1] - overlay->w / 2;
 		break;
 	    case SDL_IYUV_OVERLAY:
 		lum = overlay->pixels[0];
 		Cr =  overlay->pixels[2];
 		Cb =  overlay->pixels[1];
+		chroma_mod = overlay->pitches[1] - overlay->w / 2;
+		break;
+	    case SDL_NV12_OVERLAY:
+		lum = overlay->pixels[0];
+		Cr =  overlay->pixels[1] + 1;
+		Cb =  overlay->pixels[1];
+		chroma_mod = overlay->pitches[1] - (overlay->w / 2) * 2;
+		break;
+	    case SDL_NV21_OVERLAY:
+		lum = overlay->pixels[0];
+		Cr =  overlay->pixels[1];
+		Cb =  overlay->pixels[1] + 1;
+		chroma_mod = overlay->pitches[1] - (overlay->w / 2) * 2;
 		break;
 	    case SDL_YUY2_OVERLAY:
 		lum = overlay->pixels[0];
 		Cr = lum + 3;
 		Cb = lum + 1;
+		chroma_mod = 0;
 		break;
 	    case SDL_UYVY_OVERLAY:
 		lum = overlay->pixels[0]+1;
 		Cr = lum + 1;
 		Cb = lum - 1;
+		chroma_mod = 0;
 		break;
 	    case SDL_YVYU_OVERLAY:
 		lum = overlay->pixels[0];
 		Cr = lum + 1;
 		Cb = lum + 3;
+		chroma_mod = 0;
 		break;
 	    default:
 		SDL_SetError("Unsupported YUV format in blit");
 		return(-1);
 	}
+	/* The padding at the end of each row of caller owned planes */
+	if ( overlay->planes == 1 ) {
+		lum_mod = overlay->pitches[0] - (overlay->w / 2) * 4;
+	} else {
+		lum_mod = overlay->pitches[0] - overlay->w;
+	}
 	if ( SDL_MUSTLOCK(display) ) {
         	if ( SDL_LockSurface(display) < 0 ) {
 			return(-1);
@@ -1254,15 +1632,34 @@ int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 	}
 	mod = (display->pitch / display->format->BytesPerPixel);
 
+	job.colortab = swdata->colortab;
+	job.rgb_2_pix = swdata->rgb_2_pix;
+	job.lum = lum;
+	job.Cr = Cr;
+	job.Cb = Cb;
+	job.dstp = dstp;
+	job.lum_pitch = overlay->pitches[0];
+	if ( overlay->planes == 1 ) {
+		job.chroma_pitch = overlay->pitches[0];
+		job.chroma_shift = 0;
+	} else {
+		job.chroma_pitch = overlay->pitches[1];
+		job.chroma_shift = 1;
+	}
+	job.rows = overlay->h;
+	job.cols = overlay->w;
+	job.lum_mod = lum_mod;
+	job.chroma_mod = chroma_mod;
 	if ( scale_2x ) {
-		mod -= (overlay->w * 2);
-		swdata->Display2X(swdata->colortab, swdata->rgb_2_pix,
-		                  lum, Cr, Cb, dstp, overlay->h, overlay->w, mod);
+		job.Convert = swdata->Display2X;
+		job.dst_pitch = display->pitch * 2;
+		job.mod = mod - (overlay->w * 2);
 	} else {
-		mod -= overlay->w;
-		swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
-		                  lum, Cr, Cb, dstp, overlay->h, overlay->w, mod);
+		job.Convert = swdata->Display1X;
+		job.dst_pitch = display->pitch;
+		job.mod = mod - overlay->w;
 	}
+	SDL_ConvertYUVBands(overlay, &job);
 	if ( SDL_MUSTLOCK(display) ) {
 		SDL_UnlockSurface(display);
 	}
@@ -34,4 +34,10 @@ struct private_yuvhwfuncs {
 	void (*Unlock)(_THIS, SDL_Overlay *overlay);
 	int (*Display)(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst);
 	void (*FreeHW)(_THIS, SDL_Overlay *overlay);
+	/* Optional: point the overlay at caller owned planes, NULL to restore */
+	int (*SetPlanes)(_THIS, SDL_Overlay *overlay, Uint8 **pixels, Uint16 *pitches);
 };
+
+/* The bytes per row and number of rows in a plane of the given format */
+extern void SDL_GetYUVPlaneSize(Uint32 format, int plane, int w, int h,
+                                int *bytes, int *rows);
@@ -32,6 +32,7 @@
 #include "SDL_mouse.h"
 #include "../SDL_sysvideo.h"
 #include "../SDL_pixels_c.h"
+#include "../SDL_dirty_c.h"
 #include "../../events/SDL_events_c.h"
 
 #include "SDL_aavideo.h"
@@ -149,6 +150,8 @@ int AA_VideoInit(_THIS, SDL_PixelFormat *vformat)
 	/* Initialize the library */
 
 	AA_mutex = SDL_CreateMutex();
+	AA_frame_lock = SDL_CreateMutex();
+	AA_frame_ready = SDL_CreateCond();
 
 	aa_parseoptions (NULL, NULL, NULL, NULL);
 
@@ -196,47 +199,147 @@ SDL_Rect **AA_ListModes(_THIS, SDL_PixelFormat *format, Uint32 flags)
 	 }
 }
 
-/* From aavga.c
-   AAlib does not give us the choice of the actual resolution, thus we have to simulate additional
-   resolution by scaling down manually each frame
+/* AAlib does not give us the choice of the actual resolution, thus we have
+   to simulate additional resolutions by scaling down each frame.  The image
+   pixel each screen pixel lands on is looked up once per mode or resize.
 */
-static void fastscale (register char *b1, register char *b2, int x1, int x2, int y1, int y2)
+static int AA_SetupScale(_THIS)
 {
-	register int ex, spx = 0, ddx, ddx1;
-	int ddy1, ddy, spy = 0, ey;
-	int x;
-	char *bb1 = b1;
-	if (!x1 || !x2 || !y1 || !y2)
-		return;
-	ddx = x1 + x1;
-	ddx1 = x2 + x2;
-	if (ddx1 < ddx)
-		spx = ddx / ddx1, ddx %= ddx1;
-	ddy = y1 + y1;
-	ddy1 = y2 + y2;
-	if (ddy1 < ddy)
-		spy = (ddy / ddy1) * x1, ddy %= ddy1;
-	ey = -ddy1;
-	for (; y2; y2--) {
-		ex = -ddx1;
-		for (x = x2; x; x--) {
-			*b2 = *b1;
-			b2++;
-			b1 += spx;
-			ex += ddx;
-			if (ex > 0) {
-				b1++;
-				ex -= ddx1;
-			}
+	int iw, ih;
+	int *map;
+	int i;
+
+	iw = aa_imgwidth(AA_context);
+	ih = aa_imgheight(AA_context);
+	map = (int *)SDL_realloc(AA_xmap, iw * sizeof(int));
+	if ( ! map ) {
+		return(-1);
+	}
+	AA_xmap = map;
+	map = (int *)SDL_realloc(AA_ymap, ih * sizeof(int));
+	if ( ! map ) {
+		return(-1);
+	}
+	AA_ymap = map;
+	for ( i = 0; i < iw; ++i ) {
+		AA_xmap[i] = (i * AA_w) / iw;
+	}
+	for ( i = 0; i < ih; ++i ) {
+		AA_ymap[i] = (i * AA_h) / ih;
+	}
+	AA_mapw = iw;
+	AA_maph = ih;
+	return(0);
+}
+
+/* Scale part of the last frame into the AAlib image, in image pixels */
+static void AA_Downsample(_THIS, int x1, int y1, int x2, int y2)
+{
+	unsigned char *image;
+	const Uint8 *src;
+	unsigned char *dst;
+	int iw;
+	int x, y;
+
+	image = aa_image(AA_context);
+	iw = aa_imgwidth(AA_context);
+	if ( x2 > AA_mapw ) {
+		x2 = AA_mapw;
+	}
+	if ( y2 > AA_maph ) {
+		y2 = AA_maph;
+	}
+	for ( y = y1; y < y2; ++y ) {
+		dst = image + y * iw;
+
+		/* Image rows sampling the same screen row are plain copies */
+		if ( (y > y1) && (AA_ymap[y] == AA_ymap[y-1]) ) {
+			SDL_memcpy(dst + x1, dst - iw + x1, x2 - x1);
+			continue;
+		}
+		src = AA_shadow + AA_ymap[y] * AA_w;
+		for ( x = x1; x < x2; ++x ) {
+			dst[x] = src[AA_xmap[x]];
 		}
-		bb1 += spy;
-		ey += ddy;
-		if (ey > 0) {
-			bb1 += x1;
-			ey -= ddy1;
+	}
+}
+
+/* Render the text cells covering the changed part of the screen */
+static void AA_RenderDirty(_THIS)
+{
+	SDL_Rect rect;
+	int sw, sh, iw, ih;
+	int cx1, cy1, cx2, cy2;
+
+	SDL_mutexP(AA_mutex);
+	SDL_mutexP(AA_frame_lock);
+	rect = AA_dirty;
+	SDL_memset(&AA_dirty, 0, sizeof(AA_dirty));
+	cx1 = cy1 = cx2 = cy2 = 0;
+	if ( rect.w && rect.h ) {
+		sw = aa_scrwidth(AA_context);
+		sh = aa_scrheight(AA_context);
+		iw = aa_imgwidth(AA_context);
+		ih = aa_imgheight(AA_context);
+		cx1 = (rect.x * sw) / AA_w;
+		cy1 = (rect.y * sh) / AA_h;
+		cx2 = ((rect.x + rect.w) * sw + AA_w - 1) / AA_w;
+		cy2 = ((rect.y + rect.h) * sh + AA_h - 1) / AA_h;
+		AA_Downsample(this, (cx1 * iw) / sw, (cy1 * ih) / sh,
+		                    (cx2 * iw) / sw, (cy2 * ih) / sh);
+	}
+	SDL_mutexV(AA_frame_lock);
+	if ( (cx2 > cx1) && (cy2 > cy1) ) {
+		aa_renderpalette(AA_context, AA_palette, AA_rparams,
+		                 cx1, cy1, cx2, cy2);
+		aa_flush(AA_context);
+	}
+	SDL_mutexV(AA_mutex);
+}
+
+static int SDLCALL AA_RenderThread(void *data)
+{
+	SDL_VideoDevice *this = (SDL_VideoDevice *)data;
+
+	SDL_mutexP(AA_frame_lock);
+	while ( ! AA_render_quit ) {
+		if ( ! AA_dirty.w || ! AA_dirty.h ) {
+			SDL_CondWait(AA_frame_ready, AA_frame_lock);
+			continue;
 		}
-		b1 = bb1;
+		SDL_mutexV(AA_frame_lock);
+		AA_RenderDirty(this);
+		SDL_mutexP(AA_frame_lock);
+	}
+	SDL_mutexV(AA_frame_lock);
+	return(0);
+}
+
+static void AA_StopRenderThread(_THIS)
+{
+	if ( AA_render_thread ) {
+		SDL_mutexP(AA_frame_lock);
+		AA_render_quit = 1;
+		SDL_CondSignal(AA_frame_ready);
+		SDL_mutexV(AA_frame_lock);
+		SDL_WaitThread(AA_render_thread, NULL);
+		AA_render_thread = NULL;
+		AA_render_quit = 0;
+	}
+}
+
+/* Everything needs to be rendered again, e.g. after a palette change */
+static void AA_InvalidateScreen(_THIS)
+{
+	SDL_mutexP(AA_frame_lock);
+	AA_dirty.x = 0;
+	AA_dirty.y = 0;
+	AA_dirty.w = AA_w;
+	AA_dirty.h = AA_h;
+	if ( AA_render_thread ) {
+		SDL_CondSignal(AA_frame_ready);
 	}
+	SDL_mutexV(AA_frame_lock);
 }
 
 /* Various screen update functions available */
@@ -245,14 +348,21 @@ static void AA_DirectUpdate(_THIS, int numrects, SDL_Rect *rects);
 SDL_Surface *AA_SetVideoMode(_THIS, SDL_Surface *current,
 				int width, int height, int bpp, Uint32 flags)
 {
-	int mode;
+	const char *env;
+
+	/* The renderer reads the old buffers until it's stopped */
+	AA_StopRenderThread(this);
 
 	if ( AA_buffer ) {
 		SDL_free( AA_buffer );
 	}
+	if ( AA_shadow ) {
+		SDL_free( AA_shadow );
+	}
 
 	AA_buffer = SDL_malloc(width * height);
-	if ( ! AA_buffer ) {
+	AA_shadow = (Uint8 *)SDL_malloc(width * height);
+	if ( ! AA_buffer || ! AA_shadow ) {
 		SDL_SetError("Couldn't allocate buffer for requested mode");
 		return(NULL);
 	}
@@ -261,6 +371,7 @@ SDL_Surface *AA_SetVideoMode(_THIS, SDL_Surface *current,
 
 	SDL_memset(aa_image(AA_context), 0, aa_imgwidth(AA_context) * aa_imgheight(AA_context));
 	SDL_memset(AA_buffer, 0, width * height);
+	SDL_memset(AA_shadow, 0, width * height);
 
 	/* Allocate the new pixel format for the screen */
 	if ( ! SDL_ReallocFormat(current, 8, 0, 0, 0, 0) ) {
@@ -276,23 +387,46 @@ SDL_Surface *AA_SetVideoMode(_THIS, SDL_Surface *current,
 
 	AA_x_ratio = ((double)aa_imgwidth(AA_context)) / ((double)width);
 	AA_y_ratio = ((double)aa_imgheight(AA_context)) / ((double)height);
+	if ( AA_SetupScale(this) < 0 ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	AA_InvalidateScreen(this);
 
 	/* Set the blit function */
 	this->UpdateRects = AA_DirectUpdate;
 
+	/* Render on a separate thread if requested, so slow terminals don't
+	   hold up the application.
+	 */
+	env = SDL_getenv("SDL_VIDEO_AALIB_THREAD");
+	if ( env && SDL_atoi(env) ) {
+		AA_render_thread = SDL_CreateThread(AA_RenderThread, this);
+	}
+
 	/* We're done */
 	return(current);
 }
 
+/* Called from aa_getevent(), with the AAlib mutex held */
 static void AA_ResizeHandler(aa_context *context)
 {
+	SDL_VideoDevice *this = local_this;
+
 	aa_resize(context);
-	local_this->hidden->x_ratio = ((double)aa_imgwidth(context)) / ((double)local_this->screen->w);
-	local_this->hidden->y_ratio = ((double)aa_imgheight(context)) / ((double)local_this->screen->h);
+	AA_x_ratio = ((double)aa_imgwidth(context)) / ((double)this->screen->w);
+	AA_y_ratio = ((double)aa_imgheight(context)) / ((double)this->screen->h);
 
-	fastscale (local_this->hidden->buffer, aa_image(context), local_this->hidden->w, aa_imgwidth (context), local_this->hidden->h, aa_imgheight (context));
-	aa_renderpalette(context, local_this->hidden->palette, local_this->hidden->rparams, 0, 0, aa_scrwidth(context), aa_scrheight(context));
-	aa_flush(context);
+	SDL_mutexP(AA_frame_lock);
+	if ( AA_SetupScale(this) < 0 ) {
+		/* Nothing is drawn until the next mode change */
+		AA_mapw = AA_maph = 0;
+	}
+	SDL_mutexV(AA_frame_lock);
+	AA_InvalidateScreen(this);
+	if ( ! AA_render_thread ) {
+		AA_RenderDirty(this);
+	}
 }
 
 /* We don't actually allow hardware surfaces other than the main one */
@@ -328,37 +462,40 @@ static int AA_FlipHWSurface(_THIS, SDL_Surface *surface)
 static void AA_DirectUpdate(_THIS, int numrects, SDL_Rect *rects)
 {
 	int i;
-	SDL_Rect *rect;
-
-	fastscale (AA_buffer, aa_image(AA_context), AA_w, aa_imgwidth (AA_context), AA_h, aa_imgheight (AA_context));
-#if 1
-	aa_renderpalette(AA_context, AA_palette, AA_rparams, 0, 0, aa_scrwidth(AA_context), aa_scrheight(AA_context));
-#else
-	/* Render only the rectangles in the list */
-	printf("Update rects : ");
+	SDL_Rect rect;
+
+	SDL_mutexP(AA_frame_lock);
 	for ( i=0; i < numrects; ++i ) {
-		rect = &rects[i];
-		printf("(%d,%d-%d,%d)", rect->x, rect->y, rect->w, rect->h);
-		aa_renderpalette(AA_context, AA_palette, AA_rparams, rect->x * AA_x_ratio, rect->y * AA_y_ratio, rect->w * AA_x_ratio, rect->h * AA_y_ratio);
+		rect = rects[i];
+		if ( SDL_FindChangedRect(this->screen, AA_shadow, &rect) ) {
+			SDL_UnionRect(&AA_dirty, &rect);
+		}
+	}
+	if ( AA_render_thread && AA_dirty.w && AA_dirty.h ) {
+		SDL_CondSignal(AA_frame_ready);
+	}
+	SDL_mutexV(AA_frame_lock);
+
+	if ( ! AA_render_thread ) {
+		AA_RenderDirty(this);
 	}
-	printf("\n");
-#endif
-	SDL_mutexP(AA_mutex);
-	aa_flush(AA_context);
-	SDL_mutexV(AA_mutex);
-	return;
 }
 
 int AA_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors)
 {
 	int i;
 
+	SDL_mutexP(AA_mutex);
 	for ( i=0; i < ncolors; i++ ) {
 	        aa_setpalette(AA_palette, firstcolor + i,
 			      colors[i].r>>2,
 			      colors[i].g>>2,
 			      colors[i].b>>2);
 	}
+	SDL_mutexV(AA_mutex);
+
+	/* The same pixels look different now */
+	AA_InvalidateScreen(this);
 	return(1);
 }
 
@@ -369,6 +506,8 @@ void AA_VideoQuit(_THIS)
 {
 	int i;
 
+	AA_StopRenderThread(this);
+
 	aa_uninitkbd(AA_context);
 	aa_uninitmouse(AA_context);
 
@@ -383,6 +522,20 @@ void AA_VideoQuit(_THIS)
 	aa_close(AA_context);
 
 	SDL_DestroyMutex(AA_mutex);
+	SDL_DestroyCond(AA_frame_ready);
+	SDL_DestroyMutex(AA_frame_lock);
+	if ( AA_shadow ) {
+		SDL_free(AA_shadow);
+		AA_shadow = NULL;
+	}
+	if ( AA_xmap ) {
+		SDL_free(AA_xmap);
+		AA_xmap = NULL;
+	}
+	if ( AA_ymap ) {
+		SDL_free(AA_ymap);
+		AA_ymap = NULL;
+	}
 
 	this->screen->pixels = NULL;	
 }
@@ -26,6 +26,7 @@
 
 #include "SDL_mouse.h"
 #include "SDL_mutex.h"
+#include "SDL_thread.h"
 #include "../SDL_sysvideo.h"
 
 #include <aalib.h>
@@ -46,6 +47,18 @@ struct SDL_PrivateVideoData {
     SDL_mutex *mutex;
     int in_x11;
     void *buffer;
+
+    /* Only the cells covering pixels that changed are rendered again */
+    Uint8 *shadow;		/* The screen as it was last rendered */
+    SDL_Rect dirty;		/* Changed area not rendered yet */
+    int *xmap, *ymap;		/* Screen pixel sampled by each image pixel */
+    int mapw, maph;
+
+    /* Optional thread rendering the changes in the background */
+    SDL_mutex *frame_lock;	/* Protects shadow and dirty */
+    SDL_cond *frame_ready;
+    SDL_Thread *render_thread;
+    int render_quit;
 };
 
 /* Old variable names */
@@ -63,4 +76,15 @@ struct SDL_PrivateVideoData {
 #define AA_w                (this->hidden->w)
 #define AA_h                (this->hidden->h)
 
+#define AA_shadow		    (this->hidden->shadow)
+#define AA_dirty		    (this->hidden->dirty)
+#define AA_xmap		    (this->hidden->xmap)
+#define AA_ymap		    (this->hidden->ymap)
+#define AA_mapw		    (this->hidden->mapw)
+#define AA_maph		    (this->hidden->maph)
+#define AA_frame_lock	    (this->hidden->frame_lock)
+#define AA_frame_ready	    (this->hidden->frame_ready)
+#define AA_render_thread	    (this->hidden->render_thread)
+#define AA_render_quit	    (this->hidden->render_quit)
+
 #endif /* _SDL_aavideo_h */
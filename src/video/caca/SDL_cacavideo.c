@@ -41,6 +41,7 @@ static char rcsid =
 #include "SDL_mouse.h"
 #include "../SDL_sysvideo.h"
 #include "../SDL_pixels_c.h"
+#include "../SDL_dirty_c.h"
 #include "../../events/SDL_events_c.h"
 
 #include "SDL_cacavideo.h"
@@ -153,6 +154,8 @@ int Caca_VideoInit(_THIS, SDL_PixelFormat *vformat)
 	SDL_modelist[6] = NULL;
 
 	Caca_mutex = SDL_CreateMutex();
+	Caca_frame_lock = SDL_CreateMutex();
+	Caca_frame_ready = SDL_CreateCond();
 
 	/* Initialize the library */
 	if ( caca_init() != 0 ) {
@@ -190,26 +193,150 @@ SDL_Rect **Caca_ListModes(_THIS, SDL_PixelFormat *format, Uint32 flags)
 /* Various screen update functions available */
 static void Caca_DirectUpdate(_THIS, int numrects, SDL_Rect *rects);
 
-SDL_Surface *Caca_SetVideoMode(_THIS, SDL_Surface *current,
-				int width, int height, int bpp, Uint32 flags)
+/* Draw the character cells covering the changed part of the screen */
+static void Caca_RenderDirty(_THIS)
+{
+	SDL_Rect rect;
+	struct caca_bitmap *bitmap;
+	int cw, ch;
+	int cx1, cy1, cx2, cy2;
+	int px1, py1, px2, py2;
+	int y;
+
+	SDL_mutexP(Caca_mutex);
+	SDL_mutexP(Caca_frame_lock);
+	rect = Caca_dirty;
+	memset(&Caca_dirty, 0, sizeof(Caca_dirty));
+	if ( rect.w && rect.h && (Caca_render != Caca_shadow) ) {
+		for ( y = rect.y; y < rect.y + rect.h; ++y ) {
+			memcpy(Caca_render + y * Caca_pitch + rect.x * 2,
+			       Caca_shadow + y * Caca_pitch + rect.x * 2,
+			       rect.w * 2);
+		}
+	}
+	SDL_mutexV(Caca_frame_lock);
+
+	if ( rect.w && rect.h ) {
+		/* The cells covering the change, and the pixels that
+		   caca_draw_bitmap() would scale into exactly those cells.
+		 */
+		cw = caca_get_width();
+		ch = caca_get_height();
+		cx1 = (rect.x * cw) / Caca_w;
+		cy1 = (rect.y * ch) / Caca_h;
+		cx2 = ((rect.x + rect.w) * cw + Caca_w - 1) / Caca_w;
+		cy2 = ((rect.y + rect.h) * ch + Caca_h - 1) / Caca_h;
+		px1 = (cx1 * Caca_w) / cw;
+		py1 = (cy1 * Caca_h) / ch;
+		px2 = (cx2 * Caca_w + cw - 1) / cw;
+		py2 = (cy2 * Caca_h + ch - 1) / ch;
+		if ( px2 > Caca_w ) {
+			px2 = Caca_w;
+		}
+		if ( py2 > Caca_h ) {
+			py2 = Caca_h;
+		}
+		if ( (px1 == 0) && (py1 == 0) &&
+		     (px2 == Caca_w) && (py2 == Caca_h) ) {
+			caca_draw_bitmap( 0, 0, cw - 1, ch - 1,
+					  Caca_bitmap, Caca_render );
+		} else {
+			bitmap = caca_create_bitmap( 16, px2 - px1, py2 - py1,
+						     Caca_pitch, 0xf800, 0x07e0,
+						     0x001f, 0x0000 );
+			if ( bitmap ) {
+				caca_draw_bitmap( cx1, cy1, cx2 - 1, cy2 - 1,
+						  bitmap, Caca_render +
+						  py1 * Caca_pitch + px1 * 2 );
+				caca_free_bitmap( bitmap );
+			}
+		}
+		caca_refresh();
+	}
+	SDL_mutexV(Caca_mutex);
+}
+
+static int SDLCALL Caca_RenderThread(void *data)
+{
+	SDL_VideoDevice *this = (SDL_VideoDevice *)data;
+
+	SDL_mutexP(Caca_frame_lock);
+	while ( ! Caca_render_quit ) {
+		if ( ! Caca_dirty.w || ! Caca_dirty.h ) {
+			SDL_CondWait(Caca_frame_ready, Caca_frame_lock);
+			continue;
+		}
+		SDL_mutexV(Caca_frame_lock);
+		Caca_RenderDirty(this);
+		SDL_mutexP(Caca_frame_lock);
+	}
+	SDL_mutexV(Caca_frame_lock);
+	return(0);
+}
+
+static void Caca_StopRenderThread(_THIS)
 {
+	if ( Caca_render_thread ) {
+		SDL_mutexP(Caca_frame_lock);
+		Caca_render_quit = 1;
+		SDL_CondSignal(Caca_frame_ready);
+		SDL_mutexV(Caca_frame_lock);
+		SDL_WaitThread(Caca_render_thread, NULL);
+		Caca_render_thread = NULL;
+		Caca_render_quit = 0;
+	}
+}
+
+static void Caca_FreeBuffers(_THIS)
+{
+	if ( Caca_render && (Caca_render != Caca_shadow) ) {
+		free( Caca_render );
+	}
+	Caca_render = NULL;
+	if ( Caca_shadow ) {
+		free( Caca_shadow );
+		Caca_shadow = NULL;
+	}
 	if ( Caca_buffer ) {
 		free( Caca_buffer );
 		Caca_buffer = NULL;
 	}
+}
+
+SDL_Surface *Caca_SetVideoMode(_THIS, SDL_Surface *current,
+				int width, int height, int bpp, Uint32 flags)
+{
+	const char *env;
+	int threaded;
+
+	/* The renderer reads the old buffers until it's stopped */
+	Caca_StopRenderThread(this);
+	Caca_FreeBuffers(this);
 
 	if ( Caca_bitmap ) {
 		caca_free_bitmap( Caca_bitmap );
 		Caca_bitmap = NULL;
 	}
 
+	/* Render on a separate thread if requested, so slow terminals don't
+	   hold up the application.  It draws from its own copy of the frame.
+	 */
+	env = getenv("SDL_VIDEO_CACA_THREAD");
+	threaded = (env && atoi(env));
+
 	Caca_buffer = malloc(2 * ((width + 15) & ~15) * height);
-	if ( ! Caca_buffer ) {
+	Caca_shadow = malloc(2 * ((width + 15) & ~15) * height);
+	Caca_render = threaded ? malloc(2 * ((width + 15) & ~15) * height) :
+	                         Caca_shadow;
+	if ( ! Caca_buffer || ! Caca_shadow || ! Caca_render ) {
+		Caca_FreeBuffers(this);
 		SDL_SetError("Couldn't allocate buffer for requested mode");
 		return(NULL);
 	}
 
 	memset(Caca_buffer, 0, 2 * ((width + 15) & ~15) * height);
+	memset(Caca_shadow, 0, 2 * ((width + 15) & ~15) * height);
+	memset(Caca_render, 0, 2 * ((width + 15) & ~15) * height);
 
 	/* Allocate the new pixel format for the screen */
 	if ( ! SDL_ReallocFormat(current, 16, 0xf800, 0x07e0, 0x001f, 0) ) {
@@ -220,7 +347,7 @@ SDL_Surface *Caca_SetVideoMode(_THIS, SDL_Surface *current,
 	current->flags = SDL_FULLSCREEN;
 	Caca_w = current->w = width;
 	Caca_h = current->h = height;
-	current->pitch = 2 * ((width + 15) & ~15);
+	Caca_pitch = current->pitch = 2 * ((width + 15) & ~15);
 	current->pixels = Caca_buffer;
 
 	/* Create the libcaca bitmap */
@@ -233,6 +360,15 @@ SDL_Surface *Caca_SetVideoMode(_THIS, SDL_Surface *current,
 	/* Set the blit function */
 	this->UpdateRects = Caca_DirectUpdate;
 
+	/* Draw everything the first time */
+	Caca_dirty.x = 0;
+	Caca_dirty.y = 0;
+	Caca_dirty.w = width;
+	Caca_dirty.h = height;
+	if ( threaded ) {
+		Caca_render_thread = SDL_CreateThread(Caca_RenderThread, this);
+	}
+
 	/* We're done */
 	return(current);
 }
@@ -269,11 +405,24 @@ static int Caca_FlipHWSurface(_THIS, SDL_Surface *surface)
 
 static void Caca_DirectUpdate(_THIS, int numrects, SDL_Rect *rects)
 {
-	SDL_mutexP(Caca_mutex);
-	caca_draw_bitmap( 0, 0, caca_get_width() - 1, caca_get_height() - 1,
-			  Caca_bitmap, Caca_buffer );
-	caca_refresh();
-	SDL_mutexV(Caca_mutex);
+	int i;
+	SDL_Rect rect;
+
+	SDL_mutexP(Caca_frame_lock);
+	for ( i=0; i < numrects; ++i ) {
+		rect = rects[i];
+		if ( SDL_FindChangedRect(this->screen, Caca_shadow, &rect) ) {
+			SDL_UnionRect(&Caca_dirty, &rect);
+		}
+	}
+	if ( Caca_render_thread && Caca_dirty.w && Caca_dirty.h ) {
+		SDL_CondSignal(Caca_frame_ready);
+	}
+	SDL_mutexV(Caca_frame_lock);
+
+	if ( ! Caca_render_thread ) {
+		Caca_RenderDirty(this);
+	}
 	return;
 }
 
@@ -284,6 +433,8 @@ void Caca_VideoQuit(_THIS)
 {
 	int i;
 
+	Caca_StopRenderThread(this);
+
 	/* Free video mode lists */
 	for ( i=0; i<SDL_NUMMODES; ++i ) {
 		if ( SDL_modelist[i] != NULL ) {
@@ -299,6 +450,9 @@ void Caca_VideoQuit(_THIS)
 
 	caca_end();
 
+	Caca_FreeBuffers(this);
+	SDL_DestroyCond(Caca_frame_ready);
+	SDL_DestroyMutex(Caca_frame_lock);
 	SDL_DestroyMutex(Caca_mutex);
 }
 
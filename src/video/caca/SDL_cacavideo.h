@@ -31,6 +31,7 @@ static char rcsid =
 #include "SDL_mouse.h"
 #include "../SDL_sysvideo.h"
 #include "SDL_mutex.h"
+#include "SDL_thread.h"
 
 #include <sys/time.h>
 #include <time.h>
@@ -53,6 +54,18 @@ struct SDL_PrivateVideoData {
 	struct caca_bitmap *bitmap;
 	void *buffer;
 	int w, h;
+	int pitch;
+
+	/* Only the cells covering pixels that changed are drawn again */
+	Uint8 *shadow;		/* The screen as it was last drawn */
+	Uint8 *render;		/* The frame being drawn, may be shadow */
+	SDL_Rect dirty;		/* Changed area not drawn yet */
+
+	/* Optional thread drawing the changes in the background */
+	SDL_mutex *frame_lock;	/* Protects shadow and dirty */
+	SDL_cond *frame_ready;
+	SDL_Thread *render_thread;
+	int render_quit;
 
 	int lastkey;
 	struct timeval lasttime;
@@ -66,6 +79,15 @@ struct SDL_PrivateVideoData {
 
 #define Caca_w		    (this->hidden->w)
 #define Caca_h		    (this->hidden->h)
+#define Caca_pitch		    (this->hidden->pitch)
+
+#define Caca_shadow		    (this->hidden->shadow)
+#define Caca_render		    (this->hidden->render)
+#define Caca_dirty		    (this->hidden->dirty)
+#define Caca_frame_lock	    (this->hidden->frame_lock)
+#define Caca_frame_ready	    (this->hidden->frame_ready)
+#define Caca_render_thread	    (this->hidden->render_thread)
+#define Caca_render_quit	    (this->hidden->render_quit)
 
 #define Caca_lastkey		    (this->hidden->lastkey)
 #define Caca_lasttime		    (this->hidden->lasttime)
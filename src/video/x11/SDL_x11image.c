@@ -42,62 +42,199 @@ static int shm_errhandler(Display *d, XErrorEvent *e)
 		return(X_handler(d,e));
 }
 
-static void try_mitshm(_THIS, SDL_Surface *screen)
+static int attach_mitshm(_THIS, XShmSegmentInfo *info, size_t size)
 {
-	/* Dynamic X11 may not have SHM entry points on this box. */
-	if ((use_mitshm) && (!SDL_X11_HAVE_SHM))
-		use_mitshm = 0;
-
-	if(!use_mitshm)
-		return;
-	shminfo.shmid = shmget(IPC_PRIVATE, screen->h*screen->pitch,
-			       IPC_CREAT | 0777);
-	if ( shminfo.shmid >= 0 ) {
-		shminfo.shmaddr = (char *)shmat(shminfo.shmid, 0, 0);
-		shminfo.readOnly = False;
-		if ( shminfo.shmaddr != (char *)-1 ) {
+	info->shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0777);
+	if ( info->shmid >= 0 ) {
+		info->shmaddr = (char *)shmat(info->shmid, 0, 0);
+		info->readOnly = False;
+		if ( info->shmaddr != (char *)-1 ) {
 			shm_error = False;
 			X_handler = XSetErrorHandler(shm_errhandler);
-			XShmAttach(SDL_Display, &shminfo);
+			XShmAttach(SDL_Display, info);
 			XSync(SDL_Display, False);
 			XSetErrorHandler(X_handler);
 			if ( shm_error )
-				shmdt(shminfo.shmaddr);
+				shmdt(info->shmaddr);
 		} else {
 			shm_error = True;
 		}
-		shmctl(shminfo.shmid, IPC_RMID, NULL);
+		shmctl(info->shmid, IPC_RMID, NULL);
 	} else {
 		shm_error = True;
 	}
-	if ( shm_error )
+	return(shm_error ? -1 : 0);
+}
+
+static void detach_mitshm(_THIS, XShmSegmentInfo *info)
+{
+	XShmDetach(SDL_Display, info);
+	XSync(SDL_Display, False);
+	shmdt(info->shmaddr);
+}
+
+/* The number of shared memory images to cycle through.  With more than
+   one, the application draws into the next image while the X server
+   is still reading the previous ones.
+ */
+static int num_mitshm(Uint32 flags)
+{
+	const char *env;
+	int count;
+
+	count = (flags & SDL_DOUBLEBUF) ? 2 : 1;
+	env = SDL_getenv("SDL_VIDEO_X11_SHMBUFFERS");
+	if ( env ) {
+		count = SDL_atoi(env);
+	}
+	if ( count < 1 ) {
+		count = 1;
+	}
+	if ( count > SDL_X11_MAXSHMBUFFERS ) {
+		count = SDL_X11_MAXSHMBUFFERS;
+	}
+	return(count);
+}
+
+static void try_mitshm(_THIS, SDL_Surface *screen, int count)
+{
+	int i;
+
+	/* Dynamic X11 may not have SHM entry points on this box. */
+	if ((use_mitshm) && (!SDL_X11_HAVE_SHM))
+		use_mitshm = 0;
+
+	shm_numbuffers = 0;
+	if(!use_mitshm)
+		return;
+	for ( i = 0; i < count; ++i ) {
+		if ( attach_mitshm(this, &shmbuffers[i].info,
+		                   screen->h*screen->pitch) < 0 ) {
+			break;
+		}
+		shmbuffers[i].image = NULL;
+		shmbuffers[i].busy = 0;
+		shmbuffers[i].stale.w = 0;
+		++shm_numbuffers;
+	}
+	if ( shm_numbuffers == 0 )
 		use_mitshm = 0;
 	if ( use_mitshm )
-		screen->pixels = shminfo.shmaddr;
+		screen->pixels = shmbuffers[0].info.shmaddr;
+}
+
+/* Block until the X server has finished reading the given image */
+typedef struct {
+	int type;
+	ShmSeg shmseg;
+} shm_wait_info;
+
+static Bool shm_done(Display *display, XEvent *event, XPointer arg)
+{
+	shm_wait_info *wait = (shm_wait_info *)arg;
+
+	return( (event->type == wait->type) &&
+	        (((XShmCompletionEvent *)event)->shmseg == wait->shmseg) );
+}
+
+/* Match completions for our images only, XVideo overlays have their own */
+static Bool shm_mine(Display *display, XEvent *event, XPointer arg)
+{
+	SDL_VideoDevice *this = (SDL_VideoDevice *)arg;
+	int i;
+
+	if ( event->type != shm_completion ) {
+		return(False);
+	}
+	for ( i = 0; i < shm_numbuffers; ++i ) {
+		if ( shmbuffers[i].info.shmseg ==
+		     ((XShmCompletionEvent *)event)->shmseg ) {
+			return(True);
+		}
+	}
+	return(False);
+}
+
+static void X11_WaitMITSHM(_THIS, int which)
+{
+	XEvent event;
+	int i;
+
+	/* Collect the completions that have already arrived */
+	while ( XCheckIfEvent(GFX_Display, &event, shm_mine, (XPointer)this) ) {
+		for ( i = 0; i < shm_numbuffers; ++i ) {
+			if ( shmbuffers[i].info.shmseg ==
+			     ((XShmCompletionEvent *)&event)->shmseg ) {
+				shmbuffers[i].busy = 0;
+			}
+		}
+	}
+	if ( shmbuffers[which].busy ) {
+		shm_wait_info wait;
+
+		wait.type = shm_completion;
+		wait.shmseg = shmbuffers[which].info.shmseg;
+		XIfEvent(GFX_Display, &event, shm_done, (XPointer)&wait);
+		shmbuffers[which].busy = 0;
+	}
+}
+
+static void X11_FreeMITSHM(_THIS)
+{
+	XEvent event;
+	int i;
+
+	/* Let the X server finish with the images before detaching them,
+	   and drop the completions for images that will no longer exist.
+	 */
+	XSync(GFX_Display, False);
+	while ( XCheckIfEvent(GFX_Display, &event, shm_mine, (XPointer)this) )
+		;
+	for ( i = 0; i < shm_numbuffers; ++i ) {
+		if ( shmbuffers[i].image ) {
+			XDestroyImage(shmbuffers[i].image);
+			shmbuffers[i].image = NULL;
+		}
+		detach_mitshm(this, &shmbuffers[i].info);
+	}
+	shm_numbuffers = 0;
 }
 #endif /* ! NO_SHARED_MEMORY */
 
 /* Various screen update functions available */
 static void X11_NormalUpdate(_THIS, int numrects, SDL_Rect *rects);
 static void X11_MITSHMUpdate(_THIS, int numrects, SDL_Rect *rects);
+static void X11_MITSHMPipelinedUpdate(_THIS, int numrects, SDL_Rect *rects);
 
-int X11_SetupImage(_THIS, SDL_Surface *screen)
+int X11_SetupImage(_THIS, SDL_Surface *screen, Uint32 flags)
 {
 #ifndef NO_SHARED_MEMORY
-	try_mitshm(this, screen);
+	try_mitshm(this, screen, num_mitshm(flags));
 	if(use_mitshm) {
-		SDL_Ximage = XShmCreateImage(SDL_Display, SDL_Visual,
+		int i;
+
+		shm_completion = XShmGetEventBase(GFX_Display) + ShmCompletion;
+		for ( i = 0; i < shm_numbuffers; ++i ) {
+			shmbuffers[i].image = XShmCreateImage(SDL_Display,
+					     SDL_Visual,
 					     this->hidden->depth, ZPixmap,
-					     shminfo.shmaddr, &shminfo, 
+					     shmbuffers[i].info.shmaddr,
+					     &shmbuffers[i].info,
 					     screen->w, screen->h);
-		if(!SDL_Ximage) {
-			XShmDetach(SDL_Display, &shminfo);
-			XSync(SDL_Display, False);
-			shmdt(shminfo.shmaddr);
-			screen->pixels = NULL;
-			goto error;
+			if ( !shmbuffers[i].image ) {
+				X11_FreeMITSHM(this);
+				screen->pixels = NULL;
+				goto error;
+			}
+		}
+		SDL_Ximage = shmbuffers[0].image;
+		shm_current = 0;
+		shm_front = 0;
+		if ( shm_numbuffers > 1 ) {
+			this->UpdateRects = X11_MITSHMPipelinedUpdate;
+		} else {
+			this->UpdateRects = X11_MITSHMUpdate;
 		}
-		this->UpdateRects = X11_MITSHMUpdate;
 	}
 	if(!use_mitshm)
 #endif /* not NO_SHARED_MEMORY */
@@ -130,14 +267,12 @@ error:
 void X11_DestroyImage(_THIS, SDL_Surface *screen)
 {
 	if ( SDL_Ximage ) {
-		XDestroyImage(SDL_Ximage);
 #ifndef NO_SHARED_MEMORY
 		if ( use_mitshm ) {
-			XShmDetach(SDL_Display, &shminfo);
-			XSync(SDL_Display, False);
-			shmdt(shminfo.shmaddr);
-		}
+			X11_FreeMITSHM(this);
+		} else
 #endif /* ! NO_SHARED_MEMORY */
+		XDestroyImage(SDL_Ximage);
 		SDL_Ximage = NULL;
 	}
 	if ( screen ) {
@@ -186,7 +321,7 @@ int X11_ResizeImage(_THIS, SDL_Surface *screen, Uint32 flags)
         if ( flags & SDL_OPENGL ) {  /* No image when using GL */
         	retval = 0;
         } else {
-		retval = X11_SetupImage(this, screen);
+		retval = X11_SetupImage(this, screen, flags);
 		/* We support asynchronous blitting on the display */
 		if ( flags & SDL_ASYNCBLIT ) {
 			/* This is actually slower on single-CPU systems,
@@ -273,6 +408,100 @@ static void X11_MITSHMUpdate(_THIS, int numrects, SDL_Rect *rects)
 #endif /* ! NO_SHARED_MEMORY */
 }
 
+#ifndef NO_SHARED_MEMORY
+/* Grow 'stale' to include 'area' */
+static void X11_AddStaleArea(SDL_Rect *stale, const SDL_Rect *area)
+{
+	int x1, y1, x2, y2;
+
+	if ( stale->w == 0 ) {
+		*stale = *area;
+		return;
+	}
+	x1 = SDL_min(stale->x, area->x);
+	y1 = SDL_min(stale->y, area->y);
+	x2 = SDL_max(stale->x + stale->w, area->x + area->w);
+	y2 = SDL_max(stale->y + stale->h, area->y + area->h);
+	stale->x = x1;
+	stale->y = y1;
+	stale->w = x2 - x1;
+	stale->h = y2 - y1;
+}
+#endif /* ! NO_SHARED_MEMORY */
+
+/* Send the rectangles from the current image without waiting for the
+   X server, then move the screen to the next image.  The only wait is
+   for that image to come back from a previous update, and the areas it
+   missed meanwhile are copied over from the image just sent.
+ */
+static void X11_MITSHMPipelinedUpdate(_THIS, int numrects, SDL_Rect *rects)
+{
+#ifndef NO_SHARED_MEMORY
+	SDL_Surface *screen = SDL_VideoSurface;
+	SDL_X11ShmBuffer *sent;
+	SDL_X11ShmBuffer *next;
+	SDL_Rect bounds;
+	int i, last;
+
+	last = -1;
+	bounds.w = 0;
+	for ( i=0; i<numrects; ++i ) {
+		if ( rects[i].w == 0 || rects[i].h == 0 ) { /* Clipped? */
+			continue;
+		}
+		X11_AddStaleArea(&bounds, &rects[i]);
+		last = i;
+	}
+	if ( last < 0 ) {
+		return;
+	}
+
+	/* Only the last request asks for an XShmCompletionEvent, the X
+	   server handles the others before it.
+	 */
+	sent = &shmbuffers[shm_current];
+	for ( i=0; i<=last; ++i ) {
+		if ( rects[i].w == 0 || rects[i].h == 0 ) { /* Clipped? */
+			continue;
+		}
+		XShmPutImage(GFX_Display, SDL_Window, SDL_GC, sent->image,
+				rects[i].x, rects[i].y,
+				rects[i].x, rects[i].y, rects[i].w, rects[i].h,
+								(i == last));
+	}
+	XFlush(GFX_Display);
+	sent->busy = 1;
+	shm_front = shm_current;
+
+	for ( i=0; i<shm_numbuffers; ++i ) {
+		if ( i != shm_current ) {
+			X11_AddStaleArea(&shmbuffers[i].stale, &bounds);
+		}
+	}
+
+	shm_current = (shm_current + 1) % shm_numbuffers;
+	next = &shmbuffers[shm_current];
+	X11_WaitMITSHM(this, shm_current);
+	if ( next->stale.w ) {
+		int bpp = screen->format->BytesPerPixel;
+		int pitch = sent->image->bytes_per_line;
+		int offset = next->stale.y * pitch + next->stale.x * bpp;
+		Uint8 *src = (Uint8 *)sent->info.shmaddr + offset;
+		Uint8 *dst = (Uint8 *)next->info.shmaddr + offset;
+		int h;
+
+		for ( h = next->stale.h; h; --h ) {
+			SDL_memcpy(dst, src, next->stale.w * bpp);
+			src += pitch;
+			dst += pitch;
+		}
+		next->stale.w = 0;
+	}
+	SDL_Ximage = next->image;
+	screen->pixels = next->info.shmaddr;
+#endif /* ! NO_SHARED_MEMORY */
+}
+
 /* There's a problem with the automatic refreshing of the display.
    Even though the XVideo code uses the GFX_Display to update the
    video memory, it appears that updating the window asynchronously
@@ -305,6 +534,12 @@ void X11_RefreshDisplay(_THIS)
 		XShmPutImage(SDL_Display, SDL_Window, SDL_GC, SDL_Ximage,
 				0, 0, 0, 0, this->screen->w, this->screen->h,
 				False);
+	} else if ( this->UpdateRects == X11_MITSHMPipelinedUpdate ) {
+		/* The current image may be half drawn, show the last one */
+		XShmPutImage(SDL_Display, SDL_Window, SDL_GC,
+				shmbuffers[shm_front].image,
+				0, 0, 0, 0, this->screen->w, this->screen->h,
+				False);
 	} else
 #endif /* ! NO_SHARED_MEMORY */
 	{
@@ -23,7 +23,7 @@
 
 #include "SDL_x11video.h"
 
-extern int X11_SetupImage(_THIS, SDL_Surface *screen);
+extern int X11_SetupImage(_THIS, SDL_Surface *screen, Uint32 flags);
 extern void X11_DestroyImage(_THIS, SDL_Surface *screen);
 extern int X11_ResizeImage(_THIS, SDL_Surface *screen, Uint32 flags);
 
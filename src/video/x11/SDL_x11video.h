@@ -52,6 +52,19 @@
 /* Hidden "this" pointer for the video functions */
 #define _THIS	SDL_VideoDevice *this
 
+#ifndef NO_SHARED_MEMORY
+/* Maximum number of shared memory images used to pipeline screen updates */
+#define SDL_X11_MAXSHMBUFFERS	4
+
+/* A shared memory image and its state in the X server */
+typedef struct {
+    XShmSegmentInfo info;
+    XImage *image;
+    int busy;			/* Flag: XShmCompletionEvent still pending */
+    SDL_Rect stale;		/* Area older than the current screen image */
+} SDL_X11ShmBuffer;
+#endif
+
 /* Private display data */
 struct SDL_PrivateVideoData {
     int local_X11;		/* Flag: true if local display */
@@ -74,7 +87,11 @@ struct SDL_PrivateVideoData {
 #ifndef NO_SHARED_MEMORY
     /* MIT shared memory extension information */
     int use_mitshm;
-    XShmSegmentInfo shminfo;
+    SDL_X11ShmBuffer shmbuffers[SDL_X11_MAXSHMBUFFERS];
+    int shm_numbuffers;		/* Number of images actually created */
+    int shm_current;		/* The image the screen surface points at */
+    int shm_front;		/* The image last sent to the X server */
+    int shm_completion;		/* Event type of XShmCompletionEvent */
 #endif
 
     /* The variables used for displaying graphics */
@@ -173,7 +190,11 @@ struct SDL_PrivateVideoData {
 #define SDL_windowid		(this->hidden->SDL_windowid)
 #define using_dga		(this->hidden->using_dga)
 #define use_mitshm		(this->hidden->use_mitshm)
-#define shminfo			(this->hidden->shminfo)
+#define shmbuffers		(this->hidden->shmbuffers)
+#define shm_numbuffers		(this->hidden->shm_numbuffers)
+#define shm_current		(this->hidden->shm_current)
+#define shm_front		(this->hidden->shm_front)
+#define shm_completion		(this->hidden->shm_completion)
 #define SDL_Ximage		(this->hidden->Ximage)
 #define SDL_GC			(this->hidden->gc)
 #define window_w		(this->hidden->window_w)
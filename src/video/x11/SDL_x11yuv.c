@@ -27,9 +27,13 @@
 
 #include <X11/Xlib.h>
 #ifndef NO_SHARED_MEMORY
+#include <sys/types.h>
+#include <sys/time.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <unistd.h>
 #include <X11/extensions/XShm.h>
+#include "SDL_timer.h"
 #endif
 #include "../Xext/extensions/Xvlib.h"
 
@@ -56,15 +60,22 @@ static struct private_yuvhwfuncs x11_yuvfuncs = {
 	X11_LockYUVOverlay,
 	X11_UnlockYUVOverlay,
 	X11_DisplayYUVOverlay,
-	X11_FreeYUVOverlay
+	X11_FreeYUVOverlay,
+	X11_SetPlanesYUVOverlay
 };
 
 struct private_yuvhwdata {
 	int port;
 #ifndef NO_SHARED_MEMORY
 	int yuv_use_mitshm;
-	XShmSegmentInfo yuvshm;
+	int yuv_numbuffers;		/* Number of shared images, 1 or 2 */
+	int yuv_current;		/* The image the overlay planes point at */
+	int yuv_completion;		/* Event type of XShmCompletionEvent */
+	XShmSegmentInfo yuvshm[2];
+	SDL_NAME(XvImage) *images[2];
+	int yuv_pending[2];		/* Puts the X server hasn't finished */
 #endif
+	int yuv_external;		/* The planes belong to the application */
 	SDL_NAME(XvImage) *image;
 };
 
@@ -82,6 +93,151 @@ static int shm_errhandler(Display *d, XErrorEvent *e)
         } else
 		return(X_handler(d,e));
 }
+
+static int attach_yuv_shm(_THIS, SDL_NAME(XvImage) *image,
+                          XShmSegmentInfo *yuvshm)
+{
+	yuvshm->shmid = shmget(IPC_PRIVATE, image->data_size,
+			       IPC_CREAT | 0777);
+	if ( yuvshm->shmid >= 0 ) {
+		yuvshm->shmaddr = (char *)shmat(yuvshm->shmid, 0, 0);
+		yuvshm->readOnly = False;
+		if ( yuvshm->shmaddr != (char *)-1 ) {
+			shm_error = False;
+			X_handler = XSetErrorHandler(shm_errhandler);
+			XShmAttach(GFX_Display, yuvshm);
+			/* Don't discard events, the completions of images
+			   already being displayed are still being waited for */
+			XSync(GFX_Display, False);
+			XSetErrorHandler(X_handler);
+			if ( shm_error )
+				shmdt(yuvshm->shmaddr);
+		} else {
+			shm_error = True;
+		}
+		shmctl(yuvshm->shmid, IPC_RMID, NULL);
+	} else {
+		shm_error = True;
+	}
+	if ( shm_error ) {
+		return(-1);
+	}
+	image->data = yuvshm->shmaddr;
+	return(0);
+}
+
+/* The number of shared memory images to alternate between.  With two,
+   the next frame is written while the X server reads the previous one,
+   but the overlay pixels then hold the frame before last after a lock,
+   which breaks programs that only redraw part of the overlay.  So this
+   is only done when asked for.
+ */
+static int num_yuv_buffers(void)
+{
+	const char *env;
+	int count;
+
+	count = 1;
+	env = SDL_getenv("SDL_VIDEO_X11_XV_BUFFERS");
+	if ( env ) {
+		count = SDL_atoi(env);
+	}
+	if ( count < 1 ) {
+		count = 1;
+	}
+	if ( count > 2 ) {
+		count = 2;
+	}
+	return(count);
+}
+
+/* Both images must share a layout so the overlay pitches stay valid */
+static int same_yuv_layout(SDL_NAME(XvImage) *a, SDL_NAME(XvImage) *b)
+{
+	int i;
+
+	if ( (a->data_size != b->data_size) ||
+	     (a->num_planes != b->num_planes) ) {
+		return(0);
+	}
+	for ( i = 0; i < a->num_planes; ++i ) {
+		if ( (a->pitches[i] != b->pitches[i]) ||
+		     (a->offsets[i] != b->offsets[i]) ) {
+			return(0);
+		}
+	}
+	return(1);
+}
+
+static Bool yuv_shm_done(Display *display, XEvent *event, XPointer arg)
+{
+	struct private_yuvhwdata *hwdata = (struct private_yuvhwdata *)arg;
+	int i;
+
+	if ( event->type != hwdata->yuv_completion ) {
+		return(False);
+	}
+	for ( i = 0; i < hwdata->yuv_numbuffers; ++i ) {
+		if ( hwdata->yuvshm[i].shmseg ==
+		     ((XShmCompletionEvent *)event)->shmseg ) {
+			return(True);
+		}
+	}
+	return(False);
+}
+
+static void yuv_shm_completed(struct private_yuvhwdata *hwdata, XEvent *event)
+{
+	int i;
+
+	for ( i = 0; i < hwdata->yuv_numbuffers; ++i ) {
+		if ( (hwdata->yuvshm[i].shmseg ==
+		      ((XShmCompletionEvent *)event)->shmseg) &&
+		     (hwdata->yuv_pending[i] > 0) ) {
+			--hwdata->yuv_pending[i];
+		}
+	}
+}
+
+/* How long to wait for the X server to finish reading an image before
+   giving up on its completion event, in milliseconds */
+#define YUV_WAIT_TIMEOUT	100
+
+/* Collect the completions that have already arrived, and if requested,
+   wait until the X server has finished reading the given image.  This
+   doesn't block in XIfEvent(), a completion that never comes would hang
+   the application, so after YUV_WAIT_TIMEOUT the image is reused anyway.
+ */
+static void X11_WaitYUVImage(_THIS, struct private_yuvhwdata *hwdata, int which)
+{
+	XEvent event;
+	Uint32 start, elapsed;
+	struct timeval timeout;
+	fd_set fdset;
+	int x11_fd;
+
+	start = SDL_GetTicks();
+	x11_fd = ConnectionNumber(GFX_Display);
+	for ( ; ; ) {
+		while ( XCheckIfEvent(GFX_Display, &event,
+		                      yuv_shm_done, (XPointer)hwdata) ) {
+			yuv_shm_completed(hwdata, &event);
+		}
+		if ( (which < 0) || (hwdata->yuv_pending[which] == 0) ) {
+			break;
+		}
+		elapsed = SDL_GetTicks() - start;
+		if ( elapsed >= YUV_WAIT_TIMEOUT ) {
+			hwdata->yuv_pending[which] = 0;
+			break;
+		}
+		timeout.tv_sec = 0;
+		timeout.tv_usec = (YUV_WAIT_TIMEOUT - elapsed) * 1000;
+		FD_ZERO(&fdset);
+		FD_SET(x11_fd, &fdset);
+		select(x11_fd+1, &fdset, NULL, NULL, &timeout);
+	}
+}
 #endif /* !NO_SHARED_MEMORY */
 
 static int xv_error;
@@ -124,6 +280,16 @@ static void X11_ClearYUVOverlay(SDL_Overlay *overlay)
 				-128, overlay->w / 2);
 		}
 		break;
+	case SDL_NV12_OVERLAY:
+	case SDL_NV21_OVERLAY:
+		for (y = 0; y < overlay->h; y++)
+			memset(overlay->pixels[0] + y * overlay->pitches[0],
+				0, overlay->w);
+
+		for (y = 0; y < (overlay->h / 2); y++)
+			memset(overlay->pixels[1] + y * overlay->pitches[1],
+				-128, overlay->w);
+		break;
 	case SDL_YUY2_OVERLAY:
 	case SDL_YVYU_OVERLAY:
 		for (y = 0; y < overlay->h; y++)
@@ -157,25 +323,84 @@ static void X11_ClearYUVOverlay(SDL_Overlay *overlay)
 }
 #endif
 
+/* Point the overlay planes at the current image */
+static void X11_PointYUVPlanes(SDL_Overlay *overlay)
+{
+	SDL_NAME(XvImage) *image = overlay->hwdata->image;
+	int i;
+
+	for ( i=0; i<overlay->planes; ++i ) {
+		overlay->pitches[i] = image->pitches[i];
+		overlay->pixels[i] = (Uint8 *)image->data + image->offsets[i];
+	}
+}
+
+#ifndef NO_SHARED_MEMORY
+/* Wait until the current image can be written.  If the X server is still
+   reading the displayed image, switch to the other one rather than waiting.
+ */
+static void X11_NextYUVImage(_THIS, SDL_Overlay *overlay)
+{
+	struct private_yuvhwdata *hwdata;
+	int which;
+
+	hwdata = overlay->hwdata;
+	X11_WaitYUVImage(this, hwdata, -1);
+
+	which = hwdata->yuv_current;
+	if ( hwdata->yuv_pending[which] && (hwdata->yuv_numbuffers > 1) ) {
+		which = !which;
+		hwdata->yuv_current = which;
+		hwdata->image = hwdata->images[which];
+		if ( ! hwdata->yuv_external ) {
+			X11_PointYUVPlanes(overlay);
+		}
+	}
+	X11_WaitYUVImage(this, hwdata, which);
+}
+#endif /* ! NO_SHARED_MEMORY */
+
+/* Copy the application's planes into the current image */
+static void X11_CopyYUVPlanes(SDL_Overlay *overlay)
+{
+	SDL_NAME(XvImage) *image = overlay->hwdata->image;
+	int i, y;
+	int bytes, rows;
+	Uint8 *src, *dst;
+
+	for ( i=0; i<overlay->planes; ++i ) {
+		SDL_GetYUVPlaneSize(overlay->format, i,
+		                    overlay->w, overlay->h, &bytes, &rows);
+		if ( bytes > image->pitches[i] ) {
+			bytes = image->pitches[i];
+		}
+		src = overlay->pixels[i];
+		dst = (Uint8 *)image->data + image->offsets[i];
+		for ( y = 0; y < rows; ++y ) {
+			SDL_memcpy(dst, src, bytes);
+			src += overlay->pitches[i];
+			dst += image->pitches[i];
+		}
+	}
+}
+
 SDL_Overlay *X11_CreateYUVOverlay(_THIS, int width, int height, Uint32 format, SDL_Surface *display)
 {
 	SDL_Overlay *overlay;
 	struct private_yuvhwdata *hwdata;
 	int xv_port;
 	unsigned int i, j, k;
+	unsigned int xv_event_base;
 	unsigned int adaptors;
 	SDL_NAME(XvAdaptorInfo) *ainfo;
 	int bpp;
-#ifndef NO_SHARED_MEMORY
-	XShmSegmentInfo *yuvshm;
-#endif
 #ifdef INTEL_XV_BADALLOC_WORKAROUND
 	int intel_adapter = False;
 #endif
 
 	/* Look for the XVideo extension with a valid port for this format */
 	xv_port = -1;
-	if ( (Success == SDL_NAME(XvQueryExtension)(GFX_Display, &j, &j, &j, &j, &j)) &&
+	if ( (Success == SDL_NAME(XvQueryExtension)(GFX_Display, &j, &j, &j, &xv_event_base, &j)) &&
 	     (Success == SDL_NAME(XvQueryAdaptors)(GFX_Display,
 	                                 RootWindow(GFX_Display, SDL_Screen),
 	                                 &adaptors, &ainfo)) ) {
@@ -274,6 +499,7 @@ SDL_Overlay *X11_CreateYUVOverlay(_THIS, int width, int height, Uint32 format, S
 	{
 		static const char *attr[] = { "XV_AUTOPAINT_COLORKEY", "XV_AUTOPAINT_COLOURKEY" };
 		unsigned int i;
+		XEvent event;
 
 		SDL_NAME(XvSelectPortNotify)(GFX_Display, xv_port, True);
 		X_handler = XSetErrorHandler(xv_errhandler);
@@ -284,7 +510,7 @@ SDL_Overlay *X11_CreateYUVOverlay(_THIS, int width, int height, Uint32 format, S
 			a = XInternAtom(GFX_Display, attr[i], True);
 			if ( a != None ) {
      				SDL_NAME(XvSetPortAttribute)(GFX_Display, xv_port, a, 1);
-				XSync(GFX_Display, True);
+				XSync(GFX_Display, False);
 				if ( ! xv_error ) {
 					break;
 				}
@@ -292,6 +518,12 @@ SDL_Overlay *X11_CreateYUVOverlay(_THIS, int width, int height, Uint32 format, S
 		}
 		XSetErrorHandler(X_handler);
 		SDL_NAME(XvSelectPortNotify)(GFX_Display, xv_port, False);
+
+		/* Drop the port notifications, but leave the completion
+		   events of any images still on the screen in the queue */
+		while ( XCheckTypedEvent(GFX_Display,
+		                         xv_event_base + XvPortNotify, &event) )
+			;
 	}
 
 	/* Create the overlay structure */
@@ -321,50 +553,52 @@ SDL_Overlay *X11_CreateYUVOverlay(_THIS, int width, int height, Uint32 format, S
 		SDL_FreeYUVOverlay(overlay);
 		return(NULL);
 	}
+	SDL_memset(hwdata, 0, sizeof(*hwdata));
 	hwdata->port = xv_port;
 #ifndef NO_SHARED_MEMORY
-	yuvshm = &hwdata->yuvshm;
-	SDL_memset(yuvshm, 0, sizeof(*yuvshm));
 	hwdata->image = SDL_NAME(XvShmCreateImage)(GFX_Display, xv_port, format,
-						   0, width, height, yuvshm);
+						   0, width, height, &hwdata->yuvshm[0]);
 #ifdef PITCH_WORKAROUND
 	if ( hwdata->image != NULL && hwdata->image->pitches[0] != (width*bpp) ) {
 		/* Ajust overlay width according to pitch */ 
 		width = hwdata->image->pitches[0] / bpp;
 		XFree(hwdata->image);
 		hwdata->image = SDL_NAME(XvShmCreateImage)(GFX_Display, xv_port, format,
-							   0, width, height, yuvshm);
+							   0, width, height, &hwdata->yuvshm[0]);
 	}
 #endif /* PITCH_WORKAROUND */
-	hwdata->yuv_use_mitshm = (hwdata->image != NULL);
-	if ( hwdata->yuv_use_mitshm ) {
-		yuvshm->shmid = shmget(IPC_PRIVATE, hwdata->image->data_size,
-				       IPC_CREAT | 0777);
-		if ( yuvshm->shmid >= 0 ) {
-			yuvshm->shmaddr = (char *)shmat(yuvshm->shmid, 0, 0);
-			yuvshm->readOnly = False;
-			if ( yuvshm->shmaddr != (char *)-1 ) {
-				shm_error = False;
-				X_handler = XSetErrorHandler(shm_errhandler);
-				XShmAttach(GFX_Display, yuvshm);
-				XSync(GFX_Display, True);
-				XSetErrorHandler(X_handler);
-				if ( shm_error )
-					shmdt(yuvshm->shmaddr);
-			} else {
-				shm_error = True;
-			}
-			shmctl(yuvshm->shmid, IPC_RMID, NULL);
+	if ( hwdata->image != NULL ) {
+		if ( attach_yuv_shm(this, hwdata->image, &hwdata->yuvshm[0]) == 0 ) {
+			hwdata->yuv_use_mitshm = 1;
+			hwdata->yuv_numbuffers = 1;
+			hwdata->images[0] = hwdata->image;
 		} else {
-			shm_error = True;
-		}
-		if ( shm_error ) {
 			XFree(hwdata->image);
-			hwdata->yuv_use_mitshm = 0;
-		} else {
-			hwdata->image->data = yuvshm->shmaddr;
+			hwdata->image = NULL;
+		}
+	}
+	if ( hwdata->yuv_use_mitshm && (num_yuv_buffers() > 1) ) {
+		/* A second image to write into while the first is displayed,
+		   we just stay single buffered if it can't be created.
+		 */
+		SDL_NAME(XvImage) *image;
+
+		image = SDL_NAME(XvShmCreateImage)(GFX_Display, xv_port, format,
+					0, width, height, &hwdata->yuvshm[1]);
+		if ( image != NULL ) {
+			if ( same_yuv_layout(hwdata->image, image) &&
+			     (attach_yuv_shm(this, image, &hwdata->yuvshm[1]) == 0) ) {
+				hwdata->yuv_numbuffers = 2;
+				hwdata->images[1] = image;
+			} else {
+				XFree(image);
+			}
 		}
 	}
+	if ( hwdata->yuv_use_mitshm ) {
+		hwdata->yuv_completion = XShmGetEventBase(GFX_Display) +
+		                         ShmCompletion;
+	}
 	if ( !hwdata->yuv_use_mitshm )
 #endif /* NO_SHARED_MEMORY */
 	{
@@ -402,11 +636,7 @@ SDL_Overlay *X11_CreateYUVOverlay(_THIS, int width, int height, Uint32 format, S
 		SDL_FreeYUVOverlay(overlay);
 		return(NULL);
 	}
-	for ( i=0; i<overlay->planes; ++i ) {
-		overlay->pitches[i] = hwdata->image->pitches[i];
-		overlay->pixels[i] = (Uint8 *)hwdata->image->data +
-		                              hwdata->image->offsets[i];
-	}
+	X11_PointYUVPlanes(overlay);
 
 #ifdef XFREE86_REFRESH_HACK
 	/* Work around an XFree86 X server bug (?)
@@ -471,6 +701,14 @@ SDL_Overlay *X11_CreateYUVOverlay(_THIS, int width, int height, Uint32 format, S
 
 int X11_LockYUVOverlay(_THIS, SDL_Overlay *overlay)
 {
+#ifndef NO_SHARED_MEMORY
+	struct private_yuvhwdata *hwdata;
+
+	hwdata = overlay->hwdata;
+	if ( hwdata->yuv_use_mitshm && ! hwdata->yuv_external ) {
+		X11_NextYUVImage(this, overlay);
+	}
+#endif
 	return(0);
 }
 
@@ -485,25 +723,55 @@ int X11_DisplayYUVOverlay(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *
 
 	hwdata = overlay->hwdata;
 
+	if ( hwdata->yuv_external ) {
+#ifndef NO_SHARED_MEMORY
+		if ( hwdata->yuv_use_mitshm ) {
+			X11_NextYUVImage(this, overlay);
+		}
+#endif
+		X11_CopyYUVPlanes(overlay);
+	}
+
 #ifndef NO_SHARED_MEMORY
 	if ( hwdata->yuv_use_mitshm ) {
 		SDL_NAME(XvShmPutImage)(GFX_Display, hwdata->port, SDL_Window, SDL_GC,
 	              hwdata->image,
 		      src->x, src->y, src->w, src->h,
-		      dst->x, dst->y, dst->w, dst->h, False);
+		      dst->x, dst->y, dst->w, dst->h, True);
+		++hwdata->yuv_pending[hwdata->yuv_current];
+
+		/* The next lock waits for the completion event instead */
+		XFlush(GFX_Display);
+		return(0);
 	}
-	else
 #endif
-	{
-		SDL_NAME(XvPutImage)(GFX_Display, hwdata->port, SDL_Window, SDL_GC,
-				     hwdata->image,
-		                     src->x, src->y, src->w, src->h,
-		                     dst->x, dst->y, dst->w, dst->h);
-	}
+	SDL_NAME(XvPutImage)(GFX_Display, hwdata->port, SDL_Window, SDL_GC,
+			     hwdata->image,
+	                     src->x, src->y, src->w, src->h,
+	                     dst->x, dst->y, dst->w, dst->h);
 	XSync(GFX_Display, False);
 	return(0);
 }
 
+int X11_SetPlanesYUVOverlay(_THIS, SDL_Overlay *overlay, Uint8 **pixels, Uint16 *pitches)
+{
+	struct private_yuvhwdata *hwdata;
+	int i;
+
+	hwdata = overlay->hwdata;
+	if ( pixels ) {
+		for ( i=0; i<overlay->planes; ++i ) {
+			overlay->pixels[i] = pixels[i];
+			overlay->pitches[i] = pitches[i];
+		}
+		hwdata->yuv_external = 1;
+	} else {
+		hwdata->yuv_external = 0;
+		X11_PointYUVPlanes(overlay);
+	}
+	return(0);
+}
+
 void X11_FreeYUVOverlay(_THIS, SDL_Overlay *overlay)
 {
 	struct private_yuvhwdata *hwdata;
@@ -513,8 +781,17 @@ void X11_FreeYUVOverlay(_THIS, SDL_Overlay *overlay)
 		SDL_NAME(XvUngrabPort)(GFX_Display, hwdata->port, CurrentTime);
 #ifndef NO_SHARED_MEMORY
 		if ( hwdata->yuv_use_mitshm ) {
-			XShmDetach(GFX_Display, &hwdata->yuvshm);
-			shmdt(hwdata->yuvshm.shmaddr);
+			int i;
+
+			/* Let the X server finish with the images first */
+			XSync(GFX_Display, False);
+			X11_WaitYUVImage(this, hwdata, -1);
+			for ( i = 0; i < hwdata->yuv_numbuffers; ++i ) {
+				XShmDetach(GFX_Display, &hwdata->yuvshm[i]);
+				shmdt(hwdata->yuvshm[i].shmaddr);
+				XFree(hwdata->images[i]);
+			}
+			hwdata->image = NULL;
 		}
 #endif
 		if ( hwdata->image ) {
@@ -38,4 +38,6 @@ extern int X11_DisplayYUVOverlay(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL
 
 extern void X11_FreeYUVOverlay(_THIS, SDL_Overlay *overlay);
 
+extern int X11_SetPlanesYUVOverlay(_THIS, SDL_Overlay *overlay, Uint8 **pixels, Uint16 *pitches);
+
 #endif /* SDL_VIDEO_DRIVER_X11_XV */
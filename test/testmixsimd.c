@@ -0,0 +1,191 @@
+
+/* Test program to check that SDL_MixAudio() and SDL_MixAudioMulti() give
+   exactly the same results as the plain C mixing formulas, whatever vector
+   code the library picked for this CPU.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+#include "SDL_cpuinfo.h"
+
+/* Long enough to cover several 16 byte vector blocks and a partial one */
+#define MAX_LEN		67
+#define MAX_OFFSET	16
+
+static Uint8 src_buf[MAX_LEN+MAX_OFFSET];
+static Uint8 dst_buf[MAX_LEN+MAX_OFFSET];
+static Uint8 mix_buf[MAX_LEN+MAX_OFFSET];
+static Uint8 ref_buf[MAX_LEN+MAX_OFFSET];
+
+static Uint32 seed = 12345;
+
+static Uint8 RandomByte(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return (Uint8)(seed >> 16);
+}
+
+static void fill_audio(void *udata, Uint8 *stream, int len)
+{
+	SDL_memset(stream, *(Uint8 *)udata, len);
+}
+
+/* The scalar formulas of SDL_MixAudio(), written out independently */
+static void MixReference(Uint16 format, Uint8 *dst, const Uint8 *src,
+                         Uint32 len, int volume)
+{
+	int sample, sum;
+
+	if ( volume == 0 ) {
+		return;
+	}
+	switch (format) {
+		case AUDIO_U8:
+			while ( len-- ) {
+				sample = (((*src - 128) * volume) / SDL_MIX_MAXVOLUME) + 128;
+				sum = *dst + sample - 128;
+				if ( sum < 0 ) {
+					sum = 0;
+				} else if ( sum > 0xFE ) {
+					sum = 0xFE;
+				}
+				*dst++ = (Uint8)sum;
+				++src;
+			}
+			break;
+		case AUDIO_S8:
+			while ( len-- ) {
+				sample = ((Sint8)*src * volume) / SDL_MIX_MAXVOLUME;
+				sum = (Sint8)*dst + sample;
+				if ( sum > 127 ) {
+					sum = 127;
+				} else if ( sum < -128 ) {
+					sum = -128;
+				}
+				*dst++ = (Uint8)sum;
+				++src;
+			}
+			break;
+		case AUDIO_S16LSB:
+		case AUDIO_S16MSB:
+			for ( len /= 2; len--; src += 2, dst += 2 ) {
+				if ( format == AUDIO_S16LSB ) {
+					sample = (Sint16)((src[1] << 8) | src[0]);
+					sum = (Sint16)((dst[1] << 8) | dst[0]);
+				} else {
+					sample = (Sint16)((src[0] << 8) | src[1]);
+					sum = (Sint16)((dst[0] << 8) | dst[1]);
+				}
+				sum += (sample * volume) / SDL_MIX_MAXVOLUME;
+				if ( sum > 32767 ) {
+					sum = 32767;
+				} else if ( sum < -32768 ) {
+					sum = -32768;
+				}
+				if ( format == AUDIO_S16LSB ) {
+					dst[0] = sum & 0xFF;
+					dst[1] = (sum >> 8) & 0xFF;
+				} else {
+					dst[1] = sum & 0xFF;
+					dst[0] = (sum >> 8) & 0xFF;
+				}
+			}
+			break;
+	}
+}
+
+static int TestFormat(Uint16 format, const char *name, SDL_bool multi)
+{
+	SDL_AudioSpec spec;
+	SDL_MixVoice voice;
+	Uint8 silence;
+	Uint32 len;
+	int src_off, dst_off, volume, i;
+	int errors = 0;
+
+	spec.freq = 22050;
+	spec.format = format;
+	spec.channels = 2;
+	spec.samples = 512;
+	spec.callback = fill_audio;
+	spec.userdata = &silence;
+	silence = (format == AUDIO_U8) ? 0x80 : 0x00;
+	if ( SDL_OpenAudio(&spec, NULL) < 0 ) {
+		fprintf(stderr, "Couldn't open %s audio: %s\n", name, SDL_GetError());
+		return 1;
+	}
+
+	for ( len = 0; len <= MAX_LEN; ++len ) {
+		for ( i = 0; i < MAX_LEN+MAX_OFFSET; ++i ) {
+			src_buf[i] = RandomByte();
+			dst_buf[i] = RandomByte();
+		}
+		for ( src_off = 0; src_off < MAX_OFFSET; ++src_off ) {
+		for ( dst_off = 0; dst_off < MAX_OFFSET; ++dst_off ) {
+		for ( volume = 0; volume <= SDL_MIX_MAXVOLUME; ++volume ) {
+			SDL_memcpy(mix_buf, dst_buf, sizeof(mix_buf));
+			SDL_memcpy(ref_buf, dst_buf, sizeof(ref_buf));
+			MixReference(format, ref_buf+dst_off, src_buf+src_off,
+			             len, volume);
+			if ( multi ) {
+				voice.src = src_buf+src_off;
+				voice.volume = volume;
+				voice.pan = 0;
+				SDL_MixAudioMulti(mix_buf+dst_off, format,
+				                  spec.channels, len, &voice, 1);
+			} else {
+				SDL_MixAudio(mix_buf+dst_off, src_buf+src_off,
+				             len, volume);
+			}
+			if ( SDL_memcmp(mix_buf, ref_buf, sizeof(mix_buf)) != 0 ) {
+				if ( errors++ < 10 ) {
+					printf("%s%s: mismatch, len %u, src offset %d, dst offset %d, volume %d\n",
+					       multi ? "SDL_MixAudioMulti " : "",
+					       name, (unsigned)len, src_off, dst_off, volume);
+				}
+			}
+		}
+		}
+		}
+	}
+	SDL_CloseAudio();
+
+	printf("%s%s: %s\n", multi ? "SDL_MixAudioMulti " : "", name,
+	       errors ? "FAILED" : "passed");
+	return errors ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct {
+		Uint16 format;
+		const char *name;
+	} formats[] = {
+		{ AUDIO_U8, "U8" },
+		{ AUDIO_S8, "S8" },
+		{ AUDIO_S16LSB, "S16LSB" },
+		{ AUDIO_S16MSB, "S16MSB" }
+	};
+	int i, status = 0;
+
+	/* Use the dummy driver unless told otherwise, nothing is played */
+	if ( !getenv("SDL_AUDIODRIVER") ) {
+		SDL_putenv("SDL_AUDIODRIVER=dummy");
+	}
+	if ( SDL_Init(SDL_INIT_AUDIO) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return(1);
+	}
+	printf("SSE2 %s\n", SDL_HasSSE2() ? "detected" : "not detected");
+
+	for ( i = 0; i < SDL_arraysize(formats); ++i ) {
+		status |= TestFormat(formats[i].format, formats[i].name, SDL_FALSE);
+		status |= TestFormat(formats[i].format, formats[i].name, SDL_TRUE);
+	}
+
+	SDL_Quit();
+	return(status);
+}